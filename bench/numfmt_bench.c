@@ -0,0 +1,255 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup numfmt_bench numfmt_bench
+ * @brief Numeric formatting micro-benchmark
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file numfmt_bench.c
+
+    Numeric Formatting Benchmark
+
+    The numfmt_bench application measures the time taken to format
+    float and integer values using the numfmt module, and compares it
+    against the printf family formatting used by the variable server
+    rendering path.  Results are reported in nanoseconds per value.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "numfmt.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! default number of values to format */
+#define DEFAULT_COUNT       ( 1000000 )
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! checksum of the output lengths, so the work cannot be optimized away */
+static volatile size_t checksum;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static uint64_t GetTimeNs( void );
+static uint64_t Random( uint64_t *pSeed );
+static void Report( const char *name, uint64_t ns, size_t count );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the numfmt_bench application
+
+    @param[in]
+        argc
+            number of arguments on the command line
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments.
+            argv[1] optionally specifies the number of values to format.
+
+    @retval 0 - benchmark completed
+    @retval 1 - memory allocation failure
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    size_t count = DEFAULT_COUNT;
+    float *pFloats;
+    int64_t *pInts;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    uint64_t r;
+    uint64_t start;
+    char buf[NUMFMT_MAX_LEN + 32];
+    size_t sum = 0;
+    size_t i;
+
+    if ( argc > 1 )
+    {
+        count = strtoul( argv[1], NULL, 0 );
+    }
+
+    pFloats = malloc( count * sizeof( float ) );
+    pInts = malloc( count * sizeof( int64_t ) );
+    if ( ( pFloats == NULL ) || ( pInts == NULL ) )
+    {
+        fprintf( stderr, "numfmt_bench: memory allocation failure\n" );
+        return 1;
+    }
+
+    /* typical telemetry values: a mix of magnitudes and precisions */
+    for ( i = 0 ; i < count ; i++ )
+    {
+        r = Random( &seed );
+        pFloats[i] = (float)( (int32_t)( r & 0xFFFFF ) - 0x80000 ) /
+                     (float)( 1u << ( ( r >> 20 ) % 16 ) );
+        pInts[i] = (int64_t)( r >> 32 ) >> ( ( r >> 24 ) % 32 );
+    }
+
+    printf( "values: %zu\n", count );
+
+    start = GetTimeNs();
+    for ( i = 0 ; i < count ; i++ )
+    {
+        sum += (size_t)snprintf( buf, sizeof( buf ), "%f", pFloats[i] );
+    }
+    Report( "float snprintf %f", GetTimeNs() - start, count );
+
+    start = GetTimeNs();
+    for ( i = 0 ; i < count ; i++ )
+    {
+        sum += (size_t)snprintf( buf, sizeof( buf ), "%.9g", pFloats[i] );
+    }
+    Report( "float snprintf %.9g", GetTimeNs() - start, count );
+
+    start = GetTimeNs();
+    for ( i = 0 ; i < count ; i++ )
+    {
+        sum += NUMFMT_Float( pFloats[i], buf );
+    }
+    Report( "float NUMFMT_Float", GetTimeNs() - start, count );
+
+    start = GetTimeNs();
+    for ( i = 0 ; i < count ; i++ )
+    {
+        sum += (size_t)snprintf( buf,
+                                 sizeof( buf ),
+                                 "%lld",
+                                 (long long)pInts[i] );
+    }
+    Report( "int snprintf %lld", GetTimeNs() - start, count );
+
+    start = GetTimeNs();
+    for ( i = 0 ; i < count ; i++ )
+    {
+        sum += NUMFMT_Int64( pInts[i], buf );
+    }
+    Report( "int NUMFMT_Int64", GetTimeNs() - start, count );
+
+    checksum = sum;
+
+    free( pFloats );
+    free( pInts );
+
+    return 0;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  GetTimeNs                                                                 */
+/*!
+    Get the monotonic time in nanoseconds
+
+    @retval monotonic clock time in nanoseconds
+
+==============================================================================*/
+static uint64_t GetTimeNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * 1000000000ULL ) + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  Random                                                                    */
+/*!
+    Generate a pseudo-random number (xorshift64)
+
+    @param[in,out]
+        pSeed
+            pointer to the generator state
+
+    @retval pseudo-random 64 bit value
+
+==============================================================================*/
+static uint64_t Random( uint64_t *pSeed )
+{
+    uint64_t x = *pSeed;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *pSeed = x;
+
+    return x;
+}
+
+/*============================================================================*/
+/*  Report                                                                    */
+/*!
+    Report a benchmark result
+
+    @param[in]
+        name
+            name of the benchmark
+
+    @param[in]
+        ns
+            total elapsed time in nanoseconds
+
+    @param[in]
+        count
+            number of values formatted
+
+==============================================================================*/
+static void Report( const char *name, uint64_t ns, size_t count )
+{
+    printf( "%-24s %8.1f ns/value\n",
+            name,
+            ( count > 0 ) ? (double)ns / (double)count : 0.0 );
+}
+
+/*! @}
+ * end of numfmt_bench group */
@@ -0,0 +1,1576 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup templatesvc_bench templatesvc_bench
+ * @brief Template service throughput benchmark
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file templatesvc_bench.c
+
+    Template Service Benchmark
+
+    The templatesvc_bench application measures the throughput of the
+    template service render path against the in-process mock variable
+    server, so it can be run without a live varserver.
+
+    A synthetic workload of templates is generated, each referencing a
+    number of variables drawn from a shared pool of integer, float and
+    string variables, and padded with literal text to a target output
+    size.  The workload is loaded into the template service, with the
+    triggers of each template derived from the variables it references,
+    and the service is attached to an event loop as it is when it runs.
+    Each cycle modifies one referenced variable of each selected template,
+    passes the modifications to TEMPLATESVC_ProcessTemplates, and runs a
+    render cycle with TEMPLATESVC_RenderTemplates, which fetches, renders,
+    and delivers every triggered template to a file or message queue sink.
+
+    For each workload the benchmark reports renders per second, the
+    p50 and p99 trigger-to-output latency, the number of system calls
+    per render and the number of variable server calls per render.
+    System calls are counted at the libc boundary by wrapping the I/O
+    functions at link time.  Each variable server call is an IPC round
+    trip in the real client library.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <varserver/varserver.h>
+#include "templatesvc.h"
+#include "eventloop.h"
+#include "histogram.h"
+#include "mockvarserver.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! default number of templates */
+#define DEFAULT_TEMPLATES           ( 100 )
+
+/*! default number of variable references per template */
+#define DEFAULT_REFS                ( 10 )
+
+/*! default output size per template */
+#define DEFAULT_BYTES               ( 1024 )
+
+/*! default number of measured renders */
+#define DEFAULT_RENDERS             ( 10000 )
+
+/*! default size of the variable pool */
+#define DEFAULT_POOL                ( 1000 )
+
+/*! estimated rendered length of a variable reference */
+#define REF_TEXT_LEN                ( 12 )
+
+/*! largest rendered length of a variable reference */
+#define REF_MAX_LEN                 ( 24 )
+
+/*! prefix of the render metric variables */
+#define METRICS_PREFIX              "/bench/metrics"
+
+/*! largest total template size generated by the sweep */
+#define SWEEP_MAX_TOTAL             ( 512UL * 1024 * 1024 )
+
+/*! largest total number of variable references generated by the sweep */
+#define SWEEP_MAX_REFS              ( 1000000UL )
+
+/*! largest number of bytes rendered by each sweep workload */
+#define SWEEP_MAX_RENDERED          ( 1024UL * 1024 * 1024 )
+
+/*! benchmark output sinks */
+typedef enum sinkType
+{
+    /*! file target, opened and truncated for each render */
+    SINK_FD = 0,
+
+    /*! POSIX message queue target */
+    SINK_MQ = 1
+
+} SinkType;
+
+/*! benchmark workload configuration */
+typedef struct benchConfig
+{
+    /*! number of templates */
+    size_t templates;
+
+    /*! number of variable references per template */
+    size_t refs;
+
+    /*! approximate output size of each template */
+    size_t bytes;
+
+    /*! number of variables in the shared pool */
+    size_t pool;
+
+    /*! number of measured renders */
+    size_t renders;
+
+    /*! number of templates triggered per cycle */
+    size_t batch;
+
+    /*! output sink type */
+    SinkType sink;
+
+    /*! use incremental rendering */
+    bool incremental;
+
+    /*! publish the render metrics */
+    bool metrics;
+
+    /*! output compression algorithm (or NULL) */
+    const char *compress;
+
+} BenchConfig;
+
+/*! a generated template */
+typedef struct benchTemplate
+{
+    /*! pool indexes of the referenced variables */
+    size_t *pRefs;
+
+} BenchTemplate;
+
+/*! benchmark results */
+typedef struct benchResult
+{
+    /*! number of renders completed */
+    uint64_t renders;
+
+    /*! elapsed time of the measured renders */
+    uint64_t ns;
+
+    /*! trigger-to-output latency */
+    Histogram latency;
+
+    /*! number of system calls */
+    uint64_t syscalls;
+
+    /*! number of variable server calls */
+    uint64_t varcalls;
+
+} BenchResult;
+
+/*! benchmark run state */
+typedef struct benchState
+{
+    /*! workload configuration */
+    const BenchConfig *pConfig;
+
+    /*! template service under test */
+    TemplateSvcState svc;
+
+    /*! event loop the template service is attached to */
+    EventLoop *pLoop;
+
+    /*! working directory for the templates and file sink */
+    char dir[64];
+
+    /*! template service configuration file path */
+    char config[96];
+
+    /*! file sink path */
+    char target[96];
+
+    /*! message queue sink name */
+    char mqName[64];
+
+    /*! message queue receiver used to drain the sink */
+    mqd_t mqRx;
+
+    /*! message queue receive buffer */
+    char *pRxBuf;
+
+    /*! size of the message queue receive buffer */
+    size_t rxSize;
+
+    /*! thread draining the message queue sink */
+    pthread_t drainer;
+
+    /*! true if the drain thread is running */
+    bool draining;
+
+    /*! generated templates */
+    BenchTemplate *pTemplates;
+
+    /*! variables modified in the current cycle */
+    VAR_HANDLE *pModified;
+
+    /*! next template to render during warm-up */
+    size_t next;
+
+    /*! handles of the variables in the pool */
+    VAR_HANDLE *pPool;
+
+    /*! pseudo-random generator state */
+    uint64_t seed;
+
+} BenchState;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! number of system calls made through the wrapped libc functions */
+static uint64_t syscalls;
+
+/*! sweep workload dimensions */
+static const size_t sweepTemplates[] = { 1, 100, 10000 };
+static const size_t sweepRefs[] = { 1, 100, 1000 };
+static const size_t sweepBytes[] = { 100, 10000, 1000000 };
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void usage( char *cmdname );
+static int ProcessOptions( int argC, char *argV[], BenchConfig *pConfig );
+static int Sweep( const BenchConfig *pConfig );
+static int RunBench( const BenchConfig *pConfig, BenchResult *pResult );
+static int Setup( BenchState *pState );
+static int SetupPool( BenchState *pState );
+static int SetPoolVar( BenchState *pState, size_t idx );
+static int SetupTemplates( BenchState *pState );
+static int WriteTemplate( BenchState *pState, size_t idx, const char *path );
+static int WriteConfig( BenchState *pState );
+static int SetupSink( BenchState *pState );
+static int SetupService( BenchState *pState );
+static void *DrainSink( void *arg );
+static int RenderCycle( BenchState *pState, BenchResult *pResult );
+static void Cleanup( BenchState *pState );
+static void ReportHeader( void );
+static void Report( const BenchConfig *pConfig,
+                    const BenchResult *pResult,
+                    int rc );
+static uint64_t GetTimeNs( void );
+static uint64_t Random( uint64_t *pSeed );
+
+/* libc functions wrapped at link time to count system calls */
+ssize_t __real_write( int fd, const void *buf, size_t count );
+ssize_t __real_read( int fd, void *buf, size_t count );
+int __real_open( const char *pathname, int flags, ... );
+int __real_close( int fd );
+off_t __real_lseek( int fd, off_t offset, int whence );
+int __real_stat( const char *pathname, struct stat *statbuf );
+int __real_fstat( int fd, struct stat *statbuf );
+mqd_t __real_mq_open( const char *name, int oflag, ... );
+int __real_mq_close( mqd_t mqdes );
+int __real_mq_send( mqd_t mqdes,
+                    const char *msg_ptr,
+                    size_t msg_len,
+                    unsigned int msg_prio );
+
+ssize_t __wrap_write( int fd, const void *buf, size_t count );
+ssize_t __wrap_read( int fd, void *buf, size_t count );
+int __wrap_open( const char *pathname, int flags, ... );
+int __wrap_close( int fd );
+off_t __wrap_lseek( int fd, off_t offset, int whence );
+int __wrap_stat( const char *pathname, struct stat *statbuf );
+int __wrap_fstat( int fd, struct stat *statbuf );
+mqd_t __wrap_mq_open( const char *name, int oflag, ... );
+int __wrap_mq_close( mqd_t mqdes );
+int __wrap_mq_send( mqd_t mqdes,
+                    const char *msg_ptr,
+                    size_t msg_len,
+                    unsigned int msg_prio );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the templatesvc_bench application
+
+    @param[in]
+        argc
+            number of arguments on the command line
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @retval 0 - benchmark completed
+    @retval 1 - one or more workloads failed
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    BenchConfig config;
+    BenchResult result;
+    int rc;
+
+    memset( &config, 0, sizeof( config ) );
+    config.templates = DEFAULT_TEMPLATES;
+    config.refs = DEFAULT_REFS;
+    config.bytes = DEFAULT_BYTES;
+    config.pool = DEFAULT_POOL;
+    config.renders = DEFAULT_RENDERS;
+    config.batch = 1;
+    config.sink = SINK_FD;
+
+    ReportHeader();
+
+    if ( ProcessOptions( argc, argv, &config ) == EOK )
+    {
+        rc = RunBench( &config, &result );
+        Report( &config, &result, rc );
+    }
+    else
+    {
+        rc = Sweep( &config );
+    }
+
+    return ( rc == EOK ) ? 0 : 1;
+}
+
+/*============================================================================*/
+/*  __wrap_write                                                              */
+/*!
+    Count a write system call
+
+==============================================================================*/
+ssize_t __wrap_write( int fd, const void *buf, size_t count )
+{
+    syscalls++;
+    return __real_write( fd, buf, count );
+}
+
+/*============================================================================*/
+/*  __wrap_read                                                               */
+/*!
+    Count a read system call
+
+==============================================================================*/
+ssize_t __wrap_read( int fd, void *buf, size_t count )
+{
+    syscalls++;
+    return __real_read( fd, buf, count );
+}
+
+/*============================================================================*/
+/*  __wrap_open                                                               */
+/*!
+    Count an open system call
+
+==============================================================================*/
+int __wrap_open( const char *pathname, int flags, ... )
+{
+    va_list args;
+    mode_t mode = 0;
+
+    if ( flags & O_CREAT )
+    {
+        va_start( args, flags );
+        mode = (mode_t)va_arg( args, int );
+        va_end( args );
+    }
+
+    syscalls++;
+    return __real_open( pathname, flags, mode );
+}
+
+/*============================================================================*/
+/*  __wrap_close                                                              */
+/*!
+    Count a close system call
+
+==============================================================================*/
+int __wrap_close( int fd )
+{
+    syscalls++;
+    return __real_close( fd );
+}
+
+/*============================================================================*/
+/*  __wrap_lseek                                                              */
+/*!
+    Count an lseek system call
+
+==============================================================================*/
+off_t __wrap_lseek( int fd, off_t offset, int whence )
+{
+    syscalls++;
+    return __real_lseek( fd, offset, whence );
+}
+
+/*============================================================================*/
+/*  __wrap_stat                                                               */
+/*!
+    Count a stat system call
+
+==============================================================================*/
+int __wrap_stat( const char *pathname, struct stat *statbuf )
+{
+    syscalls++;
+    return __real_stat( pathname, statbuf );
+}
+
+/*============================================================================*/
+/*  __wrap_fstat                                                              */
+/*!
+    Count an fstat system call
+
+==============================================================================*/
+int __wrap_fstat( int fd, struct stat *statbuf )
+{
+    syscalls++;
+    return __real_fstat( fd, statbuf );
+}
+
+/*============================================================================*/
+/*  __wrap_mq_open                                                            */
+/*!
+    Count an mq_open system call
+
+==============================================================================*/
+mqd_t __wrap_mq_open( const char *name, int oflag, ... )
+{
+    va_list args;
+    mode_t mode = 0;
+    struct mq_attr *pAttr = NULL;
+
+    if ( oflag & O_CREAT )
+    {
+        va_start( args, oflag );
+        mode = (mode_t)va_arg( args, int );
+        pAttr = va_arg( args, struct mq_attr * );
+        va_end( args );
+    }
+
+    syscalls++;
+    return __real_mq_open( name, oflag, mode, pAttr );
+}
+
+/*============================================================================*/
+/*  __wrap_mq_close                                                           */
+/*!
+    Count an mq_close system call
+
+==============================================================================*/
+int __wrap_mq_close( mqd_t mqdes )
+{
+    syscalls++;
+    return __real_mq_close( mqdes );
+}
+
+/*============================================================================*/
+/*  __wrap_mq_send                                                            */
+/*!
+    Count an mq_send system call
+
+==============================================================================*/
+int __wrap_mq_send( mqd_t mqdes,
+                    const char *msg_ptr,
+                    size_t msg_len,
+                    unsigned int msg_prio )
+{
+    syscalls++;
+    return __real_mq_send( mqdes, msg_ptr, msg_len, msg_prio );
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the application usage
+
+    @param[in]
+        cmdname
+            name of the benchmark executable
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    if ( cmdname != NULL )
+    {
+        fprintf( stderr,
+                 "usage: %s [-t templates] [-r refs] [-o bytes] [-k fd|mq]"
+                 " [-n renders] [-c batch] [-p pool] [-z zstd|lz4] [-i] [-m]"
+                 " [-S] [-h]\n"
+                 " [-h] : display this help\n"
+                 " [-t] : number of templates (default %d)\n"
+                 " [-r] : variable references per template (default %d)\n"
+                 " [-o] : output bytes per template (default %d)\n"
+                 " [-k] : output sink type (default fd)\n"
+                 " [-n] : number of measured renders (default %d)\n"
+                 " [-c] : templates triggered per cycle (default 1)\n"
+                 " [-p] : number of variables in the pool (default %d)\n"
+                 " [-z] : output compression algorithm\n"
+                 " [-i] : incremental rendering\n"
+                 " [-m] : publish the render metrics\n"
+                 " [-S] : sweep the workload matrix\n",
+                 cmdname,
+                 DEFAULT_TEMPLATES,
+                 DEFAULT_REFS,
+                 DEFAULT_BYTES,
+                 DEFAULT_RENDERS,
+                 DEFAULT_POOL );
+    }
+}
+
+/*============================================================================*/
+/*  ProcessOptions                                                            */
+/*!
+    Process the command line options
+
+    @param[in]
+        argC
+            number of arguments
+
+    @param[in]
+        argV
+            array of pointers to the arguments
+
+    @param[in,out]
+        pConfig
+            pointer to the workload configuration to update
+
+    @retval EOK - run the single configured workload
+    @retval EAGAIN - sweep the workload matrix
+
+==============================================================================*/
+static int ProcessOptions( int argC, char *argV[], BenchConfig *pConfig )
+{
+    int c;
+    int result = EOK;
+    const char *options = "ht:r:o:k:n:c:p:z:imS";
+
+    while ( ( c = getopt( argC, argV, options ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 't':
+                pConfig->templates = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'r':
+                pConfig->refs = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'o':
+                pConfig->bytes = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'k':
+                pConfig->sink = ( strcmp( optarg, "mq" ) == 0 ) ? SINK_MQ
+                                                               : SINK_FD;
+                break;
+
+            case 'n':
+                pConfig->renders = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'c':
+                pConfig->batch = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'p':
+                pConfig->pool = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'z':
+                pConfig->compress = optarg;
+                break;
+
+            case 'i':
+                pConfig->incremental = true;
+                break;
+
+            case 'm':
+                pConfig->metrics = true;
+                break;
+
+            case 'S':
+                result = EAGAIN;
+                break;
+
+            case 'h':
+                usage( argV[0] );
+                exit( 0 );
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if ( pConfig->templates == 0 )
+    {
+        pConfig->templates = 1;
+    }
+
+    if ( pConfig->refs == 0 )
+    {
+        pConfig->refs = 1;
+    }
+
+    if ( pConfig->pool == 0 )
+    {
+        pConfig->pool = 1;
+    }
+
+    if ( ( pConfig->batch == 0 ) ||
+         ( pConfig->batch > pConfig->templates ) )
+    {
+        pConfig->batch = pConfig->templates;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Sweep                                                                     */
+/*!
+    Run the workload matrix
+
+    The Sweep function runs every combination of the sweep template
+    counts, reference counts, output sizes and sink types.  The number of
+    renders is reduced for large outputs, and workloads which would
+    generate more than SWEEP_MAX_TOTAL bytes of templates or more than
+    SWEEP_MAX_REFS variable references are skipped.
+
+    @param[in]
+        pConfig
+            pointer to the base workload configuration
+
+    @retval EOK - all workloads completed or were skipped
+    @retval other - one or more workloads failed
+
+==============================================================================*/
+static int Sweep( const BenchConfig *pConfig )
+{
+    int result = EOK;
+    BenchConfig config;
+    BenchResult res;
+    size_t t;
+    size_t r;
+    size_t b;
+    int s;
+    int rc;
+
+    for ( t = 0 ; t < sizeof( sweepTemplates ) / sizeof( size_t ) ; t++ )
+    {
+        for ( r = 0 ; r < sizeof( sweepRefs ) / sizeof( size_t ) ; r++ )
+        {
+            for ( b = 0 ; b < sizeof( sweepBytes ) / sizeof( size_t ) ; b++ )
+            {
+                for ( s = SINK_FD ; s <= SINK_MQ ; s++ )
+                {
+                    config = *pConfig;
+                    config.templates = sweepTemplates[t];
+                    config.refs = sweepRefs[r];
+                    config.bytes = sweepBytes[b];
+                    config.sink = (SinkType)s;
+                    config.batch = 1;
+
+                    if ( config.renders * config.bytes > SWEEP_MAX_RENDERED )
+                    {
+                        config.renders = SWEEP_MAX_RENDERED / config.bytes;
+                    }
+
+                    if ( ( config.templates * config.bytes >
+                           SWEEP_MAX_TOTAL ) ||
+                         ( config.templates * config.refs >
+                           SWEEP_MAX_REFS ) )
+                    {
+                        Report( &config, NULL, EFBIG );
+                    }
+                    else
+                    {
+                        rc = RunBench( &config, &res );
+                        Report( &config, &res, rc );
+
+                        /* message size limits are not a failure */
+                        if ( ( rc != EOK ) && ( rc != EMSGSIZE ) )
+                        {
+                            result = rc;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RunBench                                                                  */
+/*!
+    Run a benchmark workload
+
+    The RunBench function generates the workload and loads it into the
+    template service, triggers every template once to warm up the
+    service, and then performs render cycles until the configured number
+    of renders has been measured.
+
+    @param[in]
+        pConfig
+            pointer to the workload configuration
+
+    @param[out]
+        pResult
+            pointer to the location to store the results
+
+    @retval EOK - the workload completed
+    @retval other - the workload could not be set up or rendered
+
+==============================================================================*/
+static int RunBench( const BenchConfig *pConfig, BenchResult *pResult )
+{
+    int result;
+    BenchState state;
+    MockStats stats;
+    uint64_t start;
+    size_t i;
+
+    memset( &state, 0, sizeof( state ) );
+    memset( pResult, 0, sizeof( BenchResult ) );
+    HIST_Init( &pResult->latency );
+
+    state.pConfig = pConfig;
+    state.seed = 0x9E3779B97F4A7C15ULL;
+    state.mqRx = (mqd_t)-1;
+
+    result = Setup( &state );
+
+    /* warm up: render each template once */
+    for ( i = 0 ; ( result == EOK ) && ( i < pConfig->templates ) ; i++ )
+    {
+        result = RenderCycle( &state, NULL );
+    }
+
+    if ( result == EOK )
+    {
+        HIST_Init( &pResult->latency );
+        MOCK_ResetStats();
+        syscalls = 0;
+
+        start = GetTimeNs();
+        while ( ( result == EOK ) &&
+                ( pResult->renders < pConfig->renders ) )
+        {
+            result = RenderCycle( &state, pResult );
+        }
+
+        pResult->ns = GetTimeNs() - start;
+        pResult->syscalls = syscalls;
+
+        MOCK_GetStats( &stats );
+        pResult->varcalls = stats.calls;
+    }
+
+    Cleanup( &state );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Setup                                                                     */
+/*!
+    Set up a benchmark workload
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @retval EOK - the workload was set up
+    @retval other - the workload could not be set up
+
+==============================================================================*/
+static int Setup( BenchState *pState )
+{
+    int result = ENOMEM;
+    const BenchConfig *pConfig = pState->pConfig;
+    size_t renderSize;
+
+    snprintf( pState->dir,
+              sizeof( pState->dir ),
+              "/tmp/templatesvc_bench.XXXXXX" );
+    if ( mkdtemp( pState->dir ) != NULL )
+    {
+        TEMPLATESVC_Init( &pState->svc );
+
+        /* rendering buffer with room for the variable text variation */
+        renderSize = ( pConfig->bytes * 2 ) + ( pConfig->refs * REF_MAX_LEN );
+        if ( renderSize > pState->svc.varfpSize )
+        {
+            pState->svc.varfpSize = renderSize;
+        }
+
+        if ( pConfig->metrics == true )
+        {
+            pState->svc.pMetricsPrefix = METRICS_PREFIX;
+        }
+
+        pState->pModified = calloc( pConfig->batch, sizeof( VAR_HANDLE ) );
+        if ( pState->pModified != NULL )
+        {
+            result = SetupPool( pState );
+            if ( result == EOK )
+            {
+                result = SetupSink( pState );
+            }
+
+            if ( result == EOK )
+            {
+                result = SetupTemplates( pState );
+            }
+
+            if ( result == EOK )
+            {
+                result = SetupService( pState );
+            }
+        }
+    }
+    else
+    {
+        pState->dir[0] = '\0';
+        result = errno;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupPool                                                                 */
+/*!
+    Create the pool of variables referenced by the templates
+
+    The pool is a mix of 32 bit integers, 64 bit integers, floats and
+    strings.
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @retval EOK - the variables were created
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int SetupPool( BenchState *pState )
+{
+    int result = ENOMEM;
+    const BenchConfig *pConfig = pState->pConfig;
+    size_t i;
+
+    pState->pPool = calloc( pConfig->pool, sizeof( VAR_HANDLE ) );
+    if ( pState->pPool != NULL )
+    {
+        result = EOK;
+
+        for ( i = 0 ; ( result == EOK ) && ( i < pConfig->pool ) ; i++ )
+        {
+            result = SetPoolVar( pState, i );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetPoolVar                                                                */
+/*!
+    Create or update a pool variable with a new random value
+
+    The type of each pool variable is determined by its index.  Variables
+    are set directly in the mock, as their owner would set them, so
+    these updates are not counted as template service calls.
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @param[in]
+        idx
+            index of the pool variable
+
+    @retval EOK - the variable was set
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int SetPoolVar( BenchState *pState, size_t idx )
+{
+    int result = EOK;
+    char name[64];
+    char str[32];
+    VarObject obj;
+    uint64_t r = Random( &pState->seed );
+
+    memset( &obj, 0, sizeof( obj ) );
+    switch( idx % 4 )
+    {
+        case 0:
+            obj.type = VARTYPE_INT32;
+            obj.val.l = (int32_t)r;
+            break;
+
+        case 1:
+            obj.type = VARTYPE_UINT64;
+            obj.val.ull = r;
+            break;
+
+        case 2:
+            obj.type = VARTYPE_FLOAT;
+            obj.val.f = (float)( r % 100000 ) / 100.0f;
+            break;
+
+        default:
+            snprintf( str, sizeof( str ), "value-%llu",
+                      (unsigned long long)( r % 1000000 ) );
+            obj.type = VARTYPE_STR;
+            obj.val.str = str;
+            break;
+    }
+
+    if ( pState->pPool[idx] == VAR_INVALID )
+    {
+        snprintf( name, sizeof( name ), "/bench/var/%zu", idx );
+        pState->pPool[idx] = MOCK_AddVar( name, &obj );
+        if ( pState->pPool[idx] == VAR_INVALID )
+        {
+            result = ENOMEM;
+        }
+    }
+    else
+    {
+        result = MOCK_SetVar( pState->pPool[idx], &obj );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupTemplates                                                            */
+/*!
+    Generate the workload templates and the service configuration
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @retval EOK - the templates were set up
+    @retval other - the templates could not be set up
+
+==============================================================================*/
+static int SetupTemplates( BenchState *pState )
+{
+    int result = ENOMEM;
+    const BenchConfig *pConfig = pState->pConfig;
+    char path[128];
+    size_t i;
+
+    pState->pTemplates = calloc( pConfig->templates, sizeof( BenchTemplate ) );
+    if ( pState->pTemplates != NULL )
+    {
+        result = EOK;
+
+        for ( i = 0 ; ( result == EOK ) && ( i < pConfig->templates ) ; i++ )
+        {
+            snprintf( path, sizeof( path ), "%s/t%zu.tmpl", pState->dir, i );
+            result = WriteTemplate( pState, i, path );
+        }
+
+        if ( result == EOK )
+        {
+            result = WriteConfig( pState );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  WriteTemplate                                                             */
+/*!
+    Generate a workload template file
+
+    The template references the configured number of randomly selected
+    pool variables, separated by literal text sized so the rendered
+    output is approximately the configured size.
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @param[in]
+        idx
+            index of the template to generate
+
+    @param[in]
+        path
+            path of the template file to write
+
+    @retval EOK - the template was written
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - the template file could not be written
+
+==============================================================================*/
+static int WriteTemplate( BenchState *pState, size_t idx, const char *path )
+{
+    int result = ENOMEM;
+    const BenchConfig *pConfig = pState->pConfig;
+    BenchTemplate *pTemplate = &pState->pTemplates[idx];
+    FILE *fp;
+    size_t gap = 0;
+    size_t i;
+    size_t j;
+    size_t v;
+
+    pTemplate->pRefs = calloc( pConfig->refs, sizeof( size_t ) );
+    if ( pTemplate->pRefs != NULL )
+    {
+        result = EIO;
+
+        if ( pConfig->bytes > pConfig->refs * REF_TEXT_LEN )
+        {
+            gap = ( pConfig->bytes / pConfig->refs ) - REF_TEXT_LEN;
+        }
+
+        fp = fopen( path, "w" );
+        if ( fp != NULL )
+        {
+            for ( i = 0 ; i < pConfig->refs ; i++ )
+            {
+                for ( j = 0 ; j < gap ; j++ )
+                {
+                    fputc( ( ( j % 64 ) == 63 ) ? '\n' : 'a' + ( j % 26 ),
+                           fp );
+                }
+
+                v = Random( &pState->seed ) % pConfig->pool;
+                pTemplate->pRefs[i] = v;
+                fprintf( fp, "${/bench/var/%zu}", v );
+            }
+
+            if ( fclose( fp ) == 0 )
+            {
+                result = EOK;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  WriteConfig                                                               */
+/*!
+    Generate the template service configuration
+
+    Each template is triggered by the variables it references, and is
+    delivered to the benchmark sink.
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @retval EOK - the configuration was written
+    @retval EIO - the configuration file could not be written
+
+==============================================================================*/
+static int WriteConfig( BenchState *pState )
+{
+    int result = EIO;
+    const BenchConfig *pConfig = pState->pConfig;
+    bool mq = ( pConfig->sink == SINK_MQ );
+    FILE *fp;
+    size_t i;
+
+    snprintf( pState->config,
+              sizeof( pState->config ),
+              "%s/config.json",
+              pState->dir );
+
+    fp = fopen( pState->config, "w" );
+    if ( fp != NULL )
+    {
+        fprintf( fp, "{\"config\":[\n" );
+        for ( i = 0 ; i < pConfig->templates ; i++ )
+        {
+            fprintf( fp,
+                     "{\"name\":\"t%zu\",\"trigger\":\"auto\","
+                     "\"template\":\"%s/t%zu.tmpl\","
+                     "\"type\":\"%s\",\"target\":\"%s\"",
+                     i,
+                     pState->dir,
+                     i,
+                     mq ? "mq" : "fd",
+                     mq ? pState->mqName : pState->target );
+
+            if ( pConfig->compress != NULL )
+            {
+                fprintf( fp, ",\"compress\":\"%s\"", pConfig->compress );
+            }
+
+            if ( pConfig->incremental == true )
+            {
+                fprintf( fp, ",\"incremental\":true" );
+            }
+
+            fprintf( fp, "}%s\n", ( i + 1 < pConfig->templates ) ? "," : "" );
+        }
+
+        fprintf( fp, "]}\n" );
+
+        if ( fclose( fp ) == 0 )
+        {
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupSink                                                                 */
+/*!
+    Set up the benchmark output sink
+
+    For message queue sinks, the queue is created with a message size
+    large enough for the rendered output, and a thread is started to
+    drain it, as a consumer of the output would.  Outputs larger than the
+    system msgsize_max limit (/proc/sys/fs/mqueue/msgsize_max) cannot be
+    delivered to a message queue, and fail with EMSGSIZE.
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @retval EOK - the sink was set up
+    @retval other - the message queue could not be created
+
+==============================================================================*/
+static int SetupSink( BenchState *pState )
+{
+    int result = EOK;
+    struct mq_attr attr;
+
+    snprintf( pState->target,
+              sizeof( pState->target ),
+              "%s/out",
+              pState->dir );
+
+    if ( pState->pConfig->sink == SINK_MQ )
+    {
+        snprintf( pState->mqName,
+                  sizeof( pState->mqName ),
+                  "/templatesvc_bench_%d",
+                  (int)getpid() );
+
+        /* room for the largest expected output */
+        memset( &attr, 0, sizeof( attr ) );
+        attr.mq_maxmsg = 1;
+        attr.mq_msgsize = (long)( pState->pConfig->bytes +
+                                  ( pState->pConfig->refs * REF_MAX_LEN ) );
+
+        mq_unlink( pState->mqName );
+        pState->mqRx = mq_open( pState->mqName,
+                                O_RDONLY | O_CREAT,
+                                0600,
+                                &attr );
+        if ( pState->mqRx == (mqd_t)-1 )
+        {
+            /* EINVAL indicates the size exceeds the msgsize_max limit */
+            result = ( errno == EINVAL ) ? EMSGSIZE : errno;
+        }
+        else
+        {
+            pState->rxSize = (size_t)attr.mq_msgsize;
+            pState->pRxBuf = malloc( pState->rxSize );
+            if ( pState->pRxBuf == NULL )
+            {
+                result = ENOMEM;
+            }
+            else
+            {
+                result = pthread_create( &pState->drainer,
+                                         NULL,
+                                         DrainSink,
+                                         pState );
+                pState->draining = ( result == EOK );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupService                                                              */
+/*!
+    Load the workload into the template service
+
+    The template service is opened against the mock variable server,
+    loads the generated configuration, and is attached to an event loop,
+    so its targets are written without blocking and its template files
+    are watched rather than checked on each render, as when it runs.
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @retval EOK - the service was set up
+    @retval other - the service could not be set up
+
+==============================================================================*/
+static int SetupService( BenchState *pState )
+{
+    int result;
+
+    pState->svc.pFileName = pState->config;
+
+    result = TEMPLATESVC_Open( &pState->svc );
+    if ( result == EOK )
+    {
+        result = TEMPLATESVC_LoadConfig( &pState->svc );
+    }
+
+    if ( result == EOK )
+    {
+        pState->pLoop = EVENTLOOP_Create();
+        result = ( pState->pLoop != NULL )
+                    ? TEMPLATESVC_Attach( &pState->svc, pState->pLoop )
+                    : ENOMEM;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  DrainSink                                                                 */
+/*!
+    Drain the message queue sink
+
+    The DrainSink thread receives and discards the messages delivered to
+    the message queue sink until it is cancelled.  mq_receive is not
+    counted as a template service system call.
+
+    @param[in]
+        arg
+            pointer to the benchmark state
+
+    @retval NULL
+
+==============================================================================*/
+static void *DrainSink( void *arg )
+{
+    BenchState *pState = (BenchState *)arg;
+
+    while ( mq_receive( pState->mqRx,
+                        pState->pRxBuf,
+                        pState->rxSize,
+                        NULL ) >= 0 )
+    {
+    }
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  RenderCycle                                                               */
+/*!
+    Perform a single render cycle
+
+    The RenderCycle function modifies one referenced variable of each
+    template selected for this cycle, then passes the modification
+    notifications to the template service and runs its render cycle,
+    which renders and delivers every template the modified variables
+    trigger.  In the warm-up pass (pResult is NULL) the templates are
+    selected in order, otherwise they are selected at random.  Each
+    rendered template is recorded with the latency of the whole cycle.
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @param[in,out]
+        pResult
+            pointer to the results to update, or NULL during warm-up
+
+    @retval EOK - the cycle completed
+    @retval other - a template could not be rendered or delivered
+
+==============================================================================*/
+static int RenderCycle( BenchState *pState, BenchResult *pResult )
+{
+    int result = EOK;
+    const BenchConfig *pConfig = pState->pConfig;
+    BenchTemplate *pTemplate;
+    size_t v;
+    uint64_t start;
+    uint64_t latency;
+    size_t count;
+    size_t renders;
+    size_t i;
+
+    count = ( pResult != NULL ) ? pConfig->batch : 1;
+
+    /* trigger: modify one referenced variable of each template */
+    for ( i = 0 ; i < count ; i++ )
+    {
+        if ( pResult == NULL )
+        {
+            pTemplate = &pState->pTemplates[pState->next++ %
+                                            pConfig->templates];
+        }
+        else
+        {
+            pTemplate = &pState->pTemplates[Random( &pState->seed ) %
+                                            pConfig->templates];
+        }
+
+        v = pTemplate->pRefs[Random( &pState->seed ) % pConfig->refs];
+        SetPoolVar( pState, v );
+        pState->pModified[i] = pState->pPool[v];
+    }
+
+    start = GetTimeNs();
+
+    /* notify the service, as the variable server would */
+    for ( i = 0 ; i < count ; i++ )
+    {
+        (void)TEMPLATESVC_ProcessTemplates( &pState->svc,
+                                            pState->pModified[i] );
+    }
+
+    renders = pState->svc.numDirty;
+    result = TEMPLATESVC_RenderTemplates( &pState->svc );
+
+    if ( ( result == EOK ) && ( pResult != NULL ) )
+    {
+        latency = GetTimeNs() - start;
+        for ( i = 0 ; i < renders ; i++ )
+        {
+            HIST_Record( &pResult->latency, latency );
+        }
+
+        pResult->renders += renders;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Cleanup                                                                   */
+/*!
+    Release the resources used by a benchmark workload
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+==============================================================================*/
+static void Cleanup( BenchState *pState )
+{
+    char path[128];
+    size_t i;
+
+    if ( pState->draining == true )
+    {
+        pthread_cancel( pState->drainer );
+        pthread_join( pState->drainer, NULL );
+    }
+
+    TEMPLATESVC_Close( &pState->svc );
+    EVENTLOOP_Destroy( pState->pLoop );
+
+    if ( pState->pTemplates != NULL )
+    {
+        for ( i = 0 ; i < pState->pConfig->templates ; i++ )
+        {
+            snprintf( path, sizeof( path ), "%s/t%zu.tmpl", pState->dir, i );
+            unlink( path );
+            free( pState->pTemplates[i].pRefs );
+        }
+
+        free( pState->pTemplates );
+    }
+
+    if ( pState->mqRx != (mqd_t)-1 )
+    {
+        mq_close( pState->mqRx );
+        mq_unlink( pState->mqName );
+    }
+
+    if ( pState->dir[0] != '\0' )
+    {
+        unlink( pState->config );
+        unlink( pState->target );
+        rmdir( pState->dir );
+    }
+
+    free( pState->pRxBuf );
+    free( pState->pModified );
+    free( pState->pPool );
+    MOCK_Clear();
+}
+
+/*============================================================================*/
+/*  ReportHeader                                                              */
+/*!
+    Print the benchmark report column headings
+
+==============================================================================*/
+static void ReportHeader( void )
+{
+    printf( "%9s %6s %8s %4s %8s %12s %10s %10s %9s %9s\n",
+            "templates",
+            "refs",
+            "bytes",
+            "sink",
+            "renders",
+            "renders/s",
+            "p50(us)",
+            "p99(us)",
+            "sys/rndr",
+            "var/rndr" );
+}
+
+/*============================================================================*/
+/*  Report                                                                    */
+/*!
+    Print a benchmark result row
+
+    @param[in]
+        pConfig
+            pointer to the workload configuration
+
+    @param[in]
+        pResult
+            pointer to the results (may be NULL if the workload was skipped)
+
+    @param[in]
+        rc
+            status of the workload
+
+==============================================================================*/
+static void Report( const BenchConfig *pConfig,
+                    const BenchResult *pResult,
+                    int rc )
+{
+    double renders;
+
+    printf( "%9zu %6zu %8zu %4s ",
+            pConfig->templates,
+            pConfig->refs,
+            pConfig->bytes,
+            ( pConfig->sink == SINK_MQ ) ? "mq" : "fd" );
+
+    if ( ( rc == EOK ) &&
+         ( pResult != NULL ) &&
+         ( pResult->renders > 0 ) )
+    {
+        renders = (double)pResult->renders;
+
+        printf( "%8llu %12.1f %10.2f %10.2f %9.2f %9.2f\n",
+                (unsigned long long)pResult->renders,
+                renders * 1e9 / (double)pResult->ns,
+                (double)HIST_Percentile( &pResult->latency, 0.50 ) / 1e3,
+                (double)HIST_Percentile( &pResult->latency, 0.99 ) / 1e3,
+                (double)pResult->syscalls / renders,
+                (double)pResult->varcalls / renders );
+    }
+    else
+    {
+        printf( "%8s %s\n", "-", ( rc == EFBIG ) ? "skipped" : strerror( rc ) );
+    }
+
+    fflush( stdout );
+}
+
+/*============================================================================*/
+/*  GetTimeNs                                                                 */
+/*!
+    Get the monotonic time in nanoseconds
+
+    @retval monotonic clock time in nanoseconds
+
+==============================================================================*/
+static uint64_t GetTimeNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * 1000000000ULL ) + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  Random                                                                    */
+/*!
+    Generate a pseudo-random number (xorshift64)
+
+    @param[in,out]
+        pSeed
+            pointer to the generator state
+
+    @retval pseudo-random 64 bit value
+
+==============================================================================*/
+static uint64_t Random( uint64_t *pSeed )
+{
+    uint64_t x = *pSeed;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *pSeed = x;
+
+    return x;
+}
+
+/*! @}
+ * end of templatesvc_bench group */
@@ -0,0 +1,663 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup templatesvc_dispatch templatesvc_dispatch
+ * @brief Template service trigger dispatch benchmark
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file templatesvc_dispatch.c
+
+    Template Service Dispatch Benchmark
+
+    The templatesvc_dispatch application measures the memory footprint
+    of a large rule set, and the cost of mapping a trigger notification
+    to the templates it triggers, against the in-process mock variable
+    server.
+
+    A configuration of the requested number of templates is generated.
+    Each template is triggered by its own variable and by one of a small
+    number of shared group variables.  The resident memory and the
+    allocated heap are sampled before and after the configuration is
+    loaded.  Notifications for randomly selected trigger variables are
+    then dispatched one at a time, each followed by a render cycle of the
+    templates it triggered, as a signal from the variable server would be.
+    The full cycle is timed, and the CPU cache misses are counted over it
+    when the hardware performance counters are available.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <malloc.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <varserver/varserver.h>
+#include "templatesvc.h"
+#include "mockvarserver.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! default number of templates */
+#define DISPATCH_TEMPLATES          ( 20000 )
+
+/*! default number of shared group trigger variables */
+#define DISPATCH_GROUPS             ( 64 )
+
+/*! default number of dispatched notifications */
+#define DISPATCH_NOTIFICATIONS      ( 200000 )
+
+/*! number of render cycles timed together */
+#define DISPATCH_BATCH              ( 256 )
+
+/*! maximum length of a generated variable name */
+#define DISPATCH_NAME_LEN           ( 64 )
+
+/*! dispatch benchmark state */
+typedef struct dispatchState
+{
+    /*! number of templates */
+    size_t numTemplates;
+
+    /*! number of shared group trigger variables */
+    size_t numGroups;
+
+    /*! number of dispatched notifications */
+    size_t notifications;
+
+    /*! trigger variable handles (template variables, then groups) */
+    VAR_HANDLE *pHandles;
+
+    /*! number of trigger variable handles */
+    size_t numHandles;
+
+    /*! cache miss counter (-1 if not available) */
+    int perfFd;
+
+    /*! random number generator state */
+    uint64_t seed;
+} DispatchState;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! template service state */
+static TemplateSvcState state;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void usage( char *cmdname );
+static int ProcessOptions( int argC, char *argV[], DispatchState *pDispatch );
+static int SetupVars( DispatchState *pDispatch );
+static int WriteConfig( DispatchState *pDispatch, char *path );
+static int Run( DispatchState *pDispatch );
+static int OpenCacheMisses( void );
+static size_t GetRSS( void );
+static uint64_t Random( DispatchState *pDispatch );
+static uint64_t GetTimeNs( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the templatesvc_dispatch application
+
+    @param[in]
+        argc
+            number of arguments on the command line
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @return 0 on success, 1 on failure
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    DispatchState dispatch;
+    char path[] = "/tmp/templatesvc_dispatch.XXXXXX";
+    size_t rssBase;
+    size_t rssLoaded;
+    size_t heapBase;
+    size_t heapLoaded;
+    uint64_t startNs;
+    uint64_t loadNs = 0;
+    int result;
+
+    memset( &dispatch, 0, sizeof( dispatch ) );
+    dispatch.numTemplates = DISPATCH_TEMPLATES;
+    dispatch.numGroups = DISPATCH_GROUPS;
+    dispatch.notifications = DISPATCH_NOTIFICATIONS;
+    dispatch.perfFd = -1;
+    dispatch.seed = 0x9e3779b97f4a7c15ULL;
+
+    result = ProcessOptions( argc, argv, &dispatch );
+    if ( result == EOK )
+    {
+        result = SetupVars( &dispatch );
+    }
+
+    if ( result == EOK )
+    {
+        result = WriteConfig( &dispatch, path );
+    }
+
+    if ( result == EOK )
+    {
+        TEMPLATESVC_Init( &state );
+        state.pFileName = path;
+
+        rssBase = GetRSS();
+        heapBase = mallinfo2().uordblks;
+
+        result = TEMPLATESVC_Open( &state );
+        if ( result == EOK )
+        {
+            startNs = GetTimeNs();
+            result = TEMPLATESVC_LoadConfig( &state );
+            loadNs = GetTimeNs() - startNs;
+        }
+
+        unlink( path );
+
+        if ( result == EOK )
+        {
+            /* return the memory of the released configuration tree */
+            malloc_trim( 0 );
+            rssLoaded = GetRSS();
+            heapLoaded = mallinfo2().uordblks;
+
+            fprintf( stderr,
+                     "%10s %8s %10s %12s %12s %12s %12s\n",
+                     "templates", "groups", "load(ms)", "rss(KiB)",
+                     "heap(KiB)", "heap/tmpl(B)", "strings(B)" );
+            fprintf( stderr,
+                     "%10zu %8zu %10.1f %12zu %12zu %12.1f %12zu\n",
+                     dispatch.numTemplates,
+                     dispatch.numGroups,
+                     loadNs / 1e6,
+                     ( rssLoaded - rssBase ) / 1024,
+                     ( heapLoaded - heapBase ) / 1024,
+                     (double)( heapLoaded - heapBase ) /
+                        (double)dispatch.numTemplates,
+                     STRTAB_Size( state.pStrings ) );
+
+            result = Run( &dispatch );
+        }
+
+        TEMPLATESVC_Close( &state );
+    }
+
+    if ( dispatch.perfFd != -1 )
+    {
+        close( dispatch.perfFd );
+    }
+
+    free( dispatch.pHandles );
+
+    if ( result != EOK )
+    {
+        fprintf( stderr, "templatesvc_dispatch: %s\n", strerror( result ) );
+    }
+
+    return ( result == EOK ) ? 0 : 1;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the application usage
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    if ( cmdname != NULL )
+    {
+        fprintf( stderr,
+                 "usage: %s [-t templates] [-g groups] [-n notifications]"
+                 " [-h]\n"
+                 " [-h] : display this help\n"
+                 " [-t] : number of templates\n"
+                 " [-g] : number of shared group trigger variables\n"
+                 " [-n] : number of dispatched notifications\n",
+                 cmdname );
+    }
+}
+
+/*============================================================================*/
+/*  ProcessOptions                                                            */
+/*!
+    Process the command line options
+
+    @param[in]
+        argC
+            number of arguments
+
+    @param[in]
+        argV
+            array of pointers to the command line arguments
+
+    @param[in]
+        pDispatch
+            pointer to the dispatch benchmark state
+
+    @retval EOK - the options were processed
+    @retval EINVAL - invalid options
+
+==============================================================================*/
+static int ProcessOptions( int argC, char *argV[], DispatchState *pDispatch )
+{
+    int c;
+    int result = EOK;
+    const char *options = "t:g:n:h";
+
+    while ( ( c = getopt( argC, argV, options ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 't':
+                pDispatch->numTemplates = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'g':
+                pDispatch->numGroups = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'n':
+                pDispatch->notifications = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'h':
+            default:
+                usage( argV[0] );
+                result = EINVAL;
+                break;
+        }
+    }
+
+    if ( ( result == EOK ) &&
+         ( ( pDispatch->numTemplates == 0 ) ||
+           ( pDispatch->numGroups == 0 ) ) )
+    {
+        usage( argV[0] );
+        result = EINVAL;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupVars                                                                 */
+/*!
+    Create the trigger variables in the mock variable server
+
+    @param[in]
+        pDispatch
+            pointer to the dispatch benchmark state
+
+    @retval EOK - the variables were created
+    @retval ENOMEM - memory allocation failed
+
+==============================================================================*/
+static int SetupVars( DispatchState *pDispatch )
+{
+    int result = ENOMEM;
+    char name[DISPATCH_NAME_LEN];
+    VarObject obj;
+    size_t i;
+
+    pDispatch->numHandles = pDispatch->numTemplates + pDispatch->numGroups;
+    pDispatch->pHandles = calloc( pDispatch->numHandles,
+                                  sizeof( VAR_HANDLE ) );
+    if ( pDispatch->pHandles != NULL )
+    {
+        result = EOK;
+
+        memset( &obj, 0, sizeof( obj ) );
+        obj.type = VARTYPE_UINT32;
+        obj.len = sizeof( uint32_t );
+
+        for ( i = 0 ; ( result == EOK ) && ( i < pDispatch->numHandles ) ; i++ )
+        {
+            if ( i < pDispatch->numTemplates )
+            {
+                snprintf( name, sizeof( name ), "/bench/v%zu", i );
+            }
+            else
+            {
+                snprintf( name,
+                          sizeof( name ),
+                          "/bench/g%zu",
+                          i - pDispatch->numTemplates );
+            }
+
+            pDispatch->pHandles[i] = MOCK_AddVar( name, &obj );
+            if ( pDispatch->pHandles[i] == VAR_INVALID )
+            {
+                result = ENOMEM;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  WriteConfig                                                               */
+/*!
+    Generate the template service configuration
+
+    Each template renders its own variable as a JSON Lines record to
+    /dev/null, and is triggered by its own variable and a group variable.
+
+    @param[in]
+        pDispatch
+            pointer to the dispatch benchmark state
+
+    @param[in,out]
+        path
+            mkstemp template which receives the configuration file name
+
+    @retval EOK - the configuration was written
+    @retval other - the configuration file could not be written
+
+==============================================================================*/
+static int WriteConfig( DispatchState *pDispatch, char *path )
+{
+    int result = EOK;
+    FILE *fp = NULL;
+    int fd;
+    size_t i;
+
+    fd = mkstemp( path );
+    if ( fd != -1 )
+    {
+        fp = fdopen( fd, "w" );
+        if ( fp == NULL )
+        {
+            result = errno;
+            close( fd );
+            unlink( path );
+        }
+    }
+    else
+    {
+        result = errno;
+    }
+
+    if ( fp != NULL )
+    {
+        fprintf( fp, "{\"config\":[\n" );
+        for ( i = 0 ; i < pDispatch->numTemplates ; i++ )
+        {
+            fprintf( fp,
+                     "{\"name\":\"t%zu\","
+                     "\"trigger\":[\"/bench/v%zu\",\"/bench/g%zu\"],"
+                     "\"format\":\"jsonl\",\"vars\":[\"/bench/v%zu\"],"
+                     "\"type\":\"fd\",\"target\":\"/dev/null\"}%s\n",
+                     i,
+                     i,
+                     i % pDispatch->numGroups,
+                     i,
+                     ( i + 1 < pDispatch->numTemplates ) ? "," : "" );
+        }
+
+        fprintf( fp, "]}\n" );
+
+        if ( fclose( fp ) != 0 )
+        {
+            result = errno;
+            unlink( path );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Run                                                                       */
+/*!
+    Dispatch the notifications and report the render cycle cost
+
+    @param[in]
+        pDispatch
+            pointer to the dispatch benchmark state
+
+    @retval EOK - the notifications were dispatched
+    @retval other - a dispatch or render failed
+
+==============================================================================*/
+static int Run( DispatchState *pDispatch )
+{
+    int result = EOK;
+    uint64_t elapsed = 0;
+    uint64_t startNs;
+    uint64_t misses = 0;
+    size_t done = 0;
+    size_t batch;
+    size_t i;
+
+    pDispatch->perfFd = OpenCacheMisses();
+
+    while ( ( result == EOK ) && ( done < pDispatch->notifications ) )
+    {
+        batch = pDispatch->notifications - done;
+        if ( batch > DISPATCH_BATCH )
+        {
+            batch = DISPATCH_BATCH;
+        }
+
+        if ( pDispatch->perfFd != -1 )
+        {
+            ioctl( pDispatch->perfFd, PERF_EVENT_IOC_ENABLE, 0 );
+        }
+
+        startNs = GetTimeNs();
+        for ( i = 0 ; ( i < batch ) && ( result == EOK ) ; i++ )
+        {
+            (void)TEMPLATESVC_ProcessTemplates(
+                        &state,
+                        pDispatch->pHandles[ Random( pDispatch ) %
+                                             pDispatch->numHandles ] );
+
+            result = TEMPLATESVC_RenderTemplates( &state );
+        }
+
+        elapsed += GetTimeNs() - startNs;
+
+        if ( pDispatch->perfFd != -1 )
+        {
+            ioctl( pDispatch->perfFd, PERF_EVENT_IOC_DISABLE, 0 );
+        }
+
+        done += i;
+    }
+
+    if ( ( pDispatch->perfFd != -1 ) &&
+         ( read( pDispatch->perfFd, &misses, sizeof( misses ) ) !=
+            sizeof( misses ) ) )
+    {
+        misses = 0;
+    }
+
+    fprintf( stderr,
+             "%14s %12s %14s %14s\n",
+             "notifications", "index(B)", "ns/cycle", "misses/cycle" );
+
+    if ( pDispatch->perfFd != -1 )
+    {
+        fprintf( stderr,
+                 "%14zu %12zu %14.1f %14.2f\n",
+                 done,
+                 TRIGINDEX_Size( state.pTrigIndex ),
+                 ( done > 0 ) ? (double)elapsed / (double)done : 0.0,
+                 ( done > 0 ) ? (double)misses / (double)done : 0.0 );
+    }
+    else
+    {
+        fprintf( stderr,
+                 "%14zu %12zu %14.1f %14s\n",
+                 done,
+                 TRIGINDEX_Size( state.pTrigIndex ),
+                 ( done > 0 ) ? (double)elapsed / (double)done : 0.0,
+                 "n/a" );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  OpenCacheMisses                                                           */
+/*!
+    Open a disabled user space cache miss counter for this thread
+
+    @retval counter file descriptor
+    @retval -1 if the performance counters are not available
+
+==============================================================================*/
+static int OpenCacheMisses( void )
+{
+    struct perf_event_attr attr;
+
+    memset( &attr, 0, sizeof( attr ) );
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof( attr );
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 );
+}
+
+/*============================================================================*/
+/*  GetRSS                                                                    */
+/*!
+    Get the resident memory of the process
+
+    @retval resident memory in bytes (0 if it cannot be read)
+
+==============================================================================*/
+static size_t GetRSS( void )
+{
+    FILE *fp;
+    unsigned long size = 0;
+    unsigned long resident = 0;
+
+    fp = fopen( "/proc/self/statm", "r" );
+    if ( fp != NULL )
+    {
+        if ( fscanf( fp, "%lu %lu", &size, &resident ) != 2 )
+        {
+            resident = 0;
+        }
+
+        fclose( fp );
+    }
+
+    return (size_t)resident * (size_t)sysconf( _SC_PAGESIZE );
+}
+
+/*============================================================================*/
+/*  Random                                                                    */
+/*!
+    Generate a pseudo random number (xorshift64)
+
+    @param[in]
+        pDispatch
+            pointer to the dispatch benchmark state
+
+    @retval pseudo random number
+
+==============================================================================*/
+static uint64_t Random( DispatchState *pDispatch )
+{
+    uint64_t x = pDispatch->seed;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    pDispatch->seed = x;
+
+    return x;
+}
+
+/*============================================================================*/
+/*  GetTimeNs                                                                 */
+/*!
+    Get the monotonic time in ns
+
+    @retval monotonic time in ns
+
+==============================================================================*/
+static uint64_t GetTimeNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of templatesvc_dispatch group */
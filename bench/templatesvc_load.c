@@ -0,0 +1,1393 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup templatesvc_load templatesvc_load
+ * @brief Drive the template service with variable writes at a set rate
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file templatesvc_load.c
+
+    Template Service Load Generator
+
+    The templatesvc_load application loads a template service
+    configuration, creates its trigger variables in the in-process mock
+    variable server, and writes them at a configured rate.  The writes
+    are made with VAR_Set, so each one raises a MODIFIED notification
+    which is dispatched to the template service.
+
+    The variable written on each write is selected uniformly or with a
+    Zipfian distribution, and writes are either evenly spaced or grouped
+    into bursts.  The load is open loop: each write has a scheduled time,
+    and if the service falls behind the writes are issued late rather
+    than being skipped.
+
+    The tool creates the template sinks itself.  Each "fd" target is
+    created as a FIFO and each "mq" target as a message queue, and both
+    are read by the tool.  The latency of a write is measured from its
+    scheduled time to the arrival of the next output at each sink the
+    written variable triggers.
+
+    With the -S option, the tool searches for the highest write rate the
+    configuration sustains: every write delivered, the target rate
+    achieved, and the p99 latency within the latency budget.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <mqueue.h>
+#include <sys/stat.h>
+#include <varserver/varserver.h>
+#include <tjson/json.h>
+#include "templatesvc.h"
+#include "histogram.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! maximum number of writes issued between dispatches when behind */
+#define LOAD_MAX_BATCH              ( 256 )
+
+/*! requested FIFO buffer size, so renders do not block on the reader */
+#define LOAD_PIPE_SIZE              ( 1024 * 1024 )
+
+/*! size of the sink read buffer */
+#define LOAD_READ_SIZE              ( 64 * 1024 )
+
+/*! maximum number of trials when searching for the sustainable rate */
+#define LOAD_MAX_TRIALS             ( 16 )
+
+/*! fraction of the target rate which must be achieved */
+#define LOAD_RATE_TOLERANCE         ( 0.95 )
+
+/*! variable selection and write spacing */
+typedef enum loadDist
+{
+    /*! uniform variable selection, evenly spaced writes */
+    LOAD_UNIFORM = 0,
+
+    /*! Zipfian variable selection, evenly spaced writes */
+    LOAD_ZIPF = 1,
+
+    /*! uniform variable selection, writes grouped in bursts */
+    LOAD_BURST = 2
+
+} LoadDist;
+
+/*! a template output read by the load generator */
+typedef struct loadSink
+{
+    /*! sink type */
+    TemplateType type;
+
+    /*! target name */
+    char *target;
+
+    /*! read end of a FIFO sink */
+    int fd;
+
+    /*! write end held open so the FIFO does not report a hang up */
+    int wfd;
+
+    /*! message queue sink */
+    mqd_t mq;
+
+    /*! the FIFO or message queue was created by the load generator */
+    bool created;
+
+    /*! scheduled times of the writes not yet delivered to this sink */
+    uint64_t *pPending;
+
+    /*! number of undelivered writes */
+    size_t numPending;
+
+    /*! allocated number of undelivered writes */
+    size_t maxPending;
+
+} LoadSink;
+
+/*! a trigger variable written by the load generator */
+typedef struct loadVar
+{
+    /*! variable handle */
+    VAR_HANDLE hVar;
+
+    /*! next value to write */
+    uint32_t value;
+
+    /*! indexes of the sinks triggered by this variable */
+    size_t *pSinks;
+
+    /*! number of sinks triggered by this variable */
+    size_t numSinks;
+
+} LoadVar;
+
+/*! results of one load trial */
+typedef struct loadTrial
+{
+    /*! target write rate */
+    double rate;
+
+    /*! number of writes issued */
+    uint64_t writes;
+
+    /*! number of sink outputs received */
+    uint64_t arrivals;
+
+    /*! number of writes never delivered to a sink */
+    uint64_t lost;
+
+    /*! trial duration */
+    uint64_t elapsed;
+
+    /*! write to arrival latency */
+    Histogram latency;
+
+} LoadTrial;
+
+/*! load generator state */
+typedef struct loadState
+{
+    /*! name of the template service configuration file */
+    char *pConfigFile;
+
+    /*! target write rate (writes per second) */
+    double rate;
+
+    /*! variable selection and write spacing */
+    LoadDist dist;
+
+    /*! Zipfian exponent */
+    double zipfExponent;
+
+    /*! number of writes per burst */
+    size_t burst;
+
+    /*! trial duration in seconds */
+    double duration;
+
+    /*! search for the maximum sustainable rate */
+    bool search;
+
+    /*! p99 latency budget for a sustainable rate */
+    uint64_t budgetNs;
+
+    /*! size of the rendering buffer (0 for the default) */
+    size_t varfpSize;
+
+    /*! trigger variables */
+    LoadVar *pVars;
+
+    /*! number of trigger variables */
+    size_t numVars;
+
+    /*! template sinks */
+    LoadSink *pSinks;
+
+    /*! number of template sinks */
+    size_t numSinks;
+
+    /*! index of the sink being set up */
+    size_t sink;
+
+    /*! Zipfian cumulative distribution over the variables */
+    double *pZipf;
+
+    /*! random number generator state */
+    uint64_t seed;
+
+    /*! sink read buffer */
+    char *pBuf;
+
+} LoadState;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! template service state under load */
+static TemplateSvcState state;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void usage( char *cmdname );
+static int ProcessOptions( int argC, char *argV[], LoadState *pLoad );
+static int SetupSink( JNode *pNode, void *arg );
+static int SetupVar( JNode *pNode, void *arg );
+static int OpenSink( LoadSink *pSink );
+static void CloseSink( LoadSink *pSink );
+static int SetupZipf( LoadState *pLoad );
+static int Search( LoadState *pLoad );
+static void RunTrial( LoadState *pLoad, LoadTrial *pTrial );
+static void Write( LoadState *pLoad, LoadTrial *pTrial, uint64_t due );
+static LoadVar *SelectVar( LoadState *pLoad );
+static int AddPending( LoadSink *pSink, uint64_t due );
+static void Drain( LoadState *pLoad, LoadTrial *pTrial );
+static void Arrive( LoadSink *pSink, LoadTrial *pTrial, uint64_t now );
+static bool Sustainable( LoadState *pLoad, LoadTrial *pTrial );
+static void Dispatch( void );
+static void ReportHeader( void );
+static void Report( LoadState *pLoad, LoadTrial *pTrial );
+static uint64_t Random( LoadState *pLoad );
+static uint64_t GetTimeNs( void );
+static void SleepUntil( uint64_t ns );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the templatesvc_load application
+
+    @param[in]
+        argc
+            number of arguments on the command line
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @retval 0 - the load was run
+    @retval 1 - the load could not be run
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    LoadState load;
+    JNode *config = NULL;
+    size_t i;
+    int result;
+
+    memset( &load, 0, sizeof( load ) );
+    load.rate = 1000.0;
+    load.dist = LOAD_UNIFORM;
+    load.zipfExponent = 1.0;
+    load.burst = 32;
+    load.duration = 2.0;
+    load.budgetNs = 10000000ULL;
+    load.seed = 0x9e3779b97f4a7c15ULL;
+
+    result = ProcessOptions( argc, argv, &load );
+    if ( result == EOK )
+    {
+        load.pBuf = malloc( LOAD_READ_SIZE );
+        result = ( load.pBuf != NULL ) ? EOK : ENOMEM;
+    }
+
+    if ( result == EOK )
+    {
+        TEMPLATESVC_Init( &state );
+        if ( load.varfpSize > 0 )
+        {
+            state.varfpSize = load.varfpSize;
+        }
+
+        result = TEMPLATESVC_Open( &state );
+        if ( result == EOK )
+        {
+            config = JSON_Process( load.pConfigFile );
+            result = ( config != NULL ) ? EOK : ENOENT;
+        }
+
+        if ( result == EOK )
+        {
+            /* create the trigger variables and the sinks before the
+               templates resolve and open them */
+            result = JSON_Iterate( (JArray *)JSON_Find( config, "config" ),
+                                   SetupSink,
+                                   (void *)&load );
+        }
+
+        if ( ( result == EOK ) &&
+             ( load.numVars == 0 ) )
+        {
+            fprintf( stderr, "templatesvc_load: no trigger variables\n" );
+            result = ENOENT;
+        }
+
+        if ( result == EOK )
+        {
+            result = SetupZipf( &load );
+        }
+
+        if ( result == EOK )
+        {
+            result = TEMPLATESVC_Load( &state, config );
+        }
+
+        if ( result == EOK )
+        {
+            result = Search( &load );
+        }
+
+        TEMPLATESVC_Close( &state );
+
+        for ( i = 0 ; i < load.numSinks ; i++ )
+        {
+            CloseSink( &load.pSinks[i] );
+        }
+    }
+
+    if ( result != EOK )
+    {
+        fprintf( stderr, "templatesvc_load: %s\n", strerror( result ) );
+    }
+
+    return ( result == EOK ) ? 0 : 1;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the application usage
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    if ( cmdname != NULL )
+    {
+        fprintf( stderr,
+                 "usage: %s [-r rate] [-d dist] [-z exponent] [-b burst]"
+                 " [-t secs] [-S] [-l us] [-s size] [-h] -f filename\n"
+                 " [-h] : display this help\n"
+                 " [-r] : writes per second (starting rate with -S)\n"
+                 " [-d] : distribution: uniform, zipf or burst\n"
+                 " [-z] : Zipfian exponent\n"
+                 " [-b] : writes per burst\n"
+                 " [-t] : duration of each trial in seconds\n"
+                 " [-S] : search for the maximum sustainable rate\n"
+                 " [-l] : p99 latency budget in microseconds\n"
+                 " [-s] : size of the rendering buffer\n"
+                 " -f <filename> : configuration file\n",
+                 cmdname );
+    }
+}
+
+/*============================================================================*/
+/*  ProcessOptions                                                            */
+/*!
+    Process the command line options
+
+    @param[in]
+        argC
+            number of arguments
+
+    @param[in]
+        argV
+            array of pointers to the command line arguments
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @retval EOK - the options were processed
+    @retval EINVAL - invalid options
+
+==============================================================================*/
+static int ProcessOptions( int argC, char *argV[], LoadState *pLoad )
+{
+    int result = EOK;
+    int c;
+
+    while ( ( c = getopt( argC, argV, "hr:d:z:b:t:Sl:s:f:" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'r':
+                pLoad->rate = strtod( optarg, NULL );
+                break;
+
+            case 'd':
+                if ( strcmp( optarg, "uniform" ) == 0 )
+                {
+                    pLoad->dist = LOAD_UNIFORM;
+                }
+                else if ( strcmp( optarg, "zipf" ) == 0 )
+                {
+                    pLoad->dist = LOAD_ZIPF;
+                }
+                else if ( strcmp( optarg, "burst" ) == 0 )
+                {
+                    pLoad->dist = LOAD_BURST;
+                }
+                else
+                {
+                    result = EINVAL;
+                }
+                break;
+
+            case 'z':
+                pLoad->zipfExponent = strtod( optarg, NULL );
+                break;
+
+            case 'b':
+                pLoad->burst = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 't':
+                pLoad->duration = strtod( optarg, NULL );
+                break;
+
+            case 'S':
+                pLoad->search = true;
+                break;
+
+            case 'l':
+                pLoad->budgetNs = strtoull( optarg, NULL, 0 ) * 1000ULL;
+                break;
+
+            case 's':
+                pLoad->varfpSize = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'f':
+                pLoad->pConfigFile = optarg;
+                break;
+
+            default:
+                result = EINVAL;
+                break;
+        }
+    }
+
+    if ( ( pLoad->pConfigFile == NULL ) ||
+         ( pLoad->rate <= 0.0 ) ||
+         ( pLoad->duration <= 0.0 ) ||
+         ( pLoad->burst == 0 ) ||
+         ( pLoad->burst > LOAD_MAX_BATCH ) )
+    {
+        result = EINVAL;
+    }
+
+    if ( result != EOK )
+    {
+        usage( argV[0] );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupSink                                                                 */
+/*!
+    Set up the sink and trigger variables of a template
+
+    The SetupSink function is a JSON_Iterate callback which opens the
+    sink for a template definition, and creates each of its trigger
+    variables in the mock variable server.  Templates without a target
+    are ignored.
+
+    @param[in]
+        pNode
+            pointer to the template definition node
+
+    @param[in]
+        arg
+            pointer to the load generator state
+
+    @retval EOK - the sink was set up
+    @retval ENOMEM - memory allocation failure
+    @retval other - the sink could not be opened
+
+==============================================================================*/
+static int SetupSink( JNode *pNode, void *arg )
+{
+    LoadState *pLoad = (LoadState *)arg;
+    LoadSink *pSinks;
+    LoadSink *pSink;
+    char *type;
+    int result = EOK;
+
+    if ( JSON_GetStr( pNode, "target" ) != NULL )
+    {
+        pSinks = realloc( pLoad->pSinks,
+                          ( pLoad->numSinks + 1 ) * sizeof( LoadSink ) );
+        if ( pSinks != NULL )
+        {
+            pLoad->pSinks = pSinks;
+            pSink = &pSinks[pLoad->numSinks];
+            memset( pSink, 0, sizeof( LoadSink ) );
+
+            type = JSON_GetStr( pNode, "type" );
+            pSink->type = ( ( type != NULL ) && ( strcmp( type, "mq" ) == 0 ) )
+                          ? TMPL_MQ
+                          : TMPL_FD;
+            pSink->target = JSON_GetStr( pNode, "target" );
+            pSink->fd = -1;
+            pSink->wfd = -1;
+            pSink->mq = (mqd_t)-1;
+
+            result = OpenSink( pSink );
+            if ( result == EOK )
+            {
+                pLoad->sink = pLoad->numSinks++;
+                result = JSON_Iterate( (JArray *)JSON_Find( pNode, "trigger" ),
+                                       SetupVar,
+                                       (void *)pLoad );
+            }
+            else
+            {
+                fprintf( stderr,
+                         "templatesvc_load: cannot open sink %s: %s\n",
+                         pSink->target,
+                         strerror( result ) );
+            }
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupVar                                                                  */
+/*!
+    Set up a trigger variable
+
+    The SetupVar function is a JSON_Iterate callback which creates a
+    trigger variable in the mock variable server, if it does not already
+    exist, and associates it with the sink being set up.
+
+    @param[in]
+        pNode
+            pointer to the trigger variable name node
+
+    @param[in]
+        arg
+            pointer to the load generator state
+
+    @retval EOK - the variable was set up
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - the trigger is not a variable name
+
+==============================================================================*/
+static int SetupVar( JNode *pNode, void *arg )
+{
+    LoadState *pLoad = (LoadState *)arg;
+    JVar *pVar = (JVar *)pNode;
+    LoadVar *pVars;
+    LoadVar *pLoadVar = NULL;
+    VarInfo info;
+    size_t *pSinks;
+    size_t i;
+    int result = EINVAL;
+
+    if ( ( pNode->type == JSON_VAR ) &&
+         ( pVar->var.type == JVARTYPE_STR ) &&
+         ( pVar->var.val.str != NULL ) )
+    {
+        memset( &info, 0, sizeof( info ) );
+        strncpy( info.name, pVar->var.val.str, MAX_NAME_LEN );
+        info.var.type = VARTYPE_UINT32;
+        info.var.len = sizeof( uint32_t );
+
+        result = VARSERVER_CreateVar( state.hVarServer, &info );
+        if ( result == EEXIST )
+        {
+            info.hVar = VAR_FindByName( state.hVarServer, info.name );
+            result = EOK;
+        }
+
+        for ( i = 0 ; ( result == EOK ) && ( i < pLoad->numVars ) ; i++ )
+        {
+            if ( pLoad->pVars[i].hVar == info.hVar )
+            {
+                pLoadVar = &pLoad->pVars[i];
+                break;
+            }
+        }
+
+        if ( ( result == EOK ) && ( pLoadVar == NULL ) )
+        {
+            pVars = realloc( pLoad->pVars,
+                             ( pLoad->numVars + 1 ) * sizeof( LoadVar ) );
+            if ( pVars != NULL )
+            {
+                pLoad->pVars = pVars;
+                pLoadVar = &pVars[pLoad->numVars++];
+                memset( pLoadVar, 0, sizeof( LoadVar ) );
+                pLoadVar->hVar = info.hVar;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pSinks = realloc( pLoadVar->pSinks,
+                              ( pLoadVar->numSinks + 1 ) * sizeof( size_t ) );
+            if ( pSinks != NULL )
+            {
+                pLoadVar->pSinks = pSinks;
+                pSinks[pLoadVar->numSinks++] = pLoad->sink;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  OpenSink                                                                  */
+/*!
+    Open a template sink for reading
+
+    FIFO sinks are created if the target does not exist, and a regular
+    file target is rejected, since its output cannot be timed.  Message
+    queue sinks are created if they do not exist.
+
+    @param[in]
+        pSink
+            pointer to the sink to open
+
+    @retval EOK - the sink was opened
+    @retval EEXIST - the target exists but is not a FIFO
+    @retval other - the sink could not be opened
+
+==============================================================================*/
+static int OpenSink( LoadSink *pSink )
+{
+    int result = EOK;
+    struct stat sb;
+
+    if ( pSink->type == TMPL_MQ )
+    {
+        pSink->mq = mq_open( pSink->target, O_RDONLY | O_NONBLOCK );
+        if ( ( pSink->mq == (mqd_t)-1 ) && ( errno == ENOENT ) )
+        {
+            pSink->mq = mq_open( pSink->target,
+                                 O_RDONLY | O_NONBLOCK | O_CREAT,
+                                 0644,
+                                 NULL );
+            pSink->created = true;
+        }
+
+        result = ( pSink->mq != (mqd_t)-1 ) ? EOK : errno;
+    }
+    else
+    {
+        if ( stat( pSink->target, &sb ) != 0 )
+        {
+            result = ( mkfifo( pSink->target, 0644 ) == 0 ) ? EOK : errno;
+            pSink->created = ( result == EOK );
+        }
+        else if ( S_ISFIFO( sb.st_mode ) == 0 )
+        {
+            result = EEXIST;
+        }
+
+        if ( result == EOK )
+        {
+            pSink->fd = open( pSink->target, O_RDONLY | O_NONBLOCK );
+            pSink->wfd = open( pSink->target, O_WRONLY | O_NONBLOCK );
+            if ( ( pSink->fd == -1 ) || ( pSink->wfd == -1 ) )
+            {
+                result = errno;
+            }
+#ifdef F_SETPIPE_SZ
+            else
+            {
+                /* the service blocks writing to a full FIFO */
+                (void)fcntl( pSink->fd, F_SETPIPE_SZ, LOAD_PIPE_SIZE );
+            }
+#endif
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CloseSink                                                                 */
+/*!
+    Close a template sink, and remove it if it was created by the load
+    generator
+
+    @param[in]
+        pSink
+            pointer to the sink to close
+
+==============================================================================*/
+static void CloseSink( LoadSink *pSink )
+{
+    if ( pSink->type == TMPL_MQ )
+    {
+        if ( pSink->mq != (mqd_t)-1 )
+        {
+            mq_close( pSink->mq );
+        }
+
+        if ( pSink->created == true )
+        {
+            mq_unlink( pSink->target );
+        }
+    }
+    else
+    {
+        if ( pSink->fd != -1 )
+        {
+            close( pSink->fd );
+        }
+
+        if ( pSink->wfd != -1 )
+        {
+            close( pSink->wfd );
+        }
+
+        if ( pSink->created == true )
+        {
+            unlink( pSink->target );
+        }
+    }
+
+    free( pSink->pPending );
+    pSink->pPending = NULL;
+}
+
+/*============================================================================*/
+/*  SetupZipf                                                                 */
+/*!
+    Build the Zipfian cumulative distribution over the trigger variables
+
+    The variable at index i is selected with a probability proportional
+    to 1 / ( i + 1 )^s, where s is the Zipfian exponent.
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @retval EOK - the distribution was built
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int SetupZipf( LoadState *pLoad )
+{
+    int result = EOK;
+    double sum = 0.0;
+    size_t i;
+
+    if ( pLoad->dist == LOAD_ZIPF )
+    {
+        pLoad->pZipf = malloc( pLoad->numVars * sizeof( double ) );
+        if ( pLoad->pZipf != NULL )
+        {
+            for ( i = 0 ; i < pLoad->numVars ; i++ )
+            {
+                sum += 1.0 / pow( (double)( i + 1 ), pLoad->zipfExponent );
+                pLoad->pZipf[i] = sum;
+            }
+
+            for ( i = 0 ; i < pLoad->numVars ; i++ )
+            {
+                pLoad->pZipf[i] /= sum;
+            }
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Search                                                                    */
+/*!
+    Run the load trials
+
+    Without the search option, a single trial is run at the target rate.
+    Otherwise the rate is doubled until a trial is not sustainable, and
+    then bisected between the highest sustainable and the lowest
+    unsustainable rates until they are within 5% of each other.
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @retval EOK - the trials were run
+
+==============================================================================*/
+static int Search( LoadState *pLoad )
+{
+    LoadTrial trial;
+    double rate = pLoad->rate;
+    double lo = 0.0;
+    double hi = 0.0;
+    int trials = 0;
+
+    ReportHeader();
+
+    do
+    {
+        memset( &trial, 0, sizeof( trial ) );
+        HIST_Init( &trial.latency );
+        trial.rate = rate;
+
+        RunTrial( pLoad, &trial );
+        Report( pLoad, &trial );
+
+        if ( Sustainable( pLoad, &trial ) == true )
+        {
+            lo = rate;
+            rate = ( hi > 0.0 ) ? ( lo + hi ) / 2.0 : rate * 2.0;
+        }
+        else
+        {
+            hi = rate;
+            rate = ( lo + hi ) / 2.0;
+        }
+
+        trials++;
+
+    } while ( ( pLoad->search == true ) &&
+              ( trials < LOAD_MAX_TRIALS ) &&
+              ( ( hi == 0.0 ) || ( ( hi - lo ) > hi * 0.05 ) ) );
+
+    if ( pLoad->search == true )
+    {
+        fprintf( stderr,
+                 "max sustainable rate: %.0f writes/s\n",
+                 lo );
+    }
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  RunTrial                                                                  */
+/*!
+    Run one load trial
+
+    The writes due at the current time are issued, up to LOAD_MAX_BATCH
+    at a time, and the resulting notifications are dispatched to the
+    template service before the sinks are read.  When the generator is
+    ahead of schedule it sleeps until the next write is due.  After the
+    last write, the remaining notifications are dispatched and any write
+    which has not reached its sinks is counted as lost.
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @param[in,out]
+        pTrial
+            pointer to the trial to run
+
+==============================================================================*/
+static void RunTrial( LoadState *pLoad, LoadTrial *pTrial )
+{
+    uint64_t interval;
+    uint64_t start;
+    uint64_t end;
+    uint64_t next;
+    uint64_t now;
+    size_t writes;
+    size_t n;
+    size_t i;
+
+    /* spacing between writes, or between bursts */
+    n = ( pLoad->dist == LOAD_BURST ) ? pLoad->burst : 1;
+    interval = (uint64_t)( 1e9 * (double)n / pTrial->rate );
+    if ( interval == 0 )
+    {
+        interval = 1;
+    }
+
+    start = GetTimeNs();
+    end = start + (uint64_t)( pLoad->duration * 1e9 );
+    next = start;
+
+    while ( next < end )
+    {
+        SleepUntil( next );
+
+        now = GetTimeNs();
+        writes = 0;
+        while ( ( next <= now ) &&
+                ( next < end ) &&
+                ( writes < LOAD_MAX_BATCH ) )
+        {
+            for ( i = 0 ; i < n ; i++ )
+            {
+                Write( pLoad, pTrial, next );
+            }
+
+            writes += n;
+            next += interval;
+        }
+
+        Dispatch();
+        Drain( pLoad, pTrial );
+    }
+
+    Dispatch();
+    Drain( pLoad, pTrial );
+
+    pTrial->elapsed = GetTimeNs() - start;
+
+    for ( i = 0 ; i < pLoad->numSinks ; i++ )
+    {
+        pTrial->lost += pLoad->pSinks[i].numPending;
+        pLoad->pSinks[i].numPending = 0;
+    }
+}
+
+/*============================================================================*/
+/*  Write                                                                     */
+/*!
+    Write a trigger variable
+
+    The selected variable is set to its next value, and the write is
+    queued on each sink the variable triggers.  If the signal queue is
+    full, the pending notifications are dispatched and the write is
+    retried.
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @param[in,out]
+        pTrial
+            pointer to the trial being run
+
+    @param[in]
+        due
+            time the write was scheduled for
+
+==============================================================================*/
+static void Write( LoadState *pLoad, LoadTrial *pTrial, uint64_t due )
+{
+    LoadVar *pVar;
+    VarObject obj;
+    size_t i;
+    int rc;
+
+    pVar = SelectVar( pLoad );
+
+    memset( &obj, 0, sizeof( obj ) );
+    obj.type = VARTYPE_UINT32;
+    obj.len = sizeof( uint32_t );
+    obj.val.ul = ++pVar->value;
+
+    rc = VAR_Set( state.hVarServer, pVar->hVar, &obj );
+    if ( rc == EAGAIN )
+    {
+        Dispatch();
+        Drain( pLoad, pTrial );
+        rc = VAR_Set( state.hVarServer, pVar->hVar, &obj );
+    }
+
+    if ( rc == EOK )
+    {
+        for ( i = 0 ; i < pVar->numSinks ; i++ )
+        {
+            AddPending( &pLoad->pSinks[pVar->pSinks[i]], due );
+        }
+    }
+
+    pTrial->writes++;
+}
+
+/*============================================================================*/
+/*  SelectVar                                                                 */
+/*!
+    Select the next trigger variable to write
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @retval pointer to the selected variable
+
+==============================================================================*/
+static LoadVar *SelectVar( LoadState *pLoad )
+{
+    double u;
+    size_t lo = 0;
+    size_t hi = pLoad->numVars - 1;
+    size_t mid;
+
+    if ( pLoad->pZipf != NULL )
+    {
+        /* find the first variable whose cumulative probability exceeds u */
+        u = (double)( Random( pLoad ) >> 11 ) / (double)( 1ULL << 53 );
+        while ( lo < hi )
+        {
+            mid = ( lo + hi ) / 2;
+            if ( pLoad->pZipf[mid] > u )
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+    }
+    else
+    {
+        lo = Random( pLoad ) % pLoad->numVars;
+    }
+
+    return &pLoad->pVars[lo];
+}
+
+/*============================================================================*/
+/*  AddPending                                                                */
+/*!
+    Queue an undelivered write on a sink
+
+    @param[in]
+        pSink
+            pointer to the sink
+
+    @param[in]
+        due
+            time the write was scheduled for
+
+    @retval EOK - the write was queued
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int AddPending( LoadSink *pSink, uint64_t due )
+{
+    int result = EOK;
+    uint64_t *p;
+    size_t size;
+
+    if ( pSink->numPending == pSink->maxPending )
+    {
+        size = ( pSink->maxPending > 0 ) ? pSink->maxPending * 2 : 1024;
+        p = realloc( pSink->pPending, size * sizeof( uint64_t ) );
+        if ( p != NULL )
+        {
+            pSink->pPending = p;
+            pSink->maxPending = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        pSink->pPending[pSink->numPending++] = due;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Drain                                                                     */
+/*!
+    Read all the output which has arrived at the sinks
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @param[in,out]
+        pTrial
+            pointer to the trial being run
+
+==============================================================================*/
+static void Drain( LoadState *pLoad, LoadTrial *pTrial )
+{
+    LoadSink *pSink;
+    size_t i;
+    ssize_t n;
+
+    for ( i = 0 ; i < pLoad->numSinks ; i++ )
+    {
+        pSink = &pLoad->pSinks[i];
+
+        if ( pSink->type == TMPL_MQ )
+        {
+            while ( mq_receive( pSink->mq,
+                                pLoad->pBuf,
+                                LOAD_READ_SIZE,
+                                NULL ) >= 0 )
+            {
+                Arrive( pSink, pTrial, GetTimeNs() );
+            }
+        }
+        else
+        {
+            /* a FIFO does not preserve render boundaries, so all the
+               output read at once is counted as one arrival */
+            n = 0;
+            while ( read( pSink->fd, pLoad->pBuf, LOAD_READ_SIZE ) > 0 )
+            {
+                n++;
+            }
+
+            if ( n > 0 )
+            {
+                Arrive( pSink, pTrial, GetTimeNs() );
+            }
+        }
+    }
+}
+
+/*============================================================================*/
+/*  Arrive                                                                    */
+/*!
+    Record the arrival of output at a sink
+
+    All the writes queued on the sink were made before the render which
+    produced the output, so they are all delivered by it.
+
+    @param[in]
+        pSink
+            pointer to the sink
+
+    @param[in,out]
+        pTrial
+            pointer to the trial being run
+
+    @param[in]
+        now
+            arrival time
+
+==============================================================================*/
+static void Arrive( LoadSink *pSink, LoadTrial *pTrial, uint64_t now )
+{
+    size_t i;
+
+    for ( i = 0 ; i < pSink->numPending ; i++ )
+    {
+        HIST_Record( &pTrial->latency, now - pSink->pPending[i] );
+    }
+
+    pSink->numPending = 0;
+    pTrial->arrivals++;
+}
+
+/*============================================================================*/
+/*  Sustainable                                                               */
+/*!
+    Determine if a trial rate was sustained
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @param[in]
+        pTrial
+            pointer to the completed trial
+
+    @retval true - every write was delivered at the target rate within
+                   the latency budget
+    @retval false - the rate was not sustained
+
+==============================================================================*/
+static bool Sustainable( LoadState *pLoad, LoadTrial *pTrial )
+{
+    double achieved = (double)pTrial->writes * 1e9 / (double)pTrial->elapsed;
+
+    return ( pTrial->lost == 0 ) &&
+           ( achieved >= pTrial->rate * LOAD_RATE_TOLERANCE ) &&
+           ( HIST_Percentile( &pTrial->latency, 0.99 ) <= pLoad->budgetNs );
+}
+
+/*============================================================================*/
+/*  Dispatch                                                                  */
+/*!
+    Dispatch all pending notifications to the template service
+
+==============================================================================*/
+static void Dispatch( void )
+{
+    sigset_t pending;
+    int sigval = 0;
+    int sig;
+
+    sigpending( &pending );
+    while ( sigismember( &pending, SIG_VAR_MODIFIED ) == 1 )
+    {
+        sig = VARSERVER_WaitSignal( &sigval );
+        TEMPLATESVC_HandleSignal( &state, sig, sigval );
+        sigpending( &pending );
+    }
+}
+
+/*============================================================================*/
+/*  ReportHeader                                                              */
+/*!
+    Print the trial results header
+
+==============================================================================*/
+static void ReportHeader( void )
+{
+    fprintf( stderr,
+             "%6s %6s %12s %10s %12s %10s %8s %10s %10s %10s %4s\n",
+             "vars", "sinks", "rate", "writes", "writes/s", "arrivals",
+             "lost", "p50(us)", "p99(us)", "max(us)", "ok" );
+}
+
+/*============================================================================*/
+/*  Report                                                                    */
+/*!
+    Print the results of a trial
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @param[in]
+        pTrial
+            pointer to the completed trial
+
+==============================================================================*/
+static void Report( LoadState *pLoad, LoadTrial *pTrial )
+{
+    double secs = (double)pTrial->elapsed / 1e9;
+
+    fprintf( stderr,
+             "%6zu %6zu %12.1f %10lu %12.1f %10lu %8lu"
+             " %10.2f %10.2f %10.2f %4s\n",
+             pLoad->numVars,
+             pLoad->numSinks,
+             pTrial->rate,
+             (unsigned long)pTrial->writes,
+             ( secs > 0 ) ? pTrial->writes / secs : 0.0,
+             (unsigned long)pTrial->arrivals,
+             (unsigned long)pTrial->lost,
+             HIST_Percentile( &pTrial->latency, 0.50 ) / 1e3,
+             HIST_Percentile( &pTrial->latency, 0.99 ) / 1e3,
+             pTrial->latency.max / 1e3,
+             Sustainable( pLoad, pTrial ) ? "yes" : "no" );
+}
+
+/*============================================================================*/
+/*  Random                                                                    */
+/*!
+    Generate a pseudo random number (xorshift64)
+
+    @param[in]
+        pLoad
+            pointer to the load generator state
+
+    @retval pseudo random number
+
+==============================================================================*/
+static uint64_t Random( LoadState *pLoad )
+{
+    uint64_t x = pLoad->seed;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    pLoad->seed = x;
+
+    return x;
+}
+
+/*============================================================================*/
+/*  GetTimeNs                                                                 */
+/*!
+    Get the monotonic time in ns
+
+    @retval monotonic time in ns
+
+==============================================================================*/
+static uint64_t GetTimeNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  SleepUntil                                                                */
+/*!
+    Sleep until a monotonic time
+
+    @param[in]
+        ns
+            monotonic time to wake up at
+
+==============================================================================*/
+static void SleepUntil( uint64_t ns )
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)( ns / 1000000000ULL );
+    ts.tv_nsec = (long)( ns % 1000000000ULL );
+
+    while ( clock_nanosleep( CLOCK_MONOTONIC,
+                             TIMER_ABSTIME,
+                             &ts,
+                             NULL ) == EINTR )
+    {
+    }
+}
+
+/*! @}
+ * end of templatesvc_load group */
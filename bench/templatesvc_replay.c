@@ -0,0 +1,929 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup templatesvc_replay templatesvc_replay
+ * @brief Replay a trigger capture through the template service
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file templatesvc_replay.c
+
+    Template Service Trigger Replay
+
+    The templatesvc_replay application replays a trigger capture recorded
+    by templatesvc (see the -c option) through the template service
+    dispatch and render pipeline, using the in-process mock variable
+    server as the value source, so a production trigger storm can be
+    reproduced on a development machine.
+
+    Every variable in the capture name table is created in the mock
+    variable server.  The capture is then replayed one render cycle at a
+    time: the values captured for the cycle are applied, the cycle's
+    MODIFIED notifications are injected, and the notifications are
+    dispatched to the template service.  If the capture does not hold
+    values, each numeric variable is incremented when it is modified.
+
+    Notifications are injected at their original times by default, or as
+    fast as possible with the -x option.  The replay reports the
+    notification and render throughput, and the latency from the time
+    each cycle's first notification was due to the time the cycle's
+    templates were delivered.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <varserver/varserver.h>
+#include <tjson/json.h>
+#include "templatesvc.h"
+#include "capture.h"
+#include "histogram.h"
+#include "mockvarserver.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! initial number of replay events */
+#define REPLAY_INITIAL_EVENTS       ( 1024 )
+
+/*! a replay event decoded from the capture */
+typedef struct replayEvent
+{
+    /*! capture record type (CYCLE, MODIFIED or VALUE) */
+    CaptureRecType type;
+
+    /*! time the signal was received, in ns since the capture started */
+    uint64_t timestamp;
+
+    /*! mock variable handle */
+    VAR_HANDLE hVar;
+
+    /*! captured value (VALUE events) */
+    VarObject value;
+
+} ReplayEvent;
+
+/*! replay state */
+typedef struct replayState
+{
+    /*! name of the template service configuration file */
+    char *pConfigFile;
+
+    /*! name of the capture file */
+    char *pCaptureFile;
+
+    /*! replay as fast as possible instead of at the original times */
+    bool fast;
+
+    /*! size of the rendering buffer (0 for the default) */
+    size_t varfpSize;
+
+    /*! capture flags */
+    uint32_t flags;
+
+    /*! replay events */
+    ReplayEvent *pEvents;
+
+    /*! number of replay events */
+    size_t numEvents;
+
+    /*! allocated number of replay events */
+    size_t maxEvents;
+
+    /*! map of captured variable handles to mock variable handles */
+    VAR_HANDLE *pHandles;
+
+    /*! number of entries in the handle map */
+    size_t numHandles;
+
+    /*! number of variables in the capture name table */
+    size_t vars;
+
+    /*! number of MODIFIED notifications replayed */
+    uint64_t signals;
+
+    /*! number of MODIFIED notifications for unwatched variables */
+    uint64_t ignored;
+
+    /*! number of render cycles replayed */
+    uint64_t cycles;
+
+    /*! cycle latency */
+    Histogram latency;
+
+} ReplayState;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! template service state under replay */
+static TemplateSvcState state;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void usage( char *cmdname );
+static int ProcessOptions( int argC, char *argV[], ReplayState *pReplay );
+static int LoadCapture( ReplayState *pReplay );
+static int AddVar( ReplayState *pReplay, const CaptureRecord *pRecord );
+static int AddEvent( ReplayState *pReplay, const CaptureRecord *pRecord );
+static VAR_HANDLE MapHandle( ReplayState *pReplay, VAR_HANDLE hVar );
+static int Replay( ReplayState *pReplay );
+static size_t ReplayCycle( ReplayState *pReplay, size_t idx, uint64_t start );
+static int Inject( ReplayState *pReplay, VAR_HANDLE hVar );
+static void Dispatch( void );
+static void Bump( VAR_HANDLE hVar );
+static void Report( ReplayState *pReplay, uint64_t ns );
+static uint64_t GetTimeNs( void );
+static void SleepUntil( uint64_t ns );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the templatesvc_replay application
+
+    @param[in]
+        argc
+            number of arguments on the command line
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @retval 0 - the capture was replayed
+    @retval 1 - the capture could not be replayed
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    ReplayState replay;
+    JNode *config;
+    int result;
+
+    memset( &replay, 0, sizeof( replay ) );
+    HIST_Init( &replay.latency );
+
+    result = ProcessOptions( argc, argv, &replay );
+    if ( result == EOK )
+    {
+        /* create the captured variables before the templates resolve them */
+        result = LoadCapture( &replay );
+    }
+
+    if ( result == EOK )
+    {
+        TEMPLATESVC_Init( &state );
+        if ( replay.varfpSize > 0 )
+        {
+            state.varfpSize = replay.varfpSize;
+        }
+
+        result = TEMPLATESVC_Open( &state );
+        if ( result == EOK )
+        {
+            config = JSON_Process( replay.pConfigFile );
+            result = ( config != NULL )
+                     ? TEMPLATESVC_Load( &state, config )
+                     : ENOENT;
+        }
+
+        if ( result == EOK )
+        {
+            result = Replay( &replay );
+        }
+
+        TEMPLATESVC_Close( &state );
+    }
+
+    if ( result != EOK )
+    {
+        fprintf( stderr, "templatesvc_replay: %s\n", strerror( result ) );
+    }
+
+    return ( result == EOK ) ? 0 : 1;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the application usage
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    if ( cmdname != NULL )
+    {
+        fprintf( stderr,
+                 "usage: %s [-x] [-s size] [-h] -f filename capture\n"
+                 " [-h] : display this help\n"
+                 " [-x] : replay as fast as possible\n"
+                 " [-s] : size of the rendering buffer\n"
+                 " -f <filename> : configuration file\n"
+                 " capture : capture file recorded with templatesvc -c\n",
+                 cmdname );
+    }
+}
+
+/*============================================================================*/
+/*  ProcessOptions                                                            */
+/*!
+    Process the command line options
+
+    @param[in]
+        argC
+            number of arguments
+
+    @param[in]
+        argV
+            array of pointers to the command line arguments
+
+    @param[in]
+        pReplay
+            pointer to the replay state
+
+    @retval EOK - the options were processed
+    @retval EINVAL - invalid options
+
+==============================================================================*/
+static int ProcessOptions( int argC, char *argV[], ReplayState *pReplay )
+{
+    int result = EOK;
+    int c;
+
+    while ( ( c = getopt( argC, argV, "hxs:f:" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'x':
+                pReplay->fast = true;
+                break;
+
+            case 's':
+                pReplay->varfpSize = strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'f':
+                pReplay->pConfigFile = optarg;
+                break;
+
+            default:
+                result = EINVAL;
+                break;
+        }
+    }
+
+    if ( optind < argC )
+    {
+        pReplay->pCaptureFile = argV[optind];
+    }
+
+    if ( ( pReplay->pConfigFile == NULL ) ||
+         ( pReplay->pCaptureFile == NULL ) )
+    {
+        result = EINVAL;
+    }
+
+    if ( result != EOK )
+    {
+        usage( argV[0] );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  LoadCapture                                                               */
+/*!
+    Load a capture file
+
+    The LoadCapture function reads the whole capture into memory, creates
+    a mock variable for every entry in the capture name table, and builds
+    the list of replay events.
+
+    @param[in]
+        pReplay
+            pointer to the replay state
+
+    @retval EOK - the capture was loaded
+    @retval ENOENT - the capture file could not be opened
+    @retval other - the capture could not be loaded
+
+==============================================================================*/
+static int LoadCapture( ReplayState *pReplay )
+{
+    int result = ENOENT;
+    Capture *pCapture;
+    CaptureRecord record;
+    int rc;
+
+    pCapture = CAPTURE_Open( pReplay->pCaptureFile );
+    if ( pCapture != NULL )
+    {
+        result = EOK;
+        pReplay->flags = CAPTURE_GetFlags( pCapture );
+
+        while ( ( result == EOK ) &&
+                ( ( rc = CAPTURE_Read( pCapture, &record ) ) == EOK ) )
+        {
+            switch( record.type )
+            {
+                case CAPTURE_REC_VAR:
+                    result = AddVar( pReplay, &record );
+                    break;
+
+                case CAPTURE_REC_CYCLE:
+                case CAPTURE_REC_MODIFIED:
+                case CAPTURE_REC_VALUE:
+                    result = AddEvent( pReplay, &record );
+                    break;
+
+                default:
+                    /* PRINT notifications need a client to print to */
+                    break;
+            }
+        }
+
+        if ( ( result == EOK ) && ( rc != ENOENT ) )
+        {
+            result = rc;
+        }
+
+        CAPTURE_Close( pCapture );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  AddVar                                                                    */
+/*!
+    Create a mock variable for a capture name table entry
+
+    Variables of unknown type are created as uint32 variables.
+
+    @param[in]
+        pReplay
+            pointer to the replay state
+
+    @param[in]
+        pRecord
+            pointer to the VAR record
+
+    @retval EOK - the variable was created
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int AddVar( ReplayState *pReplay, const CaptureRecord *pRecord )
+{
+    int result = ENOMEM;
+    VarObject obj;
+    VAR_HANDLE *p;
+    size_t size;
+
+    if ( pRecord->hVar >= pReplay->numHandles )
+    {
+        size = ( pReplay->numHandles > 0 ) ? pReplay->numHandles : 256;
+        while ( size <= pRecord->hVar )
+        {
+            size *= 2;
+        }
+
+        p = realloc( pReplay->pHandles, size * sizeof( VAR_HANDLE ) );
+        if ( p != NULL )
+        {
+            memset( &p[pReplay->numHandles],
+                    0,
+                    ( size - pReplay->numHandles ) * sizeof( VAR_HANDLE ) );
+            pReplay->pHandles = p;
+            pReplay->numHandles = size;
+        }
+    }
+
+    if ( pRecord->hVar < pReplay->numHandles )
+    {
+        memset( &obj, 0, sizeof( obj ) );
+        obj.type = pRecord->value.type;
+
+        switch( obj.type )
+        {
+            case VARTYPE_UINT16:
+            case VARTYPE_INT16:
+            case VARTYPE_UINT32:
+            case VARTYPE_INT32:
+            case VARTYPE_UINT64:
+            case VARTYPE_INT64:
+            case VARTYPE_FLOAT:
+                obj.len = sizeof( obj.val );
+                break;
+
+            case VARTYPE_STR:
+                obj.val.str = "";
+                obj.len = 1;
+                break;
+
+            default:
+                obj.type = VARTYPE_UINT32;
+                obj.len = sizeof( uint32_t );
+                break;
+        }
+
+        pReplay->pHandles[pRecord->hVar] = MOCK_AddVar( pRecord->name, &obj );
+        if ( pReplay->pHandles[pRecord->hVar] != VAR_INVALID )
+        {
+            pReplay->vars++;
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  AddEvent                                                                  */
+/*!
+    Add a CYCLE, MODIFIED or VALUE record to the replay events
+
+    @param[in]
+        pReplay
+            pointer to the replay state
+
+    @param[in]
+        pRecord
+            pointer to the capture record
+
+    @retval EOK - the event was added
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int AddEvent( ReplayState *pReplay, const CaptureRecord *pRecord )
+{
+    int result = EOK;
+    ReplayEvent *p;
+    ReplayEvent *pEvent;
+    size_t size;
+
+    if ( pReplay->numEvents == pReplay->maxEvents )
+    {
+        size = ( pReplay->maxEvents > 0 )
+               ? pReplay->maxEvents * 2
+               : REPLAY_INITIAL_EVENTS;
+
+        p = realloc( pReplay->pEvents, size * sizeof( ReplayEvent ) );
+        if ( p != NULL )
+        {
+            pReplay->pEvents = p;
+            pReplay->maxEvents = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        pEvent = &pReplay->pEvents[pReplay->numEvents];
+        pEvent->type = pRecord->type;
+        pEvent->timestamp = pRecord->timestamp;
+        pEvent->hVar = MapHandle( pReplay, pRecord->hVar );
+        pEvent->value = pRecord->value;
+
+        if ( ( pRecord->type == CAPTURE_REC_VALUE ) &&
+             ( pRecord->value.type == VARTYPE_STR ) )
+        {
+            /* the record's string is only valid until the next read */
+            pEvent->value.val.str = strdup( pRecord->value.val.str );
+            if ( pEvent->value.val.str == NULL )
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pReplay->numEvents++;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  MapHandle                                                                 */
+/*!
+    Map a captured variable handle to its mock variable handle
+
+    @param[in]
+        pReplay
+            pointer to the replay state
+
+    @param[in]
+        hVar
+            captured variable handle
+
+    @retval mock variable handle
+    @retval VAR_INVALID if the variable is not in the capture name table
+
+==============================================================================*/
+static VAR_HANDLE MapHandle( ReplayState *pReplay, VAR_HANDLE hVar )
+{
+    return ( hVar < pReplay->numHandles ) ? pReplay->pHandles[hVar]
+                                          : VAR_INVALID;
+}
+
+/*============================================================================*/
+/*  Replay                                                                    */
+/*!
+    Replay the capture events
+
+    @param[in]
+        pReplay
+            pointer to the replay state
+
+    @retval EOK - the capture was replayed
+
+==============================================================================*/
+static int Replay( ReplayState *pReplay )
+{
+    uint64_t start;
+    size_t idx = 0;
+    ReplayEvent *pEvent;
+
+    start = GetTimeNs();
+
+    while ( idx < pReplay->numEvents )
+    {
+        pEvent = &pReplay->pEvents[idx];
+        if ( pEvent->type == CAPTURE_REC_CYCLE )
+        {
+            idx = ReplayCycle( pReplay, idx + 1, start );
+        }
+        else
+        {
+            /* a value fetched outside of a render cycle */
+            if ( pEvent->type == CAPTURE_REC_VALUE )
+            {
+                MOCK_SetVar( pEvent->hVar, &pEvent->value );
+            }
+
+            idx++;
+        }
+    }
+
+    Report( pReplay, GetTimeNs() - start );
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  ReplayCycle                                                               */
+/*!
+    Replay one render cycle
+
+    A render cycle holds the MODIFIED events batched into the cycle,
+    and the VALUE events recorded while the cycle's templates were
+    fetched.  The values are applied first, so the templates render the
+    captured values.  The MODIFIED events are then injected at their
+    original times (unless replaying as fast as possible), and dispatched
+    to the template service together.
+
+    @param[in]
+        pReplay
+            pointer to the replay state
+
+    @param[in]
+        idx
+            index of the first event after the cycle's CYCLE event
+
+    @param[in]
+        start
+            time the replay started
+
+    @retval index of the first event after the cycle
+
+==============================================================================*/
+static size_t ReplayCycle( ReplayState *pReplay, size_t idx, uint64_t start )
+{
+    ReplayEvent *pEvents = pReplay->pEvents;
+    size_t end = idx;
+    size_t i;
+    bool first = true;
+    uint64_t due = 0;
+    uint64_t now;
+
+    while ( ( end < pReplay->numEvents ) &&
+            ( pEvents[end].type != CAPTURE_REC_CYCLE ) )
+    {
+        if ( pEvents[end].type == CAPTURE_REC_VALUE )
+        {
+            MOCK_SetVar( pEvents[end].hVar, &pEvents[end].value );
+        }
+
+        end++;
+    }
+
+    for ( i = idx ; i < end ; i++ )
+    {
+        if ( pEvents[i].type == CAPTURE_REC_MODIFIED )
+        {
+            if ( pReplay->fast == false )
+            {
+                SleepUntil( start + pEvents[i].timestamp );
+            }
+
+            if ( first == true )
+            {
+                /* latency is measured from when the cycle was due */
+                now = GetTimeNs();
+                due = ( pReplay->fast == false )
+                      ? start + pEvents[i].timestamp
+                      : now;
+                if ( due > now )
+                {
+                    due = now;
+                }
+
+                first = false;
+            }
+
+            if ( ( pReplay->flags & CAPTURE_VALUES ) == 0 )
+            {
+                Bump( pEvents[i].hVar );
+            }
+
+            Inject( pReplay, pEvents[i].hVar );
+        }
+    }
+
+    if ( first == false )
+    {
+        Dispatch();
+
+        HIST_Record( &pReplay->latency, GetTimeNs() - due );
+        pReplay->cycles++;
+    }
+
+    return end;
+}
+
+/*============================================================================*/
+/*  Inject                                                                    */
+/*!
+    Inject a MODIFIED notification
+
+    If the signal queue is full, the pending notifications are dispatched
+    and the injection is retried.
+
+    @param[in]
+        pReplay
+            pointer to the replay state
+
+    @param[in]
+        hVar
+            mock variable handle
+
+    @retval result of MOCK_InjectModified
+
+==============================================================================*/
+static int Inject( ReplayState *pReplay, VAR_HANDLE hVar )
+{
+    int result;
+
+    result = MOCK_InjectModified( hVar );
+    if ( result == EAGAIN )
+    {
+        Dispatch();
+        result = MOCK_InjectModified( hVar );
+    }
+
+    if ( result == EOK )
+    {
+        pReplay->signals++;
+    }
+    else
+    {
+        pReplay->ignored++;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Dispatch                                                                  */
+/*!
+    Dispatch all pending notifications to the template service
+
+==============================================================================*/
+static void Dispatch( void )
+{
+    sigset_t pending;
+    int sigval = 0;
+    int sig;
+
+    sigpending( &pending );
+    while ( sigismember( &pending, SIG_VAR_MODIFIED ) == 1 )
+    {
+        sig = VARSERVER_WaitSignal( &sigval );
+        TEMPLATESVC_HandleSignal( &state, sig, sigval );
+        sigpending( &pending );
+    }
+}
+
+/*============================================================================*/
+/*  Bump                                                                      */
+/*!
+    Increment the value of a numeric mock variable
+
+    @param[in]
+        hVar
+            mock variable handle
+
+==============================================================================*/
+static void Bump( VAR_HANDLE hVar )
+{
+    VarObject obj;
+
+    if ( VAR_Get( state.hVarServer, hVar, &obj ) == EOK )
+    {
+        switch( obj.type )
+        {
+            case VARTYPE_UINT16:
+                obj.val.ui++;
+                break;
+
+            case VARTYPE_INT16:
+                obj.val.i++;
+                break;
+
+            case VARTYPE_UINT32:
+                obj.val.ul++;
+                break;
+
+            case VARTYPE_INT32:
+                obj.val.l++;
+                break;
+
+            case VARTYPE_UINT64:
+                obj.val.ull++;
+                break;
+
+            case VARTYPE_INT64:
+                obj.val.ll++;
+                break;
+
+            case VARTYPE_FLOAT:
+                obj.val.f += 1.0f;
+                break;
+
+            default:
+                break;
+        }
+
+        if ( obj.type != VARTYPE_STR )
+        {
+            MOCK_SetVar( hVar, &obj );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  Report                                                                    */
+/*!
+    Print the replay results
+
+    @param[in]
+        pReplay
+            pointer to the replay state
+
+    @param[in]
+        ns
+            elapsed replay time
+
+==============================================================================*/
+static void Report( ReplayState *pReplay, uint64_t ns )
+{
+    Template *pTemplate;
+    uint64_t renders = 0;
+    double secs = (double)ns / 1e9;
+
+    for ( pTemplate = state.pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pTemplate->pNext )
+    {
+        renders += pTemplate->renders;
+    }
+
+    fprintf( stderr,
+             "%8s %10s %8s %8s %10s %10s %12s %10s %10s %10s\n",
+             "vars", "signals", "ignored", "cycles", "renders",
+             "elapsed(s)", "signals/s", "renders/s", "p50(us)", "p99(us)" );
+
+    fprintf( stderr,
+             "%8zu %10lu %8lu %8lu %10lu %10.3f %12.1f %10.1f %10.2f %10.2f\n",
+             pReplay->vars,
+             (unsigned long)pReplay->signals,
+             (unsigned long)pReplay->ignored,
+             (unsigned long)pReplay->cycles,
+             (unsigned long)renders,
+             secs,
+             ( secs > 0 ) ? pReplay->signals / secs : 0.0,
+             ( secs > 0 ) ? renders / secs : 0.0,
+             HIST_Percentile( &pReplay->latency, 0.50 ) / 1e3,
+             HIST_Percentile( &pReplay->latency, 0.99 ) / 1e3 );
+}
+
+/*============================================================================*/
+/*  GetTimeNs                                                                 */
+/*!
+    Get the monotonic time in ns
+
+    @retval monotonic time in ns
+
+==============================================================================*/
+static uint64_t GetTimeNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  SleepUntil                                                                */
+/*!
+    Sleep until a monotonic time
+
+    @param[in]
+        ns
+            monotonic time to wake up at
+
+==============================================================================*/
+static void SleepUntil( uint64_t ns )
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)( ns / 1000000000ULL );
+    ts.tv_nsec = (long)( ns % 1000000000ULL );
+
+    while ( clock_nanosleep( CLOCK_MONOTONIC,
+                             TIMER_ABSTIME,
+                             &ts,
+                             NULL ) == EINTR )
+    {
+    }
+}
+
+/*! @}
+ * end of templatesvc_replay group */
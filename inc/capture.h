@@ -0,0 +1,110 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <varserver/varserver.h>
+#include "varcache.h"
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! capture flag: the fetched variable values are captured */
+#define CAPTURE_VALUES          ( 1U << 0 )
+
+/*! capture record types */
+typedef enum captureRecType
+{
+    /*! variable name table entry */
+    CAPTURE_REC_VAR = 1,
+
+    /*! SIG_VAR_MODIFIED notification */
+    CAPTURE_REC_MODIFIED = 2,
+
+    /*! SIG_VAR_PRINT notification */
+    CAPTURE_REC_PRINT = 3,
+
+    /*! fetched variable value */
+    CAPTURE_REC_VALUE = 4,
+
+    /*! start of a render cycle */
+    CAPTURE_REC_CYCLE = 5
+
+} CaptureRecType;
+
+/*! a decoded capture record */
+typedef struct captureRecord
+{
+    /*! record type */
+    CaptureRecType type;
+
+    /*! time the signal was received, in ns since the capture started */
+    uint64_t timestamp;
+
+    /*! variable handle (VAR, MODIFIED and VALUE records) */
+    VAR_HANDLE hVar;
+
+    /*! print session identifier (PRINT records) */
+    int32_t id;
+
+    /*! variable name (VAR records) */
+    char name[MAX_NAME_LEN + 1];
+
+    /*! variable type (VAR records) or value (VALUE records).  String
+        values remain valid until the next record is read */
+    VarObject value;
+
+} CaptureRecord;
+
+/*! opaque capture file object */
+typedef struct capture Capture;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+Capture *CAPTURE_Create( const char *fileName, uint32_t flags );
+Capture *CAPTURE_Open( const char *fileName );
+uint32_t CAPTURE_GetFlags( Capture *pCapture );
+int CAPTURE_Var( Capture *pCapture,
+                 VAR_HANDLE hVar,
+                 VarType type,
+                 const char *name );
+int CAPTURE_Cycle( Capture *pCapture );
+int CAPTURE_Modified( Capture *pCapture, VAR_HANDLE hVar, const char *name );
+int CAPTURE_Print( Capture *pCapture, int32_t id );
+int CAPTURE_Value( Capture *pCapture, const VarEntry *pEntry );
+int CAPTURE_Read( Capture *pCapture, CaptureRecord *pRecord );
+int CAPTURE_Close( Capture *pCapture );
+
+#endif
@@ -0,0 +1,101 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "arena.h"
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! specifies the output compression algorithm */
+typedef enum compressType
+{
+    /*! no compression */
+    COMPRESS_NONE = 0,
+
+    /*! zstandard frame per render */
+    COMPRESS_ZSTD = 1,
+
+    /*! LZ4 frame per render */
+    COMPRESS_LZ4 = 2
+
+} CompressType;
+
+/*! compression statistics accumulated over all renders */
+typedef struct compressStats
+{
+    /*! number of frames generated */
+    uint64_t frames;
+
+    /*! total number of uncompressed bytes */
+    uint64_t bytesIn;
+
+    /*! total number of compressed bytes */
+    uint64_t bytesOut;
+
+    /*! total time spent compressing (nanoseconds) */
+    uint64_t ns;
+
+    /*! uncompressed size of the last frame */
+    size_t lastIn;
+
+    /*! compressed size of the last frame */
+    size_t lastOut;
+
+    /*! compression time of the last frame (nanoseconds) */
+    uint64_t lastNs;
+
+} CompressStats;
+
+/*! opaque compressor object */
+typedef struct compressor Compressor;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+CompressType COMPRESS_TypeFromName( const char *name );
+const char *COMPRESS_Name( CompressType type );
+Compressor *COMPRESS_Create( CompressType type );
+int COMPRESS_Frame( Compressor *pCompressor,
+                    Arena *pArena,
+                    const char *pIn,
+                    size_t inlen,
+                    const char **ppOut,
+                    size_t *pOutlen );
+int COMPRESS_Update( Compressor *pCompressor, const char *pIn, size_t inlen );
+void COMPRESS_Abort( Compressor *pCompressor );
+const CompressStats *COMPRESS_GetStats( Compressor *pCompressor );
+void COMPRESS_Delete( Compressor *pCompressor );
+
+#endif
@@ -0,0 +1,155 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef CONFCACHE_H
+#define CONFCACHE_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! a trigger of a template definition */
+typedef struct confTrigger
+{
+    /*! trigger variable name */
+    char *name;
+
+    /*! condition of the trigger (see TriggerCondition) */
+    uint32_t condition;
+
+    /*! deadband width, or level, of the condition */
+    double level;
+
+} ConfTrigger;
+
+/*! a template definition, as read from the service configuration */
+typedef struct confTemplate
+{
+    /*! template name (NULL if not specified) */
+    char *name;
+
+    /*! template file name */
+    char *template;
+
+    /*! template type ("fd" or "mq") */
+    char *type;
+
+    /*! target destination name */
+    char *target;
+
+    /*! output compression algorithm name */
+    char *compress;
+
+    /*! structured output format name */
+    char *format;
+
+    /*! structured output variable name prefix */
+    char *prefix;
+
+    /*! transaction commit variable name */
+    char *commit;
+
+    /*! append (true) or overwrite (false) */
+    bool append;
+
+    /*! keep the destination open */
+    bool keep_open;
+
+    /*! only re-format variables which changed since the last render */
+    bool incremental;
+
+    /*! format numeric values natively */
+    bool nativeFormat;
+
+    /*! periodic render interval in milliseconds (0 if not periodic) */
+    uint32_t intervalMs;
+
+    /*! array of triggers */
+    ConfTrigger *pTriggers;
+
+    /*! number of triggers */
+    size_t numTriggers;
+
+    /*! array of structured output variable names */
+    char **pVars;
+
+    /*! number of structured output variable names */
+    size_t numVars;
+
+    /*! derive the triggers from the variables the template references */
+    bool autoTrigger;
+
+    /*! array of variable names excluded from the derived triggers */
+    char **pExclude;
+
+    /*! number of excluded variable names */
+    size_t numExclude;
+
+} ConfTemplate;
+
+/*! the rule set attributes of a configuration file */
+typedef struct confTenant
+{
+    /*! tenant name (NULL to name the tenant after the file) */
+    char *name;
+
+    /*! render priority (higher priority tenants render first) */
+    int32_t priority;
+
+    /*! maximum number of templates (0 if unlimited) */
+    uint32_t maxTemplates;
+
+    /*! maximum number of renders per second (0 if unlimited) */
+    uint32_t maxRendersPerSec;
+
+} ConfTenant;
+
+/*! opaque compiled configuration cache object */
+typedef struct confCache ConfCache;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+ConfCache *CONFCACHE_Create( const char *fileName, const char *configName );
+int CONFCACHE_Add( ConfCache *pCache, const ConfTemplate *pDef );
+int CONFCACHE_SetTenant( ConfCache *pCache, const ConfTenant *pTenant );
+int CONFCACHE_Save( ConfCache *pCache );
+ConfCache *CONFCACHE_Open( const char *fileName, const char *configName );
+size_t CONFCACHE_Count( ConfCache *pCache );
+int CONFCACHE_Get( ConfCache *pCache, size_t idx, ConfTemplate *pDef );
+int CONFCACHE_GetTenant( ConfCache *pCache, ConfTenant *pTenant );
+void CONFCACHE_FreeDefinition( ConfTemplate *pDef );
+void CONFCACHE_Close( ConfCache *pCache );
+
+#endif
@@ -0,0 +1,73 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef CONFDIR_H
+#define CONFDIR_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stddef.h>
+#include <tjson/json.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! a configuration file of a configuration directory */
+typedef struct confFile
+{
+    /*! path of the configuration file */
+    char *path;
+
+    /*! parsed configuration (NULL if the file could not be parsed) */
+    JNode *config;
+
+    /*! result of parsing and preparing the file */
+    int result;
+
+    /*! data prepared from the configuration by the parse callback */
+    void *pData;
+
+} ConfFile;
+
+/*! callback which prepares a parsed configuration file on a worker thread */
+typedef int (*ConfFileFn)( ConfFile *pFile, void *arg );
+
+/*! opaque configuration directory object */
+typedef struct confDir ConfDir;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+ConfDir *CONFDIR_Open( const char *dirName );
+int CONFDIR_Parse( ConfDir *pDir, size_t threads, ConfFileFn fn, void *arg );
+size_t CONFDIR_Count( ConfDir *pDir );
+ConfFile *CONFDIR_Get( ConfDir *pDir, size_t idx );
+void CONFDIR_Close( ConfDir *pDir );
+
+#endif
@@ -0,0 +1,106 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! opaque event loop object */
+typedef struct eventLoop EventLoop;
+
+/*! opaque event loop timer object */
+typedef struct eventSource EventTimer;
+
+/*! called when a file descriptor is ready */
+typedef void (*EventFdHandler)( EventLoop *pLoop,
+                                int fd,
+                                uint32_t events,
+                                void *arg );
+
+/*! called when a signal is received */
+typedef void (*EventSignalHandler)( EventLoop *pLoop,
+                                    int sig,
+                                    int sigval,
+                                    void *arg );
+
+/*! called when a timer expires */
+typedef void (*EventTimerHandler)( EventLoop *pLoop,
+                                   EventTimer *pTimer,
+                                   uint64_t expirations,
+                                   void *arg );
+
+/*! called when a watched path changes */
+typedef void (*EventWatchHandler)( EventLoop *pLoop,
+                                   uint32_t mask,
+                                   const char *name,
+                                   void *arg );
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+EventLoop *EVENTLOOP_Create( void );
+int EVENTLOOP_AddFd( EventLoop *pLoop,
+                     int fd,
+                     uint32_t events,
+                     EventFdHandler fn,
+                     void *arg );
+int EVENTLOOP_ModifyFd( EventLoop *pLoop, int fd, uint32_t events );
+int EVENTLOOP_RemoveFd( EventLoop *pLoop, int fd );
+int EVENTLOOP_AddSignal( EventLoop *pLoop,
+                         int sig,
+                         EventSignalHandler fn,
+                         void *arg );
+EventTimer *EVENTLOOP_CreateTimer( EventLoop *pLoop,
+                                   EventTimerHandler fn,
+                                   void *arg );
+int EVENTLOOP_SetTimer( EventTimer *pTimer,
+                        uint64_t initialNs,
+                        uint64_t intervalNs );
+void EVENTLOOP_DeleteTimer( EventLoop *pLoop, EventTimer *pTimer );
+int EVENTLOOP_AddWatch( EventLoop *pLoop,
+                        const char *path,
+                        uint32_t mask,
+                        EventWatchHandler fn,
+                        void *arg );
+void EVENTLOOP_RemoveWatches( EventLoop *pLoop, void *arg );
+int EVENTLOOP_RunOnce( EventLoop *pLoop, int timeoutMs );
+int EVENTLOOP_Run( EventLoop *pLoop );
+void EVENTLOOP_Stop( EventLoop *pLoop );
+void EVENTLOOP_Destroy( EventLoop *pLoop );
+
+#endif
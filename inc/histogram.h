@@ -0,0 +1,83 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! number of sub-bucket bits per power of two (relative error <= 1/16) */
+#define HIST_SUB_BITS           ( 4 )
+
+/*! number of sub-buckets per power of two */
+#define HIST_SUB_BUCKETS        ( 1U << HIST_SUB_BITS )
+
+/*! largest recorded power of two (values above 2^36 ns share a bucket) */
+#define HIST_MAX_EXPONENT       ( 36 )
+
+/*! total number of histogram buckets */
+#define HIST_NUM_BUCKETS \
+    ( ( HIST_MAX_EXPONENT - HIST_SUB_BITS + 2 ) * HIST_SUB_BUCKETS )
+
+/*! log-linear histogram of unsigned values */
+typedef struct histogram
+{
+    /*! number of recorded values */
+    uint64_t count;
+
+    /*! sum of the recorded values */
+    uint64_t sum;
+
+    /*! smallest recorded value */
+    uint64_t min;
+
+    /*! largest recorded value */
+    uint64_t max;
+
+    /*! bucket counters */
+    uint32_t buckets[HIST_NUM_BUCKETS];
+
+} Histogram;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+void HIST_Init( Histogram *pHist );
+void HIST_Record( Histogram *pHist, uint64_t value );
+uint64_t HIST_Percentile( const Histogram *pHist, double q );
+uint64_t HIST_Mean( const Histogram *pHist );
+int HIST_Print( const Histogram *pHist, int fd );
+
+#endif
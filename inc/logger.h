@@ -0,0 +1,83 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! log levels, in increasing order of verbosity */
+typedef enum loggerLevel
+{
+    /*! failures which affect the service output */
+    LOGGER_ERROR = 0,
+
+    /*! recoverable problems */
+    LOGGER_WARNING = 1,
+
+    /*! operational information (-v) */
+    LOGGER_INFO = 2,
+
+    /*! per-render tracing (-vv) */
+    LOGGER_DEBUG = 3
+
+} LoggerLevel;
+
+/*! logger counters */
+typedef struct loggerStats
+{
+    /*! number of records written */
+    uint64_t written;
+
+    /*! number of records dropped because the ring was full */
+    uint64_t dropped;
+
+    /*! number of records suppressed by the rate limiter */
+    uint64_t suppressed;
+
+} LoggerStats;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+int LOGGER_Open( LoggerLevel level, int fd );
+void LOGGER_SetLevel( LoggerLevel level );
+bool LOGGER_Enabled( LoggerLevel level );
+void LOGGER_Log( LoggerLevel level, const char *fmt, ... )
+    __attribute__(( format( printf, 2, 3 ) ));
+void LOGGER_GetStats( LoggerStats *pStats );
+void LOGGER_Close( void );
+
+#endif
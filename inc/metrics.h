@@ -0,0 +1,83 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef METRICS_H
+#define METRICS_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <varserver/varserver.h>
+#include "histogram.h"
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! per-template metric identifiers */
+typedef enum metricId
+{
+    /*! time from trigger notification to output delivered */
+    METRIC_LATENCY = 0,
+
+    /*! time spent compiling, fetching and rendering */
+    METRIC_RENDER,
+
+    /*! time spent compressing and writing to the target */
+    METRIC_SINK,
+
+    /*! number of per-template metrics */
+    METRIC_COUNT
+
+} MetricId;
+
+/*! opaque per-template metrics object */
+typedef struct templateMetrics TemplateMetrics;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+uint64_t METRICS_Now( void );
+TemplateMetrics *METRICS_Create( VARSERVER_HANDLE hVarServer,
+                                 const char *prefix,
+                                 const char *name,
+                                 bool compressed );
+void METRICS_Record( TemplateMetrics *pMetrics, MetricId id, uint64_t ns );
+void METRICS_Compressed( TemplateMetrics *pMetrics,
+                         size_t in,
+                         size_t out,
+                         uint64_t ns );
+void METRICS_Filtered( TemplateMetrics *pMetrics );
+void METRICS_Throttled( TemplateMetrics *pMetrics );
+const Histogram *METRICS_Get( TemplateMetrics *pMetrics, MetricId id );
+int METRICS_Print( TemplateMetrics *pMetrics, VAR_HANDLE hVar, int fd );
+void METRICS_Delete( TemplateMetrics *pMetrics );
+
+#endif
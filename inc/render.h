@@ -0,0 +1,157 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef RENDER_H
+#define RENDER_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <time.h>
+#include <varserver/varserver.h>
+#include "varcache.h"
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! template segment types */
+typedef enum segType
+{
+    /*! literal text */
+    SEG_TEXT = 0,
+
+    /*! variable reference */
+    SEG_VAR = 1
+
+} SegType;
+
+/*! a compiled template segment */
+typedef struct segment
+{
+    /*! segment type */
+    SegType type;
+
+    /*! offset of the segment text in the template source */
+    size_t offset;
+
+    /*! length of the segment text in the template source */
+    size_t len;
+
+    /*! name of the referenced variable */
+    char *name;
+
+    /*! handle of the referenced variable */
+    VAR_HANDLE hVar;
+
+    /*! variable cache entry of the referenced variable */
+    VarEntry *pEntry;
+
+} Segment;
+
+/*! a template file compiled into a list of text and variable segments */
+typedef struct compiledTemplate
+{
+    /*! name of the template file */
+    char *fileName;
+
+    /*! template file content */
+    char *pSource;
+
+    /*! length of the template file content */
+    size_t sourceLen;
+
+    /*! array of template segments */
+    Segment *pSegments;
+
+    /*! number of template segments */
+    size_t numSegments;
+
+    /*! template file modification time when it was compiled */
+    struct timespec mtime;
+
+    /*! template file inode when it was compiled */
+    ino_t ino;
+
+    /*! template file size when it was compiled */
+    off_t size;
+
+    /*! variable cache used to resolve variable references */
+    VarCache *pVarCache;
+
+    /*! watch all referenced variables so unmodified values are re-used */
+    bool incremental;
+
+    /*! format numeric values natively rather than as the variable server
+        prints them */
+    bool nativeFormat;
+
+} CompiledTemplate;
+
+/*! consumer of the rendered output when the render buffer is full */
+typedef int (*RenderFlush)( const char *pData, size_t len, void *arg );
+
+/*! rendering output buffer */
+typedef struct renderBuf
+{
+    /*! pointer to the output memory */
+    char *pBuf;
+
+    /*! size of the output memory */
+    size_t size;
+
+    /*! number of bytes rendered */
+    size_t len;
+
+    /*! called with the buffer contents when the buffer is full, so the
+        output may be larger than the buffer (or NULL) */
+    RenderFlush flush;
+
+    /*! flush function argument */
+    void *arg;
+
+} RenderBuf;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+int RENDER_Compile( const char *fileName, CompiledTemplate **ppTemplate );
+int RENDER_Resolve( VARSERVER_HANDLE hVarServer,
+                    VarCache *pVarCache,
+                    CompiledTemplate *pTemplate );
+bool RENDER_IsStale( CompiledTemplate *pTemplate );
+int RENDER_Fetch( VARSERVER_HANDLE hVarServer, CompiledTemplate *pTemplate );
+int RENDER_Template( VARSERVER_HANDLE hVarServer,
+                     CompiledTemplate *pTemplate,
+                     RenderBuf *pRenderBuf );
+void RENDER_Free( CompiledTemplate *pTemplate );
+
+#endif
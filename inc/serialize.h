@@ -0,0 +1,74 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <varserver/varserver.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! fixed size serialization buffer.  The serializer never allocates
+    memory, it writes into the caller supplied buffer and flags an
+    overflow if the output does not fit */
+typedef struct serBuf
+{
+    /*! pointer to the output buffer */
+    char *pBuf;
+
+    /*! size of the output buffer */
+    size_t size;
+
+    /*! number of bytes written to the output buffer */
+    size_t len;
+
+    /*! output buffer overflow indicator */
+    bool overflow;
+
+} SerBuf;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+void SER_Init( SerBuf *pSerBuf, char *pBuf, size_t size );
+
+void SER_JsonBegin( SerBuf *pSerBuf );
+void SER_JsonMember( SerBuf *pSerBuf, const char *name, VarObject *pVarObject );
+void SER_JsonEnd( SerBuf *pSerBuf );
+
+void SER_CborMapBegin( SerBuf *pSerBuf, size_t count );
+void SER_CborMember( SerBuf *pSerBuf, const char *name, VarObject *pVarObject );
+
+#endif
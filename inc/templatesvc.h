@@ -0,0 +1,489 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef TEMPLATESVC_H
+#define TEMPLATESVC_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <mqueue.h>
+#include <varserver/varserver.h>
+#include <varserver/varfp.h>
+#include <tjson/json.h>
+#include "compress.h"
+#include "render.h"
+#include "varcache.h"
+#include "metrics.h"
+#include "capture.h"
+#include "logger.h"
+#include "eventloop.h"
+#include "confcache.h"
+#include "arena.h"
+#include "strtab.h"
+#include "trigindex.h"
+#include "varreg.h"
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! specifies the type of template */
+typedef enum templateType
+{
+    /*! regular file or stream based template */
+    TMPL_FD = 0,
+
+    /*! message queue template */
+    TMPL_MQ = 1
+} TemplateType;
+
+/*! specifies the output format of a template */
+typedef enum outputFormat
+{
+    /*! text rendered from a template file */
+    FMT_TEXT = 0,
+
+    /*! one JSON Lines record per render */
+    FMT_JSONL = 1,
+
+    /*! one CBOR map per render */
+    FMT_CBOR = 2
+} OutputFormat;
+
+/*! condition under which a trigger notification renders the template */
+typedef enum triggerCondition
+{
+    /*! every notification renders the template */
+    TRIGGER_ALWAYS = 0,
+
+    /*! the value differs from the last rendered value */
+    TRIGGER_CHANGE,
+
+    /*! the value moved at least the deadband from the last rendered value */
+    TRIGGER_DEADBAND,
+
+    /*! the value crossed above the level */
+    TRIGGER_RISING_ABOVE,
+
+    /*! the value crossed below the level */
+    TRIGGER_FALLING_BELOW
+
+} TriggerCondition;
+
+/*! the TriggerVar object caches a trigger variable handle and
+    links trigger variables into a chain */
+typedef struct triggerVar
+{
+    /*! variable handle */
+    VAR_HANDLE hVar;
+
+    /*! variable name */
+    char *name;
+
+    /*! variable cache entry */
+    VarEntry *pEntry;
+
+    /*! condition which a notification must meet to trigger a render */
+    TriggerCondition condition;
+
+    /*! deadband width, or level, of the condition */
+    double level;
+
+    /*! indicates if the last value is known */
+    bool primed;
+
+    /*! last value of a numeric variable */
+    double last;
+
+    /*! last value of a 64-bit integer variable, compared exactly */
+    uint64_t lastWide;
+
+    /*! last formatted text of a non-numeric variable */
+    char *pLastText;
+
+    /*! size of the last formatted text buffer */
+    size_t lastSize;
+
+    /*! number of notifications filtered out by the condition */
+    uint64_t filtered;
+} TriggerVar;
+
+/*! a named rule set, loaded from one configuration file, which shares
+    the service with the other rule sets */
+typedef struct tenant
+{
+    /*! tenant name */
+    char *name;
+
+    /*! render priority (higher priority tenants render first) */
+    int32_t priority;
+
+    /*! maximum number of templates (0 if unlimited) */
+    uint32_t maxTemplates;
+
+    /*! maximum number of renders per second (0 if unlimited) */
+    uint32_t maxRendersPerSec;
+
+    /*! renders available to the rate limit */
+    double tokens;
+
+    /*! time at which the available renders were last topped up */
+    uint64_t refillNs;
+
+    /*! number of templates of the tenant */
+    size_t templates;
+
+    /*! number of times the tenant's templates have been rendered */
+    uint64_t renders;
+
+    /*! number of renders deferred by the rate limit */
+    uint64_t throttled;
+
+    /*! tenant metrics (NULL if metrics are not published) */
+    TemplateMetrics *pMetrics;
+
+    /*! pointer to the next tenant */
+    struct tenant *pNext;
+} Tenant;
+
+/* template service state (see below) */
+struct templateSvcState;
+
+/*! template component which maps trigger variables to
+ *  a template file */
+typedef struct template
+{
+    /*! array of trigger variables */
+    TriggerVar *pTriggers;
+
+    /*! number of trigger variables */
+    size_t numTriggers;
+
+    /*! array of wildcard trigger patterns, expanded into the triggers */
+    TriggerVar *pWildcards;
+
+    /*! number of wildcard trigger patterns */
+    size_t numWildcards;
+
+    /*! triggers are derived from the variables the template references */
+    bool autoTrigger;
+
+    /*! array of variable names excluded from the derived triggers */
+    char **ppExclude;
+
+    /*! number of excluded variable names */
+    size_t numExclude;
+
+    /*! template name used for publishing metrics */
+    char *name;
+
+    /*! configuration signature, used to match the template on reload */
+    char *pSignature;
+
+    /*! pointer to the template file name */
+    char *templateFileName;
+
+    /*! compiled template */
+    CompiledTemplate *pCompiled;
+
+    /*! output format */
+    OutputFormat format;
+
+    /*! array of variables rendered by the structured output formats */
+    TriggerVar *pVars;
+
+    /*! number of structured output variables */
+    size_t numVars;
+
+    /*! target destination name */
+    char *target;
+
+    /*! template type */
+    TemplateType type;
+
+    /*! output file descriptor */
+    int fd;
+
+    /*! message queue handle */
+    mqd_t mq;
+
+    /*! keep the destination open */
+    bool keep_open;
+
+    /*! append (true) or overwrite (false) */
+    bool append;
+
+    /*! only re-format variables which changed since the last render */
+    bool incremental;
+
+    /*! format numeric values natively rather than as the variable server
+        prints them */
+    bool nativeFormat;
+
+    /*! template has been triggered and needs to be rendered */
+    bool dirty;
+
+    /*! render deferred by the tenant's rate limit */
+    bool deferred;
+
+    /*! template is in the service's dirty set */
+    bool queued;
+
+    /*! position of the template in the render order */
+    int64_t rank;
+
+    /*! template service the template belongs to */
+    struct templateSvcState *pState;
+
+    /*! rule set the template belongs to */
+    Tenant *pTenant;
+
+    /*! transaction commit trigger (NULL if not transactional) */
+    TriggerVar *pCommit;
+
+    /*! template has been triggered since the last commit */
+    bool pending;
+
+    /*! periodic render interval in milliseconds (0 if not periodic) */
+    uint32_t intervalMs;
+
+    /*! time of the last trigger of a periodic template */
+    uint64_t triggeredNs;
+
+    /*! number of times the template has been rendered and delivered */
+    uint64_t renders;
+
+    /*! number of trigger notifications filtered out by their conditions */
+    uint64_t filtered;
+
+    /*! number of renders deferred by the tenant's rate limit */
+    uint64_t throttled;
+
+    /*! output compression algorithm */
+    CompressType compress;
+
+    /*! output compressor (NULL if the output is not compressed) */
+    Compressor *pCompressor;
+
+    /*! render metrics (NULL if metrics are not published) */
+    TemplateMetrics *pMetrics;
+
+    /*! time of the first trigger in the current render cycle */
+    uint64_t triggerNs;
+
+    /*! time spent fetching in the current render cycle */
+    uint64_t fetchNs;
+
+    /*! time at which the current render completed */
+    uint64_t renderedNs;
+
+    /*! template file is watched for changes by the event loop */
+    bool watched;
+
+    /*! watched template file has changed since it was compiled */
+    bool stale;
+
+    /*! output waiting for the target to become writable */
+    char *pPending;
+
+    /*! length of the pending output */
+    size_t pendingLen;
+
+    /*! size of the pending output buffer */
+    size_t pendingSize;
+
+    /*! pointer to the next template */
+    struct template *pNext;
+} Template;
+
+
+/*! TemplateSvc state */
+typedef struct templateSvcState
+{
+    /*! variable server handle */
+    VARSERVER_HANDLE hVarServer;
+
+    /*! verbose flag */
+    bool verbose;
+
+    /*! most verbose level to log */
+    LoggerLevel logLevel;
+
+    /*! name of the TemplateSvc definition file */
+    char *pFileName;
+
+    /*! name of the directory of TemplateSvc definition files (or NULL) */
+    char *pConfigDir;
+
+    /*! Variable Output stream */
+    VarFP *pVarFP;
+
+    /*! Variable output file descriptor */
+    int varFd;
+
+    /*! size of the template rendering buffer */
+    size_t varfpSize;
+
+    /*! scratch stream for fetching variables */
+    VarFP *pFetchFP;
+
+    /*! scratch stream file descriptor */
+    int fetchFd;
+
+    /*! pointer to the file vars list */
+    Template *pTemplates;
+
+    /*! dirty or deferred templates, visited by the next render cycle */
+    Template **ppDirty;
+
+    /*! number of templates in the dirty set */
+    size_t numDirty;
+
+    /*! allocated size of the dirty set */
+    size_t dirtySize;
+
+    /*! templates of the previous configuration not yet matched on reload,
+        hashed by their signature */
+    Template **ppRetired;
+
+    /*! number of retired template hash buckets (power of 2) */
+    size_t retiredBuckets;
+
+    /*! rule sets hosted by the service */
+    Tenant *pTenants;
+
+    /*! rule set of the configuration being loaded */
+    Tenant *pTenant;
+
+    /*! timer which runs the scheduled render cycles, such as the retries
+        of the renders deferred by a rate limit */
+    EventTimer *pRetryTimer;
+
+    /*! timer which expands the wildcard triggers to new variables */
+    EventTimer *pRescanTimer;
+
+    /*! timer which retries the variables which have not been found */
+    EventTimer *pResolveTimer;
+
+    /*! current retry delay of the unresolved variables (0 if idle) */
+    uint32_t resolveDelayMs;
+
+    /*! number of variables which were not found at the last retry */
+    size_t unresolved;
+
+    /*! variable handle index and modification tracking */
+    VarCache *pVarCache;
+
+    /*! most connections registering the variables (0 for one per CPU) */
+    size_t connections;
+
+    /*! registrar holding the extra variable server connections */
+    VarReg *pRegistrar;
+
+    /*! render every template once the configuration is loaded */
+    bool renderOnLoad;
+
+    /*! long-lived arena holding the objects set up with the templates */
+    Arena *pArena;
+
+    /*! arena holding the scratch memory of a render cycle */
+    Arena *pCycleArena;
+
+    /*! interned strings of the template definitions */
+    StrTab *pStrings;
+
+    /*! trigger variable handle to trigger record index */
+    TrigIndex *pTrigIndex;
+
+    /*! the trigger index must be rebuilt before the next dispatch */
+    bool reindex;
+
+    /*! stamp of the template most recently added to the trigger index */
+    uint32_t indexStamp;
+
+    /*! variable name prefix for published metrics (NULL if disabled) */
+    char *pMetricsPrefix;
+
+    /*! name of the trigger capture file (NULL if disabled) */
+    char *pCaptureFile;
+
+    /*! trigger capture flags */
+    uint32_t captureFlags;
+
+    /*! trigger capture (NULL if not capturing) */
+    Capture *pCapture;
+
+    /*! event loop (NULL if the service is not attached to one) */
+    EventLoop *pEventLoop;
+
+    /*! periodic render timer (NULL if there are no periodic templates) */
+    EventTimer *pTicker;
+
+    /*! periodic render timer tick in nanoseconds */
+    uint64_t tickNs;
+
+    /*! monotonic time of the periodic render timer's zeroth tick */
+    uint64_t tickBaseNs;
+
+    /*! number of periodic render timer ticks */
+    uint64_t ticks;
+
+    /*! name of the compiled configuration cache file (NULL if disabled) */
+    char *pCacheFile;
+
+    /*! configuration cache the templates were loaded from (or NULL) */
+    ConfCache *pConfCache;
+
+    /*! configuration cache being built while the configuration is parsed */
+    ConfCache *pNewConfCache;
+} TemplateSvcState;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+int TEMPLATESVC_Init( TemplateSvcState *pState );
+int TEMPLATESVC_Open( TemplateSvcState *pState );
+int TEMPLATESVC_Load( TemplateSvcState *pState, JNode *config );
+int TEMPLATESVC_LoadConfig( TemplateSvcState *pState );
+int TEMPLATESVC_Reload( TemplateSvcState *pState );
+int TEMPLATESVC_SetupTemplate( JNode *pNode, void *arg );
+int TEMPLATESVC_Attach( TemplateSvcState *pState, EventLoop *pLoop );
+int TEMPLATESVC_HandleSignal( TemplateSvcState *pState, int sig, int sigval );
+int TEMPLATESVC_ProcessTemplates( TemplateSvcState *pState, VAR_HANDLE hVar );
+int TEMPLATESVC_RenderTemplates( TemplateSvcState *pState );
+size_t TEMPLATESVC_RescanWildcards( TemplateSvcState *pState );
+size_t TEMPLATESVC_ResolvePending( TemplateSvcState *pState );
+int TEMPLATESVC_PrintTemplateFD( TemplateSvcState *pState,
+                                 Template *pTemplate );
+int TEMPLATESVC_PrintTemplateMQ( TemplateSvcState *pState,
+                                 Template *pTemplate );
+void TEMPLATESVC_Close( TemplateSvcState *pState );
+
+#endif
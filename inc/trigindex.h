@@ -0,0 +1,65 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef TRIGINDEX_H
+#define TRIGINDEX_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stddef.h>
+#include <varserver/varserver.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! opaque trigger index object */
+typedef struct trigIndex TrigIndex;
+
+/* triggered template and trigger record (see templatesvc.h) */
+struct template;
+struct triggerVar;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+TrigIndex *TRIGINDEX_Create( void );
+void TRIGINDEX_Delete( TrigIndex *pIndex );
+void TRIGINDEX_Clear( TrigIndex *pIndex );
+int TRIGINDEX_Add( TrigIndex *pIndex,
+                   VAR_HANDLE hVar,
+                   struct template *pTemplate,
+                   struct triggerVar *pTrigger );
+int TRIGINDEX_Build( TrigIndex *pIndex );
+size_t TRIGINDEX_Find( TrigIndex *pIndex, VAR_HANDLE hVar, size_t *pFirst );
+struct template *TRIGINDEX_Template( TrigIndex *pIndex, size_t i );
+struct triggerVar *TRIGINDEX_Trigger( TrigIndex *pIndex, size_t i );
+size_t TRIGINDEX_Count( TrigIndex *pIndex );
+size_t TRIGINDEX_Size( TrigIndex *pIndex );
+
+#endif
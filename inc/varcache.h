@@ -0,0 +1,146 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef VARCACHE_H
+#define VARCACHE_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <varserver/varserver.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! a variable known to the template service */
+typedef struct varEntry
+{
+    /*! variable handle */
+    VAR_HANDLE hVar;
+
+    /*! variable name */
+    char *name;
+
+    /*! modification version, incremented on each MODIFIED notification */
+    uint32_t version;
+
+    /*! indicates if a MODIFIED notification has been requested */
+    bool watched;
+
+    /*! connection of the notification (NULL for the service's own) */
+    VARSERVER_HANDLE hWatch;
+
+    /*! indicates if the variable is still referenced (see VARCACHE_Sweep) */
+    bool marked;
+
+    /*! stamp of the template whose triggers last indexed the variable */
+    uint32_t indexStamp;
+
+    /*! variable type (VARTYPE_INVALID until first fetched) */
+    VarType type;
+
+    /*! event cycle in which the value snapshot was last used */
+    uint32_t cycle;
+
+    /*! modification version of the value snapshot */
+    uint32_t fetchedVersion;
+
+    /*! indicates if the value snapshot is valid */
+    bool valid;
+
+    /*! indicates if the text of a numeric value is printed by the variable
+        server, for the templates which do not format numbers natively */
+    bool printed;
+
+    /*! value snapshot (numeric types only) */
+    VarObject value;
+
+    /*! formatted text of the value snapshot (NUL terminated) */
+    char *pText;
+
+    /*! length of the formatted text */
+    size_t textLen;
+
+    /*! allocated size of the formatted text buffer */
+    size_t textSize;
+
+    /*! pointer to the next entry in the hash chain */
+    struct varEntry *pNext;
+
+    /*! pointer to the next entry in the name hash chain */
+    struct varEntry *pNameNext;
+
+} VarEntry;
+
+/*! opaque variable cache object */
+typedef struct varCache VarCache;
+
+/* capture file (see capture.h) */
+struct capture;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+VarCache *VARCACHE_Create( void );
+void VARCACHE_Delete( VarCache *pVarCache );
+VarEntry *VARCACHE_Find( VarCache *pVarCache, VAR_HANDLE hVar );
+VarEntry *VARCACHE_Add( VarCache *pVarCache,
+                        VAR_HANDLE hVar,
+                        const char *name );
+VarEntry *VARCACHE_Lookup( VarCache *pVarCache,
+                           VARSERVER_HANDLE hVarServer,
+                           const char *name );
+void VARCACHE_SetWatched( VarEntry *pEntry, VARSERVER_HANDLE hVarServer );
+void VARCACHE_SetPrinted( VarEntry *pEntry );
+void VARCACHE_Defer( VarCache *pVarCache, bool defer );
+bool VARCACHE_Deferred( VarCache *pVarCache );
+int VARCACHE_Watch( VarCache *pVarCache,
+                    VARSERVER_HANDLE hVarServer,
+                    VarEntry *pEntry );
+void VARCACHE_ClearMarks( VarCache *pVarCache );
+void VARCACHE_Mark( VarEntry *pEntry );
+size_t VARCACHE_Sweep( VarCache *pVarCache, VARSERVER_HANDLE hVarServer );
+VarEntry *VARCACHE_Modified( VarCache *pVarCache, VAR_HANDLE hVar );
+void VARCACHE_SetScratch( VarCache *pVarCache,
+                          int fd,
+                          char *pBuf,
+                          size_t size );
+void VARCACHE_SetCapture( VarCache *pVarCache, struct capture *pCapture );
+uint32_t VARCACHE_BeginCycle( VarCache *pVarCache );
+int VARCACHE_Fetch( VarCache *pVarCache,
+                    VARSERVER_HANDLE hVarServer,
+                    VarEntry *pEntry );
+int VARCACHE_Refresh( VarCache *pVarCache,
+                      VARSERVER_HANDLE hVarServer,
+                      VarEntry *pEntry );
+size_t VARCACHE_Format( const VarEntry *pEntry, char *buf );
+
+#endif
@@ -0,0 +1,74 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef VARREG_H
+#define VARREG_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <varserver/varserver.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! a variable to be looked up, and optionally watched */
+typedef struct varRegItem
+{
+    /*! variable name */
+    char *name;
+
+    /*! variable handle (VAR_INVALID until the variable is found) */
+    VAR_HANDLE hVar;
+
+    /*! request a MODIFIED notification for the variable */
+    bool watch;
+
+    /*! connection the notification was requested on (NULL if none) */
+    VARSERVER_HANDLE hWatch;
+} VarRegItem;
+
+/*! opaque variable registrar object */
+typedef struct varReg VarReg;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+VarReg *VARREG_Create( void );
+void VARREG_Delete( VarReg *pReg );
+void VARREG_Clear( VarReg *pReg );
+int VARREG_Add( VarReg *pReg, char *name, VAR_HANDLE hVar, bool watch );
+size_t VARREG_Run( VarReg *pReg,
+                   VARSERVER_HANDLE hVarServer,
+                   size_t connections );
+size_t VARREG_Count( VarReg *pReg );
+VarRegItem *VARREG_Get( VarReg *pReg, size_t idx );
+
+#endif
@@ -0,0 +1,1606 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup mockvarserver mockvarserver
+ * @brief In-process stand-in for the variable server client library
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file mockvarserver.c
+
+    Mock Variable Server
+
+    The mockvarserver module implements the subset of the VARSERVER_*,
+    VAR_*, VARFP_* and TEMPLATE_* client APIs used by the template service,
+    backed by an in-process table of variables.  It allows the template
+    service logic to be exercised and measured without a running variable
+    server.
+
+    Variables are added to the table with MOCK_AddVar and updated with
+    MOCK_SetVar.  Every client API call is counted, since each one is an
+    IPC round trip to the server in the real client library.  The
+    counters are updated atomically, since the client may call the API
+    from several threads, each with its own connection.
+
+    Notifications are delivered the same way the real server delivers
+    them: MOCK_InjectModified and MOCK_InjectPrint queue SIG_VAR_MODIFIED
+    and SIG_VAR_PRINT real-time signals to the calling process.  The
+    signals are blocked by VARSERVER_Open, so they stay pending until they
+    are collected with VARSERVER_WaitSignal or sigtimedwait.
+
+    VARFP buffers are backed by a memfd mapped into the process, which is
+    how the real implementation shares the buffer between the file
+    descriptor and the memory view.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <varserver/varserver.h>
+#include <varserver/varfp.h>
+#include <varserver/vartemplate.h>
+#include "mockvarserver.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! initial size of the variable table (must be a power of 2) */
+#define MOCK_INITIAL_SIZE       ( 1024 )
+
+/*! size of the buffer used to print a variable */
+#define MOCK_PRINT_SIZE         ( 64 )
+
+/*! size of the template file read buffer */
+#define MOCK_TEMPLATE_SIZE      ( 64 * 1024 )
+
+/*! maximum number of concurrently pending print sessions */
+#define MOCK_MAX_SESSIONS       ( 16 )
+
+/*! a mock variable */
+typedef struct mockVar
+{
+    /*! variable name */
+    char *name;
+
+    /*! variable value (strings are owned by the mock) */
+    VarObject obj;
+
+    /*! indicates if a MODIFIED notification was requested */
+    bool notify;
+
+} MockVar;
+
+/*! mock VarFP object */
+typedef struct mockVarFP
+{
+    /*! memory file descriptor */
+    int fd;
+
+    /*! mapped memory */
+    char *pData;
+
+    /*! size of the mapped memory */
+    size_t size;
+
+} MockVarFP;
+
+/*! a pending print session */
+typedef struct mockSession
+{
+    /*! handle of the variable to print (VAR_INVALID if unused) */
+    VAR_HANDLE hVar;
+
+    /*! file descriptor to print to */
+    int fd;
+
+} MockSession;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! variable table, indexed by variable handle - 1 */
+static MockVar *pVars;
+
+/*! number of variables in the table */
+static size_t numVars;
+
+/*! allocated size of the variable table */
+static size_t maxVars;
+
+/*! open addressed name index, holding variable handles */
+static VAR_HANDLE *pIndex;
+
+/*! size of the name index (power of 2) */
+static size_t indexSize;
+
+/*! call counters */
+static MockStats stats;
+
+/*! dummy server handle */
+static int mockServer;
+
+/*! pending print sessions, indexed by session identifier */
+static MockSession sessions[MOCK_MAX_SESSIONS];
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static uint64_t HashName( const char *name );
+static MockVar *GetVar( VAR_HANDLE hVar );
+static int GrowIndex( void );
+static int CopyObject( VarObject *pDst, const VarObject *pSrc );
+static int ReadAll( int fd, char **ppBuf, size_t *pLen );
+static void GetSignalMask( sigset_t *pMask );
+static void Count( uint64_t *pCounter );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  MOCK_AddVar                                                               */
+/*!
+    Add a variable to the mock variable server
+
+    @param[in]
+        name
+            variable name
+
+    @param[in]
+        pObj
+            initial value of the variable
+
+    @retval handle of the new variable
+    @retval VAR_INVALID if the variable could not be added
+
+==============================================================================*/
+VAR_HANDLE MOCK_AddVar( const char *name, const VarObject *pObj )
+{
+    VAR_HANDLE hVar = VAR_INVALID;
+    MockVar *p = NULL;
+    size_t size;
+    size_t i;
+
+    if ( ( name != NULL ) &&
+         ( pObj != NULL ) &&
+         ( GrowIndex() == EOK ) )
+    {
+        if ( numVars < maxVars )
+        {
+            p = &pVars[numVars];
+        }
+        else
+        {
+            size = ( maxVars == 0 ) ? MOCK_INITIAL_SIZE : maxVars * 2;
+            p = realloc( pVars, size * sizeof( MockVar ) );
+            if ( p != NULL )
+            {
+                pVars = p;
+                maxVars = size;
+                p = &pVars[numVars];
+            }
+        }
+    }
+
+    if ( p != NULL )
+    {
+        memset( p, 0, sizeof( MockVar ) );
+        p->name = strdup( name );
+        if ( ( p->name != NULL ) &&
+             ( CopyObject( &p->obj, pObj ) == EOK ) )
+        {
+            hVar = (VAR_HANDLE)( ++numVars );
+
+            i = HashName( name ) & ( indexSize - 1 );
+            while ( pIndex[i] != VAR_INVALID )
+            {
+                i = ( i + 1 ) & ( indexSize - 1 );
+            }
+
+            pIndex[i] = hVar;
+        }
+        else
+        {
+            free( p->name );
+        }
+    }
+
+    return hVar;
+}
+
+/*============================================================================*/
+/*  MOCK_SetVar                                                               */
+/*!
+    Set the value of a mock variable
+
+    The value type is not checked, so this can be used to simulate a
+    variable whose type is changed by its owner.
+
+    @param[in]
+        hVar
+            handle of the variable to set
+
+    @param[in]
+        pObj
+            new value of the variable
+
+    @retval EOK - the variable was set
+    @retval ENOENT - the variable does not exist
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int MOCK_SetVar( VAR_HANDLE hVar, const VarObject *pObj )
+{
+    int result = EINVAL;
+    MockVar *p;
+
+    if ( pObj != NULL )
+    {
+        result = ENOENT;
+
+        p = GetVar( hVar );
+        if ( p != NULL )
+        {
+            if ( p->obj.type == VARTYPE_STR )
+            {
+                free( p->obj.val.str );
+            }
+
+            result = CopyObject( &p->obj, pObj );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  MOCK_GetStats                                                             */
+/*!
+    Get the mock variable server call counters
+
+    @param[out]
+        pStats
+            pointer to the location to store the counters
+
+==============================================================================*/
+void MOCK_GetStats( MockStats *pStats )
+{
+    if ( pStats != NULL )
+    {
+        *pStats = stats;
+    }
+}
+
+/*============================================================================*/
+/*  MOCK_ResetStats                                                           */
+/*!
+    Reset the mock variable server call counters
+
+==============================================================================*/
+void MOCK_ResetStats( void )
+{
+    memset( &stats, 0, sizeof( stats ) );
+}
+
+/*============================================================================*/
+/*  MOCK_Clear                                                                */
+/*!
+    Remove all of the variables from the mock variable server
+
+==============================================================================*/
+void MOCK_Clear( void )
+{
+    size_t i;
+
+    for ( i = 0 ; i < numVars ; i++ )
+    {
+        free( pVars[i].name );
+        if ( pVars[i].obj.type == VARTYPE_STR )
+        {
+            free( pVars[i].obj.val.str );
+        }
+    }
+
+    free( pVars );
+    free( pIndex );
+
+    memset( sessions, 0, sizeof( sessions ) );
+
+    pVars = NULL;
+    pIndex = NULL;
+    numVars = 0;
+    maxVars = 0;
+    indexSize = 0;
+}
+
+/*============================================================================*/
+/*  MOCK_IsWatched                                                            */
+/*!
+    Check if a MODIFIED notification was requested for a mock variable
+
+    @param[in]
+        hVar
+            handle of the variable to check
+
+    @retval true - a MODIFIED notification was requested
+    @retval false - no MODIFIED notification was requested
+
+==============================================================================*/
+bool MOCK_IsWatched( VAR_HANDLE hVar )
+{
+    MockVar *p = GetVar( hVar );
+
+    return ( p != NULL ) ? p->notify : false;
+}
+
+/*============================================================================*/
+/*  MOCK_InjectModified                                                       */
+/*!
+    Inject a MODIFIED notification for a mock variable
+
+    The MOCK_InjectModified function queues a SIG_VAR_MODIFIED signal
+    carrying the variable handle to the calling process, as the variable
+    server does when a watched variable is changed.  Nothing is queued if
+    no MODIFIED notification was requested for the variable.
+
+    @param[in]
+        hVar
+            handle of the modified variable
+
+    @retval EOK - the notification was queued
+    @retval ENOENT - the variable does not exist or is not watched
+    @retval EAGAIN - the signal queue is full
+
+==============================================================================*/
+int MOCK_InjectModified( VAR_HANDLE hVar )
+{
+    int result = ENOENT;
+    union sigval val;
+
+    if ( MOCK_IsWatched( hVar ) == true )
+    {
+        val.sival_int = (int)hVar;
+        result = ( sigqueue( getpid(), SIG_VAR_MODIFIED, val ) == 0 )
+                 ? EOK
+                 : errno;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  MOCK_InjectPrint                                                          */
+/*!
+    Inject a PRINT notification for a mock variable
+
+    The MOCK_InjectPrint function opens a print session for the variable
+    and queues a SIG_VAR_PRINT signal carrying the session identifier to
+    the calling process, as the variable server does when a client prints
+    a variable which has a PRINT notification registered.
+
+    @param[in]
+        hVar
+            handle of the variable to print
+
+    @param[in]
+        fd
+            file descriptor the variable should be printed to
+
+    @retval EOK - the notification was queued
+    @retval ENOENT - the variable does not exist
+    @retval ENOSPC - too many print sessions are pending
+    @retval EAGAIN - the signal queue is full
+
+==============================================================================*/
+int MOCK_InjectPrint( VAR_HANDLE hVar, int fd )
+{
+    int result = ENOENT;
+    union sigval val;
+    int i;
+
+    if ( GetVar( hVar ) != NULL )
+    {
+        result = ENOSPC;
+
+        for ( i = 0 ; i < MOCK_MAX_SESSIONS ; i++ )
+        {
+            if ( sessions[i].hVar == VAR_INVALID )
+            {
+                val.sival_int = i;
+                if ( sigqueue( getpid(), SIG_VAR_PRINT, val ) == 0 )
+                {
+                    sessions[i].hVar = hVar;
+                    sessions[i].fd = fd;
+                    result = EOK;
+                }
+                else
+                {
+                    result = errno;
+                }
+
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VARSERVER_Open                                                            */
+/*!
+    Open a connection to the mock variable server
+
+    The notification signals are blocked so they remain pending until they
+    are collected with VARSERVER_WaitSignal.
+
+    @retval handle to the mock variable server
+
+==============================================================================*/
+VARSERVER_HANDLE VARSERVER_Open( void )
+{
+    sigset_t mask;
+
+    Count( &stats.calls );
+    Count( &stats.opens );
+
+    GetSignalMask( &mask );
+    sigprocmask( SIG_BLOCK, &mask, NULL );
+
+    return (VARSERVER_HANDLE)&mockServer;
+}
+
+/*============================================================================*/
+/*  VARSERVER_Close                                                           */
+/*!
+    Close a connection to the mock variable server
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @retval EOK - the connection was closed
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VARSERVER_Close( VARSERVER_HANDLE hVarServer )
+{
+    Count( &stats.calls );
+    return ( hVarServer == (VARSERVER_HANDLE)&mockServer ) ? EOK : EINVAL;
+}
+
+/*============================================================================*/
+/*  VARSERVER_WaitSignal                                                      */
+/*!
+    Wait for a notification signal from the mock variable server
+
+    @param[out]
+        sigval
+            pointer to the location to store the signal value
+
+    @retval the received signal number
+    @retval -1 if the wait failed
+
+==============================================================================*/
+int VARSERVER_WaitSignal( int *sigval )
+{
+    sigset_t mask;
+    siginfo_t info;
+    int sig;
+
+    GetSignalMask( &mask );
+
+    sig = sigwaitinfo( &mask, &info );
+    if ( ( sig > 0 ) && ( sigval != NULL ) )
+    {
+        *sigval = info.si_value.sival_int;
+    }
+
+    return sig;
+}
+
+/*============================================================================*/
+/*  VARSERVER_CreateVar                                                       */
+/*!
+    Create a new mock variable
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in,out]
+        pVarInfo
+            variable name and initial value.  The handle of the new
+            variable is returned in pVarInfo->hVar
+
+    @retval EOK - the variable was created
+    @retval EEXIST - a variable with the same name already exists
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VARSERVER_CreateVar( VARSERVER_HANDLE hVarServer, VarInfo *pVarInfo )
+{
+    int result = EINVAL;
+
+    if ( ( hVarServer != NULL ) && ( pVarInfo != NULL ) )
+    {
+        if ( VAR_FindByName( hVarServer, pVarInfo->name ) != VAR_INVALID )
+        {
+            result = EEXIST;
+        }
+        else
+        {
+            pVarInfo->hVar = MOCK_AddVar( pVarInfo->name, &pVarInfo->var );
+            result = ( pVarInfo->hVar != VAR_INVALID ) ? EOK : ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_FindByName                                                            */
+/*!
+    Find a mock variable by name
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        name
+            name of the variable to find
+
+    @retval handle of the variable
+    @retval VAR_INVALID if the variable does not exist
+
+==============================================================================*/
+VAR_HANDLE VAR_FindByName( VARSERVER_HANDLE hVarServer, char *name )
+{
+    VAR_HANDLE hVar = VAR_INVALID;
+    size_t i;
+
+    Count( &stats.calls );
+
+    if ( ( hVarServer != NULL ) &&
+         ( name != NULL ) &&
+         ( indexSize > 0 ) )
+    {
+        i = HashName( name ) & ( indexSize - 1 );
+        while ( pIndex[i] != VAR_INVALID )
+        {
+            if ( strcmp( pVars[pIndex[i] - 1].name, name ) == 0 )
+            {
+                hVar = pIndex[i];
+                break;
+            }
+
+            i = ( i + 1 ) & ( indexSize - 1 );
+        }
+    }
+
+    return hVar;
+}
+
+/*============================================================================*/
+/*  VAR_Notify                                                                */
+/*!
+    Request a notification for a mock variable
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        hVar
+            handle of the variable
+
+    @param[in]
+        notification
+            type of notification requested
+
+    @retval EOK - the notification was registered
+    @retval ENOENT - the variable does not exist
+
+==============================================================================*/
+int VAR_Notify( VARSERVER_HANDLE hVarServer,
+                VAR_HANDLE hVar,
+                NotificationType notification )
+{
+    int result = ENOENT;
+    MockVar *p;
+
+    Count( &stats.calls );
+    Count( &stats.notifies );
+
+    p = GetVar( hVar );
+    if ( ( hVarServer != NULL ) && ( p != NULL ) )
+    {
+        if ( notification == NOTIFY_MODIFIED )
+        {
+            p->notify = true;
+        }
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_NotifyCancel                                                          */
+/*!
+    Cancel a notification for a mock variable
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        hVar
+            handle of the variable
+
+    @param[in]
+        notification
+            type of notification to cancel
+
+    @retval EOK - the notification was cancelled
+    @retval ENOENT - the variable does not exist
+
+==============================================================================*/
+int VAR_NotifyCancel( VARSERVER_HANDLE hVarServer,
+                      VAR_HANDLE hVar,
+                      NotificationType notification )
+{
+    int result = ENOENT;
+    MockVar *p;
+
+    Count( &stats.calls );
+    Count( &stats.notifies );
+
+    p = GetVar( hVar );
+    if ( ( hVarServer != NULL ) && ( p != NULL ) )
+    {
+        if ( notification == NOTIFY_MODIFIED )
+        {
+            p->notify = false;
+        }
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_Get                                                                   */
+/*!
+    Get the value of a mock variable
+
+    String values are returned by reference to the mock's copy, and are
+    valid until the variable is next set.
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        hVar
+            handle of the variable
+
+    @param[out]
+        pObj
+            pointer to the location to store the value
+
+    @retval EOK - the value was retrieved
+    @retval ENOENT - the variable does not exist
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VAR_Get( VARSERVER_HANDLE hVarServer, VAR_HANDLE hVar, VarObject *pObj )
+{
+    int result = EINVAL;
+    MockVar *p;
+
+    Count( &stats.calls );
+    Count( &stats.gets );
+
+    if ( ( hVarServer != NULL ) && ( pObj != NULL ) )
+    {
+        result = ENOENT;
+
+        p = GetVar( hVar );
+        if ( p != NULL )
+        {
+            *pObj = p->obj;
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_Set                                                                   */
+/*!
+    Set the value of a mock variable
+
+    The VAR_Set function sets the value of a mock variable and, if a
+    MODIFIED notification was requested for it, queues a SIG_VAR_MODIFIED
+    signal to the calling process as the variable server does.
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        hVar
+            handle of the variable
+
+    @param[in]
+        pObj
+            pointer to the new value
+
+    @retval EOK - the value was set
+    @retval ENOENT - the variable does not exist
+    @retval EAGAIN - the value was set, but the signal queue is full
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VAR_Set( VARSERVER_HANDLE hVarServer, VAR_HANDLE hVar, VarObject *pObj )
+{
+    int result = EINVAL;
+
+    Count( &stats.calls );
+
+    if ( hVarServer != NULL )
+    {
+        result = MOCK_SetVar( hVar, pObj );
+        if ( ( result == EOK ) &&
+             ( MOCK_IsWatched( hVar ) == true ) )
+        {
+            result = MOCK_InjectModified( hVar );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_GetType                                                               */
+/*!
+    Get the type of a mock variable
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        hVar
+            handle of the variable
+
+    @param[out]
+        pType
+            pointer to the location to store the type
+
+    @retval EOK - the type was retrieved
+    @retval ENOENT - the variable does not exist
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VAR_GetType( VARSERVER_HANDLE hVarServer,
+                 VAR_HANDLE hVar,
+                 VarType *pType )
+{
+    int result = EINVAL;
+    MockVar *p;
+
+    Count( &stats.calls );
+
+    if ( ( hVarServer != NULL ) && ( pType != NULL ) )
+    {
+        result = ENOENT;
+
+        p = GetVar( hVar );
+        if ( p != NULL )
+        {
+            *pType = p->obj.type;
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_Print                                                                 */
+/*!
+    Print the value of a mock variable to a file descriptor
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        hVar
+            handle of the variable
+
+    @param[in]
+        fd
+            output file descriptor
+
+    @retval EOK - the value was printed
+    @retval ENOENT - the variable does not exist
+    @retval EIO - the value could not be written
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VAR_Print( VARSERVER_HANDLE hVarServer, VAR_HANDLE hVar, int fd )
+{
+    int result = EINVAL;
+    MockVar *p;
+    char buf[MOCK_PRINT_SIZE];
+    const char *pText = buf;
+    int n = 0;
+
+    Count( &stats.calls );
+    Count( &stats.prints );
+
+    if ( ( hVarServer != NULL ) && ( fd >= 0 ) )
+    {
+        result = ENOENT;
+
+        p = GetVar( hVar );
+        if ( p != NULL )
+        {
+            switch( p->obj.type )
+            {
+                case VARTYPE_UINT16:
+                    n = snprintf( buf, sizeof( buf ), "%u", p->obj.val.ui );
+                    break;
+
+                case VARTYPE_INT16:
+                    n = snprintf( buf, sizeof( buf ), "%d", p->obj.val.i );
+                    break;
+
+                case VARTYPE_UINT32:
+                    n = snprintf( buf, sizeof( buf ), "%u", p->obj.val.ul );
+                    break;
+
+                case VARTYPE_INT32:
+                    n = snprintf( buf, sizeof( buf ), "%d", p->obj.val.l );
+                    break;
+
+                case VARTYPE_UINT64:
+                    n = snprintf( buf,
+                                  sizeof( buf ),
+                                  "%llu",
+                                  (unsigned long long)p->obj.val.ull );
+                    break;
+
+                case VARTYPE_INT64:
+                    n = snprintf( buf,
+                                  sizeof( buf ),
+                                  "%lld",
+                                  (long long)p->obj.val.ll );
+                    break;
+
+                case VARTYPE_FLOAT:
+                    n = snprintf( buf, sizeof( buf ), "%f", p->obj.val.f );
+                    break;
+
+                case VARTYPE_STR:
+                    pText = p->obj.val.str;
+                    n = (int)strlen( pText );
+                    break;
+
+                default:
+                    break;
+            }
+
+            result = ( write( fd, pText, (size_t)n ) == n ) ? EOK : EIO;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_GetFirst                                                              */
+/*!
+    Get the first mock variable which matches a query
+
+    Only QUERY_MATCH (case sensitive substring) queries are supported.
+    The handle of the last match is used as the query cursor.
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in,out]
+        query
+            the query to search for.  The name and handle of the matching
+            variable are returned in the query object
+
+    @param[out]
+        obj
+            pointer to the location to store the variable value
+
+    @retval EOK - a matching variable was found
+    @retval ENOENT - no matching variable was found
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VAR_GetFirst( VARSERVER_HANDLE hVarServer,
+                  VarQuery *query,
+                  VarObject *obj )
+{
+    int result = EINVAL;
+
+    if ( query != NULL )
+    {
+        query->hVar = VAR_INVALID;
+        result = VAR_GetNext( hVarServer, query, obj );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_GetNext                                                               */
+/*!
+    Get the next mock variable which matches a query
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in,out]
+        query
+            the query started by VAR_GetFirst
+
+    @param[out]
+        obj
+            pointer to the location to store the variable value
+
+    @retval EOK - a matching variable was found
+    @retval ENOENT - no more matching variables were found
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VAR_GetNext( VARSERVER_HANDLE hVarServer,
+                 VarQuery *query,
+                 VarObject *obj )
+{
+    int result = EINVAL;
+    size_t i;
+
+    Count( &stats.calls );
+
+    if ( ( hVarServer != NULL ) &&
+         ( query != NULL ) &&
+         ( query->match != NULL ) &&
+         ( obj != NULL ) )
+    {
+        result = ENOENT;
+
+        for ( i = query->hVar ; i < numVars ; i++ )
+        {
+            if ( strstr( pVars[i].name, query->match ) != NULL )
+            {
+                query->hVar = (VAR_HANDLE)( i + 1 );
+                strncpy( query->name, pVars[i].name, MAX_NAME_LEN );
+                query->name[MAX_NAME_LEN] = '\0';
+                *obj = pVars[i].obj;
+                result = EOK;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_OpenPrintSession                                                      */
+/*!
+    Open a print session queued by MOCK_InjectPrint
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        id
+            print session identifier received with SIG_VAR_PRINT
+
+    @param[out]
+        hVar
+            pointer to the location to store the variable to print
+
+    @param[out]
+        fd
+            pointer to the location to store the output file descriptor
+
+    @retval EOK - the print session was opened
+    @retval ENOENT - the print session does not exist
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VAR_OpenPrintSession( VARSERVER_HANDLE hVarServer,
+                          int32_t id,
+                          VAR_HANDLE *hVar,
+                          int *fd )
+{
+    int result = EINVAL;
+
+    Count( &stats.calls );
+
+    if ( ( hVarServer != NULL ) && ( hVar != NULL ) && ( fd != NULL ) )
+    {
+        result = ENOENT;
+
+        if ( ( id >= 0 ) &&
+             ( id < MOCK_MAX_SESSIONS ) &&
+             ( sessions[id].hVar != VAR_INVALID ) )
+        {
+            *hVar = sessions[id].hVar;
+            *fd = sessions[id].fd;
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_ClosePrintSession                                                     */
+/*!
+    Close a print session opened by VAR_OpenPrintSession
+
+    The output file descriptor belongs to the caller of MOCK_InjectPrint
+    and is not closed.
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        id
+            print session identifier
+
+    @param[in]
+        fd
+            output file descriptor returned by VAR_OpenPrintSession
+
+    @retval EOK - the print session was closed
+    @retval ENOENT - the print session does not exist
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VAR_ClosePrintSession( VARSERVER_HANDLE hVarServer, int32_t id, int fd )
+{
+    int result = EINVAL;
+
+    Count( &stats.calls );
+
+    if ( hVarServer != NULL )
+    {
+        result = ENOENT;
+
+        if ( ( id >= 0 ) &&
+             ( id < MOCK_MAX_SESSIONS ) &&
+             ( sessions[id].hVar != VAR_INVALID ) &&
+             ( sessions[id].fd == fd ) )
+        {
+            sessions[id].hVar = VAR_INVALID;
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TEMPLATE_FileToFile                                                       */
+/*!
+    Render a template file to an output file
+
+    The TEMPLATE_FileToFile function reads the whole template from the
+    input file descriptor and writes it to the output file descriptor,
+    replacing each ${name} variable reference with the value of the
+    variable.  References to unknown variables are written unchanged.
+
+    @param[in]
+        hVarServer
+            handle to the mock variable server
+
+    @param[in]
+        fdin
+            template input file descriptor
+
+    @param[in]
+        fdout
+            rendered output file descriptor
+
+    @retval EOK - the template was rendered
+    @retval EIO - the output could not be written
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int TEMPLATE_FileToFile( VARSERVER_HANDLE hVarServer, int fdin, int fdout )
+{
+    int result = EINVAL;
+    char *pBuf = NULL;
+    size_t len = 0;
+    size_t i = 0;
+    size_t start = 0;
+    char *pEnd;
+    VAR_HANDLE hVar;
+
+    if ( ( hVarServer != NULL ) &&
+         ( fdin >= 0 ) &&
+         ( fdout >= 0 ) )
+    {
+        result = ReadAll( fdin, &pBuf, &len );
+        while ( ( result == EOK ) && ( i + 1 < len ) )
+        {
+            pEnd = ( ( pBuf[i] == '$' ) && ( pBuf[i + 1] == '{' ) )
+                    ? memchr( &pBuf[i + 2], '}', len - i - 2 )
+                    : NULL;
+            if ( pEnd != NULL )
+            {
+                *pEnd = '\0';
+                hVar = VAR_FindByName( hVarServer, &pBuf[i + 2] );
+                *pEnd = '}';
+
+                if ( hVar != VAR_INVALID )
+                {
+                    if ( write( fdout, &pBuf[start], i - start ) !=
+                         (ssize_t)( i - start ) )
+                    {
+                        result = EIO;
+                    }
+                    else
+                    {
+                        result = VAR_Print( hVarServer, hVar, fdout );
+                    }
+
+                    start = (size_t)( pEnd - pBuf ) + 1;
+                }
+
+                i = (size_t)( pEnd - pBuf ) + 1;
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        if ( ( result == EOK ) &&
+             ( write( fdout, &pBuf[start], len - start ) !=
+               (ssize_t)( len - start ) ) )
+        {
+            result = EIO;
+        }
+
+        free( pBuf );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VARFP_Open                                                                */
+/*!
+    Open a memory backed output stream
+
+    @param[in]
+        name
+            name of the output stream
+
+    @param[in]
+        size
+            size of the output stream memory
+
+    @retval pointer to the output stream
+    @retval NULL if the output stream could not be created
+
+==============================================================================*/
+VarFP *VARFP_Open( char *name, size_t size )
+{
+    MockVarFP *pVarFP = NULL;
+    void *p;
+
+    if ( ( name != NULL ) && ( size > 0 ) )
+    {
+        pVarFP = calloc( 1, sizeof( MockVarFP ) );
+        if ( pVarFP != NULL )
+        {
+            pVarFP->size = size;
+            pVarFP->fd = memfd_create( name, 0 );
+            p = MAP_FAILED;
+
+            if ( ( pVarFP->fd != -1 ) &&
+                 ( ftruncate( pVarFP->fd, (off_t)size ) == 0 ) )
+            {
+                p = mmap( NULL,
+                          size,
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED,
+                          pVarFP->fd,
+                          0 );
+            }
+
+            if ( p != MAP_FAILED )
+            {
+                pVarFP->pData = p;
+            }
+            else
+            {
+                if ( pVarFP->fd != -1 )
+                {
+                    close( pVarFP->fd );
+                }
+
+                free( pVarFP );
+                pVarFP = NULL;
+            }
+        }
+    }
+
+    return (VarFP *)pVarFP;
+}
+
+/*============================================================================*/
+/*  VARFP_GetFd                                                               */
+/*!
+    Get the file descriptor of a memory backed output stream
+
+    @param[in]
+        pVarFP
+            pointer to the output stream
+
+    @retval the output stream file descriptor
+    @retval -1 if the output stream is invalid
+
+==============================================================================*/
+int VARFP_GetFd( VarFP *pVarFP )
+{
+    return ( pVarFP != NULL ) ? ((MockVarFP *)pVarFP)->fd : -1;
+}
+
+/*============================================================================*/
+/*  VARFP_GetData                                                             */
+/*!
+    Get the memory of a memory backed output stream
+
+    @param[in]
+        pVarFP
+            pointer to the output stream
+
+    @retval pointer to the output stream memory
+    @retval NULL if the output stream is invalid
+
+==============================================================================*/
+char *VARFP_GetData( VarFP *pVarFP )
+{
+    return ( pVarFP != NULL ) ? ((MockVarFP *)pVarFP)->pData : NULL;
+}
+
+/*============================================================================*/
+/*  VARFP_Close                                                               */
+/*!
+    Close a memory backed output stream
+
+    @param[in]
+        pVarFP
+            pointer to the output stream to close
+
+    @retval EOK - the output stream was closed
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VARFP_Close( VarFP *pVarFP )
+{
+    int result = EINVAL;
+    MockVarFP *p = (MockVarFP *)pVarFP;
+
+    if ( p != NULL )
+    {
+        munmap( p->pData, p->size );
+        close( p->fd );
+        free( p );
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  HashName                                                                  */
+/*!
+    Hash a variable name (FNV-1a)
+
+    @param[in]
+        name
+            variable name
+
+    @retval hash of the variable name
+
+==============================================================================*/
+static uint64_t HashName( const char *name )
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+
+    while ( *name != '\0' )
+    {
+        h ^= (unsigned char)*name++;
+        h *= 0x100000001B3ULL;
+    }
+
+    return h;
+}
+
+/*============================================================================*/
+/*  GetVar                                                                    */
+/*!
+    Get a mock variable by handle
+
+    @param[in]
+        hVar
+            variable handle
+
+    @retval pointer to the mock variable
+    @retval NULL if the variable does not exist
+
+==============================================================================*/
+static MockVar *GetVar( VAR_HANDLE hVar )
+{
+    return ( ( hVar != VAR_INVALID ) && ( hVar <= numVars ) )
+            ? &pVars[hVar - 1]
+            : NULL;
+}
+
+/*============================================================================*/
+/*  GrowIndex                                                                 */
+/*!
+    Grow the name index if it is more than half full
+
+    @retval EOK - the index has room for another variable
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int GrowIndex( void )
+{
+    int result = EOK;
+    VAR_HANDLE *p;
+    size_t size;
+    size_t i;
+    size_t j;
+
+    if ( ( numVars + 1 ) * 2 > indexSize )
+    {
+        size = ( indexSize == 0 ) ? MOCK_INITIAL_SIZE * 2 : indexSize * 2;
+        p = calloc( size, sizeof( VAR_HANDLE ) );
+        if ( p != NULL )
+        {
+            for ( i = 0 ; i < numVars ; i++ )
+            {
+                j = HashName( pVars[i].name ) & ( size - 1 );
+                while ( p[j] != VAR_INVALID )
+                {
+                    j = ( j + 1 ) & ( size - 1 );
+                }
+
+                p[j] = (VAR_HANDLE)( i + 1 );
+            }
+
+            free( pIndex );
+            pIndex = p;
+            indexSize = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CopyObject                                                                */
+/*!
+    Copy a variable value, duplicating string values
+
+    @param[out]
+        pDst
+            pointer to the destination value
+
+    @param[in]
+        pSrc
+            pointer to the source value
+
+    @retval EOK - the value was copied
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int CopyObject( VarObject *pDst, const VarObject *pSrc )
+{
+    int result = EOK;
+
+    *pDst = *pSrc;
+
+    if ( pSrc->type == VARTYPE_STR )
+    {
+        pDst->val.str = strdup( ( pSrc->val.str != NULL ) ? pSrc->val.str
+                                                           : "" );
+        if ( pDst->val.str == NULL )
+        {
+            pDst->type = VARTYPE_INVALID;
+            result = ENOMEM;
+        }
+        else
+        {
+            pDst->len = strlen( pDst->val.str ) + 1;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ReadAll                                                                   */
+/*!
+    Read the remainder of a file into an allocated buffer
+
+    @param[in]
+        fd
+            input file descriptor
+
+    @param[out]
+        ppBuf
+            pointer to the location to store the allocated buffer
+
+    @param[out]
+        pLen
+            pointer to the location to store the number of bytes read
+
+    @retval EOK - the file was read
+    @retval ENOMEM - memory allocation failure
+    @retval other - error returned by read()
+
+==============================================================================*/
+static int ReadAll( int fd, char **ppBuf, size_t *pLen )
+{
+    int result = EOK;
+    char *pBuf = NULL;
+    char *p;
+    size_t size = 0;
+    size_t len = 0;
+    ssize_t n = 1;
+
+    while ( ( result == EOK ) && ( n > 0 ) )
+    {
+        if ( len == size )
+        {
+            size += MOCK_TEMPLATE_SIZE;
+            p = realloc( pBuf, size );
+            if ( p == NULL )
+            {
+                result = ENOMEM;
+                break;
+            }
+
+            pBuf = p;
+        }
+
+        n = read( fd, &pBuf[len], size - len );
+        if ( n > 0 )
+        {
+            len += (size_t)n;
+        }
+        else if ( ( n < 0 ) && ( errno != EINTR ) )
+        {
+            result = errno;
+        }
+        else if ( n < 0 )
+        {
+            n = 1;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        *ppBuf = pBuf;
+        *pLen = len;
+    }
+    else
+    {
+        free( pBuf );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  GetSignalMask                                                             */
+/*!
+    Get the set of notification signals delivered by the mock server
+
+    @param[out]
+        pMask
+            pointer to the signal set to populate
+
+==============================================================================*/
+static void GetSignalMask( sigset_t *pMask )
+{
+    sigemptyset( pMask );
+    sigaddset( pMask, SIG_VAR_MODIFIED );
+    sigaddset( pMask, SIG_VAR_PRINT );
+}
+
+/*============================================================================*/
+/*  Count                                                                     */
+/*!
+    Increment a call counter
+
+    @param[in]
+        pCounter
+            pointer to the counter
+
+==============================================================================*/
+static void Count( uint64_t *pCounter )
+{
+    (void)__atomic_fetch_add( pCounter, 1, __ATOMIC_RELAXED );
+}
+
+/*! @}
+ * end of mockvarserver group */
@@ -0,0 +1,74 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+#ifndef MOCKVARSERVER_H
+#define MOCKVARSERVER_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <varserver/varserver.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! mock variable server call counters */
+typedef struct mockStats
+{
+    /*! number of variable server API calls (one IPC round trip each) */
+    uint64_t calls;
+
+    /*! number of VAR_Get calls */
+    uint64_t gets;
+
+    /*! number of VAR_Print calls */
+    uint64_t prints;
+
+    /*! number of VAR_Notify calls */
+    uint64_t notifies;
+
+    /*! number of VARSERVER_Open calls */
+    uint64_t opens;
+
+} MockStats;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+VAR_HANDLE MOCK_AddVar( const char *name, const VarObject *pObj );
+int MOCK_SetVar( VAR_HANDLE hVar, const VarObject *pObj );
+void MOCK_GetStats( MockStats *pStats );
+void MOCK_ResetStats( void );
+void MOCK_Clear( void );
+bool MOCK_IsWatched( VAR_HANDLE hVar );
+int MOCK_InjectModified( VAR_HANDLE hVar );
+int MOCK_InjectPrint( VAR_HANDLE hVar, int fd );
+
+#endif
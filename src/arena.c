@@ -0,0 +1,386 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup arena arena
+ * @brief Block arena allocator
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file arena.c
+
+    Arena Allocator
+
+    The arena module hands out memory by bumping a pointer through large
+    blocks, rather than making a heap allocation for each object.
+    Objects allocated from an arena are not freed individually.  They
+    are all released together when the arena is reset or deleted.
+
+    Resetting an arena keeps its blocks, so an arena which is reset
+    after each unit of work, and which makes the same allocations each
+    time, stops allocating from the heap once it has grown to fit the
+    largest unit of work.  An arena which is never reset holds objects
+    which live as long as the arena itself.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! alignment of the allocations */
+#define ARENA_ALIGN                 ( _Alignof( max_align_t ) )
+
+/*! an arena block */
+typedef struct arenaBlock
+{
+    /*! pointer to the next block */
+    struct arenaBlock *pNext;
+
+    /*! number of bytes allocated from the block */
+    size_t used;
+
+    /*! size of the block data */
+    size_t size;
+
+    /*! block data */
+    max_align_t data[];
+} ArenaBlock;
+
+/*! arena */
+struct arena
+{
+    /*! first block */
+    ArenaBlock *pFirst;
+
+    /*! block currently being allocated from */
+    ArenaBlock *pCurrent;
+
+    /*! last block */
+    ArenaBlock *pLast;
+
+    /*! minimum size of a block */
+    size_t blockSize;
+
+    /*! number of bytes allocated since the last reset */
+    size_t used;
+
+    /*! total size of the blocks */
+    size_t size;
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static ArenaBlock *AddBlock( Arena *pArena, size_t size );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  ARENA_Create                                                              */
+/*!
+    Create an arena
+
+    No memory is reserved for the objects until the first allocation.
+
+    @param[in]
+        blockSize
+            minimum size of each block of the arena
+
+    @retval pointer to the new arena
+    @retval NULL if memory allocation failed
+
+==============================================================================*/
+Arena *ARENA_Create( size_t blockSize )
+{
+    Arena *pArena;
+
+    pArena = calloc( 1, sizeof( Arena ) );
+    if ( pArena != NULL )
+    {
+        pArena->blockSize = ( blockSize > 0 ) ? blockSize : ARENA_ALIGN;
+    }
+
+    return pArena;
+}
+
+/*============================================================================*/
+/*  ARENA_Delete                                                              */
+/*!
+    Delete an arena
+
+    All of the blocks of the arena, and so all of the objects allocated
+    from it, are freed.
+
+    @param[in]
+        pArena
+            pointer to the arena to delete (may be NULL)
+
+==============================================================================*/
+void ARENA_Delete( Arena *pArena )
+{
+    ArenaBlock *pBlock;
+
+    if ( pArena != NULL )
+    {
+        while ( pArena->pFirst != NULL )
+        {
+            pBlock = pArena->pFirst;
+            pArena->pFirst = pBlock->pNext;
+            free( pBlock );
+        }
+
+        free( pArena );
+    }
+}
+
+/*============================================================================*/
+/*  ARENA_Alloc                                                               */
+/*!
+    Allocate memory from an arena
+
+    The ARENA_Alloc function returns suitably aligned memory from the
+    current block.  When the current block is full, the allocation moves
+    on to the next block which was kept by a reset, and a new block is
+    only added when there is none.  An allocation which is larger than
+    the block size gets a block of its own.
+
+    @param[in]
+        pArena
+            pointer to the arena
+
+    @param[in]
+        size
+            number of bytes to allocate
+
+    @retval pointer to the allocated memory
+    @retval NULL if memory allocation failed
+
+==============================================================================*/
+void *ARENA_Alloc( Arena *pArena, size_t size )
+{
+    void *result = NULL;
+    ArenaBlock *pBlock;
+
+    if ( ( pArena != NULL ) &&
+         ( size <= SIZE_MAX - ARENA_ALIGN ) )
+    {
+        size = ( size + ARENA_ALIGN - 1 ) & ~( ARENA_ALIGN - 1 );
+
+        pBlock = pArena->pCurrent;
+        while ( ( pBlock != NULL ) &&
+                ( ( pBlock->size - pBlock->used ) < size ) )
+        {
+            pBlock = pBlock->pNext;
+        }
+
+        if ( pBlock == NULL )
+        {
+            pBlock = AddBlock( pArena, size );
+        }
+
+        if ( pBlock != NULL )
+        {
+            pArena->pCurrent = pBlock;
+            result = (char *)pBlock->data + pBlock->used;
+            pBlock->used += size;
+            pArena->used += size;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ARENA_Calloc                                                              */
+/*!
+    Allocate zeroed memory from an arena
+
+    @param[in]
+        pArena
+            pointer to the arena
+
+    @param[in]
+        size
+            number of bytes to allocate
+
+    @retval pointer to the allocated memory
+    @retval NULL if memory allocation failed
+
+==============================================================================*/
+void *ARENA_Calloc( Arena *pArena, size_t size )
+{
+    void *result;
+
+    result = ARENA_Alloc( pArena, size );
+    if ( result != NULL )
+    {
+        memset( result, 0, size );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ARENA_Reset                                                               */
+/*!
+    Release all of the objects allocated from an arena
+
+    The blocks of the arena are kept, and are re-used by the following
+    allocations.  Memory returned by the arena before the reset must no
+    longer be used.
+
+    @param[in]
+        pArena
+            pointer to the arena
+
+==============================================================================*/
+void ARENA_Reset( Arena *pArena )
+{
+    ArenaBlock *pBlock;
+
+    if ( pArena != NULL )
+    {
+        for ( pBlock = pArena->pFirst ;
+              pBlock != NULL ;
+              pBlock = pBlock->pNext )
+        {
+            pBlock->used = 0;
+        }
+
+        pArena->pCurrent = pArena->pFirst;
+        pArena->used = 0;
+    }
+}
+
+/*============================================================================*/
+/*  ARENA_Used                                                                */
+/*!
+    Get the number of bytes allocated from an arena since its last reset
+
+    @param[in]
+        pArena
+            pointer to the arena
+
+    @retval number of bytes allocated, including alignment padding
+
+==============================================================================*/
+size_t ARENA_Used( Arena *pArena )
+{
+    return ( pArena != NULL ) ? pArena->used : 0;
+}
+
+/*============================================================================*/
+/*  ARENA_Size                                                                */
+/*!
+    Get the memory reserved by an arena
+
+    @param[in]
+        pArena
+            pointer to the arena
+
+    @retval number of bytes allocated from the heap for the arena
+
+==============================================================================*/
+size_t ARENA_Size( Arena *pArena )
+{
+    return ( pArena != NULL ) ? sizeof( Arena ) + pArena->size : 0;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  AddBlock                                                                  */
+/*!
+    Add a block to the end of an arena
+
+    @param[in]
+        pArena
+            pointer to the arena
+
+    @param[in]
+        size
+            size of the allocation which the block must fit
+
+    @retval pointer to the new block
+    @retval NULL if memory allocation failed
+
+==============================================================================*/
+static ArenaBlock *AddBlock( Arena *pArena, size_t size )
+{
+    ArenaBlock *pBlock = NULL;
+
+    if ( size < pArena->blockSize )
+    {
+        size = pArena->blockSize;
+    }
+
+    if ( size <= SIZE_MAX - sizeof( ArenaBlock ) )
+    {
+        pBlock = malloc( sizeof( ArenaBlock ) + size );
+    }
+
+    if ( pBlock != NULL )
+    {
+        pBlock->pNext = NULL;
+        pBlock->used = 0;
+        pBlock->size = size;
+
+        if ( pArena->pLast != NULL )
+        {
+            pArena->pLast->pNext = pBlock;
+        }
+        else
+        {
+            pArena->pFirst = pBlock;
+        }
+
+        pArena->pLast = pBlock;
+        pArena->size += sizeof( ArenaBlock ) + size;
+    }
+
+    return pBlock;
+}
+
+/*! @}
+ * end of arena group */
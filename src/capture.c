@@ -0,0 +1,1160 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup capture capture
+ * @brief Trigger capture files
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file capture.c
+
+    Trigger capture files
+
+    The capture module records the signals received by the template
+    service, and optionally the variable values it fetches, to a compact
+    binary file so that a production trigger storm can be replayed later
+    against the mock variable server.
+
+    A capture file starts with an 8 byte magic number followed by the
+    format version and the capture flags.  It then holds a sequence of
+    records, each starting with a one byte record type.  All integers are
+    encoded as LEB128 variable length integers (signed integers are
+    zigzag encoded first), so a typical MODIFIED record is 4 to 6 bytes.
+
+        VAR      : handle, type, name length, name
+        MODIFIED : ns since the previous signal, handle
+        PRINT    : ns since the previous signal, session identifier
+        VALUE    : handle, type, value
+        CYCLE    : (no fields)
+
+    Variable names are written once, in a VAR record emitted before the
+    first record which refers to the variable.  A CYCLE record marks the
+    start of each render cycle, and is followed by the signals batched
+    into the cycle and the values fetched to render it.  Float values are
+    stored as their 4 byte IEEE representation, and all non-numeric values
+    are stored as the text rendered by the variable server.
+
+    Records are written through a stdio buffer, so capturing costs a few
+    bytes of memory copy per signal on the render path.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include "capture.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! capture file magic number */
+#define CAPTURE_MAGIC           "TSVCCAPT"
+
+/*! length of the capture file magic number */
+#define CAPTURE_MAGIC_LEN       ( 8 )
+
+/*! capture file format version */
+#define CAPTURE_VERSION         ( 1 )
+
+/*! capture file stdio buffer size */
+#define CAPTURE_BUFFER_SIZE     ( 64 * 1024 )
+
+/*! capture file */
+struct capture
+{
+    /*! capture file stream */
+    FILE *fp;
+
+    /*! stdio buffer of the capture file stream */
+    char *pBuffer;
+
+    /*! true if the capture is being recorded, false if it is being read */
+    bool writing;
+
+    /*! capture flags */
+    uint32_t flags;
+
+    /*! monotonic time the capture started (ns) */
+    uint64_t start;
+
+    /*! timestamp of the previous signal record (ns since start) */
+    uint64_t last;
+
+    /*! bitmap of the variable handles already in the name table */
+    uint8_t *pNamed;
+
+    /*! size of the name table bitmap in bytes */
+    size_t namedSize;
+
+    /*! string value buffer used when reading */
+    char *pStr;
+
+    /*! size of the string value buffer */
+    size_t strSize;
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static uint64_t Now( void );
+static bool IsNamed( Capture *pCapture, VAR_HANDLE hVar );
+static int SetNamed( Capture *pCapture, VAR_HANDLE hVar );
+static void PutVarint( FILE *fp, uint64_t value );
+static void PutSigned( FILE *fp, int64_t value );
+static int GetVarint( FILE *fp, uint64_t *pValue );
+static int GetSigned( FILE *fp, int64_t *pValue );
+static int PutTimestamp( Capture *pCapture );
+static int ReadVar( Capture *pCapture, CaptureRecord *pRecord );
+static int ReadValue( Capture *pCapture, CaptureRecord *pRecord );
+static Capture *NewCapture( const char *fileName, const char *mode );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  CAPTURE_Create                                                            */
+/*!
+    Create a capture file for recording
+
+    The CAPTURE_Create function creates (or replaces) a capture file and
+    writes its header.  The capture timestamps are relative to the time
+    the capture file was created.
+
+    @param[in]
+        fileName
+            name of the capture file to create
+
+    @param[in]
+        flags
+            capture flags (CAPTURE_VALUES)
+
+    @retval pointer to the capture object
+    @retval NULL if the capture file could not be created
+
+==============================================================================*/
+Capture *CAPTURE_Create( const char *fileName, uint32_t flags )
+{
+    Capture *pCapture;
+
+    pCapture = NewCapture( fileName, "wb" );
+    if ( pCapture != NULL )
+    {
+        pCapture->writing = true;
+        pCapture->flags = flags;
+        pCapture->start = Now();
+
+        fwrite( CAPTURE_MAGIC, 1, CAPTURE_MAGIC_LEN, pCapture->fp );
+        PutVarint( pCapture->fp, CAPTURE_VERSION );
+        PutVarint( pCapture->fp, flags );
+
+        if ( ferror( pCapture->fp ) )
+        {
+            CAPTURE_Close( pCapture );
+            pCapture = NULL;
+        }
+    }
+
+    return pCapture;
+}
+
+/*============================================================================*/
+/*  CAPTURE_Open                                                              */
+/*!
+    Open a capture file for reading
+
+    The CAPTURE_Open function opens a capture file and checks its header.
+    The records are then read with CAPTURE_Read.
+
+    @param[in]
+        fileName
+            name of the capture file to open
+
+    @retval pointer to the capture object
+    @retval NULL if the file could not be opened or is not a capture file
+
+==============================================================================*/
+Capture *CAPTURE_Open( const char *fileName )
+{
+    Capture *pCapture;
+    char magic[CAPTURE_MAGIC_LEN];
+    uint64_t version = 0;
+    uint64_t flags = 0;
+
+    pCapture = NewCapture( fileName, "rb" );
+    if ( pCapture != NULL )
+    {
+        if ( ( fread( magic, 1, CAPTURE_MAGIC_LEN, pCapture->fp )
+                    == CAPTURE_MAGIC_LEN ) &&
+             ( memcmp( magic, CAPTURE_MAGIC, CAPTURE_MAGIC_LEN ) == 0 ) &&
+             ( GetVarint( pCapture->fp, &version ) == EOK ) &&
+             ( version == CAPTURE_VERSION ) &&
+             ( GetVarint( pCapture->fp, &flags ) == EOK ) )
+        {
+            pCapture->flags = (uint32_t)flags;
+        }
+        else
+        {
+            CAPTURE_Close( pCapture );
+            pCapture = NULL;
+        }
+    }
+
+    return pCapture;
+}
+
+/*============================================================================*/
+/*  CAPTURE_GetFlags                                                          */
+/*!
+    Get the flags of a capture
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @retval the capture flags
+
+==============================================================================*/
+uint32_t CAPTURE_GetFlags( Capture *pCapture )
+{
+    return ( pCapture != NULL ) ? pCapture->flags : 0;
+}
+
+/*============================================================================*/
+/*  CAPTURE_Var                                                               */
+/*!
+    Add a variable to the capture name table
+
+    The CAPTURE_Var function writes a VAR record for the variable unless
+    it is already in the name table.
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @param[in]
+        hVar
+            handle of the variable
+
+    @param[in]
+        type
+            type of the variable (VARTYPE_INVALID if unknown)
+
+    @param[in]
+        name
+            name of the variable
+
+    @retval EOK - the variable is in the name table
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - the record could not be written
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CAPTURE_Var( Capture *pCapture,
+                 VAR_HANDLE hVar,
+                 VarType type,
+                 const char *name )
+{
+    int result = EINVAL;
+    size_t len;
+
+    if ( ( pCapture != NULL ) &&
+         ( pCapture->writing == true ) &&
+         ( hVar != VAR_INVALID ) &&
+         ( name != NULL ) )
+    {
+        result = EOK;
+
+        if ( IsNamed( pCapture, hVar ) == false )
+        {
+            result = SetNamed( pCapture, hVar );
+            if ( result == EOK )
+            {
+                len = strnlen( name, MAX_NAME_LEN );
+
+                fputc( CAPTURE_REC_VAR, pCapture->fp );
+                PutVarint( pCapture->fp, hVar );
+                PutVarint( pCapture->fp, (uint64_t)type );
+                PutVarint( pCapture->fp, len );
+                fwrite( name, 1, len, pCapture->fp );
+
+                result = ferror( pCapture->fp ) ? EIO : EOK;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CAPTURE_Cycle                                                             */
+/*!
+    Record the start of a render cycle
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @retval EOK - the cycle was recorded
+    @retval EIO - the record could not be written
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CAPTURE_Cycle( Capture *pCapture )
+{
+    int result = EINVAL;
+
+    if ( ( pCapture != NULL ) &&
+         ( pCapture->writing == true ) )
+    {
+        fputc( CAPTURE_REC_CYCLE, pCapture->fp );
+        result = ferror( pCapture->fp ) ? EIO : EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CAPTURE_Modified                                                          */
+/*!
+    Record a MODIFIED notification
+
+    The CAPTURE_Modified function records the receipt of a SIG_VAR_MODIFIED
+    signal.  The variable is added to the name table first if necessary.
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @param[in]
+        hVar
+            handle of the modified variable
+
+    @param[in]
+        name
+            name of the modified variable (NULL if unknown)
+
+    @retval EOK - the notification was recorded
+    @retval EIO - the record could not be written
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CAPTURE_Modified( Capture *pCapture, VAR_HANDLE hVar, const char *name )
+{
+    int result = EINVAL;
+
+    if ( ( pCapture != NULL ) &&
+         ( pCapture->writing == true ) )
+    {
+        if ( name != NULL )
+        {
+            CAPTURE_Var( pCapture, hVar, VARTYPE_INVALID, name );
+        }
+
+        fputc( CAPTURE_REC_MODIFIED, pCapture->fp );
+        result = PutTimestamp( pCapture );
+        PutVarint( pCapture->fp, hVar );
+
+        if ( ferror( pCapture->fp ) )
+        {
+            result = EIO;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CAPTURE_Print                                                             */
+/*!
+    Record a PRINT notification
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @param[in]
+        id
+            print session identifier
+
+    @retval EOK - the notification was recorded
+    @retval EIO - the record could not be written
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CAPTURE_Print( Capture *pCapture, int32_t id )
+{
+    int result = EINVAL;
+
+    if ( ( pCapture != NULL ) &&
+         ( pCapture->writing == true ) )
+    {
+        fputc( CAPTURE_REC_PRINT, pCapture->fp );
+        result = PutTimestamp( pCapture );
+        PutSigned( pCapture->fp, id );
+
+        if ( ferror( pCapture->fp ) )
+        {
+            result = EIO;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CAPTURE_Value                                                             */
+/*!
+    Record a fetched variable value
+
+    The CAPTURE_Value function records the value snapshot of a variable
+    cache entry.  Nothing is recorded unless the capture was created with
+    the CAPTURE_VALUES flag.  Non-numeric values are recorded as the text
+    rendered by the variable server.
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry holding the value
+
+    @retval EOK - the value was recorded (or values are not captured)
+    @retval EIO - the record could not be written
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CAPTURE_Value( Capture *pCapture, const VarEntry *pEntry )
+{
+    int result = EINVAL;
+    const VarObject *pObj;
+
+    if ( ( pCapture != NULL ) &&
+         ( pCapture->writing == true ) &&
+         ( pEntry != NULL ) )
+    {
+        result = EOK;
+
+        if ( pCapture->flags & CAPTURE_VALUES )
+        {
+            CAPTURE_Var( pCapture, pEntry->hVar, pEntry->type, pEntry->name );
+
+            pObj = &pEntry->value;
+
+            fputc( CAPTURE_REC_VALUE, pCapture->fp );
+            PutVarint( pCapture->fp, pEntry->hVar );
+
+            switch( pObj->type )
+            {
+                case VARTYPE_UINT16:
+                    PutVarint( pCapture->fp, pObj->type );
+                    PutVarint( pCapture->fp, pObj->val.ui );
+                    break;
+
+                case VARTYPE_INT16:
+                    PutVarint( pCapture->fp, pObj->type );
+                    PutSigned( pCapture->fp, pObj->val.i );
+                    break;
+
+                case VARTYPE_UINT32:
+                    PutVarint( pCapture->fp, pObj->type );
+                    PutVarint( pCapture->fp, pObj->val.ul );
+                    break;
+
+                case VARTYPE_INT32:
+                    PutVarint( pCapture->fp, pObj->type );
+                    PutSigned( pCapture->fp, pObj->val.l );
+                    break;
+
+                case VARTYPE_UINT64:
+                    PutVarint( pCapture->fp, pObj->type );
+                    PutVarint( pCapture->fp, pObj->val.ull );
+                    break;
+
+                case VARTYPE_INT64:
+                    PutVarint( pCapture->fp, pObj->type );
+                    PutSigned( pCapture->fp, pObj->val.ll );
+                    break;
+
+                case VARTYPE_FLOAT:
+                    PutVarint( pCapture->fp, pObj->type );
+                    fwrite( &pObj->val.f, 1, sizeof( float ), pCapture->fp );
+                    break;
+
+                default:
+                    PutVarint( pCapture->fp, VARTYPE_STR );
+                    PutVarint( pCapture->fp, pEntry->textLen );
+                    fwrite( pEntry->pText, 1, pEntry->textLen, pCapture->fp );
+                    break;
+            }
+
+            result = ferror( pCapture->fp ) ? EIO : EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CAPTURE_Read                                                              */
+/*!
+    Read the next capture record
+
+    @param[in]
+        pCapture
+            pointer to a capture object opened with CAPTURE_Open
+
+    @param[out]
+        pRecord
+            pointer to the location to store the decoded record
+
+    @retval EOK - a record was read
+    @retval ENOENT - there are no more records
+    @retval EBADMSG - the capture file is corrupt or truncated
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CAPTURE_Read( Capture *pCapture, CaptureRecord *pRecord )
+{
+    int result = EINVAL;
+    uint64_t value;
+    int64_t id;
+    int type;
+
+    if ( ( pCapture != NULL ) &&
+         ( pCapture->writing == false ) &&
+         ( pRecord != NULL ) )
+    {
+        memset( pRecord, 0, sizeof( CaptureRecord ) );
+
+        type = fgetc( pCapture->fp );
+        pRecord->type = (CaptureRecType)type;
+
+        switch( type )
+        {
+            case EOF:
+                result = ENOENT;
+                break;
+
+            case CAPTURE_REC_VAR:
+                result = ReadVar( pCapture, pRecord );
+                break;
+
+            case CAPTURE_REC_MODIFIED:
+                result = GetVarint( pCapture->fp, &value );
+                if ( result == EOK )
+                {
+                    pCapture->last += value;
+                    result = GetVarint( pCapture->fp, &value );
+                    pRecord->hVar = (VAR_HANDLE)value;
+                }
+                break;
+
+            case CAPTURE_REC_PRINT:
+                result = GetVarint( pCapture->fp, &value );
+                if ( result == EOK )
+                {
+                    pCapture->last += value;
+                    result = GetSigned( pCapture->fp, &id );
+                    pRecord->id = (int32_t)id;
+                }
+                break;
+
+            case CAPTURE_REC_VALUE:
+                result = ReadValue( pCapture, pRecord );
+                break;
+
+            case CAPTURE_REC_CYCLE:
+                result = EOK;
+                break;
+
+            default:
+                result = EBADMSG;
+                break;
+        }
+
+        pRecord->timestamp = pCapture->last;
+
+        if ( result == ENOENT )
+        {
+            /* a record was started but not completed */
+            result = ( type == EOF ) ? ENOENT : EBADMSG;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CAPTURE_Close                                                             */
+/*!
+    Close a capture file
+
+    The CAPTURE_Close function flushes any buffered records, closes the
+    capture file and frees the capture object.
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @retval EOK - the capture was closed
+    @retval EIO - buffered records could not be written
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CAPTURE_Close( Capture *pCapture )
+{
+    int result = EINVAL;
+
+    if ( pCapture != NULL )
+    {
+        result = EOK;
+
+        if ( pCapture->fp != NULL )
+        {
+            if ( fclose( pCapture->fp ) != 0 )
+            {
+                result = EIO;
+            }
+        }
+
+        free( pCapture->pBuffer );
+        free( pCapture->pNamed );
+        free( pCapture->pStr );
+        free( pCapture );
+    }
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NewCapture                                                                */
+/*!
+    Allocate a capture object and open its file
+
+    @param[in]
+        fileName
+            name of the capture file
+
+    @param[in]
+        mode
+            stdio file open mode
+
+    @retval pointer to the capture object
+    @retval NULL if the file could not be opened
+
+==============================================================================*/
+static Capture *NewCapture( const char *fileName, const char *mode )
+{
+    Capture *pCapture = NULL;
+
+    if ( fileName != NULL )
+    {
+        pCapture = calloc( 1, sizeof( Capture ) );
+        if ( pCapture != NULL )
+        {
+            pCapture->fp = fopen( fileName, mode );
+            pCapture->pBuffer = malloc( CAPTURE_BUFFER_SIZE );
+            if ( pCapture->fp == NULL )
+            {
+                CAPTURE_Close( pCapture );
+                pCapture = NULL;
+            }
+            else if ( pCapture->pBuffer != NULL )
+            {
+                setvbuf( pCapture->fp,
+                         pCapture->pBuffer,
+                         _IOFBF,
+                         CAPTURE_BUFFER_SIZE );
+            }
+        }
+    }
+
+    return pCapture;
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the monotonic time in ns
+
+    @retval monotonic time in ns
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  PutTimestamp                                                              */
+/*!
+    Write the time since the previous signal record
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @retval EOK - the timestamp was written
+
+==============================================================================*/
+static int PutTimestamp( Capture *pCapture )
+{
+    uint64_t now = Now() - pCapture->start;
+    uint64_t delta = ( now > pCapture->last ) ? now - pCapture->last : 0;
+
+    pCapture->last += delta;
+    PutVarint( pCapture->fp, delta );
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  IsNamed                                                                   */
+/*!
+    Check if a variable is in the capture name table
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @param[in]
+        hVar
+            variable handle
+
+    @retval true - the variable is in the name table
+    @retval false - the variable is not in the name table
+
+==============================================================================*/
+static bool IsNamed( Capture *pCapture, VAR_HANDLE hVar )
+{
+    size_t idx = (size_t)hVar / 8;
+
+    return ( idx < pCapture->namedSize ) &&
+           ( pCapture->pNamed[idx] & ( 1U << ( hVar % 8 ) ) );
+}
+
+/*============================================================================*/
+/*  SetNamed                                                                  */
+/*!
+    Add a variable to the capture name table bitmap
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @param[in]
+        hVar
+            variable handle
+
+    @retval EOK - the variable was added
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int SetNamed( Capture *pCapture, VAR_HANDLE hVar )
+{
+    int result = EOK;
+    size_t idx = (size_t)hVar / 8;
+    size_t size;
+    uint8_t *p;
+
+    if ( idx >= pCapture->namedSize )
+    {
+        size = ( pCapture->namedSize > 0 ) ? pCapture->namedSize : 64;
+        while ( size <= idx )
+        {
+            size *= 2;
+        }
+
+        p = realloc( pCapture->pNamed, size );
+        if ( p != NULL )
+        {
+            memset( &p[pCapture->namedSize], 0, size - pCapture->namedSize );
+            pCapture->pNamed = p;
+            pCapture->namedSize = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        pCapture->pNamed[idx] |= ( 1U << ( hVar % 8 ) );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ReadVar                                                                   */
+/*!
+    Read the body of a VAR record
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @param[out]
+        pRecord
+            pointer to the record to populate
+
+    @retval EOK - the record was read
+    @retval EBADMSG - the record is corrupt
+    @retval ENOENT - the record is truncated
+
+==============================================================================*/
+static int ReadVar( Capture *pCapture, CaptureRecord *pRecord )
+{
+    int result;
+    uint64_t hVar = 0;
+    uint64_t type = 0;
+    uint64_t len = 0;
+
+    result = GetVarint( pCapture->fp, &hVar );
+    if ( result == EOK )
+    {
+        result = GetVarint( pCapture->fp, &type );
+    }
+
+    if ( result == EOK )
+    {
+        result = GetVarint( pCapture->fp, &len );
+    }
+
+    if ( result == EOK )
+    {
+        if ( len > MAX_NAME_LEN )
+        {
+            result = EBADMSG;
+        }
+        else if ( fread( pRecord->name, 1, len, pCapture->fp ) != len )
+        {
+            result = ENOENT;
+        }
+        else
+        {
+            pRecord->name[len] = '\0';
+            pRecord->hVar = (VAR_HANDLE)hVar;
+            pRecord->value.type = (VarType)type;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ReadValue                                                                 */
+/*!
+    Read the body of a VALUE record
+
+    @param[in]
+        pCapture
+            pointer to the capture object
+
+    @param[out]
+        pRecord
+            pointer to the record to populate
+
+    @retval EOK - the record was read
+    @retval EBADMSG - the record is corrupt
+    @retval ENOMEM - memory allocation failure
+    @retval ENOENT - the record is truncated
+
+==============================================================================*/
+static int ReadValue( Capture *pCapture, CaptureRecord *pRecord )
+{
+    int result;
+    uint64_t hVar = 0;
+    uint64_t type = 0;
+    uint64_t u = 0;
+    int64_t s = 0;
+    VarObject *pObj = &pRecord->value;
+    char *p;
+
+    result = GetVarint( pCapture->fp, &hVar );
+    if ( result == EOK )
+    {
+        pRecord->hVar = (VAR_HANDLE)hVar;
+        result = GetVarint( pCapture->fp, &type );
+    }
+
+    if ( result == EOK )
+    {
+        pObj->type = (VarType)type;
+
+        switch( pObj->type )
+        {
+            case VARTYPE_UINT16:
+            case VARTYPE_UINT32:
+            case VARTYPE_UINT64:
+                result = GetVarint( pCapture->fp, &u );
+                break;
+
+            case VARTYPE_INT16:
+            case VARTYPE_INT32:
+            case VARTYPE_INT64:
+                result = GetSigned( pCapture->fp, &s );
+                break;
+
+            case VARTYPE_FLOAT:
+                pObj->len = sizeof( float );
+                if ( fread( &pObj->val.f, 1, sizeof( float ), pCapture->fp )
+                        != sizeof( float ) )
+                {
+                    result = ENOENT;
+                }
+                break;
+
+            case VARTYPE_STR:
+                result = GetVarint( pCapture->fp, &u );
+                if ( ( result == EOK ) && ( u + 1 > pCapture->strSize ) )
+                {
+                    p = realloc( pCapture->pStr, u + 1 );
+                    if ( p != NULL )
+                    {
+                        pCapture->pStr = p;
+                        pCapture->strSize = u + 1;
+                    }
+                    else
+                    {
+                        result = ENOMEM;
+                    }
+                }
+
+                if ( result == EOK )
+                {
+                    if ( fread( pCapture->pStr, 1, u, pCapture->fp ) == u )
+                    {
+                        pCapture->pStr[u] = '\0';
+                        pObj->val.str = pCapture->pStr;
+                        pObj->len = u + 1;
+                    }
+                    else
+                    {
+                        result = ENOENT;
+                    }
+                }
+                break;
+
+            default:
+                result = EBADMSG;
+                break;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        switch( pObj->type )
+        {
+            case VARTYPE_UINT16:
+                pObj->val.ui = (uint16_t)u;
+                pObj->len = sizeof( uint16_t );
+                break;
+
+            case VARTYPE_INT16:
+                pObj->val.i = (int16_t)s;
+                pObj->len = sizeof( int16_t );
+                break;
+
+            case VARTYPE_UINT32:
+                pObj->val.ul = (uint32_t)u;
+                pObj->len = sizeof( uint32_t );
+                break;
+
+            case VARTYPE_INT32:
+                pObj->val.l = (int32_t)s;
+                pObj->len = sizeof( int32_t );
+                break;
+
+            case VARTYPE_UINT64:
+                pObj->val.ull = u;
+                pObj->len = sizeof( uint64_t );
+                break;
+
+            case VARTYPE_INT64:
+                pObj->val.ll = s;
+                pObj->len = sizeof( int64_t );
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  PutVarint                                                                 */
+/*!
+    Write an unsigned LEB128 variable length integer
+
+    @param[in]
+        fp
+            output stream
+
+    @param[in]
+        value
+            value to write
+
+==============================================================================*/
+static void PutVarint( FILE *fp, uint64_t value )
+{
+    while ( value >= 0x80 )
+    {
+        fputc( (int)( ( value & 0x7F ) | 0x80 ), fp );
+        value >>= 7;
+    }
+
+    fputc( (int)value, fp );
+}
+
+/*============================================================================*/
+/*  PutSigned                                                                 */
+/*!
+    Write a zigzag encoded signed variable length integer
+
+    @param[in]
+        fp
+            output stream
+
+    @param[in]
+        value
+            value to write
+
+==============================================================================*/
+static void PutSigned( FILE *fp, int64_t value )
+{
+    PutVarint( fp, ( (uint64_t)value << 1 ) ^ (uint64_t)( value >> 63 ) );
+}
+
+/*============================================================================*/
+/*  GetVarint                                                                 */
+/*!
+    Read an unsigned LEB128 variable length integer
+
+    @param[in]
+        fp
+            input stream
+
+    @param[out]
+        pValue
+            pointer to the location to store the value
+
+    @retval EOK - the value was read
+    @retval ENOENT - end of file
+    @retval EBADMSG - the value is too long
+
+==============================================================================*/
+static int GetVarint( FILE *fp, uint64_t *pValue )
+{
+    int result = EBADMSG;
+    uint64_t value = 0;
+    unsigned int shift;
+    int c;
+
+    for ( shift = 0 ; shift < 64 ; shift += 7 )
+    {
+        c = fgetc( fp );
+        if ( c == EOF )
+        {
+            result = ENOENT;
+            break;
+        }
+
+        value |= (uint64_t)( c & 0x7F ) << shift;
+        if ( ( c & 0x80 ) == 0 )
+        {
+            *pValue = value;
+            result = EOK;
+            break;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  GetSigned                                                                 */
+/*!
+    Read a zigzag encoded signed variable length integer
+
+    @param[in]
+        fp
+            input stream
+
+    @param[out]
+        pValue
+            pointer to the location to store the value
+
+    @retval EOK - the value was read
+    @retval ENOENT - end of file
+    @retval EBADMSG - the value is too long
+
+==============================================================================*/
+static int GetSigned( FILE *fp, int64_t *pValue )
+{
+    int result;
+    uint64_t u = 0;
+
+    result = GetVarint( fp, &u );
+    if ( result == EOK )
+    {
+        *pValue = (int64_t)( u >> 1 ) ^ -(int64_t)( u & 1 );
+    }
+
+    return result;
+}
+
+/*! @}
+ * end of capture group */
@@ -0,0 +1,1064 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup compress compress
+ * @brief Per-render output compression
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file compress.c
+
+    Output Compression
+
+    The compress module wraps the zstd and lz4 streaming compressors
+    so that each rendered template is emitted as a single self-contained
+    compressed frame.  Consumers can therefore decode each record
+    independently.  A render which does not fit in the render buffer is
+    passed to the compressor in parts with COMPRESS_Update, and its frame
+    is terminated by COMPRESS_Frame.  The compression contexts and output
+    buffers are re-used across renders.
+
+    Support for each algorithm is selected at build time via the
+    HAVE_ZSTD and HAVE_LZ4 definitions.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include "compress.h"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! compressor object */
+struct compressor
+{
+    /*! compression algorithm */
+    CompressType type;
+
+#ifdef HAVE_ZSTD
+    /*! zstd compression context */
+    ZSTD_CCtx *zctx;
+#endif
+
+#ifdef HAVE_LZ4
+    /*! lz4 frame compression context */
+    LZ4F_cctx *lctx;
+
+    /*! lz4 frame preferences */
+    LZ4F_preferences_t prefs;
+#endif
+
+    /*! compressed output buffer used when no arena is given */
+    char *pBuf;
+
+    /*! size of the compressed output buffer */
+    size_t bufSize;
+
+    /*! output buffer of the frame being compressed */
+    char *pOut;
+
+    /*! size of the output buffer of the frame being compressed */
+    size_t outSize;
+
+    /*! a frame has been started by COMPRESS_Update */
+    bool streaming;
+
+    /*! compressed length of the frame in progress */
+    size_t streamOut;
+
+    /*! uncompressed length of the frame in progress */
+    size_t streamIn;
+
+    /*! compression time of the frame in progress (nanoseconds) */
+    uint64_t streamNs;
+
+    /*! compression statistics */
+    CompressStats stats;
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4)
+static int ReserveBuffer( Compressor *pCompressor,
+                          Arena *pArena,
+                          size_t size );
+#endif
+static int CompressZSTD( Compressor *pCompressor,
+                         Arena *pArena,
+                         const char *pIn,
+                         size_t inlen,
+                         size_t *pOutlen );
+static int CompressLZ4( Compressor *pCompressor,
+                        Arena *pArena,
+                        const char *pIn,
+                        size_t inlen,
+                        size_t *pOutlen );
+static int StreamFrame( Compressor *pCompressor,
+                        const char *pIn,
+                        size_t inlen,
+                        bool end );
+static int StreamZSTD( Compressor *pCompressor,
+                       const char *pIn,
+                       size_t inlen,
+                       bool end );
+static int StreamLZ4( Compressor *pCompressor,
+                      const char *pIn,
+                      size_t inlen,
+                      bool end );
+static uint64_t GetTimeNs( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  COMPRESS_TypeFromName                                                     */
+/*!
+    Map a compression algorithm name to its type
+
+    The COMPRESS_TypeFromName function converts the "compress" configuration
+    string into a CompressType.
+
+    @param[in]
+        name
+            name of the compression algorithm ("zstd" or "lz4")
+
+    @retval COMPRESS_ZSTD - zstandard compression
+    @retval COMPRESS_LZ4 - lz4 compression
+    @retval COMPRESS_NONE - no compression or unknown algorithm
+
+==============================================================================*/
+CompressType COMPRESS_TypeFromName( const char *name )
+{
+    CompressType type = COMPRESS_NONE;
+
+    if ( name != NULL )
+    {
+        if ( strcmp( name, "zstd" ) == 0 )
+        {
+            type = COMPRESS_ZSTD;
+        }
+        else if ( strcmp( name, "lz4" ) == 0 )
+        {
+            type = COMPRESS_LZ4;
+        }
+    }
+
+    return type;
+}
+
+/*============================================================================*/
+/*  COMPRESS_Name                                                             */
+/*!
+    Get the name of a compression algorithm
+
+    @param[in]
+        type
+            compression algorithm type
+
+    @retval pointer to the compression algorithm name
+
+==============================================================================*/
+const char *COMPRESS_Name( CompressType type )
+{
+    switch( type )
+    {
+        case COMPRESS_ZSTD:
+            return "zstd";
+
+        case COMPRESS_LZ4:
+            return "lz4";
+
+        default:
+            return "none";
+    }
+}
+
+/*============================================================================*/
+/*  COMPRESS_Create                                                           */
+/*!
+    Create a compressor
+
+    The COMPRESS_Create function allocates a compressor object and its
+    associated compression context.
+
+    @param[in]
+        type
+            compression algorithm type
+
+    @retval pointer to the new compressor
+    @retval NULL if the algorithm is not supported by this build or
+            the compressor could not be created
+
+==============================================================================*/
+Compressor *COMPRESS_Create( CompressType type )
+{
+    Compressor *pCompressor = NULL;
+    int result = ENOTSUP;
+
+    pCompressor = calloc( 1, sizeof( Compressor ) );
+    if ( pCompressor != NULL )
+    {
+        pCompressor->type = type;
+
+        switch( type )
+        {
+#ifdef HAVE_ZSTD
+            case COMPRESS_ZSTD:
+                pCompressor->zctx = ZSTD_createCCtx();
+                if ( pCompressor->zctx != NULL )
+                {
+                    ZSTD_CCtx_setParameter( pCompressor->zctx,
+                                            ZSTD_c_contentSizeFlag,
+                                            1 );
+                    result = EOK;
+                }
+                break;
+#endif
+
+#ifdef HAVE_LZ4
+            case COMPRESS_LZ4:
+                if ( !LZ4F_isError(
+                        LZ4F_createCompressionContext( &pCompressor->lctx,
+                                                       LZ4F_VERSION ) ) )
+                {
+                    memset( &pCompressor->prefs,
+                            0,
+                            sizeof( pCompressor->prefs ) );
+                    pCompressor->prefs.frameInfo.contentChecksumFlag =
+                        LZ4F_noContentChecksum;
+                    result = EOK;
+                }
+                break;
+#endif
+
+            default:
+                break;
+        }
+
+        if ( result != EOK )
+        {
+            COMPRESS_Delete( pCompressor );
+            pCompressor = NULL;
+        }
+    }
+
+    return pCompressor;
+}
+
+/*============================================================================*/
+/*  COMPRESS_Frame                                                            */
+/*!
+    Compress a rendered template into a single frame
+
+    The COMPRESS_Frame function compresses the input buffer and terminates
+    the frame so the output can be decoded independently of any previous
+    output.  When an arena is given, the output buffer is allocated from
+    it, and is valid until the arena is reset.  Otherwise the output
+    buffer is owned by the compressor, and is valid until the next call
+    to COMPRESS_Frame.  If the frame was started by COMPRESS_Update, the
+    input is the last part of the render, and the output buffer is always
+    owned by the compressor.
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+    @param[in]
+        pArena
+            arena to allocate the output buffer from (or NULL)
+
+    @param[in]
+        pIn
+            pointer to the uncompressed data
+
+    @param[in]
+        inlen
+            length of the uncompressed data
+
+    @param[out]
+        ppOut
+            pointer to a location to store the compressed data pointer
+
+    @param[out]
+        pOutlen
+            pointer to a location to store the compressed data length
+
+    @retval EOK - the frame was compressed successfully
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - the compressor reported an error
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int COMPRESS_Frame( Compressor *pCompressor,
+                    Arena *pArena,
+                    const char *pIn,
+                    size_t inlen,
+                    const char **ppOut,
+                    size_t *pOutlen )
+{
+    int result = EINVAL;
+    uint64_t start;
+    size_t outlen = 0;
+
+    if ( ( pCompressor != NULL ) &&
+         ( pIn != NULL ) &&
+         ( ppOut != NULL ) &&
+         ( pOutlen != NULL ) )
+    {
+        start = GetTimeNs();
+
+        if ( pCompressor->streaming == true )
+        {
+            /* terminate the frame started by COMPRESS_Update */
+            result = StreamFrame( pCompressor, pIn, inlen, true );
+            inlen = pCompressor->streamIn;
+            outlen = pCompressor->streamOut;
+            start -= pCompressor->streamNs;
+
+            /* the next render starts a new frame */
+            COMPRESS_Abort( pCompressor );
+        }
+        else if ( pCompressor->type == COMPRESS_ZSTD )
+        {
+            result = CompressZSTD( pCompressor,
+                                   pArena,
+                                   pIn,
+                                   inlen,
+                                   &outlen );
+        }
+        else if ( pCompressor->type == COMPRESS_LZ4 )
+        {
+            result = CompressLZ4( pCompressor,
+                                  pArena,
+                                  pIn,
+                                  inlen,
+                                  &outlen );
+        }
+        else
+        {
+            result = ENOTSUP;
+        }
+
+        if ( result == EOK )
+        {
+            pCompressor->stats.lastIn = inlen;
+            pCompressor->stats.lastOut = outlen;
+            pCompressor->stats.lastNs = GetTimeNs() - start;
+            pCompressor->stats.frames++;
+            pCompressor->stats.bytesIn += inlen;
+            pCompressor->stats.bytesOut += outlen;
+            pCompressor->stats.ns += pCompressor->stats.lastNs;
+
+            *ppOut = pCompressor->pOut;
+            *pOutlen = outlen;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  COMPRESS_Update                                                           */
+/*!
+    Compress part of a render which does not fit in the render buffer
+
+    The COMPRESS_Update function starts a frame, if one is not already in
+    progress, and compresses the input into it.  The frame is terminated
+    by COMPRESS_Frame with the last part of the render, or discarded by
+    COMPRESS_Abort.  The compressed output grows in the compressor's own
+    buffer, as its final size is not known in advance.
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+    @param[in]
+        pIn
+            pointer to the uncompressed data
+
+    @param[in]
+        inlen
+            length of the uncompressed data
+
+    @retval EOK - the data was compressed into the frame
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - the compressor reported an error
+    @retval ENOTSUP - the compression algorithm is not built in
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int COMPRESS_Update( Compressor *pCompressor, const char *pIn, size_t inlen )
+{
+    int result = EINVAL;
+    uint64_t start;
+
+    if ( ( pCompressor != NULL ) &&
+         ( pIn != NULL ) )
+    {
+        start = GetTimeNs();
+
+        result = StreamFrame( pCompressor, pIn, inlen, false );
+        if ( result == EOK )
+        {
+            pCompressor->streamNs += GetTimeNs() - start;
+        }
+        else
+        {
+            COMPRESS_Abort( pCompressor );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  COMPRESS_Abort                                                            */
+/*!
+    Discard the frame started by COMPRESS_Update
+
+    The COMPRESS_Abort function is used when a render fails part way
+    through, so that the next render starts a new frame.  It does nothing
+    if no frame is in progress.  It is also used to release the frame
+    state once COMPRESS_Frame has terminated the frame.
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+==============================================================================*/
+void COMPRESS_Abort( Compressor *pCompressor )
+{
+    if ( ( pCompressor != NULL ) &&
+         ( pCompressor->streaming == true ) )
+    {
+#ifdef HAVE_ZSTD
+        if ( pCompressor->zctx != NULL )
+        {
+            (void)ZSTD_CCtx_reset( pCompressor->zctx,
+                                   ZSTD_reset_session_only );
+        }
+#endif
+
+        /* an lz4 frame is reset when the next frame is begun */
+        pCompressor->streaming = false;
+        pCompressor->streamIn = 0;
+        pCompressor->streamOut = 0;
+        pCompressor->streamNs = 0;
+    }
+}
+
+/*============================================================================*/
+/*  COMPRESS_GetStats                                                         */
+/*!
+    Get the compressor statistics
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+    @retval pointer to the compressor statistics
+    @retval NULL if the compressor is invalid
+
+==============================================================================*/
+const CompressStats *COMPRESS_GetStats( Compressor *pCompressor )
+{
+    return ( pCompressor != NULL ) ? &pCompressor->stats : NULL;
+}
+
+/*============================================================================*/
+/*  COMPRESS_Delete                                                           */
+/*!
+    Delete a compressor
+
+    The COMPRESS_Delete function releases the compression context
+    and output buffer associated with the compressor.
+
+    @param[in]
+        pCompressor
+            pointer to the compressor to delete
+
+==============================================================================*/
+void COMPRESS_Delete( Compressor *pCompressor )
+{
+    if ( pCompressor != NULL )
+    {
+#ifdef HAVE_ZSTD
+        if ( pCompressor->zctx != NULL )
+        {
+            ZSTD_freeCCtx( pCompressor->zctx );
+        }
+#endif
+
+#ifdef HAVE_LZ4
+        if ( pCompressor->lctx != NULL )
+        {
+            LZ4F_freeCompressionContext( pCompressor->lctx );
+        }
+#endif
+
+        free( pCompressor->pBuf );
+        free( pCompressor );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4)
+/*============================================================================*/
+/*  ReserveBuffer                                                             */
+/*!
+    Set up the output buffer of a frame
+
+    The output buffer is allocated from the arena if one is given, and
+    otherwise the compressor's own buffer is grown to fit.
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+    @param[in]
+        pArena
+            arena to allocate the output buffer from (or NULL)
+
+    @param[in]
+        size
+            required buffer size
+
+    @retval EOK - the output buffer is large enough
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int ReserveBuffer( Compressor *pCompressor,
+                          Arena *pArena,
+                          size_t size )
+{
+    int result = EOK;
+    char *p;
+
+    if ( pArena != NULL )
+    {
+        pCompressor->pOut = ARENA_Alloc( pArena, size );
+        pCompressor->outSize = size;
+        if ( pCompressor->pOut == NULL )
+        {
+            result = ENOMEM;
+        }
+    }
+    else if ( size > pCompressor->bufSize )
+    {
+        p = realloc( pCompressor->pBuf, size );
+        if ( p != NULL )
+        {
+            pCompressor->pBuf = p;
+            pCompressor->bufSize = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( pArena == NULL )
+    {
+        pCompressor->pOut = pCompressor->pBuf;
+        pCompressor->outSize = pCompressor->bufSize;
+    }
+
+    return result;
+}
+
+#endif
+
+/*============================================================================*/
+/*  CompressZSTD                                                              */
+/*!
+    Compress a buffer into a single zstd frame
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+    @param[in]
+        pArena
+            arena to allocate the output buffer from (or NULL)
+
+    @param[in]
+        pIn
+            pointer to the uncompressed data
+
+    @param[in]
+        inlen
+            length of the uncompressed data
+
+    @param[out]
+        pOutlen
+            pointer to a location to store the compressed length
+
+    @retval EOK - the frame was compressed successfully
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - compression failed
+    @retval ENOTSUP - zstd support is not built in
+
+==============================================================================*/
+static int CompressZSTD( Compressor *pCompressor,
+                         Arena *pArena,
+                         const char *pIn,
+                         size_t inlen,
+                         size_t *pOutlen )
+{
+#ifdef HAVE_ZSTD
+    int result;
+    size_t n;
+
+    result = ReserveBuffer( pCompressor,
+                            pArena,
+                            ZSTD_compressBound( inlen ) );
+    if ( result == EOK )
+    {
+        /* ZSTD_compress2 always ends the frame, so each render
+           is independently decodable */
+        n = ZSTD_compress2( pCompressor->zctx,
+                            pCompressor->pOut,
+                            pCompressor->outSize,
+                            pIn,
+                            inlen );
+        if ( ZSTD_isError( n ) )
+        {
+            result = EIO;
+        }
+        else
+        {
+            *pOutlen = n;
+        }
+    }
+
+    return result;
+#else
+    (void)pCompressor;
+    (void)pArena;
+    (void)pIn;
+    (void)inlen;
+    (void)pOutlen;
+    return ENOTSUP;
+#endif
+}
+
+/*============================================================================*/
+/*  CompressLZ4                                                               */
+/*!
+    Compress a buffer into a single lz4 frame
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+    @param[in]
+        pArena
+            arena to allocate the output buffer from (or NULL)
+
+    @param[in]
+        pIn
+            pointer to the uncompressed data
+
+    @param[in]
+        inlen
+            length of the uncompressed data
+
+    @param[out]
+        pOutlen
+            pointer to a location to store the compressed length
+
+    @retval EOK - the frame was compressed successfully
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - compression failed
+    @retval ENOTSUP - lz4 support is not built in
+
+==============================================================================*/
+static int CompressLZ4( Compressor *pCompressor,
+                        Arena *pArena,
+                        const char *pIn,
+                        size_t inlen,
+                        size_t *pOutlen )
+{
+#ifdef HAVE_LZ4
+    int result;
+    size_t n;
+    size_t total = 0;
+    size_t cap;
+
+    cap = LZ4F_compressFrameBound( inlen, &pCompressor->prefs );
+    result = ReserveBuffer( pCompressor, pArena, cap );
+    if ( result == EOK )
+    {
+        result = EIO;
+
+        n = LZ4F_compressBegin( pCompressor->lctx,
+                                pCompressor->pOut,
+                                cap,
+                                &pCompressor->prefs );
+        if ( !LZ4F_isError( n ) )
+        {
+            total += n;
+            n = LZ4F_compressUpdate( pCompressor->lctx,
+                                     pCompressor->pOut + total,
+                                     cap - total,
+                                     pIn,
+                                     inlen,
+                                     NULL );
+            if ( !LZ4F_isError( n ) )
+            {
+                total += n;
+
+                /* close the frame at the render boundary */
+                n = LZ4F_compressEnd( pCompressor->lctx,
+                                      pCompressor->pOut + total,
+                                      cap - total,
+                                      NULL );
+                if ( !LZ4F_isError( n ) )
+                {
+                    total += n;
+                    *pOutlen = total;
+                    result = EOK;
+                }
+            }
+        }
+    }
+
+    return result;
+#else
+    (void)pCompressor;
+    (void)pArena;
+    (void)pIn;
+    (void)inlen;
+    (void)pOutlen;
+    return ENOTSUP;
+#endif
+}
+
+/*============================================================================*/
+/*  StreamFrame                                                               */
+/*!
+    Compress part of a frame into the compressor's own buffer
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+    @param[in]
+        pIn
+            pointer to the uncompressed data
+
+    @param[in]
+        inlen
+            length of the uncompressed data
+
+    @param[in]
+        end
+            true to terminate the frame after the data
+
+    @retval EOK - the data was compressed into the frame
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - compression failed
+    @retval ENOTSUP - the compression algorithm is not built in
+
+==============================================================================*/
+static int StreamFrame( Compressor *pCompressor,
+                        const char *pIn,
+                        size_t inlen,
+                        bool end )
+{
+    int result;
+
+    if ( pCompressor->type == COMPRESS_ZSTD )
+    {
+        result = StreamZSTD( pCompressor, pIn, inlen, end );
+    }
+    else if ( pCompressor->type == COMPRESS_LZ4 )
+    {
+        result = StreamLZ4( pCompressor, pIn, inlen, end );
+    }
+    else
+    {
+        result = ENOTSUP;
+    }
+
+    if ( result == EOK )
+    {
+        pCompressor->streaming = true;
+        pCompressor->streamIn += inlen;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  StreamZSTD                                                                */
+/*!
+    Compress part of a zstd frame
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+    @param[in]
+        pIn
+            pointer to the uncompressed data
+
+    @param[in]
+        inlen
+            length of the uncompressed data
+
+    @param[in]
+        end
+            true to terminate the frame after the data
+
+    @retval EOK - the data was compressed into the frame
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - compression failed
+    @retval ENOTSUP - zstd support is not built in
+
+==============================================================================*/
+static int StreamZSTD( Compressor *pCompressor,
+                       const char *pIn,
+                       size_t inlen,
+                       bool end )
+{
+#ifdef HAVE_ZSTD
+    int result = EOK;
+    ZSTD_inBuffer in;
+    ZSTD_outBuffer out;
+    size_t remaining;
+    bool done = false;
+
+    in.src = pIn;
+    in.size = inlen;
+    in.pos = 0;
+
+    while ( ( result == EOK ) && ( done == false ) )
+    {
+        result = ReserveBuffer( pCompressor,
+                                NULL,
+                                pCompressor->streamOut +
+                                    ZSTD_CStreamOutSize() );
+        if ( result == EOK )
+        {
+            out.dst = pCompressor->pOut;
+            out.size = pCompressor->outSize;
+            out.pos = pCompressor->streamOut;
+
+            remaining = ZSTD_compressStream2( pCompressor->zctx,
+                                              &out,
+                                              &in,
+                                              end ? ZSTD_e_end
+                                                  : ZSTD_e_continue );
+            if ( ZSTD_isError( remaining ) )
+            {
+                result = EIO;
+            }
+            else
+            {
+                /* the end of a frame may need more than one call */
+                pCompressor->streamOut = out.pos;
+                done = ( end == true ) ? ( remaining == 0 )
+                                       : ( in.pos == in.size );
+            }
+        }
+    }
+
+    return result;
+#else
+    (void)pCompressor;
+    (void)pIn;
+    (void)inlen;
+    (void)end;
+    return ENOTSUP;
+#endif
+}
+
+/*============================================================================*/
+/*  StreamLZ4                                                                 */
+/*!
+    Compress part of an lz4 frame
+
+    @param[in]
+        pCompressor
+            pointer to the compressor
+
+    @param[in]
+        pIn
+            pointer to the uncompressed data
+
+    @param[in]
+        inlen
+            length of the uncompressed data
+
+    @param[in]
+        end
+            true to terminate the frame after the data
+
+    @retval EOK - the data was compressed into the frame
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - compression failed
+    @retval ENOTSUP - lz4 support is not built in
+
+==============================================================================*/
+static int StreamLZ4( Compressor *pCompressor,
+                      const char *pIn,
+                      size_t inlen,
+                      bool end )
+{
+#ifdef HAVE_LZ4
+    int result = EOK;
+    size_t n;
+
+    if ( pCompressor->streaming == false )
+    {
+        /* begin the frame */
+        result = ReserveBuffer( pCompressor, NULL, LZ4F_HEADER_SIZE_MAX );
+        if ( result == EOK )
+        {
+            n = LZ4F_compressBegin( pCompressor->lctx,
+                                    pCompressor->pOut,
+                                    pCompressor->outSize,
+                                    &pCompressor->prefs );
+            result = LZ4F_isError( n ) ? EIO : EOK;
+            pCompressor->streamOut = LZ4F_isError( n ) ? 0 : n;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        result = ReserveBuffer( pCompressor,
+                                NULL,
+                                pCompressor->streamOut +
+                                    LZ4F_compressBound( inlen,
+                                                        &pCompressor->prefs ) );
+    }
+
+    if ( result == EOK )
+    {
+        n = LZ4F_compressUpdate( pCompressor->lctx,
+                                 pCompressor->pOut + pCompressor->streamOut,
+                                 pCompressor->outSize - pCompressor->streamOut,
+                                 pIn,
+                                 inlen,
+                                 NULL );
+        if ( LZ4F_isError( n ) )
+        {
+            result = EIO;
+        }
+        else
+        {
+            pCompressor->streamOut += n;
+        }
+    }
+
+    if ( ( result == EOK ) && ( end == true ) )
+    {
+        /* the bound of an empty update covers the buffered data and the
+           end of the frame */
+        result = ReserveBuffer( pCompressor,
+                                NULL,
+                                pCompressor->streamOut +
+                                    LZ4F_compressBound( 0,
+                                                        &pCompressor->prefs ) );
+    }
+
+    if ( ( result == EOK ) && ( end == true ) )
+    {
+        n = LZ4F_compressEnd( pCompressor->lctx,
+                              pCompressor->pOut + pCompressor->streamOut,
+                              pCompressor->outSize - pCompressor->streamOut,
+                              NULL );
+        if ( LZ4F_isError( n ) )
+        {
+            result = EIO;
+        }
+        else
+        {
+            pCompressor->streamOut += n;
+        }
+    }
+
+    return result;
+#else
+    (void)pCompressor;
+    (void)pIn;
+    (void)inlen;
+    (void)end;
+    return ENOTSUP;
+#endif
+}
+
+/*============================================================================*/
+/*  GetTimeNs                                                                 */
+/*!
+    Get the monotonic time in nanoseconds
+
+    @retval monotonic clock time in nanoseconds
+
+==============================================================================*/
+static uint64_t GetTimeNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * 1000000000ULL ) + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of compress group */
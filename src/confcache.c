@@ -0,0 +1,1384 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup confcache confcache
+ * @brief Compiled configuration cache
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file confcache.c
+
+    Compiled configuration cache
+
+    The confcache module stores the template definitions of the service
+    configuration in a compact binary file, so that a large configuration
+    does not have to be parsed again on the next start.  The cache file
+    is mapped into memory, and the definitions read from it refer to the
+    strings in the mapping directly, so loading it costs one pass over
+    the records.
+
+    A cache file consists of a header, followed by the trigger records,
+    the template records, the structured output variable records and a
+    string table.  Every string is interned, so a variable name which is
+    referenced by many templates is stored once, and records refer to
+    strings by their offset in the string table.
+
+    The header also holds the tenant attributes of the configuration
+    file (see ConfTenant).
+
+    The header records the size, modification time and FNV-1a hash of
+    the configuration file the cache was built from.  A cache file is
+    only used if all three match the current configuration file, so an
+    edited configuration is parsed again, even if its size and
+    modification time are unchanged.  The cache is written to a
+    temporary file which is renamed over the old cache, so a cache file
+    is never seen partially written.
+
+    The cache file is in the native byte order and layout, and is not
+    intended to be shared between machines.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "confcache.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! cache file magic number */
+#define CONFCACHE_MAGIC         "TSVCCONF"
+
+/*! length of the cache file magic number */
+#define CONFCACHE_MAGIC_LEN     ( 8 )
+
+/*! cache file format version */
+#define CONFCACHE_VERSION       ( 3 )
+
+/*! string offset of an absent string */
+#define CONFCACHE_NONE          ( UINT32_MAX )
+
+/*! number of string attributes of a template definition */
+#define CONFCACHE_NUM_STRINGS   ( 8 )
+
+/*! initial number of string intern slots (must be a power of 2) */
+#define CONFCACHE_INITIAL_SLOTS ( 1024 )
+
+/*! size of the buffer used to hash the configuration file */
+#define CONFCACHE_READ_SIZE     ( 64 * 1024 )
+
+/*! template flag: append to the target */
+#define CONFCACHE_APPEND        ( 1U << 0 )
+
+/*! template flag: keep the target open */
+#define CONFCACHE_KEEP_OPEN     ( 1U << 1 )
+
+/*! template flag: incremental rendering */
+#define CONFCACHE_INCREMENTAL   ( 1U << 2 )
+
+/*! template flag: triggers derived from the template references */
+#define CONFCACHE_AUTO_TRIGGER  ( 1U << 3 )
+
+/*! template flag: numeric values formatted natively */
+#define CONFCACHE_NATIVE_FORMAT ( 1U << 4 )
+
+/*! identity of the configuration file a cache was built from */
+typedef struct configKey
+{
+    /*! size of the configuration file */
+    uint64_t size;
+
+    /*! modification time of the configuration file in ns */
+    int64_t mtimeNs;
+
+    /*! FNV-1a hash of the configuration file contents */
+    uint64_t hash;
+
+} ConfigKey;
+
+/*! cache file tenant record */
+typedef struct cacheTenant
+{
+    /*! offset of the tenant name */
+    uint32_t name;
+
+    /*! render priority */
+    int32_t priority;
+
+    /*! maximum number of templates */
+    uint32_t maxTemplates;
+
+    /*! maximum number of renders per second */
+    uint32_t maxRendersPerSec;
+
+} CacheTenant;
+
+/*! cache file header */
+typedef struct cacheHeader
+{
+    /*! magic number */
+    char magic[CONFCACHE_MAGIC_LEN];
+
+    /*! format version */
+    uint32_t version;
+
+    /*! number of template records */
+    uint32_t numTemplates;
+
+    /*! number of trigger records */
+    uint32_t numTriggers;
+
+    /*! number of variable records */
+    uint32_t numVars;
+
+    /*! configuration file the cache was built from */
+    ConfigKey key;
+
+    /*! tenant attributes of the configuration file */
+    CacheTenant tenant;
+
+    /*! size of the string table */
+    uint64_t stringsSize;
+
+} CacheHeader;
+
+/*! cache file trigger record */
+typedef struct cacheTrigger
+{
+    /*! offset of the trigger variable name */
+    uint32_t name;
+
+    /*! condition of the trigger */
+    uint32_t condition;
+
+    /*! deadband width, or level, of the condition */
+    double level;
+
+} CacheTrigger;
+
+/*! cache file template record */
+typedef struct cacheTemplate
+{
+    /*! offsets of the string attributes (see stringAttrs) */
+    uint32_t strings[CONFCACHE_NUM_STRINGS];
+
+    /*! template flags */
+    uint32_t flags;
+
+    /*! periodic render interval in milliseconds */
+    uint32_t intervalMs;
+
+    /*! index of the first trigger record */
+    uint32_t firstTrigger;
+
+    /*! number of trigger records */
+    uint32_t numTriggers;
+
+    /*! index of the first variable record */
+    uint32_t firstVar;
+
+    /*! number of variable records */
+    uint32_t numVars;
+
+    /*! number of excluded variable records, following the variables */
+    uint32_t numExclude;
+
+} CacheTemplate;
+
+/*! compiled configuration cache */
+struct confCache
+{
+    /*! true if the cache is being built, false if it is being read */
+    bool writing;
+
+    /*! name of the cache file */
+    char *fileName;
+
+    /*! configuration file the cache is built from */
+    ConfigKey key;
+
+    /*! tenant attributes of the configuration file */
+    CacheTenant tenant;
+
+    /*! template records */
+    CacheTemplate *pTemplates;
+
+    /*! number of template records */
+    size_t numTemplates;
+
+    /*! allocated number of template records */
+    size_t templatesSize;
+
+    /*! trigger records */
+    CacheTrigger *pTriggers;
+
+    /*! number of trigger records */
+    size_t numTriggers;
+
+    /*! allocated number of trigger records */
+    size_t triggersSize;
+
+    /*! variable records */
+    uint32_t *pVars;
+
+    /*! number of variable records */
+    size_t numVars;
+
+    /*! allocated number of variable records */
+    size_t varsSize;
+
+    /*! string table */
+    char *pStrings;
+
+    /*! length of the string table */
+    size_t stringsLen;
+
+    /*! allocated size of the string table */
+    size_t stringsSize;
+
+    /*! string intern hash table of string offsets */
+    uint32_t *pSlots;
+
+    /*! number of intern slots (power of 2) */
+    size_t numSlots;
+
+    /*! number of interned strings */
+    size_t numStrings;
+
+    /*! memory mapping of the cache file being read */
+    void *pMap;
+
+    /*! size of the memory mapping */
+    size_t mapSize;
+};
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! string attributes of a template definition, in cache record order */
+static const size_t stringAttrs[CONFCACHE_NUM_STRINGS] =
+{
+    offsetof( ConfTemplate, name ),
+    offsetof( ConfTemplate, template ),
+    offsetof( ConfTemplate, type ),
+    offsetof( ConfTemplate, target ),
+    offsetof( ConfTemplate, compress ),
+    offsetof( ConfTemplate, format ),
+    offsetof( ConfTemplate, prefix ),
+    offsetof( ConfTemplate, commit )
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int GetConfigKey( const char *configName, ConfigKey *pKey );
+static uint64_t Hash( uint64_t h, const void *p, size_t len );
+static int Intern( ConfCache *pCache, const char *str, uint32_t *pOffset );
+static int GrowSlots( ConfCache *pCache );
+static int Reserve( void **pp, size_t *pSize, size_t count, size_t elemSize );
+static bool Validate( ConfCache *pCache );
+static bool ValidString( ConfCache *pCache, uint32_t offset );
+static char *String( ConfCache *pCache, uint32_t offset );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  CONFCACHE_Create                                                          */
+/*!
+    Start building a configuration cache
+
+    The CONFCACHE_Create function identifies the configuration file the
+    cache is built from.  It must be called before the configuration
+    file is parsed, so a configuration file which is modified while it
+    is being parsed does not match the cache.
+
+    @param[in]
+        fileName
+            name of the cache file to write
+
+    @param[in]
+        configName
+            name of the configuration file
+
+    @retval pointer to the configuration cache object
+    @retval NULL if the configuration file could not be read
+
+==============================================================================*/
+ConfCache *CONFCACHE_Create( const char *fileName, const char *configName )
+{
+    ConfCache *pCache = NULL;
+
+    if ( ( fileName != NULL ) &&
+         ( configName != NULL ) )
+    {
+        pCache = calloc( 1, sizeof( ConfCache ) );
+        if ( pCache != NULL )
+        {
+            pCache->writing = true;
+            pCache->fileName = strdup( fileName );
+            pCache->pSlots = malloc( CONFCACHE_INITIAL_SLOTS *
+                                     sizeof( uint32_t ) );
+            if ( ( pCache->fileName == NULL ) ||
+                 ( pCache->pSlots == NULL ) ||
+                 ( GetConfigKey( configName, &pCache->key ) != EOK ) )
+            {
+                CONFCACHE_Close( pCache );
+                pCache = NULL;
+            }
+            else
+            {
+                pCache->numSlots = CONFCACHE_INITIAL_SLOTS;
+                pCache->tenant.name = CONFCACHE_NONE;
+                memset( pCache->pSlots,
+                        0xFF,
+                        CONFCACHE_INITIAL_SLOTS * sizeof( uint32_t ) );
+            }
+        }
+    }
+
+    return pCache;
+}
+
+/*============================================================================*/
+/*  CONFCACHE_Add                                                             */
+/*!
+    Add a template definition to a configuration cache
+
+    @param[in]
+        pCache
+            pointer to the configuration cache being built
+
+    @param[in]
+        pDef
+            pointer to the template definition to add
+
+    @retval EOK - the template definition was added
+    @retval ENOMEM - memory allocation failure
+    @retval E2BIG - the cache is too large
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CONFCACHE_Add( ConfCache *pCache, const ConfTemplate *pDef )
+{
+    int result = EINVAL;
+    CacheTemplate *pRecord;
+    CacheTrigger *pTrigger;
+    char *str;
+    size_t i;
+
+    if ( ( pCache != NULL ) &&
+         ( pCache->writing == true ) &&
+         ( pDef != NULL ) )
+    {
+        result = Reserve( (void **)&pCache->pTemplates,
+                          &pCache->templatesSize,
+                          pCache->numTemplates + 1,
+                          sizeof( CacheTemplate ) );
+        if ( result == EOK )
+        {
+            result = Reserve( (void **)&pCache->pTriggers,
+                              &pCache->triggersSize,
+                              pCache->numTriggers + pDef->numTriggers,
+                              sizeof( CacheTrigger ) );
+        }
+
+        if ( result == EOK )
+        {
+            result = Reserve( (void **)&pCache->pVars,
+                              &pCache->varsSize,
+                              pCache->numVars + pDef->numVars +
+                              pDef->numExclude,
+                              sizeof( uint32_t ) );
+        }
+
+        if ( result == EOK )
+        {
+            pRecord = &pCache->pTemplates[pCache->numTemplates];
+            memset( pRecord, 0, sizeof( CacheTemplate ) );
+
+            for ( i = 0 ;
+                  ( i < CONFCACHE_NUM_STRINGS ) && ( result == EOK ) ;
+                  i++ )
+            {
+                str = *(char **)( (const char *)pDef + stringAttrs[i] );
+                result = Intern( pCache, str, &pRecord->strings[i] );
+            }
+
+            pRecord->flags = ( pDef->append ? CONFCACHE_APPEND : 0 ) |
+                             ( pDef->keep_open ? CONFCACHE_KEEP_OPEN : 0 ) |
+                             ( pDef->incremental ? CONFCACHE_INCREMENTAL : 0 );
+            pRecord->flags |= ( pDef->autoTrigger ? CONFCACHE_AUTO_TRIGGER
+                                                  : 0 ) |
+                              ( pDef->nativeFormat ? CONFCACHE_NATIVE_FORMAT
+                                                   : 0 );
+            pRecord->intervalMs = pDef->intervalMs;
+            pRecord->firstTrigger = (uint32_t)pCache->numTriggers;
+            pRecord->numTriggers = (uint32_t)pDef->numTriggers;
+            pRecord->firstVar = (uint32_t)pCache->numVars;
+            pRecord->numVars = (uint32_t)pDef->numVars;
+            pRecord->numExclude = (uint32_t)pDef->numExclude;
+
+            for ( i = 0 ; ( i < pDef->numTriggers ) && ( result == EOK ) ; i++ )
+            {
+                pTrigger = &pCache->pTriggers[pCache->numTriggers + i];
+                pTrigger->condition = pDef->pTriggers[i].condition;
+                pTrigger->level = pDef->pTriggers[i].level;
+                result = Intern( pCache,
+                                 pDef->pTriggers[i].name,
+                                 &pTrigger->name );
+            }
+
+            for ( i = 0 ; ( i < pDef->numVars ) && ( result == EOK ) ; i++ )
+            {
+                result = Intern( pCache,
+                                 pDef->pVars[i],
+                                 &pCache->pVars[pCache->numVars + i] );
+            }
+
+            for ( i = 0 ; ( i < pDef->numExclude ) && ( result == EOK ) ; i++ )
+            {
+                result = Intern( pCache,
+                                 pDef->pExclude[i],
+                                 &pCache->pVars[pCache->numVars +
+                                                pDef->numVars + i] );
+            }
+
+            if ( result == EOK )
+            {
+                pCache->numTemplates++;
+                pCache->numTriggers += pDef->numTriggers;
+                pCache->numVars += pDef->numVars + pDef->numExclude;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CONFCACHE_SetTenant                                                       */
+/*!
+    Set the tenant attributes of a configuration cache
+
+    @param[in]
+        pCache
+            pointer to the configuration cache being built
+
+    @param[in]
+        pTenant
+            pointer to the tenant attributes of the configuration
+
+    @retval EOK - the tenant attributes were set
+    @retval ENOMEM - memory allocation failure
+    @retval E2BIG - the cache is too large
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CONFCACHE_SetTenant( ConfCache *pCache, const ConfTenant *pTenant )
+{
+    int result = EINVAL;
+
+    if ( ( pCache != NULL ) &&
+         ( pCache->writing == true ) &&
+         ( pTenant != NULL ) )
+    {
+        result = Intern( pCache, pTenant->name, &pCache->tenant.name );
+        pCache->tenant.priority = pTenant->priority;
+        pCache->tenant.maxTemplates = pTenant->maxTemplates;
+        pCache->tenant.maxRendersPerSec = pTenant->maxRendersPerSec;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CONFCACHE_Save                                                            */
+/*!
+    Write a configuration cache file
+
+    The CONFCACHE_Save function writes the template definitions added to
+    the cache to a temporary file, and renames it over the cache file.
+
+    @param[in]
+        pCache
+            pointer to the configuration cache being built
+
+    @retval EOK - the cache file was written
+    @retval EINVAL - invalid arguments
+    @retval other - error returned by the file operations
+
+==============================================================================*/
+int CONFCACHE_Save( ConfCache *pCache )
+{
+    int result = EINVAL;
+    CacheHeader header;
+    char *tmpName;
+    size_t len;
+    FILE *fp = NULL;
+    bool ok;
+
+    if ( ( pCache != NULL ) &&
+         ( pCache->writing == true ) )
+    {
+        memset( &header, 0, sizeof( header ) );
+        memcpy( header.magic, CONFCACHE_MAGIC, CONFCACHE_MAGIC_LEN );
+        header.version = CONFCACHE_VERSION;
+        header.numTemplates = (uint32_t)pCache->numTemplates;
+        header.numTriggers = (uint32_t)pCache->numTriggers;
+        header.numVars = (uint32_t)pCache->numVars;
+        header.key = pCache->key;
+        header.tenant = pCache->tenant;
+        header.stringsSize = pCache->stringsLen;
+
+        len = strlen( pCache->fileName ) + sizeof( ".tmp" );
+        tmpName = malloc( len );
+        if ( tmpName != NULL )
+        {
+            snprintf( tmpName, len, "%s.tmp", pCache->fileName );
+            fp = fopen( tmpName, "w" );
+        }
+
+        if ( fp == NULL )
+        {
+            result = ( tmpName != NULL ) ? errno : ENOMEM;
+        }
+        else
+        {
+            ok = ( fwrite( &header, sizeof( header ), 1, fp ) == 1 ) &&
+                 ( fwrite( pCache->pTriggers,
+                           sizeof( CacheTrigger ),
+                           pCache->numTriggers,
+                           fp ) == pCache->numTriggers ) &&
+                 ( fwrite( pCache->pTemplates,
+                           sizeof( CacheTemplate ),
+                           pCache->numTemplates,
+                           fp ) == pCache->numTemplates ) &&
+                 ( fwrite( pCache->pVars,
+                           sizeof( uint32_t ),
+                           pCache->numVars,
+                           fp ) == pCache->numVars ) &&
+                 ( fwrite( pCache->pStrings,
+                           1,
+                           pCache->stringsLen,
+                           fp ) == pCache->stringsLen );
+
+            result = ( fclose( fp ) == 0 ) && ( ok == true ) ? EOK : EIO;
+            if ( result == EOK )
+            {
+                result = ( rename( tmpName, pCache->fileName ) == 0 ) ? EOK
+                                                                        : errno;
+            }
+
+            if ( result != EOK )
+            {
+                unlink( tmpName );
+            }
+        }
+
+        free( tmpName );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CONFCACHE_Open                                                            */
+/*!
+    Open a configuration cache file
+
+    The CONFCACHE_Open function maps a configuration cache file into
+    memory.  The cache is only opened if it is intact, and was built
+    from the current contents of the configuration file.
+
+    @param[in]
+        fileName
+            name of the cache file
+
+    @param[in]
+        configName
+            name of the configuration file
+
+    @retval pointer to the configuration cache object
+    @retval NULL if there is no valid cache for the configuration file
+
+==============================================================================*/
+ConfCache *CONFCACHE_Open( const char *fileName, const char *configName )
+{
+    ConfCache *pCache = NULL;
+    struct stat st;
+    int fd;
+
+    if ( ( fileName != NULL ) &&
+         ( configName != NULL ) )
+    {
+        fd = open( fileName, O_RDONLY );
+        if ( fd != -1 )
+        {
+            pCache = calloc( 1, sizeof( ConfCache ) );
+            if ( ( pCache != NULL ) &&
+                 ( fstat( fd, &st ) == 0 ) &&
+                 ( (size_t)st.st_size >= sizeof( CacheHeader ) ) )
+            {
+                pCache->mapSize = (size_t)st.st_size;
+                pCache->pMap = mmap( NULL,
+                                     pCache->mapSize,
+                                     PROT_READ,
+                                     MAP_PRIVATE,
+                                     fd,
+                                     0 );
+                if ( pCache->pMap == MAP_FAILED )
+                {
+                    pCache->pMap = NULL;
+                }
+            }
+
+            close( fd );
+
+            if ( ( pCache != NULL ) &&
+                 ( ( pCache->pMap == NULL ) ||
+                   ( GetConfigKey( configName, &pCache->key ) != EOK ) ||
+                   ( Validate( pCache ) == false ) ) )
+            {
+                CONFCACHE_Close( pCache );
+                pCache = NULL;
+            }
+        }
+    }
+
+    return pCache;
+}
+
+/*============================================================================*/
+/*  CONFCACHE_Count                                                           */
+/*!
+    Get the number of template definitions in a configuration cache
+
+    @param[in]
+        pCache
+            pointer to the configuration cache
+
+    @retval number of template definitions
+
+==============================================================================*/
+size_t CONFCACHE_Count( ConfCache *pCache )
+{
+    return ( pCache != NULL ) ? pCache->numTemplates : 0;
+}
+
+/*============================================================================*/
+/*  CONFCACHE_Get                                                             */
+/*!
+    Get a template definition from a configuration cache
+
+    The strings of the template definition refer to the cache, and
+    remain valid until the cache is closed.  The trigger and variable
+    arrays are allocated, and must be freed with
+    CONFCACHE_FreeDefinition.
+
+    @param[in]
+        pCache
+            pointer to the configuration cache
+
+    @param[in]
+        idx
+            index of the template definition
+
+    @param[out]
+        pDef
+            pointer to the template definition to populate
+
+    @retval EOK - the template definition was retrieved
+    @retval ENOENT - there is no template definition at the index
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CONFCACHE_Get( ConfCache *pCache, size_t idx, ConfTemplate *pDef )
+{
+    int result = EINVAL;
+    const CacheTemplate *pRecord;
+    const CacheTrigger *pTrigger;
+    size_t i;
+
+    if ( ( pCache != NULL ) &&
+         ( pDef != NULL ) )
+    {
+        memset( pDef, 0, sizeof( ConfTemplate ) );
+        result = ( idx < pCache->numTemplates ) ? EOK : ENOENT;
+    }
+
+    if ( result == EOK )
+    {
+        pRecord = &pCache->pTemplates[idx];
+
+        for ( i = 0 ; i < CONFCACHE_NUM_STRINGS ; i++ )
+        {
+            *(char **)( (char *)pDef + stringAttrs[i] ) =
+                String( pCache, pRecord->strings[i] );
+        }
+
+        pDef->append = ( pRecord->flags & CONFCACHE_APPEND ) != 0;
+        pDef->keep_open = ( pRecord->flags & CONFCACHE_KEEP_OPEN ) != 0;
+        pDef->incremental = ( pRecord->flags & CONFCACHE_INCREMENTAL ) != 0;
+        pDef->intervalMs = pRecord->intervalMs;
+        pDef->autoTrigger = ( pRecord->flags & CONFCACHE_AUTO_TRIGGER ) != 0;
+        pDef->nativeFormat = ( pRecord->flags & CONFCACHE_NATIVE_FORMAT ) != 0;
+
+        if ( pRecord->numTriggers > 0 )
+        {
+            pDef->pTriggers = calloc( pRecord->numTriggers,
+                                      sizeof( ConfTrigger ) );
+            if ( pDef->pTriggers != NULL )
+            {
+                pDef->numTriggers = pRecord->numTriggers;
+                pTrigger = &pCache->pTriggers[pRecord->firstTrigger];
+                for ( i = 0 ; i < pDef->numTriggers ; i++ )
+                {
+                    pDef->pTriggers[i].name = String( pCache,
+                                                      pTrigger[i].name );
+                    pDef->pTriggers[i].condition = pTrigger[i].condition;
+                    pDef->pTriggers[i].level = pTrigger[i].level;
+                }
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( pRecord->numVars > 0 )
+        {
+            pDef->pVars = calloc( pRecord->numVars, sizeof( char * ) );
+            if ( pDef->pVars != NULL )
+            {
+                pDef->numVars = pRecord->numVars;
+                for ( i = 0 ; i < pDef->numVars ; i++ )
+                {
+                    pDef->pVars[i] = String( pCache,
+                                             pCache->pVars[pRecord->firstVar
+                                                           + i] );
+                }
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( pRecord->numExclude > 0 )
+        {
+            pDef->pExclude = calloc( pRecord->numExclude, sizeof( char * ) );
+            if ( pDef->pExclude != NULL )
+            {
+                pDef->numExclude = pRecord->numExclude;
+                for ( i = 0 ; i < pDef->numExclude ; i++ )
+                {
+                    pDef->pExclude[i] = String( pCache,
+                                                pCache->pVars[pRecord->firstVar
+                                                              + pRecord->numVars
+                                                              + i] );
+                }
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result != EOK )
+        {
+            CONFCACHE_FreeDefinition( pDef );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CONFCACHE_GetTenant                                                       */
+/*!
+    Get the tenant attributes of a configuration cache
+
+    The tenant name refers to the cache, and remains valid until the
+    cache is closed.
+
+    @param[in]
+        pCache
+            pointer to the configuration cache
+
+    @param[out]
+        pTenant
+            pointer to the tenant attributes to populate
+
+    @retval EOK - the tenant attributes were retrieved
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int CONFCACHE_GetTenant( ConfCache *pCache, ConfTenant *pTenant )
+{
+    int result = EINVAL;
+
+    if ( ( pCache != NULL ) &&
+         ( pCache->writing == false ) &&
+         ( pTenant != NULL ) )
+    {
+        pTenant->name = String( pCache, pCache->tenant.name );
+        pTenant->priority = pCache->tenant.priority;
+        pTenant->maxTemplates = pCache->tenant.maxTemplates;
+        pTenant->maxRendersPerSec = pCache->tenant.maxRendersPerSec;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CONFCACHE_FreeDefinition                                                  */
+/*!
+    Free the trigger and variable arrays of a template definition
+
+    The strings of the template definition are not freed.
+
+    @param[in]
+        pDef
+            pointer to the template definition
+
+==============================================================================*/
+void CONFCACHE_FreeDefinition( ConfTemplate *pDef )
+{
+    if ( pDef != NULL )
+    {
+        free( pDef->pTriggers );
+        pDef->pTriggers = NULL;
+        pDef->numTriggers = 0;
+
+        free( pDef->pVars );
+        pDef->pVars = NULL;
+        pDef->numVars = 0;
+
+        free( pDef->pExclude );
+        pDef->pExclude = NULL;
+        pDef->numExclude = 0;
+    }
+}
+
+/*============================================================================*/
+/*  CONFCACHE_Close                                                           */
+/*!
+    Close a configuration cache
+
+    The CONFCACHE_Close function discards a cache which is being built,
+    or unmaps a cache file which is being read.  The strings of the
+    template definitions retrieved from the cache are no longer valid.
+
+    @param[in]
+        pCache
+            pointer to the configuration cache
+
+==============================================================================*/
+void CONFCACHE_Close( ConfCache *pCache )
+{
+    if ( pCache != NULL )
+    {
+        if ( pCache->pMap != NULL )
+        {
+            munmap( pCache->pMap, pCache->mapSize );
+        }
+        else
+        {
+            free( pCache->pTemplates );
+            free( pCache->pTriggers );
+            free( pCache->pVars );
+            free( pCache->pStrings );
+        }
+
+        free( pCache->pSlots );
+        free( pCache->fileName );
+        free( pCache );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  GetConfigKey                                                              */
+/*!
+    Identify a configuration file
+
+    @param[in]
+        configName
+            name of the configuration file
+
+    @param[out]
+        pKey
+            pointer to the configuration key to populate
+
+    @retval EOK - the configuration file was identified
+    @retval ENOMEM - memory allocation failure
+    @retval other - error returned by the file operations
+
+==============================================================================*/
+static int GetConfigKey( const char *configName, ConfigKey *pKey )
+{
+    int result;
+    struct stat st;
+    char *pBuf;
+    ssize_t n;
+    int fd;
+
+    memset( pKey, 0, sizeof( ConfigKey ) );
+
+    fd = open( configName, O_RDONLY );
+    if ( fd == -1 )
+    {
+        result = errno;
+    }
+    else
+    {
+        pBuf = malloc( CONFCACHE_READ_SIZE );
+        if ( pBuf == NULL )
+        {
+            result = ENOMEM;
+        }
+        else if ( fstat( fd, &st ) != 0 )
+        {
+            result = errno;
+        }
+        else
+        {
+            pKey->size = (uint64_t)st.st_size;
+            pKey->mtimeNs = (int64_t)st.st_mtim.tv_sec * 1000000000LL +
+                            st.st_mtim.tv_nsec;
+            pKey->hash = Hash( 0xCBF29CE484222325ULL, NULL, 0 );
+
+            while ( ( n = read( fd, pBuf, CONFCACHE_READ_SIZE ) ) > 0 )
+            {
+                pKey->hash = Hash( pKey->hash, pBuf, (size_t)n );
+            }
+
+            result = ( n == 0 ) ? EOK : errno;
+        }
+
+        free( pBuf );
+        close( fd );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Hash                                                                      */
+/*!
+    Continue an FNV-1a hash
+
+    @param[in]
+        h
+            hash of the preceding data
+
+    @param[in]
+        p
+            pointer to the data to hash
+
+    @param[in]
+        len
+            length of the data to hash
+
+    @retval hash of the preceding data and the data
+
+==============================================================================*/
+static uint64_t Hash( uint64_t h, const void *p, size_t len )
+{
+    const unsigned char *pData = p;
+    size_t i;
+
+    for ( i = 0 ; i < len ; i++ )
+    {
+        h ^= pData[i];
+        h *= 0x100000001B3ULL;
+    }
+
+    return h;
+}
+
+/*============================================================================*/
+/*  Intern                                                                    */
+/*!
+    Add a string to the string table of a configuration cache
+
+    A string which is already in the string table is not added again.
+
+    @param[in]
+        pCache
+            pointer to the configuration cache being built
+
+    @param[in]
+        str
+            string to add (may be NULL)
+
+    @param[out]
+        pOffset
+            pointer to a location to store the offset of the string
+
+    @retval EOK - the string was interned
+    @retval ENOMEM - memory allocation failure
+    @retval E2BIG - the string table is full
+
+==============================================================================*/
+static int Intern( ConfCache *pCache, const char *str, uint32_t *pOffset )
+{
+    int result = EOK;
+    size_t len;
+    size_t idx;
+    uint32_t offset;
+
+    *pOffset = CONFCACHE_NONE;
+
+    if ( str != NULL )
+    {
+        len = strlen( str );
+        idx = Hash( 0xCBF29CE484222325ULL, str, len ) &
+              ( pCache->numSlots - 1 );
+
+        while ( ( ( offset = pCache->pSlots[idx] ) != CONFCACHE_NONE ) &&
+                ( strcmp( &pCache->pStrings[offset], str ) != 0 ) )
+        {
+            idx = ( idx + 1 ) & ( pCache->numSlots - 1 );
+        }
+
+        if ( offset != CONFCACHE_NONE )
+        {
+            *pOffset = offset;
+        }
+        else if ( pCache->stringsLen + len + 1 >= CONFCACHE_NONE )
+        {
+            result = E2BIG;
+        }
+        else
+        {
+            result = Reserve( (void **)&pCache->pStrings,
+                              &pCache->stringsSize,
+                              pCache->stringsLen + len + 1,
+                              1 );
+            if ( result == EOK )
+            {
+                offset = (uint32_t)pCache->stringsLen;
+                memcpy( &pCache->pStrings[offset], str, len + 1 );
+                pCache->stringsLen += len + 1;
+                pCache->pSlots[idx] = offset;
+                *pOffset = offset;
+
+                /* keep the intern table at most half full */
+                if ( ++pCache->numStrings * 2 > pCache->numSlots )
+                {
+                    result = GrowSlots( pCache );
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  GrowSlots                                                                 */
+/*!
+    Double the number of string intern slots
+
+    @param[in]
+        pCache
+            pointer to the configuration cache being built
+
+    @retval EOK - the intern table was resized
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int GrowSlots( ConfCache *pCache )
+{
+    int result = ENOMEM;
+    size_t numSlots = pCache->numSlots * 2;
+    uint32_t *pSlots;
+    const char *str;
+    size_t idx;
+    size_t i;
+
+    pSlots = malloc( numSlots * sizeof( uint32_t ) );
+    if ( pSlots != NULL )
+    {
+        memset( pSlots, 0xFF, numSlots * sizeof( uint32_t ) );
+
+        for ( i = 0 ; i < pCache->numSlots ; i++ )
+        {
+            if ( pCache->pSlots[i] != CONFCACHE_NONE )
+            {
+                str = &pCache->pStrings[pCache->pSlots[i]];
+                idx = Hash( 0xCBF29CE484222325ULL, str, strlen( str ) ) &
+                      ( numSlots - 1 );
+                while ( pSlots[idx] != CONFCACHE_NONE )
+                {
+                    idx = ( idx + 1 ) & ( numSlots - 1 );
+                }
+
+                pSlots[idx] = pCache->pSlots[i];
+            }
+        }
+
+        free( pCache->pSlots );
+        pCache->pSlots = pSlots;
+        pCache->numSlots = numSlots;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Reserve                                                                   */
+/*!
+    Make room in a growable array
+
+    @param[in,out]
+        pp
+            pointer to the array pointer
+
+    @param[in,out]
+        pSize
+            pointer to the allocated number of elements
+
+    @param[in]
+        count
+            number of elements required
+
+    @param[in]
+        elemSize
+            size of an element
+
+    @retval EOK - the array has room for the elements
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int Reserve( void **pp, size_t *pSize, size_t count, size_t elemSize )
+{
+    int result = EOK;
+    size_t size = ( *pSize > 0 ) ? *pSize : 64;
+    void *p;
+
+    if ( count > *pSize )
+    {
+        while ( size < count )
+        {
+            size *= 2;
+        }
+
+        p = realloc( *pp, size * elemSize );
+        if ( p != NULL )
+        {
+            *pp = p;
+            *pSize = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Validate                                                                  */
+/*!
+    Check a mapped configuration cache file
+
+    The cache file must have been built from the configuration file
+    identified by the cache key, and all of its records must refer to
+    data within the file, so the definitions retrieved from it do not
+    need to be checked again.
+
+    @param[in]
+        pCache
+            pointer to the configuration cache being read
+
+    @retval true - the cache file is valid
+    @retval false - the cache file is stale or damaged
+
+==============================================================================*/
+static bool Validate( ConfCache *pCache )
+{
+    const CacheHeader *pHeader = pCache->pMap;
+    const char *p = pCache->pMap;
+    const CacheTemplate *pRecord;
+    bool result;
+    size_t size;
+    size_t i;
+    size_t j;
+
+    result = ( memcmp( pHeader->magic,
+                       CONFCACHE_MAGIC,
+                       CONFCACHE_MAGIC_LEN ) == 0 ) &&
+             ( pHeader->version == CONFCACHE_VERSION ) &&
+             ( memcmp( &pHeader->key,
+                       &pCache->key,
+                       sizeof( ConfigKey ) ) == 0 );
+
+    if ( result == true )
+    {
+        size = sizeof( CacheHeader ) +
+               (size_t)pHeader->numTriggers * sizeof( CacheTrigger ) +
+               (size_t)pHeader->numTemplates * sizeof( CacheTemplate ) +
+               (size_t)pHeader->numVars * sizeof( uint32_t ) +
+               pHeader->stringsSize;
+
+        result = ( size == pCache->mapSize ) &&
+                 ( ( pHeader->stringsSize == 0 ) ||
+                   ( p[pCache->mapSize - 1] == '\0' ) );
+    }
+
+    if ( result == true )
+    {
+        p += sizeof( CacheHeader );
+        pCache->pTriggers = (CacheTrigger *)p;
+        pCache->numTriggers = pHeader->numTriggers;
+        p += pCache->numTriggers * sizeof( CacheTrigger );
+
+        pCache->pTemplates = (CacheTemplate *)p;
+        pCache->numTemplates = pHeader->numTemplates;
+        p += pCache->numTemplates * sizeof( CacheTemplate );
+
+        pCache->pVars = (uint32_t *)p;
+        pCache->numVars = pHeader->numVars;
+        p += pCache->numVars * sizeof( uint32_t );
+
+        pCache->pStrings = (char *)p;
+        pCache->stringsLen = pHeader->stringsSize;
+
+        pCache->tenant = pHeader->tenant;
+        result = ValidString( pCache, pCache->tenant.name );
+    }
+
+    for ( i = 0 ; ( i < pCache->numTemplates ) && ( result == true ) ; i++ )
+    {
+        pRecord = &pCache->pTemplates[i];
+        result = ( pRecord->firstTrigger <= pCache->numTriggers ) &&
+                 ( pRecord->numTriggers <=
+                   pCache->numTriggers - pRecord->firstTrigger ) &&
+                 ( pRecord->firstVar <= pCache->numVars ) &&
+                 ( pRecord->numVars <= pCache->numVars - pRecord->firstVar ) &&
+                 ( pRecord->numExclude <=
+                   pCache->numVars - pRecord->firstVar - pRecord->numVars );
+
+        for ( j = 0 ;
+              ( j < CONFCACHE_NUM_STRINGS ) && ( result == true ) ;
+              j++ )
+        {
+            result = ValidString( pCache, pRecord->strings[j] );
+        }
+    }
+
+    for ( i = 0 ; ( i < pCache->numTriggers ) && ( result == true ) ; i++ )
+    {
+        result = ValidString( pCache, pCache->pTriggers[i].name );
+    }
+
+    for ( i = 0 ; ( i < pCache->numVars ) && ( result == true ) ; i++ )
+    {
+        result = ValidString( pCache, pCache->pVars[i] );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ValidString                                                               */
+/*!
+    Check a string offset of a mapped configuration cache file
+
+    @param[in]
+        pCache
+            pointer to the configuration cache being read
+
+    @param[in]
+        offset
+            string offset to check
+
+    @retval true - the offset is absent or within the string table
+    @retval false - the offset is outside the string table
+
+==============================================================================*/
+static bool ValidString( ConfCache *pCache, uint32_t offset )
+{
+    return ( offset == CONFCACHE_NONE ) || ( offset < pCache->stringsLen );
+}
+
+/*============================================================================*/
+/*  String                                                                    */
+/*!
+    Get a string from the string table of a configuration cache
+
+    @param[in]
+        pCache
+            pointer to the configuration cache
+
+    @param[in]
+        offset
+            offset of the string
+
+    @retval pointer to the string
+    @retval NULL if the string is absent
+
+==============================================================================*/
+static char *String( ConfCache *pCache, uint32_t offset )
+{
+    return ( offset != CONFCACHE_NONE ) ? &pCache->pStrings[offset] : NULL;
+}
+
+/*! @}
+ * end of confcache group */
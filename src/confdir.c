@@ -0,0 +1,459 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup confdir confdir
+ * @brief Configuration directory loading
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file confdir.c
+
+    Configuration directory
+
+    The confdir module loads a directory of configuration files, so each
+    application can install its own rule file rather than editing a
+    shared configuration.  Every file in the directory whose name ends in
+    ".json" is loaded, in name order.  Hidden files are skipped, so an
+    editor's temporary files are not picked up.
+
+    The files are parsed by a pool of worker threads, which take the
+    next unparsed file until none are left.  An optional callback is
+    run on the worker thread once a file is parsed, so the work which
+    does not touch the variable server (such as compiling templates)
+    is also done in parallel.  Each file has its own result: a file
+    which cannot be parsed does not prevent the others from loading.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <tjson/json.h>
+#include "confdir.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! configuration file name suffix */
+#define CONFDIR_SUFFIX          ".json"
+
+/*! maximum number of parser threads */
+#define CONFDIR_MAX_THREADS     ( 16 )
+
+/*! configuration directory */
+struct confDir
+{
+    /*! configuration files, in name order */
+    ConfFile *pFiles;
+
+    /*! number of configuration files */
+    size_t numFiles;
+
+    /*! index of the next file to be parsed */
+    atomic_size_t next;
+
+    /*! callback which prepares each parsed file (or NULL) */
+    ConfFileFn fn;
+
+    /*! opaque argument of the callback */
+    void *arg;
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int Filter( const struct dirent *pEntry );
+static void *ParseThread( void *arg );
+static void ParseFile( ConfDir *pDir, ConfFile *pFile );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  CONFDIR_Open                                                              */
+/*!
+    Open a configuration directory
+
+    The CONFDIR_Open function lists the configuration files of a
+    directory.  The files are not read until CONFDIR_Parse is called.
+
+    @param[in]
+        dirName
+            name of the configuration directory
+
+    @retval pointer to the configuration directory object
+    @retval NULL if the directory could not be read
+
+==============================================================================*/
+ConfDir *CONFDIR_Open( const char *dirName )
+{
+    ConfDir *pDir = NULL;
+    struct dirent **ppEntries = NULL;
+    size_t len;
+    int n;
+    int i;
+
+    if ( dirName != NULL )
+    {
+        n = scandir( dirName, &ppEntries, Filter, alphasort );
+        if ( n >= 0 )
+        {
+            pDir = calloc( 1, sizeof( ConfDir ) );
+            if ( ( pDir != NULL ) && ( n > 0 ) )
+            {
+                pDir->pFiles = calloc( (size_t)n, sizeof( ConfFile ) );
+                if ( pDir->pFiles == NULL )
+                {
+                    free( pDir );
+                    pDir = NULL;
+                }
+            }
+
+            for ( i = 0 ; i < n ; i++ )
+            {
+                if ( pDir != NULL )
+                {
+                    len = strlen( dirName ) +
+                          strlen( ppEntries[i]->d_name ) + 2;
+                    pDir->pFiles[i].path = malloc( len );
+                    if ( pDir->pFiles[i].path != NULL )
+                    {
+                        snprintf( pDir->pFiles[i].path,
+                                  len,
+                                  "%s/%s",
+                                  dirName,
+                                  ppEntries[i]->d_name );
+                        pDir->pFiles[i].result = EINVAL;
+                        pDir->numFiles++;
+                    }
+                    else
+                    {
+                        CONFDIR_Close( pDir );
+                        pDir = NULL;
+                    }
+                }
+
+                free( ppEntries[i] );
+            }
+
+            free( ppEntries );
+        }
+    }
+
+    return pDir;
+}
+
+/*============================================================================*/
+/*  CONFDIR_Parse                                                             */
+/*!
+    Parse the files of a configuration directory
+
+    The CONFDIR_Parse function parses the configuration files using up to
+    the specified number of worker threads.  Once a file is parsed, the
+    callback is invoked for it on the same worker thread, and its result
+    becomes the result of the file.  The callback must not use the
+    variable server, and must only modify the file it is given.
+
+    @param[in]
+        pDir
+            pointer to the configuration directory
+
+    @param[in]
+        threads
+            maximum number of worker threads (0 for one per online CPU)
+
+    @param[in]
+        fn
+            callback which prepares each parsed file (or NULL)
+
+    @param[in]
+        arg
+            opaque argument passed to the callback
+
+    @retval EOK - all of the files were parsed and prepared
+    @retval EINVAL - invalid arguments
+    @retval other - the result of the last file which failed
+
+==============================================================================*/
+int CONFDIR_Parse( ConfDir *pDir, size_t threads, ConfFileFn fn, void *arg )
+{
+    int result = EINVAL;
+    pthread_t workers[CONFDIR_MAX_THREADS];
+    sigset_t mask;
+    sigset_t saved;
+    size_t started = 0;
+    long cpus;
+    size_t i;
+
+    if ( pDir != NULL )
+    {
+        pDir->fn = fn;
+        pDir->arg = arg;
+        atomic_store( &pDir->next, 0 );
+
+        if ( threads == 0 )
+        {
+            cpus = sysconf( _SC_NPROCESSORS_ONLN );
+            threads = ( cpus > 0 ) ? (size_t)cpus : 1;
+        }
+
+        if ( threads > CONFDIR_MAX_THREADS )
+        {
+            threads = CONFDIR_MAX_THREADS;
+        }
+
+        if ( threads > pDir->numFiles )
+        {
+            threads = pDir->numFiles;
+        }
+
+        /* the workers must not take the process signals, which are
+           received synchronously by the main thread */
+        sigfillset( &mask );
+        pthread_sigmask( SIG_SETMASK, &mask, &saved );
+
+        /* the calling thread is one of the workers */
+        for ( i = 1 ; i < threads ; i++ )
+        {
+            if ( pthread_create( &workers[started],
+                                 NULL,
+                                 ParseThread,
+                                 pDir ) == 0 )
+            {
+                started++;
+            }
+        }
+
+        pthread_sigmask( SIG_SETMASK, &saved, NULL );
+
+        (void)ParseThread( pDir );
+
+        for ( i = 0 ; i < started ; i++ )
+        {
+            pthread_join( workers[i], NULL );
+        }
+
+        result = EOK;
+        for ( i = 0 ; i < pDir->numFiles ; i++ )
+        {
+            if ( pDir->pFiles[i].result != EOK )
+            {
+                result = pDir->pFiles[i].result;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CONFDIR_Count                                                             */
+/*!
+    Get the number of files in a configuration directory
+
+    @param[in]
+        pDir
+            pointer to the configuration directory
+
+    @retval number of configuration files
+
+==============================================================================*/
+size_t CONFDIR_Count( ConfDir *pDir )
+{
+    return ( pDir != NULL ) ? pDir->numFiles : 0;
+}
+
+/*============================================================================*/
+/*  CONFDIR_Get                                                               */
+/*!
+    Get a file of a configuration directory
+
+    @param[in]
+        pDir
+            pointer to the configuration directory
+
+    @param[in]
+        idx
+            index of the file, in name order
+
+    @retval pointer to the configuration file
+    @retval NULL if the index is out of range
+
+==============================================================================*/
+ConfFile *CONFDIR_Get( ConfDir *pDir, size_t idx )
+{
+    return ( ( pDir != NULL ) && ( idx < pDir->numFiles ) )
+           ? &pDir->pFiles[idx]
+           : NULL;
+}
+
+/*============================================================================*/
+/*  CONFDIR_Close                                                             */
+/*!
+    Close a configuration directory
+
+    The parsed configurations are freed, so the templates set up from
+    them must not refer to their strings.  Prepared file data must be
+    freed by the caller before the directory is closed.
+
+    @param[in]
+        pDir
+            pointer to the configuration directory
+
+==============================================================================*/
+void CONFDIR_Close( ConfDir *pDir )
+{
+    size_t i;
+
+    if ( pDir != NULL )
+    {
+        for ( i = 0 ; i < pDir->numFiles ; i++ )
+        {
+            free( pDir->pFiles[i].path );
+            if ( pDir->pFiles[i].config != NULL )
+            {
+                JSON_Free( pDir->pFiles[i].config );
+            }
+        }
+
+        free( pDir->pFiles );
+        free( pDir );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Filter                                                                    */
+/*!
+    Select the configuration files of a directory
+
+    @param[in]
+        pEntry
+            pointer to the directory entry
+
+    @retval 1 if the entry is a configuration file
+    @retval 0 if the entry is not a configuration file
+
+==============================================================================*/
+static int Filter( const struct dirent *pEntry )
+{
+    size_t len = strlen( pEntry->d_name );
+    size_t suffixLen = strlen( CONFDIR_SUFFIX );
+
+    return ( ( pEntry->d_name[0] != '.' ) &&
+             ( len > suffixLen ) &&
+             ( strcmp( &pEntry->d_name[len - suffixLen],
+                       CONFDIR_SUFFIX ) == 0 ) ) ? 1 : 0;
+}
+
+/*============================================================================*/
+/*  ParseThread                                                               */
+/*!
+    Configuration file parser worker
+
+    The ParseThread function parses configuration files until all of
+    the files of the directory have been taken.
+
+    @param[in]
+        arg
+            pointer to the configuration directory
+
+    @retval NULL
+
+==============================================================================*/
+static void *ParseThread( void *arg )
+{
+    ConfDir *pDir = (ConfDir *)arg;
+    size_t idx;
+
+    while ( ( idx = atomic_fetch_add( &pDir->next, 1 ) ) < pDir->numFiles )
+    {
+        ParseFile( pDir, &pDir->pFiles[idx] );
+    }
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  ParseFile                                                                 */
+/*!
+    Parse and prepare one configuration file
+
+    A file which does not hold a "config" array is not a valid
+    configuration file, and is not passed to the callback.
+
+    @param[in]
+        pDir
+            pointer to the configuration directory
+
+    @param[in]
+        pFile
+            pointer to the configuration file
+
+==============================================================================*/
+static void ParseFile( ConfDir *pDir, ConfFile *pFile )
+{
+    pFile->config = JSON_Process( pFile->path );
+    if ( ( pFile->config == NULL ) ||
+         ( JSON_Find( pFile->config, "config" ) == NULL ) )
+    {
+        pFile->result = EINVAL;
+    }
+    else if ( pDir->fn != NULL )
+    {
+        pFile->result = pDir->fn( pFile, pDir->arg );
+    }
+    else
+    {
+        pFile->result = EOK;
+    }
+}
+
+/*! @}
+ * end of confdir group */
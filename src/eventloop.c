@@ -0,0 +1,1216 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup eventloop eventloop
+ * @brief epoll based event loop
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file eventloop.c
+
+    Event loop
+
+    The eventloop module multiplexes every source of work onto a single
+    epoll instance: signals are received through a signalfd, timers are
+    timerfds, path changes are reported by inotify, and any other file
+    descriptor can be registered directly.  The loop only sleeps in
+    epoll_wait, and is woken by the kernel exactly when a source is ready,
+    so it does no polling.
+
+    The signalfd is read one signal at a time, so a handler may collect
+    the remaining pending signals itself (see TEMPLATESVC_HandleSignal).
+
+    Sources removed by a handler are released after the current batch
+    of events has been dispatched, so a handler may remove any source,
+    including its own.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/inotify.h>
+#include "eventloop.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! maximum number of events dispatched per wakeup */
+#define EVENTLOOP_MAX_EVENTS        ( 32 )
+
+/*! number of signal handler slots */
+#define EVENTLOOP_MAX_SIGNALS       ( _NSIG )
+
+/*! size of the inotify read buffer */
+#define EVENTLOOP_INOTIFY_SIZE      ( 4096 )
+
+/*! type of an event source */
+typedef enum eventSourceType
+{
+    /*! file descriptor */
+    EVENT_FD = 0,
+
+    /*! signalfd for all registered signals */
+    EVENT_SIGNAL = 1,
+
+    /*! timerfd */
+    EVENT_TIMER = 2,
+
+    /*! inotify descriptor for all watches */
+    EVENT_WATCH = 3
+
+} EventSourceType;
+
+/*! a file descriptor monitored by the event loop */
+struct eventSource
+{
+    /*! source type */
+    EventSourceType type;
+
+    /*! file descriptor */
+    int fd;
+
+    /*! file descriptor handler */
+    EventFdHandler fdHandler;
+
+    /*! timer handler */
+    EventTimerHandler timerHandler;
+
+    /*! handler argument */
+    void *arg;
+
+    /*! the source has been removed, and is released after dispatch */
+    bool removed;
+
+    /*! pointer to the next source */
+    struct eventSource *pNext;
+};
+
+/*! a signal handler */
+typedef struct eventSignal
+{
+    /*! handler function (NULL if the signal is not handled) */
+    EventSignalHandler fn;
+
+    /*! handler argument */
+    void *arg;
+
+} EventSignal;
+
+/*! an inotify watch handler */
+typedef struct eventWatch
+{
+    /*! inotify watch descriptor */
+    int wd;
+
+    /*! events reported to this handler */
+    uint32_t mask;
+
+    /*! handler function */
+    EventWatchHandler fn;
+
+    /*! handler argument */
+    void *arg;
+
+    /*! pointer to the next watch handler */
+    struct eventWatch *pNext;
+
+} EventWatch;
+
+/*! event loop */
+struct eventLoop
+{
+    /*! epoll instance */
+    int epfd;
+
+    /*! the loop runs until stopped */
+    bool running;
+
+    /*! registered file descriptor and timer sources */
+    struct eventSource *pSources;
+
+    /*! signalfd source */
+    struct eventSource signals;
+
+    /*! signals received through the signalfd */
+    sigset_t sigmask;
+
+    /*! signal handlers */
+    EventSignal handlers[EVENTLOOP_MAX_SIGNALS];
+
+    /*! inotify source */
+    struct eventSource watches;
+
+    /*! inotify watch handlers */
+    EventWatch *pWatches;
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static struct eventSource *AddSource( EventLoop *pLoop,
+                                      EventSourceType type,
+                                      int fd,
+                                      uint32_t events );
+static struct eventSource *FindSource( EventLoop *pLoop, int fd );
+static void RemoveSource( EventLoop *pLoop, struct eventSource *pSource );
+static void ReapSources( EventLoop *pLoop );
+static void Dispatch( EventLoop *pLoop, struct eventSource *pSource,
+                      uint32_t events );
+static void DispatchSignal( EventLoop *pLoop );
+static void DispatchTimer( EventLoop *pLoop, struct eventSource *pSource );
+static void DispatchWatches( EventLoop *pLoop );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  EVENTLOOP_Create                                                          */
+/*!
+    Create an event loop
+
+    @retval pointer to the new event loop
+    @retval NULL if the event loop could not be created
+
+==============================================================================*/
+EventLoop *EVENTLOOP_Create( void )
+{
+    EventLoop *pLoop;
+
+    pLoop = calloc( 1, sizeof( EventLoop ) );
+    if ( pLoop != NULL )
+    {
+        pLoop->epfd = epoll_create1( EPOLL_CLOEXEC );
+        pLoop->signals.type = EVENT_SIGNAL;
+        pLoop->signals.fd = -1;
+        pLoop->watches.type = EVENT_WATCH;
+        pLoop->watches.fd = -1;
+        sigemptyset( &pLoop->sigmask );
+
+        if ( pLoop->epfd == -1 )
+        {
+            free( pLoop );
+            pLoop = NULL;
+        }
+    }
+
+    return pLoop;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_AddFd                                                           */
+/*!
+    Monitor a file descriptor
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        fd
+            file descriptor to monitor
+
+    @param[in]
+        events
+            epoll events to monitor (EPOLLIN, EPOLLOUT, ...)
+
+    @param[in]
+        fn
+            handler called when the file descriptor is ready
+
+    @param[in]
+        arg
+            handler argument
+
+    @retval EOK - the file descriptor is monitored
+    @retval EPERM - the file descriptor does not support epoll
+    @retval EINVAL - invalid arguments
+    @retval other - the file descriptor could not be monitored
+
+==============================================================================*/
+int EVENTLOOP_AddFd( EventLoop *pLoop,
+                     int fd,
+                     uint32_t events,
+                     EventFdHandler fn,
+                     void *arg )
+{
+    int result = EINVAL;
+    struct eventSource *pSource;
+
+    if ( ( pLoop != NULL ) && ( fd >= 0 ) && ( fn != NULL ) )
+    {
+        pSource = AddSource( pLoop, EVENT_FD, fd, events );
+        if ( pSource != NULL )
+        {
+            pSource->fdHandler = fn;
+            pSource->arg = arg;
+            result = EOK;
+        }
+        else
+        {
+            result = errno;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_ModifyFd                                                        */
+/*!
+    Change the events monitored on a file descriptor
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        fd
+            monitored file descriptor
+
+    @param[in]
+        events
+            epoll events to monitor
+
+    @retval EOK - the events were changed
+    @retval ENOENT - the file descriptor is not monitored
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int EVENTLOOP_ModifyFd( EventLoop *pLoop, int fd, uint32_t events )
+{
+    int result = EINVAL;
+    struct eventSource *pSource;
+    struct epoll_event ev;
+
+    if ( pLoop != NULL )
+    {
+        result = ENOENT;
+
+        pSource = FindSource( pLoop, fd );
+        if ( pSource != NULL )
+        {
+            memset( &ev, 0, sizeof( ev ) );
+            ev.events = events;
+            ev.data.ptr = pSource;
+
+            result = ( epoll_ctl( pLoop->epfd, EPOLL_CTL_MOD, fd, &ev ) == 0 )
+                     ? EOK
+                     : errno;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_RemoveFd                                                        */
+/*!
+    Stop monitoring a file descriptor
+
+    The file descriptor is not closed.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        fd
+            monitored file descriptor
+
+    @retval EOK - the file descriptor is no longer monitored
+    @retval ENOENT - the file descriptor is not monitored
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int EVENTLOOP_RemoveFd( EventLoop *pLoop, int fd )
+{
+    int result = EINVAL;
+    struct eventSource *pSource;
+
+    if ( pLoop != NULL )
+    {
+        result = ENOENT;
+
+        pSource = FindSource( pLoop, fd );
+        if ( pSource != NULL )
+        {
+            RemoveSource( pLoop, pSource );
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_AddSignal                                                       */
+/*!
+    Handle a signal in the event loop
+
+    The signal is blocked, and received through the loop's signalfd.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        sig
+            signal number
+
+    @param[in]
+        fn
+            handler called when the signal is received
+
+    @param[in]
+        arg
+            handler argument
+
+    @retval EOK - the signal is handled by the event loop
+    @retval EINVAL - invalid arguments
+    @retval other - the signalfd could not be set up
+
+==============================================================================*/
+int EVENTLOOP_AddSignal( EventLoop *pLoop,
+                         int sig,
+                         EventSignalHandler fn,
+                         void *arg )
+{
+    int result = EINVAL;
+    struct epoll_event ev;
+    int fd;
+
+    if ( ( pLoop != NULL ) &&
+         ( sig > 0 ) &&
+         ( sig < EVENTLOOP_MAX_SIGNALS ) &&
+         ( fn != NULL ) )
+    {
+        sigaddset( &pLoop->sigmask, sig );
+        sigprocmask( SIG_BLOCK, &pLoop->sigmask, NULL );
+
+        /* create the signalfd, or update its mask */
+        fd = signalfd( pLoop->signals.fd,
+                       &pLoop->sigmask,
+                       SFD_NONBLOCK | SFD_CLOEXEC );
+        if ( fd == -1 )
+        {
+            result = errno;
+        }
+        else if ( pLoop->signals.fd == -1 )
+        {
+            memset( &ev, 0, sizeof( ev ) );
+            ev.events = EPOLLIN;
+            ev.data.ptr = &pLoop->signals;
+
+            if ( epoll_ctl( pLoop->epfd, EPOLL_CTL_ADD, fd, &ev ) == 0 )
+            {
+                pLoop->signals.fd = fd;
+                result = EOK;
+            }
+            else
+            {
+                result = errno;
+                close( fd );
+            }
+        }
+        else
+        {
+            result = EOK;
+        }
+
+        if ( result == EOK )
+        {
+            pLoop->handlers[sig].fn = fn;
+            pLoop->handlers[sig].arg = arg;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_CreateTimer                                                     */
+/*!
+    Create a timer
+
+    The timer is created disarmed.  Use EVENTLOOP_SetTimer to arm it.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        fn
+            handler called when the timer expires
+
+    @param[in]
+        arg
+            handler argument
+
+    @retval pointer to the new timer
+    @retval NULL if the timer could not be created
+
+==============================================================================*/
+EventTimer *EVENTLOOP_CreateTimer( EventLoop *pLoop,
+                                   EventTimerHandler fn,
+                                   void *arg )
+{
+    struct eventSource *pSource = NULL;
+    int fd;
+
+    if ( ( pLoop != NULL ) && ( fn != NULL ) )
+    {
+        fd = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+        if ( fd != -1 )
+        {
+            pSource = AddSource( pLoop, EVENT_TIMER, fd, EPOLLIN );
+            if ( pSource != NULL )
+            {
+                pSource->timerHandler = fn;
+                pSource->arg = arg;
+            }
+            else
+            {
+                close( fd );
+            }
+        }
+    }
+
+    return pSource;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_SetTimer                                                        */
+/*!
+    Arm or disarm a timer
+
+    @param[in]
+        pTimer
+            pointer to the timer
+
+    @param[in]
+        initialNs
+            time until the first expiry, or 0 to disarm the timer
+
+    @param[in]
+        intervalNs
+            period of subsequent expiries, or 0 for a single expiry
+
+    @retval EOK - the timer was set
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int EVENTLOOP_SetTimer( EventTimer *pTimer,
+                        uint64_t initialNs,
+                        uint64_t intervalNs )
+{
+    int result = EINVAL;
+    struct itimerspec its;
+
+    if ( ( pTimer != NULL ) && ( pTimer->type == EVENT_TIMER ) )
+    {
+        its.it_value.tv_sec = (time_t)( initialNs / 1000000000ULL );
+        its.it_value.tv_nsec = (long)( initialNs % 1000000000ULL );
+        its.it_interval.tv_sec = (time_t)( intervalNs / 1000000000ULL );
+        its.it_interval.tv_nsec = (long)( intervalNs % 1000000000ULL );
+
+        result = ( timerfd_settime( pTimer->fd, 0, &its, NULL ) == 0 )
+                 ? EOK
+                 : errno;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_DeleteTimer                                                     */
+/*!
+    Delete a timer
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        pTimer
+            pointer to the timer to delete
+
+==============================================================================*/
+void EVENTLOOP_DeleteTimer( EventLoop *pLoop, EventTimer *pTimer )
+{
+    if ( ( pLoop != NULL ) &&
+         ( pTimer != NULL ) &&
+         ( pTimer->type == EVENT_TIMER ) &&
+         ( pTimer->removed == false ) )
+    {
+        RemoveSource( pLoop, pTimer );
+        close( pTimer->fd );
+    }
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_AddWatch                                                        */
+/*!
+    Watch a path for changes
+
+    Several handlers may watch the same path, each for its own events.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        path
+            path of the file or directory to watch
+
+    @param[in]
+        mask
+            inotify events to report (IN_CLOSE_WRITE, IN_MOVED_TO, ...)
+
+    @param[in]
+        fn
+            handler called when a watched event occurs
+
+    @param[in]
+        arg
+            handler argument
+
+    @retval EOK - the path is watched
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - invalid arguments
+    @retval other - the watch could not be added
+
+==============================================================================*/
+int EVENTLOOP_AddWatch( EventLoop *pLoop,
+                        const char *path,
+                        uint32_t mask,
+                        EventWatchHandler fn,
+                        void *arg )
+{
+    int result = EINVAL;
+    EventWatch *pWatch;
+    struct epoll_event ev;
+    int fd;
+    int wd;
+
+    if ( ( pLoop != NULL ) && ( path != NULL ) && ( fn != NULL ) )
+    {
+        result = EOK;
+
+        if ( pLoop->watches.fd == -1 )
+        {
+            fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+            if ( fd != -1 )
+            {
+                memset( &ev, 0, sizeof( ev ) );
+                ev.events = EPOLLIN;
+                ev.data.ptr = &pLoop->watches;
+
+                if ( epoll_ctl( pLoop->epfd, EPOLL_CTL_ADD, fd, &ev ) == 0 )
+                {
+                    pLoop->watches.fd = fd;
+                }
+                else
+                {
+                    result = errno;
+                    close( fd );
+                }
+            }
+            else
+            {
+                result = errno;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            /* the watch is shared by every handler of the same path */
+            wd = inotify_add_watch( pLoop->watches.fd,
+                                    path,
+                                    mask | IN_MASK_ADD );
+            if ( wd == -1 )
+            {
+                result = errno;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pWatch = calloc( 1, sizeof( EventWatch ) );
+            if ( pWatch != NULL )
+            {
+                pWatch->wd = wd;
+                pWatch->mask = mask;
+                pWatch->fn = fn;
+                pWatch->arg = arg;
+                pWatch->pNext = pLoop->pWatches;
+                pLoop->pWatches = pWatch;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_RemoveWatches                                                   */
+/*!
+    Remove the watch handlers registered with an argument
+
+    The inotify watches themselves remain, since they may be shared by
+    other handlers.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        arg
+            handler argument of the watches to remove
+
+==============================================================================*/
+void EVENTLOOP_RemoveWatches( EventLoop *pLoop, void *arg )
+{
+    EventWatch **ppWatch;
+    EventWatch *pWatch;
+
+    if ( pLoop != NULL )
+    {
+        ppWatch = &pLoop->pWatches;
+        while ( *ppWatch != NULL )
+        {
+            pWatch = *ppWatch;
+            if ( pWatch->arg == arg )
+            {
+                *ppWatch = pWatch->pNext;
+                free( pWatch );
+            }
+            else
+            {
+                ppWatch = &pWatch->pNext;
+            }
+        }
+    }
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_RunOnce                                                         */
+/*!
+    Wait for and dispatch one batch of events
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        timeoutMs
+            maximum time to wait, or -1 to wait until an event occurs
+
+    @retval EOK - events were dispatched
+    @retval ETIMEDOUT - no events occurred before the timeout
+    @retval EINTR - the wait was interrupted
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int EVENTLOOP_RunOnce( EventLoop *pLoop, int timeoutMs )
+{
+    int result = EINVAL;
+    struct epoll_event events[EVENTLOOP_MAX_EVENTS];
+    int n;
+    int i;
+
+    if ( pLoop != NULL )
+    {
+        n = epoll_wait( pLoop->epfd,
+                        events,
+                        EVENTLOOP_MAX_EVENTS,
+                        timeoutMs );
+        if ( n > 0 )
+        {
+            for ( i = 0 ; i < n ; i++ )
+            {
+                Dispatch( pLoop,
+                          (struct eventSource *)events[i].data.ptr,
+                          events[i].events );
+            }
+
+            ReapSources( pLoop );
+            result = EOK;
+        }
+        else
+        {
+            result = ( n == 0 ) ? ETIMEDOUT : errno;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_Run                                                             */
+/*!
+    Run the event loop until it is stopped
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @retval EOK - the event loop was stopped
+    @retval EINVAL - invalid arguments
+    @retval other - waiting for events failed
+
+==============================================================================*/
+int EVENTLOOP_Run( EventLoop *pLoop )
+{
+    int result = EINVAL;
+
+    if ( pLoop != NULL )
+    {
+        result = EOK;
+        pLoop->running = true;
+
+        while ( ( pLoop->running == true ) && ( result == EOK ) )
+        {
+            result = EVENTLOOP_RunOnce( pLoop, -1 );
+            if ( result == EINTR )
+            {
+                result = EOK;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_Stop                                                            */
+/*!
+    Stop the event loop
+
+    EVENTLOOP_Run returns after the current batch of events has been
+    dispatched.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+==============================================================================*/
+void EVENTLOOP_Stop( EventLoop *pLoop )
+{
+    if ( pLoop != NULL )
+    {
+        pLoop->running = false;
+    }
+}
+
+/*============================================================================*/
+/*  EVENTLOOP_Destroy                                                         */
+/*!
+    Destroy an event loop
+
+    Timers, the signalfd and the inotify descriptor are closed.  File
+    descriptors registered with EVENTLOOP_AddFd are not closed.  The
+    handled signals remain blocked.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+==============================================================================*/
+void EVENTLOOP_Destroy( EventLoop *pLoop )
+{
+    struct eventSource *pSource;
+    EventWatch *pWatch;
+
+    if ( pLoop != NULL )
+    {
+        for ( pSource = pLoop->pSources ;
+              pSource != NULL ;
+              pSource = pSource->pNext )
+        {
+            if ( ( pSource->type == EVENT_TIMER ) &&
+                 ( pSource->removed == false ) )
+            {
+                close( pSource->fd );
+            }
+
+            pSource->removed = true;
+        }
+
+        ReapSources( pLoop );
+
+        while ( pLoop->pWatches != NULL )
+        {
+            pWatch = pLoop->pWatches;
+            pLoop->pWatches = pWatch->pNext;
+            free( pWatch );
+        }
+
+        if ( pLoop->signals.fd != -1 )
+        {
+            close( pLoop->signals.fd );
+        }
+
+        if ( pLoop->watches.fd != -1 )
+        {
+            close( pLoop->watches.fd );
+        }
+
+        close( pLoop->epfd );
+        free( pLoop );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  AddSource                                                                 */
+/*!
+    Register a file descriptor source with the epoll instance
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        type
+            source type
+
+    @param[in]
+        fd
+            file descriptor
+
+    @param[in]
+        events
+            epoll events to monitor
+
+    @retval pointer to the new source
+    @retval NULL if the source could not be registered (see errno)
+
+==============================================================================*/
+static struct eventSource *AddSource( EventLoop *pLoop,
+                                      EventSourceType type,
+                                      int fd,
+                                      uint32_t events )
+{
+    struct eventSource *pSource;
+    struct epoll_event ev;
+
+    pSource = calloc( 1, sizeof( struct eventSource ) );
+    if ( pSource != NULL )
+    {
+        pSource->type = type;
+        pSource->fd = fd;
+
+        memset( &ev, 0, sizeof( ev ) );
+        ev.events = events;
+        ev.data.ptr = pSource;
+
+        if ( epoll_ctl( pLoop->epfd, EPOLL_CTL_ADD, fd, &ev ) == 0 )
+        {
+            pSource->pNext = pLoop->pSources;
+            pLoop->pSources = pSource;
+        }
+        else
+        {
+            free( pSource );
+            pSource = NULL;
+        }
+    }
+
+    return pSource;
+}
+
+/*============================================================================*/
+/*  FindSource                                                                */
+/*!
+    Find the active file descriptor source for a file descriptor
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        fd
+            file descriptor
+
+    @retval pointer to the source
+    @retval NULL if the file descriptor is not monitored
+
+==============================================================================*/
+static struct eventSource *FindSource( EventLoop *pLoop, int fd )
+{
+    struct eventSource *pSource;
+
+    for ( pSource = pLoop->pSources ;
+          pSource != NULL ;
+          pSource = pSource->pNext )
+    {
+        if ( ( pSource->fd == fd ) &&
+             ( pSource->type == EVENT_FD ) &&
+             ( pSource->removed == false ) )
+        {
+            break;
+        }
+    }
+
+    return pSource;
+}
+
+/*============================================================================*/
+/*  RemoveSource                                                              */
+/*!
+    Deregister a source
+
+    The source is released by ReapSources after the current batch of
+    events has been dispatched.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        pSource
+            pointer to the source to remove
+
+==============================================================================*/
+static void RemoveSource( EventLoop *pLoop, struct eventSource *pSource )
+{
+    epoll_ctl( pLoop->epfd, EPOLL_CTL_DEL, pSource->fd, NULL );
+    pSource->removed = true;
+}
+
+/*============================================================================*/
+/*  ReapSources                                                               */
+/*!
+    Release the removed sources
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+==============================================================================*/
+static void ReapSources( EventLoop *pLoop )
+{
+    struct eventSource **ppSource;
+    struct eventSource *pSource;
+
+    ppSource = &pLoop->pSources;
+    while ( *ppSource != NULL )
+    {
+        pSource = *ppSource;
+        if ( pSource->removed == true )
+        {
+            *ppSource = pSource->pNext;
+            free( pSource );
+        }
+        else
+        {
+            ppSource = &pSource->pNext;
+        }
+    }
+}
+
+/*============================================================================*/
+/*  Dispatch                                                                  */
+/*!
+    Dispatch an event to its source's handler
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        pSource
+            pointer to the ready source
+
+    @param[in]
+        events
+            ready epoll events
+
+==============================================================================*/
+static void Dispatch( EventLoop *pLoop, struct eventSource *pSource,
+                      uint32_t events )
+{
+    if ( ( pSource != NULL ) && ( pSource->removed == false ) )
+    {
+        switch( pSource->type )
+        {
+            case EVENT_FD:
+                pSource->fdHandler( pLoop, pSource->fd, events, pSource->arg );
+                break;
+
+            case EVENT_SIGNAL:
+                DispatchSignal( pLoop );
+                break;
+
+            case EVENT_TIMER:
+                DispatchTimer( pLoop, pSource );
+                break;
+
+            case EVENT_WATCH:
+                DispatchWatches( pLoop );
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/*============================================================================*/
+/*  DispatchSignal                                                            */
+/*!
+    Read one signal from the signalfd and dispatch it
+
+    Only one signal is read, so the handler can collect any further
+    pending signals itself.  The signalfd remains ready while signals
+    are pending, so the loop wakes again for any left behind.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+==============================================================================*/
+static void DispatchSignal( EventLoop *pLoop )
+{
+    struct signalfd_siginfo info;
+    EventSignal *pHandler;
+    int sig;
+
+    if ( read( pLoop->signals.fd, &info, sizeof( info ) ) == sizeof( info ) )
+    {
+        sig = (int)info.ssi_signo;
+        if ( ( sig > 0 ) && ( sig < EVENTLOOP_MAX_SIGNALS ) )
+        {
+            pHandler = &pLoop->handlers[sig];
+            if ( pHandler->fn != NULL )
+            {
+                pHandler->fn( pLoop, sig, info.ssi_int, pHandler->arg );
+            }
+        }
+    }
+}
+
+/*============================================================================*/
+/*  DispatchTimer                                                             */
+/*!
+    Dispatch a timer expiry
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        pSource
+            pointer to the expired timer
+
+==============================================================================*/
+static void DispatchTimer( EventLoop *pLoop, struct eventSource *pSource )
+{
+    uint64_t expirations;
+
+    if ( ( read( pSource->fd, &expirations, sizeof( expirations ) ) ==
+                sizeof( expirations ) ) &&
+         ( expirations > 0 ) )
+    {
+        pSource->timerHandler( pLoop, pSource, expirations, pSource->arg );
+    }
+}
+
+/*============================================================================*/
+/*  DispatchWatches                                                           */
+/*!
+    Read the pending inotify events and dispatch them to the watch
+    handlers
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+==============================================================================*/
+static void DispatchWatches( EventLoop *pLoop )
+{
+    char buf[EVENTLOOP_INOTIFY_SIZE]
+        __attribute__(( aligned( __alignof__( struct inotify_event ) ) ));
+    const struct inotify_event *pEvent;
+    EventWatch *pWatch;
+    EventWatch *pNext;
+    ssize_t n;
+    char *p;
+
+    while ( ( n = read( pLoop->watches.fd, buf, sizeof( buf ) ) ) > 0 )
+    {
+        for ( p = buf ; p < buf + n ; p += sizeof( *pEvent ) + pEvent->len )
+        {
+            pEvent = (const struct inotify_event *)p;
+
+            for ( pWatch = pLoop->pWatches ; pWatch != NULL ; pWatch = pNext )
+            {
+                /* the handler may remove its own watch */
+                pNext = pWatch->pNext;
+
+                if ( ( pWatch->wd == pEvent->wd ) &&
+                     ( ( pWatch->mask & pEvent->mask ) != 0 ) )
+                {
+                    pWatch->fn( pLoop,
+                                pEvent->mask,
+                                ( pEvent->len > 0 ) ? pEvent->name : NULL,
+                                pWatch->arg );
+                }
+            }
+        }
+    }
+}
+
+/*! @}
+ * end of eventloop group */
@@ -0,0 +1,353 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup histogram histogram
+ * @brief Log-linear latency histograms
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file histogram.c
+
+    Log-linear histograms
+
+    The histogram module records unsigned values (typically nanosecond
+    durations) into a fixed array of log-linear buckets.  Values below
+    HIST_SUB_BUCKETS each have their own bucket, and every power of two
+    above that is split into HIST_SUB_BUCKETS linear sub-buckets, so the
+    relative error of any reported percentile is bounded by
+    1/HIST_SUB_BUCKETS regardless of magnitude.
+
+    Recording a value is a count-leading-zeros, a shift and an increment,
+    with no allocation, so histograms can be updated on every render.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "histogram.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static size_t BucketIndex( uint64_t value );
+static uint64_t BucketValue( size_t idx );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  HIST_Init                                                                 */
+/*!
+    Initialize a histogram
+
+    @param[in]
+        pHist
+            pointer to the histogram to initialize
+
+==============================================================================*/
+void HIST_Init( Histogram *pHist )
+{
+    if ( pHist != NULL )
+    {
+        memset( pHist, 0, sizeof( Histogram ) );
+        pHist->min = UINT64_MAX;
+    }
+}
+
+/*============================================================================*/
+/*  HIST_Record                                                               */
+/*!
+    Record a value in a histogram
+
+    @param[in]
+        pHist
+            pointer to the histogram
+
+    @param[in]
+        value
+            value to record
+
+==============================================================================*/
+void HIST_Record( Histogram *pHist, uint64_t value )
+{
+    if ( pHist != NULL )
+    {
+        pHist->buckets[BucketIndex( value )]++;
+        pHist->count++;
+        pHist->sum += value;
+
+        if ( value < pHist->min )
+        {
+            pHist->min = value;
+        }
+
+        if ( value > pHist->max )
+        {
+            pHist->max = value;
+        }
+    }
+}
+
+/*============================================================================*/
+/*  HIST_Percentile                                                           */
+/*!
+    Get a percentile from a histogram
+
+    The HIST_Percentile function finds the bucket containing the requested
+    quantile and returns its midpoint, clamped to the recorded range.
+
+    @param[in]
+        pHist
+            pointer to the histogram
+
+    @param[in]
+        q
+            quantile in the range 0.0 to 1.0
+
+    @retval the estimated value at the requested quantile
+    @retval 0 if the histogram is empty
+
+==============================================================================*/
+uint64_t HIST_Percentile( const Histogram *pHist, double q )
+{
+    uint64_t value = 0;
+    uint64_t rank;
+    uint64_t seen = 0;
+    size_t idx;
+
+    if ( ( pHist != NULL ) &&
+         ( pHist->count > 0 ) )
+    {
+        if ( q < 0.0 )
+        {
+            q = 0.0;
+        }
+        else if ( q > 1.0 )
+        {
+            q = 1.0;
+        }
+
+        /* 1-based rank of the requested sample */
+        rank = (uint64_t)( q * (double)( pHist->count - 1 ) ) + 1;
+
+        for ( idx = 0 ; idx < HIST_NUM_BUCKETS ; idx++ )
+        {
+            seen += pHist->buckets[idx];
+            if ( seen >= rank )
+            {
+                value = BucketValue( idx );
+                break;
+            }
+        }
+
+        if ( value < pHist->min )
+        {
+            value = pHist->min;
+        }
+        else if ( value > pHist->max )
+        {
+            value = pHist->max;
+        }
+    }
+
+    return value;
+}
+
+/*============================================================================*/
+/*  HIST_Mean                                                                 */
+/*!
+    Get the mean of the recorded values
+
+    @param[in]
+        pHist
+            pointer to the histogram
+
+    @retval the mean of the recorded values
+    @retval 0 if the histogram is empty
+
+==============================================================================*/
+uint64_t HIST_Mean( const Histogram *pHist )
+{
+    uint64_t mean = 0;
+
+    if ( ( pHist != NULL ) &&
+         ( pHist->count > 0 ) )
+    {
+        mean = pHist->sum / pHist->count;
+    }
+
+    return mean;
+}
+
+/*============================================================================*/
+/*  HIST_Print                                                                */
+/*!
+    Print a histogram summary
+
+    The HIST_Print function writes a single line JSON object summarizing
+    the histogram to the specified file descriptor.
+
+    @param[in]
+        pHist
+            pointer to the histogram
+
+    @param[in]
+        fd
+            output file descriptor
+
+    @retval EOK - the summary was printed
+    @retval EIO - the summary could not be written
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int HIST_Print( const Histogram *pHist, int fd )
+{
+    int result = EINVAL;
+    int n;
+
+    if ( ( pHist != NULL ) &&
+         ( fd >= 0 ) )
+    {
+        n = dprintf( fd,
+                     "{\"count\":%llu,\"min\":%llu,\"mean\":%llu,"
+                     "\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,"
+                     "\"p999\":%llu,\"max\":%llu}",
+                     (unsigned long long)pHist->count,
+                     (unsigned long long)( pHist->count ? pHist->min : 0 ),
+                     (unsigned long long)HIST_Mean( pHist ),
+                     (unsigned long long)HIST_Percentile( pHist, 0.50 ),
+                     (unsigned long long)HIST_Percentile( pHist, 0.90 ),
+                     (unsigned long long)HIST_Percentile( pHist, 0.99 ),
+                     (unsigned long long)HIST_Percentile( pHist, 0.999 ),
+                     (unsigned long long)pHist->max );
+
+        result = ( n > 0 ) ? EOK : EIO;
+    }
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  BucketIndex                                                               */
+/*!
+    Map a value to its bucket
+
+    Values below HIST_SUB_BUCKETS map directly to their own bucket.  Larger
+    values are bucketed by the position of their most significant bit, and
+    by the HIST_SUB_BITS bits which follow it.
+
+    @param[in]
+        value
+            value to map
+
+    @retval index of the bucket containing the value
+
+==============================================================================*/
+static size_t BucketIndex( uint64_t value )
+{
+    size_t idx;
+    unsigned int msb;
+    unsigned int shift;
+
+    if ( value < HIST_SUB_BUCKETS )
+    {
+        idx = (size_t)value;
+    }
+    else
+    {
+        msb = 63U - (unsigned int)__builtin_clzll( value );
+        if ( msb > HIST_MAX_EXPONENT )
+        {
+            idx = HIST_NUM_BUCKETS - 1;
+        }
+        else
+        {
+            shift = msb - HIST_SUB_BITS;
+            idx = ( ( shift + 1 ) * HIST_SUB_BUCKETS ) +
+                  (size_t)( ( value >> shift ) - HIST_SUB_BUCKETS );
+        }
+    }
+
+    return idx;
+}
+
+/*============================================================================*/
+/*  BucketValue                                                               */
+/*!
+    Get the representative value of a bucket
+
+    @param[in]
+        idx
+            bucket index
+
+    @retval the midpoint of the range of values covered by the bucket
+
+==============================================================================*/
+static uint64_t BucketValue( size_t idx )
+{
+    uint64_t value;
+    unsigned int shift;
+    uint64_t lower;
+
+    if ( idx < HIST_SUB_BUCKETS )
+    {
+        value = (uint64_t)idx;
+    }
+    else
+    {
+        shift = (unsigned int)( idx / HIST_SUB_BUCKETS ) - 1;
+        lower = ( (uint64_t)HIST_SUB_BUCKETS + ( idx % HIST_SUB_BUCKETS ) )
+                << shift;
+        value = lower + ( ( (uint64_t)1 << shift ) >> 1 );
+    }
+
+    return value;
+}
+
+/*! @}
+ * end of histogram group */
@@ -0,0 +1,708 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup logger logger
+ * @brief Leveled asynchronous logging
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file logger.c
+
+    Leveled asynchronous logging
+
+    The logger module filters log records by level before they are
+    formatted, so a disabled level costs a single comparison.  Enabled
+    records are formatted into a slot of a fixed size lock-free ring,
+    and a background thread drains the ring and writes the records to
+    the log file descriptor in batches, so the caller never blocks on
+    the log output.  If the ring is full the record is dropped and
+    counted.
+
+    Errors and warnings are rate limited per format string: after
+    LOGGER_BURST records in a LOGGER_WINDOW_NS window, further records
+    are suppressed, and the number suppressed is appended to the first
+    record of the next window.
+
+    Until LOGGER_Open is called, records are written synchronously to
+    stderr.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "logger.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of ring slots (must be a power of two) */
+#define LOGGER_RING_SIZE            ( 1024 )
+
+/*! maximum length of a log record, including the level prefix */
+#define LOGGER_MSG_LEN              ( 256 )
+
+/*! number of rate limiter entries (must be a power of two) */
+#define LOGGER_LIMITS               ( 64 )
+
+/*! records allowed per format string in each rate limiter window */
+#define LOGGER_BURST                ( 5 )
+
+/*! rate limiter window */
+#define LOGGER_WINDOW_NS            ( 1000000000ULL )
+
+/*! size of the drain thread's output buffer */
+#define LOGGER_BATCH_SIZE           ( 16 * 1024 )
+
+/*! a ring slot */
+typedef struct loggerSlot
+{
+    /*! slot sequence number */
+    atomic_size_t seq;
+
+    /*! record length */
+    size_t len;
+
+    /*! formatted record */
+    char msg[LOGGER_MSG_LEN];
+
+} LoggerSlot;
+
+/*! rate limiter state for one format string */
+typedef struct loggerLimit
+{
+    /*! format string the entry is tracking */
+    _Atomic( const char * ) fmt;
+
+    /*! start of the current window */
+    atomic_uint_fast64_t window;
+
+    /*! records logged in the current window */
+    atomic_uint count;
+
+    /*! records suppressed in the current window */
+    atomic_uint suppressed;
+
+} LoggerLimit;
+
+/*! logger state */
+typedef struct logger
+{
+    /*! current log level */
+    atomic_int level;
+
+    /*! log output file descriptor */
+    int fd;
+
+    /*! the drain thread is running */
+    bool running;
+
+    /*! request the drain thread to stop */
+    atomic_bool stop;
+
+    /*! drain thread */
+    pthread_t thread;
+
+    /*! counts the records published to the ring */
+    sem_t available;
+
+    /*! next slot to publish */
+    atomic_size_t tail;
+
+    /*! next slot to drain (drain thread only) */
+    size_t head;
+
+    /*! record slots */
+    LoggerSlot ring[LOGGER_RING_SIZE];
+
+    /*! rate limiters */
+    LoggerLimit limits[LOGGER_LIMITS];
+
+    /*! number of records written */
+    atomic_uint_fast64_t written;
+
+    /*! number of records dropped */
+    atomic_uint_fast64_t dropped;
+
+    /*! number of records suppressed */
+    atomic_uint_fast64_t suppressed;
+
+} Logger;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! the logger */
+static Logger logger = { .level = LOGGER_WARNING, .fd = STDERR_FILENO };
+
+/*! level names */
+static const char *levelNames[] =
+{
+    "error",
+    "warning",
+    "info",
+    "debug"
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static bool RateLimit( LoggerLevel level, const char *fmt, unsigned *pCount );
+static int Publish( const char *msg, size_t len );
+static void *DrainThread( void *arg );
+static size_t Drain( char *pBuf, size_t size );
+static void WriteAll( const char *pData, size_t len );
+static uint64_t GetTimeNs( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  LOGGER_Open                                                               */
+/*!
+    Start the asynchronous logger
+
+    The LOGGER_Open function sets the log level and output, and starts
+    the background thread which writes the log records.
+
+    @param[in]
+        level
+            most verbose level to log
+
+    @param[in]
+        fd
+            file descriptor to write the log records to
+
+    @retval EOK - the logger was started
+    @retval EALREADY - the logger is already running
+    @retval other - the drain thread could not be started
+
+==============================================================================*/
+int LOGGER_Open( LoggerLevel level, int fd )
+{
+    int result = EALREADY;
+    size_t i;
+    sigset_t mask;
+    sigset_t saved;
+
+    if ( logger.running == false )
+    {
+        atomic_store( &logger.level, level );
+        atomic_store( &logger.stop, false );
+        logger.fd = fd;
+        logger.head = 0;
+        atomic_store( &logger.tail, 0 );
+
+        for ( i = 0 ; i < LOGGER_RING_SIZE ; i++ )
+        {
+            atomic_store( &logger.ring[i].seq, i );
+        }
+
+        result = ( sem_init( &logger.available, 0, 0 ) == 0 ) ? EOK : errno;
+        if ( result == EOK )
+        {
+            /* the drain thread must not take the process signals, which
+               are received synchronously by the main thread */
+            sigfillset( &mask );
+            pthread_sigmask( SIG_SETMASK, &mask, &saved );
+            result = pthread_create( &logger.thread, NULL, DrainThread, NULL );
+            pthread_sigmask( SIG_SETMASK, &saved, NULL );
+            if ( result == EOK )
+            {
+                logger.running = true;
+            }
+            else
+            {
+                sem_destroy( &logger.available );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  LOGGER_SetLevel                                                           */
+/*!
+    Set the log level
+
+    @param[in]
+        level
+            most verbose level to log
+
+==============================================================================*/
+void LOGGER_SetLevel( LoggerLevel level )
+{
+    atomic_store_explicit( &logger.level, level, memory_order_relaxed );
+}
+
+/*============================================================================*/
+/*  LOGGER_Enabled                                                            */
+/*!
+    Determine if a log level is enabled
+
+    Callers can use LOGGER_Enabled to skip gathering the arguments of
+    a disabled log record.
+
+    @param[in]
+        level
+            log level to check
+
+    @retval true - records at this level are logged
+    @retval false - records at this level are discarded
+
+==============================================================================*/
+bool LOGGER_Enabled( LoggerLevel level )
+{
+    return (int)level <= atomic_load_explicit( &logger.level,
+                                               memory_order_relaxed );
+}
+
+/*============================================================================*/
+/*  LOGGER_Log                                                                */
+/*!
+    Log a record
+
+    The LOGGER_Log function discards the record if its level is not
+    enabled, or if it is rate limited.  Otherwise the record is formatted
+    and queued for the drain thread, or written directly if the logger
+    has not been started.
+
+    @param[in]
+        level
+            log level of the record
+
+    @param[in]
+        fmt
+            printf style format string
+
+==============================================================================*/
+void LOGGER_Log( LoggerLevel level, const char *fmt, ... )
+{
+    char msg[LOGGER_MSG_LEN];
+    unsigned suppressed = 0;
+    va_list args;
+    int n;
+    int len;
+
+    if ( ( LOGGER_Enabled( level ) == true ) &&
+         ( fmt != NULL ) &&
+         ( RateLimit( level, fmt, &suppressed ) == false ) )
+    {
+        len = snprintf( msg, sizeof( msg ), "templatesvc: %s: ",
+                        levelNames[level] );
+
+        va_start( args, fmt );
+        n = vsnprintf( &msg[len], sizeof( msg ) - len, fmt, args );
+        va_end( args );
+
+        len = ( n < (int)sizeof( msg ) - len ) ? len + n : sizeof( msg ) - 1;
+
+        if ( ( suppressed > 0 ) && ( len < (int)sizeof( msg ) - 1 ) )
+        {
+            n = snprintf( &msg[len], sizeof( msg ) - len,
+                          " (%u similar suppressed)", suppressed );
+            len = ( n < (int)sizeof( msg ) - len )
+                  ? len + n
+                  : sizeof( msg ) - 1;
+        }
+
+        /* terminate the record with a newline, truncating if necessary */
+        if ( len >= (int)sizeof( msg ) - 1 )
+        {
+            len = sizeof( msg ) - 2;
+        }
+
+        msg[len++] = '\n';
+
+        if ( logger.running == true )
+        {
+            (void)Publish( msg, len );
+        }
+        else
+        {
+            WriteAll( msg, len );
+            atomic_fetch_add( &logger.written, 1 );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  LOGGER_GetStats                                                           */
+/*!
+    Get the logger counters
+
+    @param[out]
+        pStats
+            pointer to the location to store the counters
+
+==============================================================================*/
+void LOGGER_GetStats( LoggerStats *pStats )
+{
+    if ( pStats != NULL )
+    {
+        pStats->written = atomic_load( &logger.written );
+        pStats->dropped = atomic_load( &logger.dropped );
+        pStats->suppressed = atomic_load( &logger.suppressed );
+    }
+}
+
+/*============================================================================*/
+/*  LOGGER_Close                                                              */
+/*!
+    Stop the asynchronous logger
+
+    The LOGGER_Close function writes any queued records, stops the drain
+    thread, and reverts to writing records synchronously to stderr.
+
+==============================================================================*/
+void LOGGER_Close( void )
+{
+    if ( logger.running == true )
+    {
+        atomic_store( &logger.stop, true );
+        sem_post( &logger.available );
+        pthread_join( logger.thread, NULL );
+        sem_destroy( &logger.available );
+
+        logger.running = false;
+        logger.fd = STDERR_FILENO;
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  RateLimit                                                                 */
+/*!
+    Apply the rate limit for a format string
+
+    Errors and warnings are limited to LOGGER_BURST records per format
+    string in each window.  Format strings which share a rate limiter
+    entry replace each other, so a colliding string restarts the window.
+
+    @param[in]
+        level
+            log level of the record
+
+    @param[in]
+        fmt
+            format string of the record
+
+    @param[out]
+        pCount
+            number of records suppressed in the previous window, if this
+            is the first record of a new window
+
+    @retval true - the record is suppressed
+    @retval false - the record should be logged
+
+==============================================================================*/
+static bool RateLimit( LoggerLevel level, const char *fmt, unsigned *pCount )
+{
+    LoggerLimit *pLimit;
+    uint64_t now;
+    bool suppress = false;
+
+    if ( level <= LOGGER_WARNING )
+    {
+        pLimit = &logger.limits[ ( (uintptr_t)fmt >> 3 ) &
+                                 ( LOGGER_LIMITS - 1 ) ];
+        now = GetTimeNs();
+
+        if ( atomic_load( &pLimit->fmt ) != fmt )
+        {
+            atomic_store( &pLimit->fmt, fmt );
+            atomic_store( &pLimit->window, now );
+            atomic_store( &pLimit->count, 0 );
+            atomic_store( &pLimit->suppressed, 0 );
+        }
+        else if ( now - atomic_load( &pLimit->window ) >= LOGGER_WINDOW_NS )
+        {
+            atomic_store( &pLimit->window, now );
+            atomic_store( &pLimit->count, 0 );
+            *pCount = atomic_exchange( &pLimit->suppressed, 0 );
+        }
+
+        if ( atomic_fetch_add( &pLimit->count, 1 ) >= LOGGER_BURST )
+        {
+            atomic_fetch_add( &pLimit->suppressed, 1 );
+            atomic_fetch_add( &logger.suppressed, 1 );
+            suppress = true;
+        }
+    }
+
+    return suppress;
+}
+
+/*============================================================================*/
+/*  Publish                                                                   */
+/*!
+    Publish a record to the ring
+
+    Each slot carries a sequence number which tells a producer when the
+    slot is free (seq == position) and the drain thread when it is full
+    (seq == position + 1), so producers only contend on the ring tail.
+
+    @param[in]
+        msg
+            formatted record
+
+    @param[in]
+        len
+            record length
+
+    @retval EOK - the record was published
+    @retval ENOSPC - the ring is full and the record was dropped
+
+==============================================================================*/
+static int Publish( const char *msg, size_t len )
+{
+    int result = ENOSPC;
+    LoggerSlot *pSlot;
+    size_t pos;
+    size_t seq;
+
+    pos = atomic_load_explicit( &logger.tail, memory_order_relaxed );
+    for ( ;; )
+    {
+        pSlot = &logger.ring[pos & ( LOGGER_RING_SIZE - 1 )];
+        seq = atomic_load_explicit( &pSlot->seq, memory_order_acquire );
+
+        if ( seq == pos )
+        {
+            if ( atomic_compare_exchange_weak_explicit(
+                        &logger.tail,
+                        &pos,
+                        pos + 1,
+                        memory_order_relaxed,
+                        memory_order_relaxed ) )
+            {
+                result = EOK;
+                break;
+            }
+        }
+        else if ( (intptr_t)( seq - pos ) < 0 )
+        {
+            /* the slot still holds an undrained record */
+            break;
+        }
+        else
+        {
+            pos = atomic_load_explicit( &logger.tail, memory_order_relaxed );
+        }
+    }
+
+    if ( result == EOK )
+    {
+        memcpy( pSlot->msg, msg, len );
+        pSlot->len = len;
+        atomic_store_explicit( &pSlot->seq, pos + 1, memory_order_release );
+        sem_post( &logger.available );
+    }
+    else
+    {
+        atomic_fetch_add( &logger.dropped, 1 );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  DrainThread                                                               */
+/*!
+    Write the published records to the log output
+
+    The drain thread waits for records to be published, and writes all
+    the records available at once with a single write.  When stopped, it
+    writes any remaining records before exiting.
+
+    @param[in]
+        arg
+            unused
+
+    @retval NULL
+
+==============================================================================*/
+static void *DrainThread( void *arg )
+{
+    char *pBuf;
+    size_t len;
+    bool done = false;
+
+    (void)arg;
+
+    pBuf = malloc( LOGGER_BATCH_SIZE );
+
+    while ( ( pBuf != NULL ) && ( done == false ) )
+    {
+        while ( ( sem_wait( &logger.available ) != 0 ) &&
+                ( errno == EINTR ) )
+        {
+        }
+
+        done = atomic_load( &logger.stop );
+
+        do
+        {
+            len = Drain( pBuf, LOGGER_BATCH_SIZE );
+            WriteAll( pBuf, len );
+        } while ( len > 0 );
+    }
+
+    free( pBuf );
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  Drain                                                                     */
+/*!
+    Copy the available records from the ring into a buffer
+
+    @param[in]
+        pBuf
+            pointer to the output buffer
+
+    @param[in]
+        size
+            size of the output buffer
+
+    @retval number of bytes copied
+
+==============================================================================*/
+static size_t Drain( char *pBuf, size_t size )
+{
+    LoggerSlot *pSlot;
+    size_t len = 0;
+    size_t seq;
+
+    for ( ;; )
+    {
+        pSlot = &logger.ring[logger.head & ( LOGGER_RING_SIZE - 1 )];
+        seq = atomic_load_explicit( &pSlot->seq, memory_order_acquire );
+
+        if ( ( seq != logger.head + 1 ) ||
+             ( len + pSlot->len > size ) )
+        {
+            break;
+        }
+
+        memcpy( &pBuf[len], pSlot->msg, pSlot->len );
+        len += pSlot->len;
+
+        /* release the slot for the next lap of the ring */
+        atomic_store_explicit( &pSlot->seq,
+                               logger.head + LOGGER_RING_SIZE,
+                               memory_order_release );
+        logger.head++;
+        atomic_fetch_add( &logger.written, 1 );
+    }
+
+    return len;
+}
+
+/*============================================================================*/
+/*  WriteAll                                                                  */
+/*!
+    Write a buffer to the log output
+
+    @param[in]
+        pData
+            pointer to the data to write
+
+    @param[in]
+        len
+            number of bytes to write
+
+==============================================================================*/
+static void WriteAll( const char *pData, size_t len )
+{
+    ssize_t n;
+
+    while ( len > 0 )
+    {
+        n = write( logger.fd, pData, len );
+        if ( n > 0 )
+        {
+            pData += n;
+            len -= n;
+        }
+        else if ( ( n < 0 ) && ( errno == EINTR ) )
+        {
+            continue;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+/*============================================================================*/
+/*  GetTimeNs                                                                 */
+/*!
+    Get the coarse monotonic time in ns
+
+    @retval monotonic time in ns
+
+==============================================================================*/
+static uint64_t GetTimeNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC_COARSE, &ts );
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of logger group */
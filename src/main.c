@@ -0,0 +1,406 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup templatesvc templatesvc
+ * @brief Trigger template file generation on variable changes
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file main.c
+
+    Template Service Application
+
+    The main entry point of the templatesvc application.  It processes
+    the command line options, loads the template service configuration
+    and dispatches the signals received from the variable server to the
+    template service core (see templatesvc.c).
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <signal.h>
+#include <varserver/varserver.h>
+#include <tjson/json.h>
+#include "templatesvc.h"
+#include "logger.h"
+#include "eventloop.h"
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! TemplateSvc state object */
+TemplateSvcState state;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+void main(int argc, char **argv);
+static int ProcessOptions( int argC, char *argV[], TemplateSvcState *pState );
+static void usage( char *cmdname );
+static int SetupTerminationHandler( EventLoop *pLoop );
+static void TerminationHandler( EventLoop *pLoop,
+                                int sig,
+                                int sigval,
+                                void *arg );
+static void ReloadHandler( EventLoop *pLoop,
+                           int sig,
+                           int sigval,
+                           void *arg );
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the templatesvc application
+
+    The main function starts the templatesvc application
+
+    @param[in]
+        argc
+            number of arguments on the command line
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @return none
+
+==============================================================================*/
+void main(int argc, char **argv)
+{
+    EventLoop *pLoop;
+
+    /* clear the templatesvc state object */
+    TEMPLATESVC_Init( &state );
+
+    /* render every template once its notifications are in place */
+    state.renderOnLoad = true;
+
+    if( argc < 2 )
+    {
+        usage( argv[0] );
+        exit( 1 );
+    }
+
+    /* process the command line options */
+    ProcessOptions( argc, argv, &state );
+
+    /* start the log output thread */
+    LOGGER_Open( state.logLevel, STDERR_FILENO );
+
+    /* create the event loop and set up the termination handler */
+    pLoop = EVENTLOOP_Create();
+    if ( ( pLoop != NULL ) &&
+         ( SetupTerminationHandler( pLoop ) == EOK ) &&
+         ( TEMPLATESVC_Open( &state ) == EOK ) )
+    {
+        /* set up the templates from the configuration, or its cache */
+        TEMPLATESVC_LoadConfig( &state );
+
+        /* receive variable server signals, template changes, and
+           configuration reload requests */
+        if ( ( TEMPLATESVC_Attach( &state, pLoop ) == EOK ) &&
+             ( EVENTLOOP_AddSignal( pLoop,
+                                    SIGHUP,
+                                    ReloadHandler,
+                                    NULL ) == EOK ) )
+        {
+            EVENTLOOP_Run( pLoop );
+        }
+        else
+        {
+            LOGGER_Log( LOGGER_ERROR, "Cannot start the event loop" );
+        }
+
+        /* close the variable server */
+        TEMPLATESVC_Close( &state );
+    }
+
+    EVENTLOOP_Destroy( pLoop );
+
+    LOGGER_Close();
+}
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the application usage
+
+    The usage function dumps the application usage message
+    to stderr.
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+    @return none
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    if( cmdname != NULL )
+    {
+        fprintf(stderr,
+                "usage: %s [-v] [-s size] [-m prefix] [-c capture] [-C]"
+                " [-b cache] [-n connections] [-h] [-f filename]"
+                " [-d directory]\n"
+                " [-h] : display this help\n"
+                " [-v] : verbose output (-vv to log every render)\n"
+                " [-s] : max message size (for mq targets)\n"
+                " [-m] : publish render metrics under this variable prefix\n"
+                " [-c] : record received triggers to this capture file\n"
+                " [-C] : also record fetched values to the capture file\n"
+                " [-b] : compiled configuration cache file\n"
+                " [-n] : max variable server connections at startup\n"
+                " [-f] : configuration file\n"
+                " [-d] : directory of *.json configuration files\n",
+                cmdname );
+    }
+}
+
+/*============================================================================*/
+/*  ProcessOptions                                                            */
+/*!
+    Process the command line options
+
+    The ProcessOptions function processes the command line options and
+    populates the TemplateSvcState object
+
+    @param[in]
+        argC
+            number of arguments
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @param[in]
+        pState
+            pointer to the TemplateSvc state object
+
+    @return always 0
+
+==============================================================================*/
+static int ProcessOptions( int argC, char *argV[], TemplateSvcState *pState )
+{
+    int c;
+    int result = EINVAL;
+    const char *options = "hvf:d:s:m:c:Cb:n:";
+
+    if( ( pState != NULL ) &&
+        ( argV != NULL ) )
+    {
+        while( ( c = getopt( argC, argV, options ) ) != -1 )
+        {
+            switch( c )
+            {
+                case 'v':
+                    pState->verbose = true;
+                    if ( pState->logLevel < LOGGER_DEBUG )
+                    {
+                        pState->logLevel++;
+                    }
+                    break;
+
+                case 's':
+                    pState->varfpSize = strtoul( optarg, NULL, 0 );
+                    break;
+
+                case 'h':
+                    usage( argV[0] );
+                    break;
+
+                case 'f':
+                    pState->pFileName = strdup(optarg);
+                    break;
+
+                case 'd':
+                    pState->pConfigDir = strdup(optarg);
+                    break;
+
+                case 'm':
+                    pState->pMetricsPrefix = strdup(optarg);
+                    break;
+
+                case 'c':
+                    pState->pCaptureFile = strdup(optarg);
+                    break;
+
+                case 'C':
+                    pState->captureFlags |= CAPTURE_VALUES;
+                    break;
+
+                case 'b':
+                    pState->pCacheFile = strdup(optarg);
+                    break;
+
+                case 'n':
+                    pState->connections = strtoul( optarg, NULL, 0 );
+                    break;
+
+                default:
+                    break;
+
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*============================================================================*/
+/*  SetupTerminationHandler                                                   */
+/*!
+    Set up the termination handler
+
+    The SetupTerminationHandler function registers the termination
+    handler with the event loop, so SIGTERM and SIGINT are received
+    alongside the variable server signals rather than interrupting them.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @retval EOK - the termination handler was registered
+    @retval other - the termination signals could not be registered
+
+==============================================================================*/
+static int SetupTerminationHandler( EventLoop *pLoop )
+{
+    int result;
+
+    result = EVENTLOOP_AddSignal( pLoop, SIGTERM, TerminationHandler, NULL );
+    if ( result == EOK )
+    {
+        result = EVENTLOOP_AddSignal( pLoop,
+                                      SIGINT,
+                                      TerminationHandler,
+                                      NULL );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TerminationHandler                                                        */
+/*!
+    Termination handler
+
+    The TerminationHandler function is invoked by the event loop when the
+    process is asked to terminate.  It stops the event loop so main can
+    close the connection with the variable server, clean up its VARFP
+    shared memory, and write out any queued log records.
+
+@param[in]
+    pLoop
+        pointer to the event loop
+
+@param[in]
+    sig
+        The signal which requested the termination
+
+@param[in]
+    sigval
+        The value associated with the signal (unused)
+
+@param[in]
+    arg
+        opaque handler argument (unused)
+
+==============================================================================*/
+static void TerminationHandler( EventLoop *pLoop,
+                                int sig,
+                                int sigval,
+                                void *arg )
+{
+    (void)sigval;
+    (void)arg;
+
+    LOGGER_Log( LOGGER_WARNING, "Terminating on signal %d", sig );
+    syslog( LOG_ERR, "Termination of templatesvc" );
+
+    EVENTLOOP_Stop( pLoop );
+}
+
+/*============================================================================*/
+/*  ReloadHandler                                                             */
+/*!
+    Configuration reload handler
+
+    The ReloadHandler function is invoked by the event loop on SIGHUP.
+    It re-reads the configuration file, and applies the changes to the
+    running templates.
+
+@param[in]
+    pLoop
+        pointer to the event loop (unused)
+
+@param[in]
+    sig
+        The signal which requested the reload (unused)
+
+@param[in]
+    sigval
+        The value associated with the signal (unused)
+
+@param[in]
+    arg
+        opaque handler argument (unused)
+
+==============================================================================*/
+static void ReloadHandler( EventLoop *pLoop,
+                           int sig,
+                           int sigval,
+                           void *arg )
+{
+    (void)pLoop;
+    (void)sig;
+    (void)sigval;
+    (void)arg;
+
+    TEMPLATESVC_Reload( &state );
+}
+
+/*! @}
+ * end of templatesvc group */
@@ -0,0 +1,536 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup metrics metrics
+ * @brief Per-template render metrics published via the variable server
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file metrics.c
+
+    Template Metrics
+
+    The metrics module keeps a set of log-linear histograms for each
+    template: trigger-to-output latency, render time and sink time, all
+    in nanoseconds measured with the monotonic clock.  It also counts the
+    trigger notifications filtered out by the template's trigger
+    conditions, and the renders deferred by a tenant's render rate limit.
+    For a compressed template it also keeps a histogram of the compression
+    time, and the totals of the uncompressed and compressed bytes.
+
+    Each histogram is published as a string variable named
+    <prefix>/<template name>/<metric>.  The variables are not updated on
+    every render.  Instead a PRINT notification is requested for each one,
+    and a summary of the histogram is generated only when a client reads
+    the variable, so the cost on the render path is a clock read and a
+    bucket increment.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <inttypes.h>
+#include "metrics.h"
+#include "logger.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! per-template metrics */
+struct templateMetrics
+{
+    /*! histograms for each metric */
+    Histogram hist[METRIC_COUNT];
+
+    /*! variable server handles for each metric */
+    VAR_HANDLE hVar[METRIC_COUNT];
+
+    /*! number of trigger notifications filtered out */
+    uint64_t filtered;
+
+    /*! variable server handle for the filtered trigger count */
+    VAR_HANDLE hFiltered;
+
+    /*! number of renders deferred by a render rate limit */
+    uint64_t throttled;
+
+    /*! variable server handle for the throttled render count */
+    VAR_HANDLE hThrottled;
+
+    /*! compression time histogram */
+    Histogram compress;
+
+    /*! variable server handle for the compression time */
+    VAR_HANDLE hCompress;
+
+    /*! total number of bytes passed to the compressor */
+    uint64_t bytesIn;
+
+    /*! total number of compressed bytes */
+    uint64_t bytesOut;
+
+    /*! variable server handle for the compression ratio */
+    VAR_HANDLE hRatio;
+};
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! variable name suffixes for each metric */
+static const char *metricNames[METRIC_COUNT] =
+{
+    "latency",
+    "render",
+    "sink"
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static VAR_HANDLE CreateMetricVar( VARSERVER_HANDLE hVarServer,
+                                   const char *prefix,
+                                   const char *name,
+                                   const char *metric );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  METRICS_Now                                                               */
+/*!
+    Get a monotonic timestamp
+
+    @retval the current value of the monotonic clock in nanoseconds
+
+==============================================================================*/
+uint64_t METRICS_Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * 1000000000ULL ) + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  METRICS_Create                                                            */
+/*!
+    Create the metrics for a template
+
+    The METRICS_Create function creates the histograms for a template
+    and the variables used to publish them.  Variables which already exist
+    (for example from a previous instance of the service) are reused.
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        prefix
+            variable name prefix, eg /sys/templatesvc
+
+    @param[in]
+        name
+            template name
+
+    @param[in]
+        compressed
+            true to also publish the compression metrics
+
+    @retval pointer to the new metrics object
+    @retval NULL if the metrics object could not be created
+
+==============================================================================*/
+TemplateMetrics *METRICS_Create( VARSERVER_HANDLE hVarServer,
+                                 const char *prefix,
+                                 const char *name,
+                                 bool compressed )
+{
+    TemplateMetrics *pMetrics = NULL;
+    int i;
+
+    if ( ( hVarServer != NULL ) &&
+         ( prefix != NULL ) &&
+         ( name != NULL ) )
+    {
+        pMetrics = calloc( 1, sizeof( TemplateMetrics ) );
+        if ( pMetrics != NULL )
+        {
+            for ( i = 0 ; i < METRIC_COUNT ; i++ )
+            {
+                HIST_Init( &pMetrics->hist[i] );
+                pMetrics->hVar[i] = CreateMetricVar( hVarServer,
+                                                     prefix,
+                                                     name,
+                                                     metricNames[i] );
+            }
+
+            pMetrics->hFiltered = CreateMetricVar( hVarServer,
+                                                   prefix,
+                                                   name,
+                                                   "filtered" );
+
+            pMetrics->hThrottled = CreateMetricVar( hVarServer,
+                                                    prefix,
+                                                    name,
+                                                    "throttled" );
+
+            HIST_Init( &pMetrics->compress );
+            pMetrics->hCompress = VAR_INVALID;
+            pMetrics->hRatio = VAR_INVALID;
+            if ( compressed == true )
+            {
+                pMetrics->hCompress = CreateMetricVar( hVarServer,
+                                                       prefix,
+                                                       name,
+                                                       "compress" );
+                pMetrics->hRatio = CreateMetricVar( hVarServer,
+                                                    prefix,
+                                                    name,
+                                                    "ratio" );
+            }
+        }
+    }
+
+    return pMetrics;
+}
+
+/*============================================================================*/
+/*  METRICS_Record                                                            */
+/*!
+    Record a template metric
+
+    @param[in]
+        pMetrics
+            pointer to the template metrics (may be NULL)
+
+    @param[in]
+        id
+            identifier of the metric to record
+
+    @param[in]
+        ns
+            duration in nanoseconds
+
+==============================================================================*/
+void METRICS_Record( TemplateMetrics *pMetrics, MetricId id, uint64_t ns )
+{
+    if ( ( pMetrics != NULL ) &&
+         ( id < METRIC_COUNT ) )
+    {
+        HIST_Record( &pMetrics->hist[id], ns );
+    }
+}
+
+/*============================================================================*/
+/*  METRICS_Compressed                                                        */
+/*!
+    Record the compression of a render
+
+    @param[in]
+        pMetrics
+            pointer to the template metrics (may be NULL)
+
+    @param[in]
+        in
+            uncompressed size of the render
+
+    @param[in]
+        out
+            compressed size of the render
+
+    @param[in]
+        ns
+            compression time in nanoseconds
+
+==============================================================================*/
+void METRICS_Compressed( TemplateMetrics *pMetrics,
+                         size_t in,
+                         size_t out,
+                         uint64_t ns )
+{
+    if ( pMetrics != NULL )
+    {
+        HIST_Record( &pMetrics->compress, ns );
+        pMetrics->bytesIn += in;
+        pMetrics->bytesOut += out;
+    }
+}
+
+/*============================================================================*/
+/*  METRICS_Filtered                                                          */
+/*!
+    Count a trigger notification filtered out by a trigger condition
+
+    @param[in]
+        pMetrics
+            pointer to the template metrics (may be NULL)
+
+==============================================================================*/
+void METRICS_Filtered( TemplateMetrics *pMetrics )
+{
+    if ( pMetrics != NULL )
+    {
+        pMetrics->filtered++;
+    }
+}
+
+/*============================================================================*/
+/*  METRICS_Throttled                                                         */
+/*!
+    Count a render deferred by a render rate limit
+
+    @param[in]
+        pMetrics
+            pointer to the template metrics (may be NULL)
+
+==============================================================================*/
+void METRICS_Throttled( TemplateMetrics *pMetrics )
+{
+    if ( pMetrics != NULL )
+    {
+        pMetrics->throttled++;
+    }
+}
+
+/*============================================================================*/
+/*  METRICS_Get                                                               */
+/*!
+    Get a template metric histogram
+
+    @param[in]
+        pMetrics
+            pointer to the template metrics
+
+    @param[in]
+        id
+            identifier of the metric to get
+
+    @retval pointer to the metric histogram
+    @retval NULL if the metric is not available
+
+==============================================================================*/
+const Histogram *METRICS_Get( TemplateMetrics *pMetrics, MetricId id )
+{
+    const Histogram *pHist = NULL;
+
+    if ( ( pMetrics != NULL ) &&
+         ( id < METRIC_COUNT ) )
+    {
+        pHist = &pMetrics->hist[id];
+    }
+
+    return pHist;
+}
+
+/*============================================================================*/
+/*  METRICS_Print                                                             */
+/*!
+    Print a template metric
+
+    The METRICS_Print function checks if the specified variable handle
+    is one of the template's metric variables, and if so, prints the
+    summary of the corresponding histogram, or the filtered trigger count,
+    or the throttled render count, or the compressed byte totals and their
+    ratio, to the output file descriptor.
+
+    @param[in]
+        pMetrics
+            pointer to the template metrics
+
+    @param[in]
+        hVar
+            handle of the variable being printed
+
+    @param[in]
+        fd
+            output file descriptor
+
+    @retval EOK - the metric was printed
+    @retval ENOENT - the variable is not one of the template's metrics
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int METRICS_Print( TemplateMetrics *pMetrics, VAR_HANDLE hVar, int fd )
+{
+    int result = EINVAL;
+    int i;
+
+    if ( ( pMetrics != NULL ) &&
+         ( hVar != VAR_INVALID ) )
+    {
+        result = ENOENT;
+
+        if ( pMetrics->hFiltered == hVar )
+        {
+            dprintf( fd, "%" PRIu64, pMetrics->filtered );
+            result = EOK;
+        }
+        else if ( pMetrics->hThrottled == hVar )
+        {
+            dprintf( fd, "%" PRIu64, pMetrics->throttled );
+            result = EOK;
+        }
+        else if ( pMetrics->hCompress == hVar )
+        {
+            result = HIST_Print( &pMetrics->compress, fd );
+        }
+        else if ( pMetrics->hRatio == hVar )
+        {
+            dprintf( fd,
+                     "{\"in\":%" PRIu64 ",\"out\":%" PRIu64
+                     ",\"ratio\":%.2f}",
+                     pMetrics->bytesIn,
+                     pMetrics->bytesOut,
+                     ( pMetrics->bytesOut > 0 )
+                        ? (double)pMetrics->bytesIn /
+                          (double)pMetrics->bytesOut
+                        : 0.0 );
+            result = EOK;
+        }
+        else
+        {
+            for ( i = 0 ; i < METRIC_COUNT ; i++ )
+            {
+                if ( pMetrics->hVar[i] == hVar )
+                {
+                    result = HIST_Print( &pMetrics->hist[i], fd );
+                    break;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  METRICS_Delete                                                            */
+/*!
+    Delete the metrics for a template
+
+    @param[in]
+        pMetrics
+            pointer to the template metrics to delete
+
+==============================================================================*/
+void METRICS_Delete( TemplateMetrics *pMetrics )
+{
+    free( pMetrics );
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  CreateMetricVar                                                           */
+/*!
+    Create a metric variable
+
+    The CreateMetricVar function finds or creates the string variable
+    <prefix>/<name>/<metric> and requests PRINT notifications for it.
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        prefix
+            variable name prefix
+
+    @param[in]
+        name
+            template name
+
+    @param[in]
+        metric
+            metric name
+
+    @retval handle of the metric variable
+    @retval VAR_INVALID if the variable could not be created
+
+==============================================================================*/
+static VAR_HANDLE CreateMetricVar( VARSERVER_HANDLE hVarServer,
+                                   const char *prefix,
+                                   const char *name,
+                                   const char *metric )
+{
+    VarInfo info;
+    VAR_HANDLE hVar = VAR_INVALID;
+    int n;
+
+    memset( &info, 0, sizeof( info ) );
+
+    n = snprintf( info.name,
+                  sizeof( info.name ),
+                  "%s/%s/%s",
+                  prefix,
+                  name,
+                  metric );
+    if ( ( n > 0 ) && ( (size_t)n < sizeof( info.name ) ) )
+    {
+        hVar = VAR_FindByName( hVarServer, info.name );
+        if ( hVar == VAR_INVALID )
+        {
+            info.var.type = VARTYPE_STR;
+            info.var.val.str = "";
+            info.var.len = 1;
+
+            if ( VARSERVER_CreateVar( hVarServer, &info ) == EOK )
+            {
+                hVar = info.hVar;
+            }
+        }
+
+        if ( ( hVar == VAR_INVALID ) ||
+             ( VAR_Notify( hVarServer, hVar, NOTIFY_PRINT ) != EOK ) )
+        {
+            LOGGER_Log( LOGGER_ERROR,
+                        "Cannot publish metric: %s",
+                        info.name );
+        }
+    }
+
+    return hVar;
+}
+
+/*! @}
+ * end of metrics group */
@@ -0,0 +1,750 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup numfmt numfmt
+ * @brief Locale independent numeric formatting
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file numfmt.c
+
+    Numeric Formatting
+
+    The numfmt module provides fast, locale independent conversion of
+    integer and floating point values to text.
+
+    Floats are converted to the shortest decimal string which round-trips
+    back to the same single precision value, using the Ryu algorithm
+    (Ulf Adams, "Ryu: fast float-to-string conversion", PLDI 2018).
+    The power of 5 multiplier tables are computed on first use rather
+    than being stored in the source.
+
+    Floats are printed in fixed notation when the decimal exponent is
+    in the range [-7, 21), and in exponential notation otherwise,
+    following the ECMAScript Number to String conversion rules.
+
+    Integers are converted two digits at a time using a lookup table,
+    with the output length computed up front from the bit length of
+    the value.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "numfmt.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#define FLOAT_MANTISSA_BITS         23
+#define FLOAT_EXPONENT_BITS         8
+#define FLOAT_BIAS                  127
+
+#define FLOAT_POW5_INV_BITCOUNT     59
+#define FLOAT_POW5_BITCOUNT         61
+
+#define FLOAT_POW5_INV_TABLE_SIZE   31
+#define FLOAT_POW5_TABLE_SIZE       48
+
+/*! decimal digit pairs "00" to "99" */
+static const char DigitPairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/*! powers of 10 used to compute the decimal length of an integer */
+static const uint64_t Pow10[20] =
+{
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL
+};
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! floor( 2^k / 5^i ) + 1 multipliers */
+static uint64_t Pow5InvSplit[FLOAT_POW5_INV_TABLE_SIZE];
+
+/*! 5^i normalized to FLOAT_POW5_BITCOUNT bits */
+static uint64_t Pow5Split[FLOAT_POW5_TABLE_SIZE];
+
+/*! indicates if the multiplier tables have been computed */
+static bool TablesReady = false;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void InitTables( void );
+static int32_t Pow5Bits( int32_t e );
+static uint32_t Log10Pow2( int32_t e );
+static uint32_t Log10Pow5( int32_t e );
+static uint32_t Pow5Factor( uint32_t value );
+static uint32_t MulShift32( uint32_t m, uint64_t factor, int32_t shift );
+static void ShortestDecimal( uint32_t ieeeMantissa,
+                             uint32_t ieeeExponent,
+                             uint32_t *pOutput,
+                             int32_t *pExponent );
+static size_t DecimalLength( uint64_t n );
+static void WriteDigits( uint64_t n, char *end );
+static size_t FormatDecimal( uint32_t digits, int32_t exponent, char *buf );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NUMFMT_Float                                                              */
+/*!
+    Format a float as the shortest round-trip decimal string
+
+    The NUMFMT_Float function converts a single precision float into the
+    shortest decimal representation which parses back to exactly the same
+    value.  The output does not depend on the current locale.
+    The output is not NUL terminated.
+
+    @param[in]
+        f
+            the value to format
+
+    @param[in]
+        buf
+            pointer to an output buffer of at least NUMFMT_MAX_LEN bytes
+
+    @retval the number of characters written
+
+==============================================================================*/
+size_t NUMFMT_Float( float f, char *buf )
+{
+    uint32_t bits;
+    uint32_t ieeeMantissa;
+    uint32_t ieeeExponent;
+    uint32_t digits;
+    int32_t exponent;
+    size_t n = 0;
+
+    memcpy( &bits, &f, sizeof( bits ) );
+
+    ieeeMantissa = bits & ( ( 1u << FLOAT_MANTISSA_BITS ) - 1u );
+    ieeeExponent = ( bits >> FLOAT_MANTISSA_BITS ) &
+                   ( ( 1u << FLOAT_EXPONENT_BITS ) - 1u );
+
+    if ( bits >> 31 )
+    {
+        buf[n++] = '-';
+    }
+
+    if ( ieeeExponent == ( ( 1u << FLOAT_EXPONENT_BITS ) - 1u ) )
+    {
+        if ( ieeeMantissa != 0 )
+        {
+            /* NaN has no sign */
+            memcpy( buf, "nan", 3 );
+            n = 3;
+        }
+        else
+        {
+            memcpy( &buf[n], "inf", 3 );
+            n += 3;
+        }
+    }
+    else if ( ( ieeeExponent == 0 ) && ( ieeeMantissa == 0 ) )
+    {
+        buf[n++] = '0';
+    }
+    else
+    {
+        if ( TablesReady == false )
+        {
+            InitTables();
+        }
+
+        ShortestDecimal( ieeeMantissa, ieeeExponent, &digits, &exponent );
+        n += FormatDecimal( digits, exponent, &buf[n] );
+    }
+
+    return n;
+}
+
+/*============================================================================*/
+/*  NUMFMT_Uint64                                                             */
+/*!
+    Format an unsigned integer
+
+    The output is not NUL terminated.
+
+    @param[in]
+        n
+            the value to format
+
+    @param[in]
+        buf
+            pointer to an output buffer of at least NUMFMT_MAX_LEN bytes
+
+    @retval the number of characters written
+
+==============================================================================*/
+size_t NUMFMT_Uint64( uint64_t n, char *buf )
+{
+    size_t len = DecimalLength( n );
+
+    WriteDigits( n, &buf[len] );
+
+    return len;
+}
+
+/*============================================================================*/
+/*  NUMFMT_Int64                                                              */
+/*!
+    Format a signed integer
+
+    The output is not NUL terminated.
+
+    @param[in]
+        n
+            the value to format
+
+    @param[in]
+        buf
+            pointer to an output buffer of at least NUMFMT_MAX_LEN bytes
+
+    @retval the number of characters written
+
+==============================================================================*/
+size_t NUMFMT_Int64( int64_t n, char *buf )
+{
+    uint64_t u = (uint64_t)n;
+    size_t neg = (size_t)( u >> 63 );
+
+    /* write the sign unconditionally and advance past it if needed */
+    buf[0] = '-';
+    u = neg ? ( ~u + 1 ) : u;
+
+    return neg + NUMFMT_Uint64( u, &buf[neg] );
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  InitTables                                                                */
+/*!
+    Compute the Ryu power of 5 multiplier tables
+
+    Pow5InvSplit[i] = floor( 2^( Pow5Bits(i) - 1 + 59 ) / 5^i ) + 1
+    Pow5Split[i] = 5^i scaled to exactly 61 significant bits
+
+    The largest numerator is 2^128, which does not fit in 128 bits.
+    Since 5^i is odd, floor( 2^128 / 5^i ) == floor( ( 2^128 - 1 ) / 5^i )
+    for i > 0, so the all-ones value is used instead.
+
+==============================================================================*/
+static void InitTables( void )
+{
+    unsigned __int128 pow5 = 1;
+    unsigned __int128 num;
+    int32_t i;
+    int32_t k;
+    int32_t bits;
+
+    for ( i = 0 ; i < FLOAT_POW5_TABLE_SIZE ; i++ )
+    {
+        bits = Pow5Bits( i );
+
+        if ( i < FLOAT_POW5_INV_TABLE_SIZE )
+        {
+            k = bits - 1 + FLOAT_POW5_INV_BITCOUNT;
+            num = ( k < 128 ) ? ( (unsigned __int128)1 << k )
+                              : ~(unsigned __int128)0;
+            Pow5InvSplit[i] = (uint64_t)( num / pow5 ) + 1;
+        }
+
+        if ( bits > FLOAT_POW5_BITCOUNT )
+        {
+            Pow5Split[i] = (uint64_t)( pow5 >> ( bits - FLOAT_POW5_BITCOUNT ) );
+        }
+        else
+        {
+            Pow5Split[i] = (uint64_t)( pow5 << ( FLOAT_POW5_BITCOUNT - bits ) );
+        }
+
+        pow5 *= 5;
+    }
+
+    TablesReady = true;
+}
+
+/*============================================================================*/
+/*  Pow5Bits                                                                  */
+/*!
+    Number of bits in 5^e, for 0 <= e <= 3528
+
+==============================================================================*/
+static int32_t Pow5Bits( int32_t e )
+{
+    return (int32_t)( ( (uint32_t)e * 1217359u ) >> 19 ) + 1;
+}
+
+/*============================================================================*/
+/*  Log10Pow2                                                                 */
+/*!
+    floor( log10( 2^e ) ), for 0 <= e <= 1650
+
+==============================================================================*/
+static uint32_t Log10Pow2( int32_t e )
+{
+    return ( (uint32_t)e * 78913u ) >> 18;
+}
+
+/*============================================================================*/
+/*  Log10Pow5                                                                 */
+/*!
+    floor( log10( 5^e ) ), for 0 <= e <= 2620
+
+==============================================================================*/
+static uint32_t Log10Pow5( int32_t e )
+{
+    return ( (uint32_t)e * 732923u ) >> 20;
+}
+
+/*============================================================================*/
+/*  Pow5Factor                                                                */
+/*!
+    Number of times 5 divides the specified value
+
+==============================================================================*/
+static uint32_t Pow5Factor( uint32_t value )
+{
+    uint32_t count = 0;
+
+    while ( ( value % 5 ) == 0 )
+    {
+        value /= 5;
+        count++;
+    }
+
+    return count;
+}
+
+/*============================================================================*/
+/*  MulShift32                                                                */
+/*!
+    Compute ( m * factor ) >> shift, for shift > 32
+
+==============================================================================*/
+static uint32_t MulShift32( uint32_t m, uint64_t factor, int32_t shift )
+{
+    uint64_t bits0 = (uint64_t)m * (uint32_t)factor;
+    uint64_t bits1 = (uint64_t)m * (uint32_t)( factor >> 32 );
+    uint64_t sum = ( bits0 >> 32 ) + bits1;
+
+    return (uint32_t)( sum >> ( shift - 32 ) );
+}
+
+/*============================================================================*/
+/*  ShortestDecimal                                                           */
+/*!
+    Compute the shortest decimal representation of a float
+
+    The ShortestDecimal function implements the Ryu float to decimal
+    conversion step for a finite non-zero float, producing the decimal
+    digits and the power of 10 exponent such that
+    value = digits * 10^exponent.
+
+    @param[in]
+        ieeeMantissa
+            IEEE 754 mantissa bits
+
+    @param[in]
+        ieeeExponent
+            IEEE 754 biased exponent bits
+
+    @param[out]
+        pOutput
+            pointer to a location to store the decimal digits
+
+    @param[out]
+        pExponent
+            pointer to a location to store the decimal exponent
+
+==============================================================================*/
+static void ShortestDecimal( uint32_t ieeeMantissa,
+                             uint32_t ieeeExponent,
+                             uint32_t *pOutput,
+                             int32_t *pExponent )
+{
+    int32_t e2;
+    uint32_t m2;
+    bool acceptBounds;
+    uint32_t mv;
+    uint32_t mp;
+    uint32_t mm;
+    uint32_t mmShift;
+    uint32_t vr;
+    uint32_t vp;
+    uint32_t vm;
+    int32_t e10;
+    bool vmIsTrailingZeros = false;
+    bool vrIsTrailingZeros = false;
+    uint8_t lastRemovedDigit = 0;
+    uint32_t q;
+    int32_t i;
+    int32_t j;
+    int32_t k;
+    int32_t removed = 0;
+    uint32_t output;
+
+    if ( ieeeExponent == 0 )
+    {
+        e2 = 1 - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+        m2 = ieeeMantissa;
+    }
+    else
+    {
+        e2 = (int32_t)ieeeExponent - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+        m2 = ( 1u << FLOAT_MANTISSA_BITS ) | ieeeMantissa;
+    }
+
+    acceptBounds = ( m2 & 1 ) == 0;
+
+    /* the value and its rounding interval boundaries, scaled by 4 */
+    mv = 4 * m2;
+    mp = 4 * m2 + 2;
+    mmShift = ( ieeeMantissa != 0 ) || ( ieeeExponent <= 1 );
+    mm = 4 * m2 - 1 - mmShift;
+
+    if ( e2 >= 0 )
+    {
+        q = Log10Pow2( e2 );
+        e10 = (int32_t)q;
+        k = FLOAT_POW5_INV_BITCOUNT + Pow5Bits( (int32_t)q ) - 1;
+        i = -e2 + (int32_t)q + k;
+        vr = MulShift32( mv, Pow5InvSplit[q], i );
+        vp = MulShift32( mp, Pow5InvSplit[q], i );
+        vm = MulShift32( mm, Pow5InvSplit[q], i );
+
+        if ( ( q != 0 ) && ( ( vp - 1 ) / 10 <= vm / 10 ) )
+        {
+            k = FLOAT_POW5_INV_BITCOUNT + Pow5Bits( (int32_t)q - 1 ) - 1;
+            lastRemovedDigit =
+                (uint8_t)( MulShift32( mv,
+                                       Pow5InvSplit[q - 1],
+                                       -e2 + (int32_t)q - 1 + k ) % 10 );
+        }
+
+        if ( q <= 9 )
+        {
+            if ( mv % 5 == 0 )
+            {
+                vrIsTrailingZeros = Pow5Factor( mv ) >= q;
+            }
+            else if ( acceptBounds )
+            {
+                vmIsTrailingZeros = Pow5Factor( mm ) >= q;
+            }
+            else
+            {
+                vp -= ( Pow5Factor( mp ) >= q );
+            }
+        }
+    }
+    else
+    {
+        q = Log10Pow5( -e2 );
+        e10 = (int32_t)q + e2;
+        i = -e2 - (int32_t)q;
+        k = Pow5Bits( i ) - FLOAT_POW5_BITCOUNT;
+        j = (int32_t)q - k;
+        vr = MulShift32( mv, Pow5Split[i], j );
+        vp = MulShift32( mp, Pow5Split[i], j );
+        vm = MulShift32( mm, Pow5Split[i], j );
+
+        if ( ( q != 0 ) && ( ( vp - 1 ) / 10 <= vm / 10 ) )
+        {
+            j = (int32_t)q - 1 - ( Pow5Bits( i + 1 ) - FLOAT_POW5_BITCOUNT );
+            lastRemovedDigit =
+                (uint8_t)( MulShift32( mv, Pow5Split[i + 1], j ) % 10 );
+        }
+
+        if ( q <= 1 )
+        {
+            vrIsTrailingZeros = true;
+            if ( acceptBounds )
+            {
+                vmIsTrailingZeros = ( mmShift == 1 );
+            }
+            else
+            {
+                --vp;
+            }
+        }
+        else if ( q < 31 )
+        {
+            vrIsTrailingZeros = ( mv & ( ( 1u << ( q - 1 ) ) - 1 ) ) == 0;
+        }
+    }
+
+    /* remove digits while the interval still contains a shorter value */
+    if ( vmIsTrailingZeros || vrIsTrailingZeros )
+    {
+        while ( vp / 10 > vm / 10 )
+        {
+            vmIsTrailingZeros &= ( vm % 10 == 0 );
+            vrIsTrailingZeros &= ( lastRemovedDigit == 0 );
+            lastRemovedDigit = (uint8_t)( vr % 10 );
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+
+        if ( vmIsTrailingZeros )
+        {
+            while ( vm % 10 == 0 )
+            {
+                vrIsTrailingZeros &= ( lastRemovedDigit == 0 );
+                lastRemovedDigit = (uint8_t)( vr % 10 );
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                ++removed;
+            }
+        }
+
+        if ( vrIsTrailingZeros &&
+             ( lastRemovedDigit == 5 ) &&
+             ( vr % 2 == 0 ) )
+        {
+            /* round even */
+            lastRemovedDigit = 4;
+        }
+
+        output = vr +
+                 ( ( ( vr == vm ) &&
+                     ( !acceptBounds || !vmIsTrailingZeros ) ) ||
+                   ( lastRemovedDigit >= 5 ) );
+    }
+    else
+    {
+        while ( vp / 10 > vm / 10 )
+        {
+            lastRemovedDigit = (uint8_t)( vr % 10 );
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+
+        output = vr + ( ( vr == vm ) || ( lastRemovedDigit >= 5 ) );
+    }
+
+    *pOutput = output;
+    *pExponent = e10 + removed;
+}
+
+/*============================================================================*/
+/*  DecimalLength                                                             */
+/*!
+    Number of decimal digits in n
+
+    The approximate length is derived from the bit length of n
+    ( log10(2) ~= 1233 / 4096 ) and corrected with one comparison.
+    Setting the low bit makes zero one digit long without affecting
+    the comparison for any other value, since powers of 10 are even.
+
+==============================================================================*/
+static size_t DecimalLength( uint64_t n )
+{
+    uint32_t t;
+
+    t = ( ( 64 - (uint32_t)__builtin_clzll( n | 1 ) ) * 1233u ) >> 12;
+
+    return (size_t)t + ( ( n | 1 ) >= Pow10[t] );
+}
+
+/*============================================================================*/
+/*  WriteDigits                                                               */
+/*!
+    Write the decimal digits of n, ending at the specified location
+
+==============================================================================*/
+static void WriteDigits( uint64_t n, char *end )
+{
+    uint32_t r;
+
+    while ( n >= 100 )
+    {
+        r = (uint32_t)( n % 100 ) * 2;
+        n /= 100;
+        end -= 2;
+        end[0] = DigitPairs[r];
+        end[1] = DigitPairs[r + 1];
+    }
+
+    if ( n >= 10 )
+    {
+        r = (uint32_t)n * 2;
+        end -= 2;
+        end[0] = DigitPairs[r];
+        end[1] = DigitPairs[r + 1];
+    }
+    else
+    {
+        *--end = (char)( '0' + n );
+    }
+}
+
+/*============================================================================*/
+/*  FormatDecimal                                                             */
+/*!
+    Format a decimal digits / exponent pair
+
+    The FormatDecimal function renders value = digits * 10^exponent
+    in fixed notation when the decimal point position is in the range
+    (-6, 21], and in exponential notation otherwise.
+
+    @param[in]
+        digits
+            decimal significand (no trailing zeros are required)
+
+    @param[in]
+        exponent
+            power of 10 exponent
+
+    @param[in]
+        buf
+            pointer to the output buffer
+
+    @retval the number of characters written
+
+==============================================================================*/
+static size_t FormatDecimal( uint32_t digits, int32_t exponent, char *buf )
+{
+    char tmp[10];
+    size_t olength;
+    int32_t point;
+    int32_t e;
+    size_t n = 0;
+
+    /* strip trailing zeros from the significand */
+    while ( ( digits >= 10 ) && ( digits % 10 == 0 ) )
+    {
+        digits /= 10;
+        exponent++;
+    }
+
+    olength = DecimalLength( digits );
+    WriteDigits( digits, &tmp[olength] );
+
+    /* position of the decimal point relative to the first digit */
+    point = (int32_t)olength + exponent;
+
+    if ( ( point > 0 ) && ( point <= 21 ) )
+    {
+        if ( exponent >= 0 )
+        {
+            /* integer value: digits followed by zeros */
+            memcpy( buf, tmp, olength );
+            n = olength;
+            memset( &buf[n], '0', (size_t)exponent );
+            n += (size_t)exponent;
+        }
+        else
+        {
+            memcpy( buf, tmp, (size_t)point );
+            buf[point] = '.';
+            memcpy( &buf[point + 1], &tmp[point], olength - (size_t)point );
+            n = olength + 1;
+        }
+    }
+    else if ( ( point <= 0 ) && ( point > -6 ) )
+    {
+        /* 0.000ddd */
+        buf[0] = '0';
+        buf[1] = '.';
+        memset( &buf[2], '0', (size_t)-point );
+        n = 2 + (size_t)-point;
+        memcpy( &buf[n], tmp, olength );
+        n += olength;
+    }
+    else
+    {
+        /* d.ddde+xx */
+        buf[n++] = tmp[0];
+        if ( olength > 1 )
+        {
+            buf[n++] = '.';
+            memcpy( &buf[n], &tmp[1], olength - 1 );
+            n += olength - 1;
+        }
+
+        e = point - 1;
+        buf[n++] = 'e';
+        buf[n++] = ( e < 0 ) ? '-' : '+';
+        n += NUMFMT_Uint64( (uint64_t)( ( e < 0 ) ? -e : e ), &buf[n] );
+    }
+
+    return n;
+}
+
+/*! @}
+ * end of numfmt group */
@@ -0,0 +1,793 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup render render
+ * @brief Compiled template renderer
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file render.c
+
+    Compiled Template Renderer
+
+    The render module compiles a template file into a list of literal
+    text segments and ${...} variable reference segments, so the template
+    file does not need to be re-read and re-parsed on every render.
+
+    Variable values are taken from the variable cache snapshot for the
+    current event cycle, so each variable is fetched and formatted at
+    most once per cycle no matter how many templates reference it.
+
+    In incremental mode, every referenced variable is watched for
+    MODIFIED notifications, so a variable is only re-fetched and
+    re-formatted when it has changed since the previous render.
+
+    Numeric values are rendered as the variable server prints them,
+    unless the template formats numbers natively, in which case they are
+    rendered as formatted by the numfmt module (e.g. 1.5 rather than
+    1.500000).
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "render.h"
+#include "numfmt.h"
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int ReadFile( int fd, size_t size, char **ppSource );
+static int Parse( CompiledTemplate *pTemplate );
+static int AddSegment( CompiledTemplate *pTemplate,
+                       SegType type,
+                       size_t offset,
+                       size_t len,
+                       size_t *pCapacity );
+static int RenderVar( VARSERVER_HANDLE hVarServer,
+                      CompiledTemplate *pTemplate,
+                      Segment *pSegment,
+                      RenderBuf *pRenderBuf );
+static int RenderText( const char *p, size_t len, RenderBuf *pRenderBuf );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  RENDER_Compile                                                            */
+/*!
+    Compile a template file
+
+    The RENDER_Compile function reads the specified template file and
+    splits it into text and variable reference segments.  Variable
+    handles are not resolved until RENDER_Resolve is called.
+
+    @param[in]
+        fileName
+            name of the template file to compile
+
+    @param[out]
+        ppTemplate
+            pointer to a location to store the compiled template
+
+    @retval EOK - the template was compiled
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - invalid arguments
+    @retval other - error opening or reading the template file
+
+==============================================================================*/
+int RENDER_Compile( const char *fileName, CompiledTemplate **ppTemplate )
+{
+    int result = EINVAL;
+    CompiledTemplate *pTemplate;
+    struct stat sb;
+    int fd;
+
+    if ( ( fileName != NULL ) &&
+         ( ppTemplate != NULL ) )
+    {
+        result = ENOMEM;
+
+        pTemplate = calloc( 1, sizeof( CompiledTemplate ) );
+        if ( pTemplate != NULL )
+        {
+            pTemplate->fileName = strdup( fileName );
+
+            fd = open( fileName, O_RDONLY );
+            if ( fd == -1 )
+            {
+                result = errno;
+            }
+            else
+            {
+                if ( fstat( fd, &sb ) == 0 )
+                {
+                    pTemplate->mtime = sb.st_mtim;
+                    pTemplate->ino = sb.st_ino;
+                    pTemplate->size = sb.st_size;
+
+                    result = ReadFile( fd,
+                                       (size_t)sb.st_size,
+                                       &pTemplate->pSource );
+                    if ( result == EOK )
+                    {
+                        pTemplate->sourceLen = (size_t)sb.st_size;
+                        result = Parse( pTemplate );
+                    }
+                }
+                else
+                {
+                    result = errno;
+                }
+
+                close( fd );
+            }
+
+            if ( result == EOK )
+            {
+                *ppTemplate = pTemplate;
+            }
+            else
+            {
+                RENDER_Free( pTemplate );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RENDER_Resolve                                                            */
+/*!
+    Resolve the variable references of a compiled template
+
+    The RENDER_Resolve function looks up the handle of each
+    variable referenced by the template which has not yet been resolved,
+    and associates it with its variable cache entry.  In incremental
+    mode, MODIFIED notifications are requested for each variable.  Unless
+    the template formats numbers natively, the variable server's
+    formatting of each variable is kept.
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        pTemplate
+            pointer to the compiled template
+
+    @retval EOK - all variable references were resolved
+    @retval ENOENT - one or more variables were not found
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int RENDER_Resolve( VARSERVER_HANDLE hVarServer,
+                    VarCache *pVarCache,
+                    CompiledTemplate *pTemplate )
+{
+    int result = EINVAL;
+    Segment *pSegment;
+    size_t i;
+
+    if ( ( hVarServer != NULL ) &&
+         ( pVarCache != NULL ) &&
+         ( pTemplate != NULL ) )
+    {
+        result = EOK;
+        pTemplate->pVarCache = pVarCache;
+
+        for ( i = 0 ; i < pTemplate->numSegments ; i++ )
+        {
+            pSegment = &pTemplate->pSegments[i];
+            if ( ( pSegment->type == SEG_VAR ) &&
+                 ( pSegment->hVar == VAR_INVALID ) )
+            {
+                pSegment->pEntry = VARCACHE_Lookup( pVarCache,
+                                                    hVarServer,
+                                                    pSegment->name );
+                if ( pSegment->pEntry != NULL )
+                {
+                    pSegment->hVar = pSegment->pEntry->hVar;
+                    if ( pTemplate->nativeFormat == false )
+                    {
+                        VARCACHE_SetPrinted( pSegment->pEntry );
+                    }
+
+                    if ( pTemplate->incremental == true )
+                    {
+                        VARCACHE_Watch( pVarCache,
+                                        hVarServer,
+                                        pSegment->pEntry );
+                    }
+                }
+                else
+                {
+                    result = ENOENT;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RENDER_IsStale                                                            */
+/*!
+    Check if a compiled template is out of date
+
+    The RENDER_IsStale function checks if the template file has been
+    modified or replaced since it was compiled.
+
+    @param[in]
+        pTemplate
+            pointer to the compiled template
+
+    @retval true - the template file has changed
+    @retval false - the compiled template is current
+
+==============================================================================*/
+bool RENDER_IsStale( CompiledTemplate *pTemplate )
+{
+    bool stale = true;
+    struct stat sb;
+
+    if ( ( pTemplate != NULL ) &&
+         ( stat( pTemplate->fileName, &sb ) == 0 ) )
+    {
+        stale = ( sb.st_ino != pTemplate->ino ) ||
+                ( sb.st_size != pTemplate->size ) ||
+                ( sb.st_mtim.tv_sec != pTemplate->mtime.tv_sec ) ||
+                ( sb.st_mtim.tv_nsec != pTemplate->mtime.tv_nsec );
+    }
+
+    return stale;
+}
+
+/*============================================================================*/
+/*  RENDER_Fetch                                                              */
+/*!
+    Fetch the variables referenced by a compiled template
+
+    The RENDER_Fetch function takes a snapshot of every variable referenced
+    by the template for the current event cycle.  Variables which have
+    already been fetched in this cycle are not fetched again.
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pTemplate
+            pointer to the compiled template
+
+    @retval EOK - the variables were fetched
+    @retval ENOENT - one or more variables could not be fetched
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int RENDER_Fetch( VARSERVER_HANDLE hVarServer, CompiledTemplate *pTemplate )
+{
+    int result = EINVAL;
+    Segment *pSegment;
+    size_t i;
+
+    if ( ( hVarServer != NULL ) &&
+         ( pTemplate != NULL ) )
+    {
+        result = EOK;
+
+        for ( i = 0 ; i < pTemplate->numSegments ; i++ )
+        {
+            pSegment = &pTemplate->pSegments[i];
+            if ( ( pSegment->pEntry != NULL ) &&
+                 ( VARCACHE_Fetch( pTemplate->pVarCache,
+                                   hVarServer,
+                                   pSegment->pEntry ) != EOK ) )
+            {
+                result = ENOENT;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RENDER_Template                                                           */
+/*!
+    Render a compiled template
+
+    The RENDER_Template function renders the compiled template into
+    the specified render buffer.
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pTemplate
+            pointer to the compiled template
+
+    @param[in,out]
+        pRenderBuf
+            pointer to the render buffer.  Output is appended at
+            pRenderBuf->len.  If the buffer has a flush function, the
+            buffer contents are passed to it whenever the buffer is full,
+            and only the remainder of the output is left in the buffer.
+
+    @retval EOK - the template was rendered
+    @retval E2BIG - the output did not fit in the render buffer
+    @retval EINVAL - invalid arguments
+    @retval other - the flush function failed
+
+==============================================================================*/
+int RENDER_Template( VARSERVER_HANDLE hVarServer,
+                     CompiledTemplate *pTemplate,
+                     RenderBuf *pRenderBuf )
+{
+    int result = EINVAL;
+    Segment *pSegment;
+    size_t i;
+
+    if ( ( hVarServer != NULL ) &&
+         ( pTemplate != NULL ) &&
+         ( pRenderBuf != NULL ) &&
+         ( pRenderBuf->pBuf != NULL ) )
+    {
+        result = EOK;
+
+        i = 0;
+        while ( ( i < pTemplate->numSegments ) && ( result == EOK ) )
+        {
+            pSegment = &pTemplate->pSegments[i++];
+            if ( pSegment->type == SEG_VAR )
+            {
+                result = RenderVar( hVarServer,
+                                    pTemplate,
+                                    pSegment,
+                                    pRenderBuf );
+            }
+            else
+            {
+                result = RenderText( &pTemplate->pSource[pSegment->offset],
+                                     pSegment->len,
+                                     pRenderBuf );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RENDER_Free                                                               */
+/*!
+    Free a compiled template
+
+    @param[in]
+        pTemplate
+            pointer to the compiled template to free
+
+==============================================================================*/
+void RENDER_Free( CompiledTemplate *pTemplate )
+{
+    size_t i;
+
+    if ( pTemplate != NULL )
+    {
+        for ( i = 0 ; i < pTemplate->numSegments ; i++ )
+        {
+            free( pTemplate->pSegments[i].name );
+        }
+
+        free( pTemplate->pSegments );
+        free( pTemplate->pSource );
+        free( pTemplate->fileName );
+        free( pTemplate );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  ReadFile                                                                  */
+/*!
+    Read the template file content into memory
+
+    @param[in]
+        fd
+            template file descriptor
+
+    @param[in]
+        size
+            size of the template file
+
+    @param[out]
+        ppSource
+            pointer to a location to store the NUL terminated file content
+
+    @retval EOK - the file was read
+    @retval ENOMEM - memory allocation failure
+    @retval EIO - the file was truncated while reading
+    @retval other - error returned by read()
+
+==============================================================================*/
+static int ReadFile( int fd, size_t size, char **ppSource )
+{
+    int result = ENOMEM;
+    char *pSource;
+    size_t total = 0;
+    ssize_t n;
+
+    pSource = malloc( size + 1 );
+    if ( pSource != NULL )
+    {
+        result = EOK;
+
+        while ( ( total < size ) && ( result == EOK ) )
+        {
+            n = read( fd, &pSource[total], size - total );
+            if ( n > 0 )
+            {
+                total += (size_t)n;
+            }
+            else if ( ( n < 0 ) && ( errno == EINTR ) )
+            {
+                continue;
+            }
+            else
+            {
+                result = ( n < 0 ) ? errno : EIO;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pSource[size] = '\0';
+            *ppSource = pSource;
+        }
+        else
+        {
+            free( pSource );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Parse                                                                     */
+/*!
+    Split the template source into segments
+
+    The Parse function splits the template source into literal text
+    segments and ${name} variable reference segments.  An unterminated
+    reference is treated as literal text.
+
+    @param[in]
+        pTemplate
+            pointer to the template to parse
+
+    @retval EOK - the template was parsed
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int Parse( CompiledTemplate *pTemplate )
+{
+    int result = EOK;
+    const char *pSource = pTemplate->pSource;
+    size_t len = pTemplate->sourceLen;
+    size_t capacity = 0;
+    size_t start = 0;
+    size_t i = 0;
+    const char *pEnd;
+    size_t nameLen;
+
+    while ( ( i + 1 < len ) && ( result == EOK ) )
+    {
+        if ( ( pSource[i] == '$' ) && ( pSource[i + 1] == '{' ) )
+        {
+            pEnd = memchr( &pSource[i + 2], '}', len - i - 2 );
+            if ( pEnd != NULL )
+            {
+                nameLen = (size_t)( pEnd - &pSource[i + 2] );
+
+                if ( i > start )
+                {
+                    result = AddSegment( pTemplate,
+                                         SEG_TEXT,
+                                         start,
+                                         i - start,
+                                         &capacity );
+                }
+
+                if ( result == EOK )
+                {
+                    result = AddSegment( pTemplate,
+                                         SEG_VAR,
+                                         i,
+                                         nameLen + 3,
+                                         &capacity );
+                }
+
+                i += nameLen + 3;
+                start = i;
+                continue;
+            }
+        }
+
+        i++;
+    }
+
+    if ( ( result == EOK ) && ( start < len ) )
+    {
+        result = AddSegment( pTemplate,
+                             SEG_TEXT,
+                             start,
+                             len - start,
+                             &capacity );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  AddSegment                                                                */
+/*!
+    Append a segment to a compiled template
+
+    @param[in]
+        pTemplate
+            pointer to the template
+
+    @param[in]
+        type
+            segment type
+
+    @param[in]
+        offset
+            offset of the segment in the template source
+
+    @param[in]
+        len
+            length of the segment in the template source.  For variable
+            segments this includes the ${ and } delimiters.
+
+    @param[in,out]
+        pCapacity
+            pointer to the allocated segment array capacity
+
+    @retval EOK - the segment was added
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int AddSegment( CompiledTemplate *pTemplate,
+                       SegType type,
+                       size_t offset,
+                       size_t len,
+                       size_t *pCapacity )
+{
+    int result = EOK;
+    Segment *pSegments;
+    Segment *pSegment;
+    size_t capacity;
+
+    if ( pTemplate->numSegments == *pCapacity )
+    {
+        capacity = ( *pCapacity == 0 ) ? 16 : *pCapacity * 2;
+        pSegments = realloc( pTemplate->pSegments,
+                             capacity * sizeof( Segment ) );
+        if ( pSegments != NULL )
+        {
+            pTemplate->pSegments = pSegments;
+            *pCapacity = capacity;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        pSegment = &pTemplate->pSegments[pTemplate->numSegments];
+        memset( pSegment, 0, sizeof( Segment ) );
+        pSegment->type = type;
+        pSegment->offset = offset;
+        pSegment->len = len;
+        pSegment->hVar = VAR_INVALID;
+
+        if ( type == SEG_VAR )
+        {
+            pSegment->name = strndup( &pTemplate->pSource[offset + 2],
+                                      len - 3 );
+            if ( pSegment->name == NULL )
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pTemplate->numSegments++;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RenderVar                                                                 */
+/*!
+    Render a variable reference segment
+
+    The RenderVar function renders the formatted text of the variable's
+    value snapshot for the current cycle.  Variables which have not been
+    found are rendered as the original reference text until they are
+    resolved, and variables whose value cannot be fetched are rendered
+    as empty text.  If the template formats numbers natively, but the
+    snapshot text was printed by the variable server for another
+    template, a numeric value is formatted here instead.
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pTemplate
+            pointer to the compiled template
+
+    @param[in]
+        pSegment
+            pointer to the variable reference segment
+
+    @param[in,out]
+        pRenderBuf
+            pointer to the render buffer
+
+    @retval EOK - the variable was rendered
+    @retval E2BIG - the output did not fit in the render buffer
+
+==============================================================================*/
+static int RenderVar( VARSERVER_HANDLE hVarServer,
+                      CompiledTemplate *pTemplate,
+                      Segment *pSegment,
+                      RenderBuf *pRenderBuf )
+{
+    int result = EOK;
+    VarEntry *pEntry;
+    char buf[NUMFMT_MAX_LEN];
+    size_t n = 0;
+
+    pEntry = pSegment->pEntry;
+    if ( pEntry == NULL )
+    {
+        result = RenderText( &pTemplate->pSource[pSegment->offset],
+                             pSegment->len,
+                             pRenderBuf );
+    }
+    else if ( VARCACHE_Fetch( pTemplate->pVarCache,
+                              hVarServer,
+                              pEntry ) == EOK )
+    {
+        if ( ( pTemplate->nativeFormat == true ) &&
+             ( pEntry->printed == true ) )
+        {
+            n = VARCACHE_Format( pEntry, buf );
+        }
+
+        result = ( n > 0 ) ? RenderText( buf, n, pRenderBuf )
+                           : RenderText( pEntry->pText,
+                                         pEntry->textLen,
+                                         pRenderBuf );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RenderText                                                                */
+/*!
+    Append text to the render buffer
+
+    @param[in]
+        p
+            pointer to the text
+
+    @param[in]
+        len
+            length of the text
+
+    @param[in,out]
+        pRenderBuf
+            pointer to the render buffer
+
+    @retval EOK - the text was appended
+    @retval E2BIG - the text did not fit in the render buffer
+    @retval other - the flush function failed
+
+==============================================================================*/
+static int RenderText( const char *p, size_t len, RenderBuf *pRenderBuf )
+{
+    int result = EOK;
+    size_t n;
+
+    while ( ( result == EOK ) &&
+            ( ( pRenderBuf->size - pRenderBuf->len ) < len ) )
+    {
+        if ( ( pRenderBuf->flush == NULL ) ||
+             ( pRenderBuf->size == 0 ) )
+        {
+            result = E2BIG;
+        }
+        else
+        {
+            /* fill the buffer and pass it on */
+            n = pRenderBuf->size - pRenderBuf->len;
+            memcpy( &pRenderBuf->pBuf[pRenderBuf->len], p, n );
+            p += n;
+            len -= n;
+
+            result = pRenderBuf->flush( pRenderBuf->pBuf,
+                                        pRenderBuf->size,
+                                        pRenderBuf->arg );
+            pRenderBuf->len = 0;
+        }
+    }
+
+    if ( ( result == EOK ) && ( len > 0 ) )
+    {
+        memcpy( &pRenderBuf->pBuf[pRenderBuf->len], p, len );
+        pRenderBuf->len += len;
+    }
+
+    return result;
+}
+
+/*! @}
+ * end of render group */
@@ -0,0 +1,676 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup serialize serialize
+ * @brief Allocation-free JSON Lines and CBOR value serializer
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file serialize.c
+
+    Structured Output Serializer
+
+    The serialize module encodes variable server values directly into
+    JSON Lines records or CBOR maps without going through the text
+    template engine.  All output is written into a caller supplied
+    fixed size buffer, so no memory is allocated while serializing.
+
+    JSON output is one object per record, terminated by a newline.
+    Non-finite floating point values are encoded as null since JSON
+    cannot represent them.
+
+    CBOR output is a single definite length map per record (RFC 8949)
+    with text string keys.  Floats are encoded as single precision.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "serialize.h"
+#include "numfmt.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! CBOR major types */
+#define CBOR_UINT       ( 0 << 5 )
+#define CBOR_NEGINT     ( 1 << 5 )
+#define CBOR_BYTES      ( 2 << 5 )
+#define CBOR_TEXT       ( 3 << 5 )
+#define CBOR_MAP        ( 5 << 5 )
+#define CBOR_SIMPLE     ( 7 << 5 )
+
+/*! CBOR simple values */
+#define CBOR_NULL       ( CBOR_SIMPLE | 22 )
+#define CBOR_FLOAT32    ( CBOR_SIMPLE | 26 )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void PutByte( SerBuf *pSerBuf, uint8_t c );
+static void PutBytes( SerBuf *pSerBuf, const void *p, size_t len );
+static void PutUint( SerBuf *pSerBuf, uint64_t n );
+static void PutInt( SerBuf *pSerBuf, int64_t n );
+static void PutFloat( SerBuf *pSerBuf, float f );
+static void PutJsonString( SerBuf *pSerBuf, const char *s, size_t len );
+static void PutJsonValue( SerBuf *pSerBuf, VarObject *pVarObject );
+static void PutCborHead( SerBuf *pSerBuf, uint8_t major, uint64_t n );
+static void PutCborValue( SerBuf *pSerBuf, VarObject *pVarObject );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  SER_Init                                                                  */
+/*!
+    Initialize a serialization buffer
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer to initialize
+
+    @param[in]
+        pBuf
+            pointer to the output memory
+
+    @param[in]
+        size
+            size of the output memory
+
+==============================================================================*/
+void SER_Init( SerBuf *pSerBuf, char *pBuf, size_t size )
+{
+    if ( pSerBuf != NULL )
+    {
+        pSerBuf->pBuf = pBuf;
+        pSerBuf->size = ( pBuf != NULL ) ? size : 0;
+        pSerBuf->len = 0;
+        pSerBuf->overflow = false;
+    }
+}
+
+/*============================================================================*/
+/*  SER_JsonBegin                                                             */
+/*!
+    Begin a JSON Lines record
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+==============================================================================*/
+void SER_JsonBegin( SerBuf *pSerBuf )
+{
+    PutByte( pSerBuf, '{' );
+}
+
+/*============================================================================*/
+/*  SER_JsonMember                                                            */
+/*!
+    Add a variable to a JSON Lines record
+
+    The SER_JsonMember function appends a "name" : value pair to the
+    current record, prefixed with a separator if it is not the first
+    member of the record.
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        name
+            name of the variable
+
+    @param[in]
+        pVarObject
+            pointer to the variable value, or NULL to encode a null value
+
+==============================================================================*/
+void SER_JsonMember( SerBuf *pSerBuf, const char *name, VarObject *pVarObject )
+{
+    if ( ( pSerBuf != NULL ) && ( name != NULL ) )
+    {
+        if ( ( pSerBuf->len > 0 ) &&
+             ( pSerBuf->len <= pSerBuf->size ) &&
+             ( pSerBuf->pBuf[pSerBuf->len - 1] != '{' ) )
+        {
+            PutByte( pSerBuf, ',' );
+        }
+
+        PutJsonString( pSerBuf, name, strlen( name ) );
+        PutByte( pSerBuf, ':' );
+        PutJsonValue( pSerBuf, pVarObject );
+    }
+}
+
+/*============================================================================*/
+/*  SER_JsonEnd                                                               */
+/*!
+    End a JSON Lines record
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+==============================================================================*/
+void SER_JsonEnd( SerBuf *pSerBuf )
+{
+    PutBytes( pSerBuf, "}\n", 2 );
+}
+
+/*============================================================================*/
+/*  SER_CborMapBegin                                                          */
+/*!
+    Begin a CBOR map record
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        count
+            number of members in the map
+
+==============================================================================*/
+void SER_CborMapBegin( SerBuf *pSerBuf, size_t count )
+{
+    PutCborHead( pSerBuf, CBOR_MAP, count );
+}
+
+/*============================================================================*/
+/*  SER_CborMember                                                            */
+/*!
+    Add a variable to a CBOR map record
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        name
+            name of the variable
+
+    @param[in]
+        pVarObject
+            pointer to the variable value, or NULL to encode a null value
+
+==============================================================================*/
+void SER_CborMember( SerBuf *pSerBuf, const char *name, VarObject *pVarObject )
+{
+    size_t len;
+
+    if ( ( pSerBuf != NULL ) && ( name != NULL ) )
+    {
+        len = strlen( name );
+        PutCborHead( pSerBuf, CBOR_TEXT, len );
+        PutBytes( pSerBuf, name, len );
+        PutCborValue( pSerBuf, pVarObject );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  PutByte                                                                   */
+/*!
+    Append a single byte to the serialization buffer
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        c
+            byte to append
+
+==============================================================================*/
+static void PutByte( SerBuf *pSerBuf, uint8_t c )
+{
+    if ( pSerBuf->len < pSerBuf->size )
+    {
+        pSerBuf->pBuf[pSerBuf->len++] = (char)c;
+    }
+    else
+    {
+        pSerBuf->overflow = true;
+    }
+}
+
+/*============================================================================*/
+/*  PutBytes                                                                  */
+/*!
+    Append a byte sequence to the serialization buffer
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        p
+            pointer to the bytes to append
+
+    @param[in]
+        len
+            number of bytes to append
+
+==============================================================================*/
+static void PutBytes( SerBuf *pSerBuf, const void *p, size_t len )
+{
+    if ( ( pSerBuf->size - pSerBuf->len ) >= len )
+    {
+        memcpy( &pSerBuf->pBuf[pSerBuf->len], p, len );
+        pSerBuf->len += len;
+    }
+    else
+    {
+        pSerBuf->overflow = true;
+    }
+}
+
+/*============================================================================*/
+/*  PutUint                                                                   */
+/*!
+    Append an unsigned integer in decimal text form
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        n
+            value to append
+
+==============================================================================*/
+static void PutUint( SerBuf *pSerBuf, uint64_t n )
+{
+    char buf[NUMFMT_MAX_LEN];
+
+    PutBytes( pSerBuf, buf, NUMFMT_Uint64( n, buf ) );
+}
+
+/*============================================================================*/
+/*  PutInt                                                                    */
+/*!
+    Append a signed integer in decimal text form
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        n
+            value to append
+
+==============================================================================*/
+static void PutInt( SerBuf *pSerBuf, int64_t n )
+{
+    char buf[NUMFMT_MAX_LEN];
+
+    PutBytes( pSerBuf, buf, NUMFMT_Int64( n, buf ) );
+}
+
+/*============================================================================*/
+/*  PutFloat                                                                  */
+/*!
+    Append a float in JSON number form
+
+    Floats are encoded as the shortest decimal string which round-trips
+    to the same value.  Non-finite values are encoded as null.
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        f
+            value to append
+
+==============================================================================*/
+static void PutFloat( SerBuf *pSerBuf, float f )
+{
+    char buf[NUMFMT_MAX_LEN];
+
+    if ( isfinite( f ) )
+    {
+        PutBytes( pSerBuf, buf, NUMFMT_Float( f, buf ) );
+    }
+    else
+    {
+        PutBytes( pSerBuf, "null", 4 );
+    }
+}
+
+/*============================================================================*/
+/*  PutJsonString                                                             */
+/*!
+    Append a quoted and escaped JSON string
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        s
+            pointer to the string to append
+
+    @param[in]
+        len
+            length of the string to append
+
+==============================================================================*/
+static void PutJsonString( SerBuf *pSerBuf, const char *s, size_t len )
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t i;
+    size_t start = 0;
+    unsigned char c;
+    char esc[6];
+
+    PutByte( pSerBuf, '"' );
+
+    for ( i = 0 ; i < len ; i++ )
+    {
+        c = (unsigned char)s[i];
+        if ( ( c >= 0x20 ) && ( c != '"' ) && ( c != '\\' ) )
+        {
+            continue;
+        }
+
+        /* flush the unescaped run */
+        PutBytes( pSerBuf, &s[start], i - start );
+        start = i + 1;
+
+        switch( c )
+        {
+            case '"':  PutBytes( pSerBuf, "\\\"", 2 ); break;
+            case '\\': PutBytes( pSerBuf, "\\\\", 2 ); break;
+            case '\n': PutBytes( pSerBuf, "\\n", 2 ); break;
+            case '\r': PutBytes( pSerBuf, "\\r", 2 ); break;
+            case '\t': PutBytes( pSerBuf, "\\t", 2 ); break;
+            default:
+                esc[0] = '\\';
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 0xF];
+                PutBytes( pSerBuf, esc, sizeof( esc ) );
+                break;
+        }
+    }
+
+    PutBytes( pSerBuf, &s[start], len - start );
+    PutByte( pSerBuf, '"' );
+}
+
+/*============================================================================*/
+/*  PutJsonValue                                                              */
+/*!
+    Append a variable value in JSON form
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        pVarObject
+            pointer to the variable value, or NULL for a null value
+
+==============================================================================*/
+static void PutJsonValue( SerBuf *pSerBuf, VarObject *pVarObject )
+{
+    if ( pVarObject == NULL )
+    {
+        PutBytes( pSerBuf, "null", 4 );
+        return;
+    }
+
+    switch( pVarObject->type )
+    {
+        case VARTYPE_UINT16:
+            PutUint( pSerBuf, pVarObject->val.ui );
+            break;
+
+        case VARTYPE_INT16:
+            PutInt( pSerBuf, pVarObject->val.i );
+            break;
+
+        case VARTYPE_UINT32:
+            PutUint( pSerBuf, pVarObject->val.ul );
+            break;
+
+        case VARTYPE_INT32:
+            PutInt( pSerBuf, pVarObject->val.l );
+            break;
+
+        case VARTYPE_UINT64:
+            PutUint( pSerBuf, pVarObject->val.ull );
+            break;
+
+        case VARTYPE_INT64:
+            PutInt( pSerBuf, pVarObject->val.ll );
+            break;
+
+        case VARTYPE_FLOAT:
+            PutFloat( pSerBuf, pVarObject->val.f );
+            break;
+
+        case VARTYPE_STR:
+            if ( pVarObject->val.str != NULL )
+            {
+                PutJsonString( pSerBuf,
+                               pVarObject->val.str,
+                               strlen( pVarObject->val.str ) );
+            }
+            else
+            {
+                PutBytes( pSerBuf, "null", 4 );
+            }
+            break;
+
+        default:
+            PutBytes( pSerBuf, "null", 4 );
+            break;
+    }
+}
+
+/*============================================================================*/
+/*  PutCborHead                                                               */
+/*!
+    Append a CBOR data item head
+
+    The PutCborHead function encodes the major type and argument using
+    the shortest possible encoding.
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        major
+            CBOR major type (already shifted into the top three bits)
+
+    @param[in]
+        n
+            data item argument
+
+==============================================================================*/
+static void PutCborHead( SerBuf *pSerBuf, uint8_t major, uint64_t n )
+{
+    uint8_t head[9];
+    size_t len;
+    size_t i;
+
+    if ( n < 24 )
+    {
+        head[0] = major | (uint8_t)n;
+        len = 1;
+    }
+    else if ( n <= UINT8_MAX )
+    {
+        head[0] = major | 24;
+        len = 2;
+    }
+    else if ( n <= UINT16_MAX )
+    {
+        head[0] = major | 25;
+        len = 3;
+    }
+    else if ( n <= UINT32_MAX )
+    {
+        head[0] = major | 26;
+        len = 5;
+    }
+    else
+    {
+        head[0] = major | 27;
+        len = 9;
+    }
+
+    /* big-endian argument */
+    for ( i = len - 1 ; i > 0 ; i-- )
+    {
+        head[i] = (uint8_t)( n & 0xFF );
+        n >>= 8;
+    }
+
+    PutBytes( pSerBuf, head, len );
+}
+
+/*============================================================================*/
+/*  PutCborValue                                                              */
+/*!
+    Append a variable value in CBOR form
+
+    @param[in]
+        pSerBuf
+            pointer to the serialization buffer
+
+    @param[in]
+        pVarObject
+            pointer to the variable value, or NULL for a null value
+
+==============================================================================*/
+static void PutCborValue( SerBuf *pSerBuf, VarObject *pVarObject )
+{
+    int64_t n;
+    uint32_t bits;
+    uint8_t buf[5];
+
+    if ( pVarObject == NULL )
+    {
+        PutByte( pSerBuf, CBOR_NULL );
+        return;
+    }
+
+    switch( pVarObject->type )
+    {
+        case VARTYPE_UINT16:
+            PutCborHead( pSerBuf, CBOR_UINT, pVarObject->val.ui );
+            break;
+
+        case VARTYPE_UINT32:
+            PutCborHead( pSerBuf, CBOR_UINT, pVarObject->val.ul );
+            break;
+
+        case VARTYPE_UINT64:
+            PutCborHead( pSerBuf, CBOR_UINT, pVarObject->val.ull );
+            break;
+
+        case VARTYPE_INT16:
+        case VARTYPE_INT32:
+        case VARTYPE_INT64:
+            n = ( pVarObject->type == VARTYPE_INT16 ) ? pVarObject->val.i
+              : ( pVarObject->type == VARTYPE_INT32 ) ? pVarObject->val.l
+              : pVarObject->val.ll;
+
+            if ( n < 0 )
+            {
+                /* negative integers are encoded as -1 - n */
+                PutCborHead( pSerBuf, CBOR_NEGINT, ~(uint64_t)n );
+            }
+            else
+            {
+                PutCborHead( pSerBuf, CBOR_UINT, (uint64_t)n );
+            }
+            break;
+
+        case VARTYPE_FLOAT:
+            memcpy( &bits, &pVarObject->val.f, sizeof( bits ) );
+            buf[0] = CBOR_FLOAT32;
+            buf[1] = (uint8_t)( bits >> 24 );
+            buf[2] = (uint8_t)( bits >> 16 );
+            buf[3] = (uint8_t)( bits >> 8 );
+            buf[4] = (uint8_t)bits;
+            PutBytes( pSerBuf, buf, sizeof( buf ) );
+            break;
+
+        case VARTYPE_STR:
+            if ( pVarObject->val.str != NULL )
+            {
+                n = (int64_t)strlen( pVarObject->val.str );
+                PutCborHead( pSerBuf, CBOR_TEXT, (uint64_t)n );
+                PutBytes( pSerBuf, pVarObject->val.str, (size_t)n );
+            }
+            else
+            {
+                PutByte( pSerBuf, CBOR_NULL );
+            }
+            break;
+
+        case VARTYPE_BLOB:
+            if ( pVarObject->val.blob != NULL )
+            {
+                PutCborHead( pSerBuf, CBOR_BYTES, pVarObject->len );
+                PutBytes( pSerBuf, pVarObject->val.blob, pVarObject->len );
+            }
+            else
+            {
+                PutByte( pSerBuf, CBOR_NULL );
+            }
+            break;
+
+        default:
+            PutByte( pSerBuf, CBOR_NULL );
+            break;
+    }
+}
+
+/*! @}
+ * end of serialize group */
@@ -0,0 +1,336 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup strtab strtab
+ * @brief Interned string arena
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file strtab.c
+
+    String Table
+
+    The strtab module holds one copy of each distinct string used by the
+    template definitions, such as template names, targets and variable
+    names.  The strings are stored in a long-lived arena supplied by the
+    owner of the table, rather than each being a separate heap
+    allocation, so the strings of the templates do not depend on the
+    parsed configuration, and a name shared by many templates is stored
+    once.
+
+    Strings are never removed from the table.  A configuration reload
+    interns the strings of the new definitions, so the table only grows
+    by the strings which were not already defined.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include "arena.h"
+#include "strtab.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! initial number of hash slots (must be a power of 2) */
+#define STRTAB_INITIAL_SLOTS        ( 256 )
+
+/*! string table */
+struct strTab
+{
+    /*! arena holding the interned strings */
+    Arena *pArena;
+
+    /*! open addressing hash table of the interned strings */
+    char **ppSlots;
+
+    /*! number of hash slots (power of 2) */
+    size_t numSlots;
+
+    /*! number of interned strings */
+    size_t count;
+
+    /*! total size of the interned strings */
+    size_t size;
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static uint32_t Hash( const char *str );
+static int Grow( StrTab *pStrTab );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  STRTAB_Create                                                             */
+/*!
+    Create a string table
+
+    @param[in]
+        pArena
+            pointer to the arena which holds the interned strings.  The
+            arena must outlive the table, and must not be reset.
+
+    @retval pointer to the new string table
+    @retval NULL if memory allocation failed or the arena is NULL
+
+==============================================================================*/
+StrTab *STRTAB_Create( Arena *pArena )
+{
+    StrTab *pStrTab = NULL;
+
+    if ( pArena != NULL )
+    {
+        pStrTab = calloc( 1, sizeof( StrTab ) );
+    }
+
+    if ( pStrTab != NULL )
+    {
+        pStrTab->pArena = pArena;
+        pStrTab->ppSlots = calloc( STRTAB_INITIAL_SLOTS, sizeof( char * ) );
+        if ( pStrTab->ppSlots != NULL )
+        {
+            pStrTab->numSlots = STRTAB_INITIAL_SLOTS;
+        }
+        else
+        {
+            free( pStrTab );
+            pStrTab = NULL;
+        }
+    }
+
+    return pStrTab;
+}
+
+/*============================================================================*/
+/*  STRTAB_Delete                                                             */
+/*!
+    Delete a string table
+
+    The interned strings remain in the arena until it is deleted.
+
+    @param[in]
+        pStrTab
+            pointer to the string table to delete (may be NULL)
+
+==============================================================================*/
+void STRTAB_Delete( StrTab *pStrTab )
+{
+    if ( pStrTab != NULL )
+    {
+        free( pStrTab->ppSlots );
+        free( pStrTab );
+    }
+}
+
+/*============================================================================*/
+/*  STRTAB_Intern                                                             */
+/*!
+    Intern a string
+
+    The STRTAB_Intern function returns the table's copy of a string,
+    copying the string into the table's arena if it is not already
+    there.  The copy remains valid until the arena is deleted, and must
+    not be modified or freed.
+
+    @param[in]
+        pStrTab
+            pointer to the string table
+
+    @param[in]
+        str
+            string to intern (may be NULL)
+
+    @retval pointer to the interned copy of the string
+    @retval NULL if str is NULL or memory allocation failed
+
+==============================================================================*/
+char *STRTAB_Intern( StrTab *pStrTab, const char *str )
+{
+    char *result = NULL;
+    size_t mask;
+    size_t idx;
+    size_t len;
+
+    if ( ( pStrTab != NULL ) &&
+         ( str != NULL ) )
+    {
+        mask = pStrTab->numSlots - 1;
+        idx = Hash( str ) & mask;
+
+        /* probe for the string */
+        while ( ( pStrTab->ppSlots[idx] != NULL ) &&
+                ( strcmp( pStrTab->ppSlots[idx], str ) != 0 ) )
+        {
+            idx = ( idx + 1 ) & mask;
+        }
+
+        result = pStrTab->ppSlots[idx];
+        if ( result == NULL )
+        {
+            len = strlen( str ) + 1;
+            result = ARENA_Alloc( pStrTab->pArena, len );
+            if ( result != NULL )
+            {
+                memcpy( result, str, len );
+                pStrTab->size += len;
+                pStrTab->ppSlots[idx] = result;
+                pStrTab->count++;
+
+                /* keep the table at most half full */
+                if ( ( pStrTab->count * 2 ) > pStrTab->numSlots )
+                {
+                    (void)Grow( pStrTab );
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  STRTAB_Size                                                               */
+/*!
+    Get the memory used by a string table
+
+    @param[in]
+        pStrTab
+            pointer to the string table
+
+    @retval number of bytes allocated for the strings and their index
+
+==============================================================================*/
+size_t STRTAB_Size( StrTab *pStrTab )
+{
+    size_t result = 0;
+
+    if ( pStrTab != NULL )
+    {
+        result = sizeof( StrTab ) +
+                 pStrTab->size +
+                 ( pStrTab->numSlots * sizeof( char * ) );
+    }
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Grow                                                                      */
+/*!
+    Double the number of hash slots
+
+    @param[in]
+        pStrTab
+            pointer to the string table
+
+    @retval EOK - the hash table was resized
+    @retval ENOMEM - memory allocation failed
+
+==============================================================================*/
+static int Grow( StrTab *pStrTab )
+{
+    int result = ENOMEM;
+    size_t numSlots = pStrTab->numSlots * 2;
+    size_t mask = numSlots - 1;
+    char **ppSlots;
+    size_t idx;
+    size_t i;
+
+    ppSlots = calloc( numSlots, sizeof( char * ) );
+    if ( ppSlots != NULL )
+    {
+        for ( i = 0 ; i < pStrTab->numSlots ; i++ )
+        {
+            if ( pStrTab->ppSlots[i] != NULL )
+            {
+                idx = Hash( pStrTab->ppSlots[i] ) & mask;
+                while ( ppSlots[idx] != NULL )
+                {
+                    idx = ( idx + 1 ) & mask;
+                }
+
+                ppSlots[idx] = pStrTab->ppSlots[i];
+            }
+        }
+
+        free( pStrTab->ppSlots );
+        pStrTab->ppSlots = ppSlots;
+        pStrTab->numSlots = numSlots;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Hash                                                                      */
+/*!
+    Calculate the FNV-1a hash of a string
+
+    @param[in]
+        str
+            string to hash
+
+    @retval hash of the string
+
+==============================================================================*/
+static uint32_t Hash( const char *str )
+{
+    uint32_t h = 2166136261u;
+
+    while ( *str != '\0' )
+    {
+        h ^= (unsigned char)*str++;
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+/*! @}
+ * end of strtab group */
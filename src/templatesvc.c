@@ -38,6 +38,9 @@ SOFTWARE.
     using a JSON object definition to describe the mapping.  The templates
     are rendered when the trigger variables change.
 
+    This file contains the template service core logic, which is linked
+    into the templatesvc application (see main.c) and into the unit tests.
+
 */
 /*============================================================================*/
 
@@ -52,14 +55,24 @@ SOFTWARE.
 #include <unistd.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <syslog.h>
+#include <limits.h>
 #include <signal.h>
 #include <time.h>
+#include <inttypes.h>
 #include <mqueue.h>
 #include <varserver/varserver.h>
 #include <varserver/vartemplate.h>
 #include <varserver/varfp.h>
 #include <tjson/json.h>
+#include "compress.h"
+#include "serialize.h"
+#include "render.h"
+#include "varcache.h"
+#include "metrics.h"
+#include "logger.h"
+#include "confcache.h"
+#include "confdir.h"
+#include "templatesvc.h"
 
 /*==============================================================================
         Private definitions
@@ -68,281 +81,754 @@ SOFTWARE.
 /*! size for the variable rendering output buffer */
 #define VARFP_SIZE                  ( 256 * 1024 )
 
-/*! specifies the type of template */
-typedef enum templateType
-{
-    /*! regular file or stream based template */
-    TMPL_FD = 0,
+/*! size of the scratch buffer for fetching non-numeric variables */
+#define VARFP_FETCH_SIZE            ( 64 * 1024 )
 
-    /*! message queue template */
-    TMPL_MQ = 1
-} TemplateType;
+/*! block size of the arena holding the objects set up with the templates */
+#define SETUP_ARENA_BLOCK_SIZE      ( 64 * 1024 )
 
-/*! the TriggerVar object caches a trigger variable handle and
-    links trigger variables into a chain */
-typedef struct triggerVar
-{
-    /*! variable handle */
-    VAR_HANDLE hVar;
+/*! block size of the arena holding the scratch memory of a render cycle */
+#define CYCLE_ARENA_BLOCK_SIZE      ( 64 * 1024 )
 
-    /*! variable name */
-    char *name;
+/*! maximum number of signals collected into a single render cycle */
+#define MAX_CYCLE_SIGNALS           ( 4096 )
 
-    /*! pointer to the next trigger variable */
-    struct triggerVar *pNext;
-} TriggerVar;
+/*! maximum output queued for a target which is not ready for writing */
+#define MAX_PENDING_OUTPUT          ( 1024 * 1024 )
 
-/*! template component which maps trigger variables to
- *  a template file */
-typedef struct template
-{
-    /*! pointer to the trigger variables */
-    TriggerVar *pTriggers;
+/*! template file changes which require the template to be recompiled */
+#define TEMPLATE_WATCH_MASK \
+    ( IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE )
 
-    /*! pointer to the template file name */
-    char *templateFileName;
+/*! name of the tenant of a configuration which is not loaded from a file */
+#define DEFAULT_TENANT              "default"
 
-    /*! target destination name */
-    char *target;
+/*! maximum length of a tenant name */
+#define MAX_TENANT_NAME             ( 64 )
 
-    /*! template type */
-    TemplateType type;
+/*! initial number of output variables allocated for a variable prefix */
+#define PREFIX_VARS_INITIAL_SIZE    ( 16 )
 
-    /*! output file descriptor */
-    int fd;
+/*! wildcard trigger character, at the end of a trigger name */
+#define WILDCARD_CHAR               '*'
+
+/*! interval between the wildcard trigger rescans in milliseconds */
+#define WILDCARD_RESCAN_MS          ( 5000 )
 
-    /*! message queue handle */
-    mqd_t mq;
+/*! trigger attribute value which derives the triggers from the template */
+#define AUTO_TRIGGER                "auto"
 
-    /*! keep the destination open */
-    bool keep_open;
+/*! first retry delay of the variables which have not been found */
+#define RESOLVE_MIN_DELAY_MS        ( 100 )
 
-    /*! append (true) or overwrite (false) */
-    bool append;
+/*! longest retry delay of the variables which have not been found */
+#define RESOLVE_MAX_DELAY_MS        ( 30000 )
 
-    /*! pointer to the next template */
-    struct template *pNext;
-} Template;
+/*! initial number of templates allocated for the dirty set */
+#define DIRTY_INITIAL_SIZE          ( 16 )
 
+/*! delay of a render cycle scheduled outside of a notification */
+#define RENDER_SOON_NS              ( 1 )
 
-/*! TemplateSvc state */
-typedef struct templateSvcState
+/*! minimum number of hash buckets of the retired templates */
+#define RETIRED_MIN_BUCKETS         ( 16 )
+
+/*! initial number of definitions allocated for a configuration file */
+#define PREPARED_INITIAL_SIZE       ( 16 )
+
+/*! a template definition prepared by a configuration directory worker */
+typedef struct preparedTemplate
 {
-    /*! variable server handle */
-    VARSERVER_HANDLE hVarServer;
+    /*! parsed template definition */
+    ConfTemplate def;
 
-    /*! verbose flag */
-    bool verbose;
+    /*! compiled template (NULL if not a text template, or not compiled) */
+    CompiledTemplate *pCompiled;
 
-    /*! name of the TemplateSvc definition file */
-    char *pFileName;
+} PreparedTemplate;
 
-    /*! Variable Output stream */
-    VarFP *pVarFP;
+/*! the template definitions prepared from a configuration file */
+typedef struct preparedFile
+{
+    /*! prepared template definitions, in configuration order */
+    PreparedTemplate *pTemplates;
 
-    /*! Variable output file descriptor */
-    int varFd;
+    /*! number of prepared template definitions */
+    size_t count;
 
-    /*! size of the template rendering buffer */
-    size_t varfpSize;
+    /*! allocated number of prepared template definitions */
+    size_t size;
 
-    /*! pointer to the file vars list */
-    Template *pTemplates;
-} TemplateSvcState;
+} PreparedFile;
 
-/*==============================================================================
-        Private file scoped variables
-==============================================================================*/
+/*! records appended to a template for the variables matching a prefix */
+typedef struct prefixMatches
+{
+    /*! template the records are appended to */
+    Template *pTemplate;
+
+    /*! wildcard the triggers are expanded from (NULL for output vars) */
+    TriggerVar *pWildcard;
 
-/*! TemplateSvc state object */
-TemplateSvcState state;
+    /*! allocated number of records */
+    size_t size;
+
+} PrefixMatches;
+
+/*! function called for each variable matching a prefix (see QueryPrefix) */
+typedef int (*PrefixMatchFn)( TemplateSvcState *pState,
+                              const char *name,
+                              VAR_HANDLE hVar,
+                              void *arg );
 
 /*==============================================================================
         Private function declarations
 ==============================================================================*/
 
-void main(int argc, char **argv);
-static int ProcessOptions( int argC, char *argV[], TemplateSvcState *pState );
-static void usage( char *cmdname );
 static int SetupVarFP( TemplateSvcState *pState );
-static int SetupTemplate( JNode *pNode, void *arg );
-static int PrintTemplateFD( TemplateSvcState *pState, Template *pTemplate );
-static int PrintTemplateMQ( TemplateSvcState *pState, Template *pTemplate );
-
-static void SetupTerminationHandler( void );
-static void TerminationHandler( int signum, siginfo_t *info, void *ptr );
+static int ParseDefinition( JNode *pNode, ConfTemplate *pDef );
+static int ParseTrigger( JNode *pNode, void *arg );
+static int ParseVar( JNode *pNode, void *arg );
+static int ParseExclude( JNode *pNode, void *arg );
+static char *ItemName( JNode *pNode );
+static void ParseTriggerCondition( JNode *pNode, ConfTrigger *pTrigger );
+static int CreateTemplate( TemplateSvcState *pState,
+                           ConfTemplate *pDef,
+                           CompiledTemplate *pCompiled );
+static OutputFormat FormatFromName( const char *format );
+static int SetupTriggers( TemplateSvcState *pState,
+                          Template *pTemplate,
+                          ConfTemplate *pDef );
+static void CacheDefinition( TemplateSvcState *pState, ConfTemplate *pDef );
+static int LoadCache( TemplateSvcState *pState );
+static int LoadFile( TemplateSvcState *pState );
+static int LoadDirectory( TemplateSvcState *pState );
+static int ParseDirectory( TemplateSvcState *pState,
+                           ConfFileFn fn,
+                           ConfDir **ppDir );
+static int PrepareFile( ConfFile *pFile, void *arg );
+static int PrepareTemplate( JNode *pNode, void *arg );
+static void FreePrepared( PreparedFile *pPrepared );
+static void ParseTenant( JNode *config, ConfTenant *pConf );
+static Tenant *SetupTenant( TemplateSvcState *pState,
+                            ConfTenant *pConf,
+                            const char *source );
+static bool AdmitRender( TemplateSvcState *pState, Template *pTemplate );
+static void RetryDeferred( EventLoop *pLoop,
+                           EventTimer *pTimer,
+                           uint64_t expirations,
+                           void *arg );
+static void SortTemplates( TemplateSvcState *pState );
+static Template *MergeTemplates( Template *pA, Template *pB );
+static bool TenantFull( Tenant *pTenant );
+static int SetupCommit( TemplateSvcState *pState,
+                        Template *pTemplate,
+                        char *name );
+static int GetLevel( JNode *pNode, char *name, double *pLevel );
+static bool CheckCondition( TemplateSvcState *pState,
+                            TriggerVar *pTriggerVar );
+static bool CheckLevel( TriggerVar *pTriggerVar, double value );
+static bool CheckWide( TriggerVar *pTriggerVar, uint64_t wide, double value );
+static bool CheckText( TriggerVar *pTriggerVar, VarEntry *pEntry );
+static int PrintStructured( TemplateSvcState *pState, Template *pTemplate );
+static int SetupOutputVars( TemplateSvcState *pState,
+                            ConfTemplate *pDef,
+                            Template *pTemplate );
+static int SetupPrefixVars( TemplateSvcState *pState,
+                            char *prefix,
+                            Template *pTemplate );
+static int AddPrefixVar( TemplateSvcState *pState,
+                         const char *name,
+                         VAR_HANDLE hVar,
+                         void *arg );
+static int QueryPrefix( TemplateSvcState *pState,
+                        char *prefix,
+                        PrefixMatchFn fn,
+                        void *arg );
+static bool IsWildcard( const char *name );
+static int SetupExclude( TemplateSvcState *pState,
+                         Template *pTemplate,
+                         ConfTemplate *pDef );
+static int DeriveTriggers( TemplateSvcState *pState, Template *pTemplate );
+static int AddDerivedTrigger( TemplateSvcState *pState,
+                              Template *pTemplate,
+                              const char *name,
+                              size_t *pSize );
+static bool IsExcluded( Template *pTemplate, const char *name );
+static int ExpandWildcard( TemplateSvcState *pState,
+                           Template *pTemplate,
+                           TriggerVar *pWildcard );
+static int AddWildcardTrigger( TemplateSvcState *pState,
+                               const char *name,
+                               VAR_HANDLE hVar,
+                               void *arg );
+static bool HasTrigger( TemplateSvcState *pState,
+                        Template *pTemplate,
+                        VAR_HANDLE hVar );
+static int StartRescan( TemplateSvcState *pState );
+static void StartResolver( TemplateSvcState *pState );
+static void ResolveTimer( EventLoop *pLoop,
+                          EventTimer *pTimer,
+                          uint64_t expirations,
+                          void *arg );
+static size_t CountPending( TemplateSvcState *pState );
+static size_t ResolveTriggers( TemplateSvcState *pState,
+                               TriggerVar *pTriggers,
+                               size_t numTriggers,
+                               size_t *pPending );
+static size_t UnresolvedRefs( CompiledTemplate *pCompiled );
+static int RegisterVars( TemplateSvcState *pState );
+static int AddTriggers( VarReg *pReg,
+                        TriggerVar *pTriggers,
+                        size_t numTriggers );
+static void RenderAll( TemplateSvcState *pState );
+static void RescanTimer( EventLoop *pLoop,
+                         EventTimer *pTimer,
+                         uint64_t expirations,
+                         void *arg );
+static int DeliverOutput( TemplateSvcState *pState,
+                          Template *pTemplate,
+                          char *pData,
+                          size_t len );
+static int RenderTemplate( TemplateSvcState *pState,
+                           Template *pTemplate,
+                           char **ppData,
+                           size_t *pLen );
+static int CompressChunk( const char *pData, size_t len, void *arg );
+static int CompressOutput( TemplateSvcState *pState,
+                           Template *pTemplate,
+                           char **ppData,
+                           size_t *pLen );
+static int WriteOutput( int fd,
+                        const char *pData,
+                        size_t len,
+                        size_t *pWritten );
+static int OpenTarget( TemplateSvcState *pState, Template *pTemplate );
+static int WriteTarget( TemplateSvcState *pState,
+                        Template *pTemplate,
+                        const char *pData,
+                        size_t len );
+static void CloseTarget( Template *pTemplate );
+static int QueueOutput( Template *pTemplate, const char *pData, size_t len );
+static void TargetWritable( EventLoop *pLoop,
+                            int fd,
+                            uint32_t events,
+                            void *arg );
+static void SignalReceived( EventLoop *pLoop,
+                            int sig,
+                            int sigval,
+                            void *arg );
+static int WatchTemplate( TemplateSvcState *pState, Template *pTemplate );
+static void DeleteTemplates( TemplateSvcState *pState );
+static int ReloadTemplate( JNode *pNode, void *arg );
+static void DeleteTemplate( TemplateSvcState *pState, Template *pTemplate );
+static size_t SweepNotifications( TemplateSvcState *pState );
+static char *TemplateSignature( ConfTemplate *pDef );
+static int RetireTemplates( TemplateSvcState *pState, size_t *pCount );
+static void RetireTemplate( TemplateSvcState *pState, Template *pTemplate );
+static Template *TakeRetired( TemplateSvcState *pState,
+                              const char *pSignature );
+static size_t DeleteRetired( TemplateSvcState *pState );
+static uint32_t SignatureHash( const char *pSignature );
+static int StartTicker( TemplateSvcState *pState );
+static void PeriodicTick( EventLoop *pLoop,
+                          EventTimer *pTimer,
+                          uint64_t expirations,
+                          void *arg );
+static uint64_t GCD( uint64_t a, uint64_t b );
+static void TemplateChanged( EventLoop *pLoop,
+                             uint32_t mask,
+                             const char *name,
+                             void *arg );
 
 static int SetupTriggerNotifications( VARSERVER_HANDLE hVarServer,
-                                      TriggerVar *pTriggerVars );
+                                      VarCache *pVarCache,
+                                      TriggerVar *pTriggerVars,
+                                      size_t numTriggerVars );
 
 static int SetupTriggerNotification( VARSERVER_HANDLE hVarServer,
+                                     VarCache *pVarCache,
                                      TriggerVar *pTriggerVar );
 
-static int ProcessTemplates( TemplateSvcState *pState, VAR_HANDLE hVar );
+static int ProcessTrigger( TemplateSvcState *pState,
+                           Template *pTemplate,
+                           TriggerVar *pTriggerVar );
+static int BuildIndex( TemplateSvcState *pState );
+static void MarkDirty( Template *pTemplate );
+static void ScheduleRender( TemplateSvcState *pState, uint64_t delayNs );
+static int QueueTemplate( Template *pTemplate );
+static void DequeueTemplate( TemplateSvcState *pState, Template *pTemplate );
+static int CompareRank( const void *pA, const void *pB );
+
+static int ProcessPendingSignals( TemplateSvcState *pState );
+static int FetchTemplate( TemplateSvcState *pState, Template *pTemplate );
+static int OutputTemplate( TemplateSvcState *pState, Template *pTemplate );
+static char *TemplateName( ConfTemplate *pDef );
+static int PrintMetrics( TemplateSvcState *pState, int32_t id );
+static int StartCapture( TemplateSvcState *pState );
+static void CaptureVar( TemplateSvcState *pState,
+                        VAR_HANDLE hVar,
+                        const char *name );
+static void CaptureSignal( TemplateSvcState *pState, int sig, int sigval );
 
-static int ProcessTemplate( TemplateSvcState *pState,
-                            Template *pTemplate,
-                            VAR_HANDLE hVar );
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
 
+/*============================================================================*/
+/*  TEMPLATESVC_Init                                                          */
+/*!
+    Initialize the template service state
+
+    The TEMPLATESVC_Init function clears the template service state object
+    and sets up its default configuration.
+
+    @param[in]
+        pState
+            pointer to the template service state to initialize
+
+    @retval EOK - the state was initialized
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int TEMPLATESVC_Init( TemplateSvcState *pState )
+{
+    int result = EINVAL;
+
+    if ( pState != NULL )
+    {
+        memset( pState, 0, sizeof( TemplateSvcState ) );
+
+        /* set up the default VARFP size */
+        pState->varfpSize = VARFP_SIZE;
+        pState->varFd = -1;
+        pState->fetchFd = -1;
+        pState->logLevel = LOGGER_WARNING;
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TEMPLATESVC_Open                                                          */
+/*!
+    Open the template service
+
+    The TEMPLATESVC_Open function sets up the rendering buffers, the
+    arenas and the variable cache, and opens a connection to the variable
+    server.  The variable server signals are blocked in the calling
+    thread first, so the notifications requested while the templates are
+    loaded stay pending until TEMPLATESVC_Attach hands them to the event
+    loop, rather than terminating the process.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @retval EOK - the template service is ready to load templates
+    @retval ENOMEM - the variable cache could not be created
+    @retval ENOTCONN - the variable server connection could not be opened
+    @retval EINVAL - invalid arguments
 
-/*==============================================================================
-        Private function definitions
 ==============================================================================*/
+int TEMPLATESVC_Open( TemplateSvcState *pState )
+{
+    int result = EINVAL;
+    sigset_t mask;
+
+    if ( pState != NULL )
+    {
+        /* hold the variable server signals until they are handled */
+        sigemptyset( &mask );
+        sigaddset( &mask, SIG_VAR_MODIFIED );
+        sigaddset( &mask, SIG_VAR_PRINT );
+        sigprocmask( SIG_BLOCK, &mask, NULL );
+
+        /* set up the rendering buffer */
+        SetupVarFP( pState );
+
+        /* create the variable cache */
+        pState->pVarCache = VARCACHE_Create();
+        VARCACHE_SetScratch( pState->pVarCache,
+                             pState->fetchFd,
+                             ( pState->pFetchFP != NULL )
+                                ? VARFP_GetData( pState->pFetchFP )
+                                : NULL,
+                             VARFP_FETCH_SIZE );
+
+        /* create the arenas, the definition strings and the
+           trigger index */
+        pState->pArena = ARENA_Create( SETUP_ARENA_BLOCK_SIZE );
+        pState->pCycleArena = ARENA_Create( CYCLE_ARENA_BLOCK_SIZE );
+        pState->pStrings = STRTAB_Create( pState->pArena );
+        pState->pTrigIndex = TRIGINDEX_Create();
+
+        /* get a handle to the VAR server */
+        pState->hVarServer = VARSERVER_Open();
+
+        if ( ( pState->pVarCache == NULL ) ||
+             ( pState->pCycleArena == NULL ) ||
+             ( pState->pStrings == NULL ) ||
+             ( pState->pTrigIndex == NULL ) )
+        {
+            result = ENOMEM;
+        }
+        else if ( pState->hVarServer == NULL )
+        {
+            result = ENOTCONN;
+        }
+        else
+        {
+            result = EOK;
+        }
+    }
+
+    return result;
+}
 
 /*============================================================================*/
-/*  main                                                                      */
+/*  TEMPLATESVC_Load                                                          */
 /*!
-    Main entry point for the templatesvc application
+    Load the template definitions
 
-    The main function starts the templatesvc application
+    The TEMPLATESVC_Load function sets up a template for each entry in the
+    "config" array of the template service configuration, as the rule set
+    named by its "tenant" object, or the "default" rule set.  The variables
+    of the templates are then registered together (see RegisterVars), and
+    every template is rendered once if renderOnLoad is set.  If a capture
+    file is specified, trigger capture starts once the templates are set
+    up.
 
     @param[in]
-        argc
-            number of arguments on the command line
-            (including the command itself)
+        pState
+            pointer to the template service state
 
     @param[in]
-        argv
-            array of pointers to the command line arguments
+        config
+            pointer to the parsed template service configuration
 
-    @return none
+    @retval EOK - the templates were loaded
+    @retval EINVAL - invalid arguments
+    @retval other - one or more templates could not be set up
 
 ==============================================================================*/
-void main(int argc, char **argv)
+int TEMPLATESVC_Load( TemplateSvcState *pState, JNode *config )
 {
-    VARSERVER_HANDLE hVarServer = NULL;
-    VAR_HANDLE hVar;
-    int result;
-    JNode *config;
+    int result = EINVAL;
     JArray *cfg;
-    int sigval;
-    int sig;
-    int fd;
+    ConfTenant tenant;
+
+    if ( ( pState != NULL ) &&
+         ( config != NULL ) )
+    {
+        /* get the configuration array */
+        cfg = (JArray *)JSON_Find( config, "config" );
 
-    /* clear the templatesvc state object */
-    memset( &state, 0, sizeof( state ) );
+        ParseTenant( config, &tenant );
+        pState->pTenant = SetupTenant( pState, &tenant, NULL );
 
-    /* set up the default VARFP size */
-    state.varfpSize = VARFP_SIZE;
-    state.varFd = -1;
+        /* set up the templates by iterating through the configuration array,
+           and then register their variables together */
+        VARCACHE_Defer( pState->pVarCache, true );
+        result = JSON_Iterate( cfg, TEMPLATESVC_SetupTemplate, (void *)pState );
+        (void)RegisterVars( pState );
+        SortTemplates( pState );
 
-    if( argc < 2 )
-    {
-        usage( argv[0] );
-        exit( 1 );
+        if ( pState->renderOnLoad == true )
+        {
+            /* pick up the changes made before the notifications were set */
+            RenderAll( pState );
+        }
+
+        if ( pState->pCaptureFile != NULL )
+        {
+            /* start recording the received triggers */
+            StartCapture( pState );
+        }
     }
 
-    /* set up the abnormal termination handler */
-    SetupTerminationHandler();
+    return result;
+}
+
+/*============================================================================*/
+/*  TEMPLATESVC_LoadConfig                                                    */
+/*!
+    Load the template definitions from the configuration
 
-    /* process the command line options */
-    ProcessOptions( argc, argv, &state );
+    The TEMPLATESVC_LoadConfig function loads the template definitions
+    from the configuration file, and then from each file of the
+    configuration directory, if they are specified.  The variables of
+    all of the templates are then registered together (see
+    RegisterVars).  If renderOnLoad is set, every template is then
+    rendered once, so a change made while the service was starting is
+    not missed.  If a capture file is specified, trigger capture starts
+    once all of the templates are set up.
 
-    /* set up the rendering buffer */
-    SetupVarFP( &state );
+    @param[in]
+        pState
+            pointer to the template service state
 
-    /* process the input file */
-    config = JSON_Process( state.pFileName );
+    @retval EOK - the templates were loaded
+    @retval EINVAL - invalid arguments
+    @retval ENOENT - no configuration file or directory is specified
+    @retval other - one or more templates could not be set up
 
-    /* get the configuration array */
-    cfg = (JArray *)JSON_Find( config, "config" );
+==============================================================================*/
+int TEMPLATESVC_LoadConfig( TemplateSvcState *pState )
+{
+    int result = EINVAL;
+    int rc;
 
-    /* get a handle to the VAR server */
-    state.hVarServer = VARSERVER_Open();
-    if( state.hVarServer != NULL )
+    if ( pState != NULL )
     {
-        /* set up the file vars by iterating through the configuration array */
-        JSON_Iterate( cfg, SetupTemplate, (void *)&state );
+        result = ENOENT;
+
+        /* hold the variable lookups until all templates are set up */
+        VARCACHE_Defer( pState->pVarCache, true );
 
-        while( 1 )
+        if ( pState->pFileName != NULL )
         {
-            /* wait for a signal from the variable server */
-            sig = VARSERVER_WaitSignal( &sigval );
-            if ( sig == SIG_VAR_MODIFIED )
+            result = LoadFile( pState );
+        }
+
+        if ( pState->pConfigDir != NULL )
+        {
+            rc = LoadDirectory( pState );
+            if ( ( pState->pFileName == NULL ) || ( rc != EOK ) )
             {
-                ProcessTemplates( &state, (VAR_HANDLE)sigval );
+                result = rc;
             }
         }
 
-        /* close the variable server */
-        if ( VARSERVER_Close( state.hVarServer ) == EOK )
+        (void)RegisterVars( pState );
+
+        /* render the higher priority rule sets first */
+        SortTemplates( pState );
+
+        if ( pState->renderOnLoad == true )
+        {
+            /* pick up the changes made before the notifications were set */
+            RenderAll( pState );
+        }
+
+        if ( pState->pCaptureFile != NULL )
         {
-            state.hVarServer = NULL;
+            /* start recording the received triggers */
+            StartCapture( pState );
         }
     }
+
+    return result;
 }
 
 /*============================================================================*/
-/*  SetupTriggers                                                             */
+/*  TEMPLATESVC_Reload                                                        */
 /*!
-    Set up a triggers
-
-    The SetupTriggers function parsers an array of variable triggers
-    and adds them to a trigger list.
-
-    @param[in]
-       pNode
-            pointer to a JSON node which should be an array of strings.
+    Reload the template definitions
+
+    The TEMPLATESVC_Reload function re-reads the template service
+    configuration file and configuration directory, applies the
+    differences to the running service, and rebuilds the configuration
+    cache file, if one is specified.  A template whose definition is
+    unchanged is kept as it is, with its compiled template, cached values
+    and open target.  New definitions are set up, and templates which are
+    no longer defined are torn down.  MODIFIED notifications are only
+    requested for new trigger variables, and are cancelled for variables
+    which are no longer referenced.  If the configuration file, or any
+    file of the configuration directory, cannot be read, the running
+    configuration is kept.
 
     @param[in]
-        arg
-            opaque pointer argument used for the templatesvc state object
+        pState
+            pointer to the template service state
 
-    @retval EOK - the template was set up successfully
-    @retval EINVAL - the template could not be set up
+    @retval EOK - the configuration was reloaded
+    @retval EINVAL - invalid arguments
+    @retval ENOENT - the configuration could not be read
+    @retval ENOMEM - memory allocation failure
+    @retval other - one or more new templates could not be set up
 
 ==============================================================================*/
-static int SetupTriggers( JNode *pNode, void *arg )
+int TEMPLATESVC_Reload( TemplateSvcState *pState )
 {
-    JVar *pVar;
     int result = EINVAL;
-    TriggerVar *pTriggerVar;
-    TriggerVar **pTriggers = (TriggerVar **)arg;
+    JNode *config = NULL;
+    JArray *cfg = NULL;
+    ConfDir *pDir = NULL;
+    ConfFile *pFile;
+    Template *pTemplate;
+    size_t before = 0;
+    size_t after = 0;
+    size_t removed = 0;
+    size_t cancelled;
+    size_t i;
+    ConfTenant tenant;
+    Tenant *pTenant;
+    int rc;
 
-    if ( ( pNode != NULL ) && ( arg != NULL ) )
+    if ( pState != NULL )
     {
-        if ( pNode->type == JSON_VAR )
+        result = ENOENT;
+
+        if ( pState->pFileName != NULL )
         {
-            pVar = (JVar *)pNode;
-            if ( pVar->var.type == JVARTYPE_STR )
+            if ( pState->pCacheFile != NULL )
+            {
+                /* identify the configuration before it is parsed */
+                pState->pNewConfCache = CONFCACHE_Create( pState->pCacheFile,
+                                                          pState->pFileName );
+            }
+
+            config = JSON_Process( pState->pFileName );
+            cfg = (JArray *)JSON_Find( config, "config" );
+            result = ( cfg != NULL ) ? EOK : ENOENT;
+        }
+
+        if ( ( pState->pConfigDir != NULL ) &&
+             ( ( pState->pFileName == NULL ) || ( result == EOK ) ) )
+        {
+            result = ParseDirectory( pState, NULL, &pDir );
+            if ( result != EOK )
             {
-                if ( pVar->var.val.str != NULL )
+                result = ENOENT;
+            }
+        }
+
+        if ( result != EOK )
+        {
+            LOGGER_Log( LOGGER_ERROR,
+                        "Cannot reload %s",
+                        ( pState->pFileName != NULL ) ? pState->pFileName
+                        : ( pState->pConfigDir != NULL ) ? pState->pConfigDir
+                                                         : "(null)" );
+        }
+        else if ( RetireTemplates( pState, &before ) != EOK )
+        {
+            LOGGER_Log( LOGGER_ERROR, "Cannot reload: out of memory" );
+            result = ENOMEM;
+        }
+        else
+        {
+            /* the tenants' templates are counted again as they are matched */
+            for ( pTenant = pState->pTenants ;
+                  pTenant != NULL ;
+                  pTenant = pTenant->pNext )
+            {
+                pTenant->templates = 0;
+            }
+
+            if ( cfg != NULL )
+            {
+                ParseTenant( config, &tenant );
+                pState->pTenant = SetupTenant( pState, &tenant, NULL );
+                if ( pState->pNewConfCache != NULL )
                 {
-                    /* allocate memory for the trigger record */
-                    pTriggerVar = calloc( 1, sizeof( TriggerVar ) );
-                    if ( pTriggerVar != NULL )
-                    {
-                        /* populate the trigger record */
-                        pTriggerVar->name = pVar->var.val.str;
+                    (void)CONFCACHE_SetTenant( pState->pNewConfCache,
+                                               &tenant );
+                }
 
-                        /* insert the new trigger record at the head of the
-                           trigger list for this template */
-                        pTriggerVar->pNext = *pTriggers;
-                        *pTriggers = pTriggerVar;
+                result = JSON_Iterate( cfg, ReloadTemplate, (void *)pState );
 
-                        /* indicate success */
-                        result = EOK;
-                    }
-                    else
-                    {
-                        /* memory allocation failure */
-                        result = ENOMEM;
-                    }
+                /* the cache only holds the configuration file */
+                if ( ( pState->pNewConfCache != NULL ) &&
+                     ( CONFCACHE_Save( pState->pNewConfCache ) != EOK ) )
+                {
+                    LOGGER_Log( LOGGER_WARNING,
+                                "Cannot write the configuration cache %s",
+                                pState->pCacheFile );
+                }
+
+                CONFCACHE_Close( pState->pNewConfCache );
+                pState->pNewConfCache = NULL;
+            }
+
+            for ( i = 0 ; i < CONFDIR_Count( pDir ) ; i++ )
+            {
+                pFile = CONFDIR_Get( pDir, i );
+
+                ParseTenant( pFile->config, &tenant );
+                pState->pTenant = SetupTenant( pState, &tenant, pFile->path );
+
+                rc = JSON_Iterate( (JArray *)JSON_Find( pFile->config,
+                                                        "config" ),
+                                   ReloadTemplate,
+                                   (void *)pState );
+                if ( rc != EOK )
+                {
+                    result = rc;
                 }
             }
+
+            /* tear down the templates which are no longer defined */
+            removed = DeleteRetired( pState );
+
+            for ( pTemplate = pState->pTemplates ;
+                  pTemplate != NULL ;
+                  pTemplate = pTemplate->pNext )
+            {
+                after++;
+            }
+
+            /* render the higher priority rule sets first */
+            SortTemplates( pState );
+
+            /* stop watching the variables which are no longer referenced */
+            cancelled = SweepNotifications( pState );
+
+            if ( pState->pTicker != NULL )
+            {
+                /* the periodic intervals may have changed */
+                EVENTLOOP_DeleteTimer( pState->pEventLoop, pState->pTicker );
+                pState->pTicker = NULL;
+            }
+
+            if ( pState->pEventLoop != NULL )
+            {
+                StartTicker( pState );
+                StartRescan( pState );
+            }
+
+            /* kept templates pick up the variables created since the
+               last rescan */
+            (void)TEMPLATESVC_RescanWildcards( pState );
+
+            /* the new templates may refer to variables not yet created */
+            StartResolver( pState );
+
+            LOGGER_Log( LOGGER_INFO,
+                        "Reloaded %zu templates: %zu kept, %zu added, "
+                        "%zu removed, %zu notifications cancelled",
+                        after,
+                        before - removed,
+                        after - ( before - removed ),
+                        removed,
+                        cancelled );
+        }
+
+        CONFCACHE_Close( pState->pNewConfCache );
+        pState->pNewConfCache = NULL;
+
+        if ( config != NULL )
+        {
+            JSON_Free( config );
         }
+
+        CONFDIR_Close( pDir );
     }
 
     return result;
 }
 
 /*============================================================================*/
-/*  SetupTemplate                                                             */
+/*  TEMPLATESVC_SetupTemplate                                                 */
 /*!
     Set up a triggered template object
 
-    The SetupTemplate function is a callback function for the JSON_Iterate
-    function which sets up a triggered template from the JSON configuration.
+    The TEMPLATESVC_SetupTemplate function is a callback function for the
+    JSON_Iterate function which sets up a triggered template from the JSON
+    configuration.
     The template definition object is expected to look similar to the
     example below:
 
@@ -352,9 +838,40 @@ static int SetupTriggers( JNode *pNode, void *arg )
         "type" : "fd",
         "target" : "/splunk",
         "keep_open" : true,
-        "append" : true
+        "append" : true,
+        "compress" : "zstd",
+        "interval_ms" : 1000
     }
 
+    The optional "compress" attribute selects a streaming compressor
+    ("zstd" or "lz4") which emits one independently decodable frame
+    per render.
+
+    The optional "incremental" attribute caches the formatted text of
+    each referenced variable, and only re-formats variables which have
+    been modified since the previous render.  All referenced variables
+    are watched for MODIFIED notifications in this mode.
+
+    Numeric variables are rendered as the variable server prints them.
+    The optional "native_format" attribute formats them in the template
+    service instead, with floats rendered as the shortest text which
+    reads back as the same value (e.g. 1.5 rather than 1.500000).
+
+    The optional "interval_ms" attribute also renders the template
+    periodically.  Periodic templates share one timer, so templates with
+    the same interval render in the same batch.  A periodic render is
+    skipped if the template was triggered within the last interval.
+
+    The optional "commit" attribute names a commit variable.  The
+    triggers then only mark the template, and it is rendered once when
+    the commit variable is notified, if it has been marked since the last
+    commit.
+
+    Instead of a "template", a "format" of "jsonl" or "cbor" may be
+    specified along with a list of "vars" and/or a variable name "prefix".
+    The listed variables are then emitted directly as one JSON Lines
+    record or one CBOR map per trigger.
+
     @param[in]
        pNode
             pointer to the template definition node
@@ -367,172 +884,170 @@ static int SetupTriggers( JNode *pNode, void *arg )
     @retval EINVAL - the template could not be set up
 
 ==============================================================================*/
-static int SetupTemplate( JNode *pNode, void *arg )
+int TEMPLATESVC_SetupTemplate( JNode *pNode, void *arg )
 {
     TemplateSvcState *pState = (TemplateSvcState *)arg;
-    JVar *pName;
-    JVar *pFileName;
-    char *template = NULL;
-    char *target = NULL;
-    char *type = NULL;
-    TemplateType tt = TMPL_FD;
-    bool append;
-    bool keep_open;
-    VARSERVER_HANDLE hVarServer;
-    Template *pTemplate;
-    TriggerVar *pTrigger = NULL;
-    int rc;
+    ConfTemplate def;
     int result = EINVAL;
 
-    if( pState != NULL )
+    if ( ( pState != NULL ) &&
+         ( ParseDefinition( pNode, &def ) == EOK ) )
     {
-        /* get a handle to the VarServer */
-        hVarServer = pState->hVarServer;
-
-        template = JSON_GetStr( pNode, "template" );
-        type = JSON_GetStr( pNode, "type" );
-        if ( type != NULL )
-        {
-            if ( strcmp( type, "mq" ) == 0 )
-            {
-                tt = TMPL_MQ;
-            }
-        }
-
-        target = JSON_GetStr( pNode, "target" );
-        append = JSON_GetBool( pNode, "append" );
-        keep_open = JSON_GetBool( pNode, "keep_open" );
-
-        /* allocate memory for the template */
-        pTemplate = calloc( 1, sizeof( Template ) );
-        if( pTemplate != NULL )
-        {
-            pTemplate->templateFileName = template;
-            pTemplate->append = append;
-            pTemplate->keep_open = keep_open;
-            pTemplate->target = target;
-            pTemplate->fd = -1;
-            pTemplate->type = tt;
-
-            /* set up the triggers */
-            if ( JSON_Iterate( (JArray *)JSON_Find( pNode, "trigger"),
-                               SetupTriggers,
-                               (void *)&(pTemplate->pTriggers) ) == EOK )
-            {
-                rc = SetupTriggerNotifications( pState->hVarServer,
-                                                pTemplate->pTriggers );
-            }
-
-
-            /* insert the template definition */
-            pTemplate->pNext = pState->pTemplates;
-            pState->pTemplates = pTemplate;
-
-            result = EOK;
-        }
+        CacheDefinition( pState, &def );
+        result = CreateTemplate( pState, &def, NULL );
+        CONFCACHE_FreeDefinition( &def );
     }
 
     return result;
 }
 
 /*============================================================================*/
-/*  SetupTriggerNotifications                                                 */
+/*  TEMPLATESVC_Attach                                                        */
 /*!
-    Set up all the NOTIFY_MODIFIED trigger notifications
+    Attach the template service to an event loop
 
-    The SetupTriggerNotifications function iterates through the TriggerVars
-    list and sets up all the NOTIFY_MODIFIED trigger notification requests
-    with the variable server.
+    The TEMPLATESVC_Attach function registers the variable server signals
+    with the event loop, and watches the loaded template files so they are
+    only recompiled when they change, and starts the periodic renders.
+    Once attached, file descriptor targets are written without blocking,
+    and output which a target is not ready to accept is queued until the
+    target becomes writable.
 
     @param[in]
-        hVarServer
-            Handle to the variable server
+        pState
+            pointer to the template service state
 
     @param[in]
-        pTriggerVars
-            pointer to the TriggerVar list
+        pLoop
+            pointer to the event loop
 
-    @retval EOK - all the triggers were successfully set up
-    @retval ENOENT - one or more of the trigger variables were not found
+    @retval EOK - the template service is attached to the event loop
     @retval EINVAL - invalid arguments
+    @retval other - the variable server signals could not be registered
 
 ==============================================================================*/
-static int SetupTriggerNotifications( VARSERVER_HANDLE hVarServer,
-                                      TriggerVar *pTriggerVars )
+int TEMPLATESVC_Attach( TemplateSvcState *pState, EventLoop *pLoop )
 {
     int result = EINVAL;
-    TriggerVar *pTriggerVar;
-    int rc;
+    Template *pTemplate;
 
-    if ( ( hVarServer != NULL ) &&
-         ( pTriggerVars != NULL ) )
+    if ( ( pState != NULL ) &&
+         ( pLoop != NULL ) )
     {
-        pTriggerVar = pTriggerVars;
-        result = EOK;
+        pState->pEventLoop = pLoop;
 
-        while ( pTriggerVar != NULL )
+        result = EVENTLOOP_AddSignal( pLoop,
+                                      SIG_VAR_MODIFIED,
+                                      SignalReceived,
+                                      pState );
+        if ( result == EOK )
         {
-            /* set up a trigger notification */
-            rc = SetupTriggerNotification( hVarServer, pTriggerVar );
-            if ( rc != EOK )
+            result = EVENTLOOP_AddSignal( pLoop,
+                                          SIG_VAR_PRINT,
+                                          SignalReceived,
+                                          pState );
+        }
+
+        pTemplate = pState->pTemplates;
+        while ( ( result == EOK ) && ( pTemplate != NULL ) )
+        {
+            if ( ( pTemplate->format == FMT_TEXT ) &&
+                 ( WatchTemplate( pState, pTemplate ) != EOK ) )
             {
-                result = rc;
+                /* fall back to checking the template file on each render */
+                LOGGER_Log( LOGGER_WARNING,
+                            "Cannot watch %s",
+                            pTemplate->templateFileName );
             }
 
-            /* move to the next trigger variable */
-            pTriggerVar = pTriggerVar->pNext;
+            pTemplate = pTemplate->pNext;
+        }
+
+        if ( result == EOK )
+        {
+            /* start the periodic renders */
+            result = StartTicker( pState );
+        }
+
+        if ( result == EOK )
+        {
+            /* start looking for new variables matching the wildcards */
+            result = StartRescan( pState );
+        }
+
+        if ( result == EOK )
+        {
+            /* keep looking for the variables which were not found */
+            StartResolver( pState );
         }
     }
+
+    return result;
 }
 
 /*============================================================================*/
-/*  SetupTriggerNotification                                                  */
+/*  TEMPLATESVC_HandleSignal                                                  */
 /*!
-    Set up a NOTIFY_MODIFIED trigger notification
+    Handle a signal from the variable server
 
-    The SetupTriggerNotification function sets up a TriggerVar NOTIFY_MODIFIED
-    trigger notification request with the variable server.
+    The TEMPLATESVC_HandleSignal function handles a signal received from the
+    variable server.  A MODIFIED signal marks the templates it triggers,
+    batches in any other pending triggers, and renders the triggered
+    templates.  A PRINT signal prints the requested template metric.
 
     @param[in]
-        hVarServer
-            Handle to the variable server
+        pState
+            pointer to the template service state
 
     @param[in]
-        pTriggerVar
-            pointer to the TriggerVar to set up
+        sig
+            the signal received from the variable server
 
-    @retval EOK - the notification was successfully set up
-    @retval ENOENT - the trigger variable was not found
+    @param[in]
+        sigval
+            the value associated with the signal
+
+    @retval EOK - the signal was handled
+    @retval ENOTSUP - the signal is not handled by the template service
     @retval EINVAL - invalid arguments
+    @retval other - the signal could not be handled
 
 ==============================================================================*/
-static int SetupTriggerNotification( VARSERVER_HANDLE hVarServer,
-                                     TriggerVar *pTriggerVar )
+int TEMPLATESVC_HandleSignal( TemplateSvcState *pState, int sig, int sigval )
 {
     int result = EINVAL;
-    VAR_HANDLE hVar;
 
-    if ( ( hVarServer != NULL ) &&
-         ( pTriggerVar != NULL ) )
+    if ( pState != NULL )
     {
-        if ( pTriggerVar->name != NULL )
+        if ( pState->pCapture != NULL )
         {
-            /* get a handle to the trigger variable */
-            pTriggerVar->hVar = VAR_FindByName( hVarServer, pTriggerVar->name );
-            if ( pTriggerVar->hVar != VAR_INVALID )
-            {
-                /* request a MODIFIED notification on the trigger variable */
-                result = VAR_Notify( hVarServer,
-                                     pTriggerVar->hVar,
-                                     NOTIFY_MODIFIED );
-            }
-            else
+            if ( sig == SIG_VAR_MODIFIED )
             {
-                result = ENOENT;
-                fprintf( stderr,
-                         "templatesvc: Cannot find variable: %s\n",
-                         pTriggerVar->name );
+                /* this signal starts a new render cycle */
+                CAPTURE_Cycle( pState->pCapture );
             }
+
+            CaptureSignal( pState, sig, sigval );
+        }
+
+        if ( sig == SIG_VAR_MODIFIED )
+        {
+            TEMPLATESVC_ProcessTemplates( pState, (VAR_HANDLE)sigval );
+
+            /* batch any other pending triggers into this cycle */
+            ProcessPendingSignals( pState );
+
+            /* render all of the triggered templates */
+            result = TEMPLATESVC_RenderTemplates( pState );
+        }
+        else if ( sig == SIG_VAR_PRINT )
+        {
+            /* a client is reading one of our metrics */
+            result = PrintMetrics( pState, sigval );
+        }
+        else
+        {
+            result = ENOTSUP;
         }
     }
 
@@ -540,50 +1055,59 @@ static int SetupTriggerNotification( VARSERVER_HANDLE hVarServer,
 }
 
 /*============================================================================*/
-/*  SetupVarFP                                                                */
+/*  TEMPLATESVC_ProcessTemplates                                              */
 /*!
-    Set up a variable output stream for rendering variables to text
+    Process Templates
 
-    The SetupVarFP function sets up a shared memory buffer backed by an
-    output stream to allow us to render templates into a memory buffer,
-    so we can send them to a message queue.
+    The TEMPLATESVC_ProcessTemplates function looks up the trigger records
+    of the specified variable handle in the trigger index, and processes
+    each of them.  The trigger index is rebuilt first if templates have
+    been added or removed since it was built.
+    Triggered templates are marked dirty, and are rendered by the next
+    call to TEMPLATESVC_RenderTemplates.
 
     @param[in]
         pState
-            pointer to the Template Service State object to initialize
+            pointer to the template service state
 
-    @retval EOK the template rendering buffer was created
-    @retval EBADF failed to create the memory buffer
-    @retval EINVAL invalid arguments
+    @param[in]
+        hVar
+            variable handle to check against
+
+    @retval EOK - the templates were successfully processed
+    @retval EINVAL - invalid arguments
+    @retval other - processing one or more templates failed
 
 ==============================================================================*/
-static int SetupVarFP( TemplateSvcState *pState )
+int TEMPLATESVC_ProcessTemplates( TemplateSvcState *pState, VAR_HANDLE hVar )
 {
     int result = EINVAL;
-    char varfp_name[64];
-    time_t now;
-    int n;
-    size_t len = sizeof(varfp_name);
+    size_t first = 0;
+    size_t n;
+    size_t i;
+    int rc;
 
     if ( pState != NULL )
     {
-        result = EBADF;
+        result = EOK;
 
-        /* generate a temporary name for the VarFP */
-        now = time(NULL);
-        n = snprintf(varfp_name, sizeof(varfp_name), "templatesvc_%ld", now );
-        if ( ( n > 0 ) && ( (size_t)n < len ) )
+        /* invalidate any cached formatting of the variable */
+        VARCACHE_Modified( pState->pVarCache, hVar );
+
+        if ( pState->reindex == true )
         {
-            /* open a VarFP object for printing */
-            pState->pVarFP = VARFP_Open( varfp_name, pState->varfpSize );
-            if ( pState->pVarFP != NULL )
+            result = BuildIndex( pState );
+        }
+
+        n = TRIGINDEX_Find( pState->pTrigIndex, hVar, &first );
+        for ( i = first ; i < first + n ; i++ )
+        {
+            rc = ProcessTrigger( pState,
+                                 TRIGINDEX_Template( pState->pTrigIndex, i ),
+                                 TRIGINDEX_Trigger( pState->pTrigIndex, i ) );
+            if ( rc != EOK )
             {
-                /* get a file descriptor for the memory buffer */
-                pState->varFd = VARFP_GetFd( pState->pVarFP );
-                if ( pState->varFd != -1 )
-                {
-                    result = EOK;
-                }
+                result = rc;
             }
         }
     }
@@ -592,46 +1116,132 @@ static int SetupVarFP( TemplateSvcState *pState )
 }
 
 /*============================================================================*/
-/*  ProcessTemplates                                                          */
+/*  TEMPLATESVC_RenderTemplates                                               */
 /*!
-    Process Templates
-
-    The ProcessTemplates function iterates through all of the templates
-    checking if the specified variable handle is a trigger for any of them.
+    Render all dirty templates
+
+    The TEMPLATESVC_RenderTemplates function performs a render cycle.  Only
+    the templates of the dirty set, which are queued as they are
+    triggered, are visited, so the cost of a cycle does not grow with the
+    number of templates loaded.  First the union of the variables
+    referenced by the dirty templates is fetched, with each variable
+    being fetched exactly once into the per-cycle snapshot.  Then every
+    dirty template is rendered from that snapshot, so related outputs are
+    generated from a consistent set of values.  Scratch memory needed by
+    the renders is taken from the cycle arena, which is reset at the
+    start of each cycle, so once the templates are warm a cycle makes no
+    heap allocations.  The templates are rendered in tenant priority
+    order.  A template whose tenant has exceeded its render rate is
+    deferred, and is kept in the dirty set to be rendered in a later
+    cycle, which is scheduled if the service is attached to an event
+    loop.
 
     @param[in]
         pState
             pointer to the template service state
 
-    @param[in]
-        hVar
-            variable handle to check against
-
-    @retval EOK - the templates were successfully processed
+    @retval EOK - the templates were successfully rendered
     @retval EINVAL - invalid arguments
-    @retval other - processing one or more templates failed
+    @retval other - rendering one or more templates failed
 
 ==============================================================================*/
-static int ProcessTemplates( TemplateSvcState *pState, VAR_HANDLE hVar )
+int TEMPLATESVC_RenderTemplates( TemplateSvcState *pState )
 {
-    Template *pTemplate;
     int result = EINVAL;
+    Template *pTemplate;
+    uint64_t start;
+    uint64_t retryNs = 0;
+    uint64_t waitNs;
+    size_t count;
+    size_t kept = 0;
+    size_t i;
     int rc;
 
     if ( pState != NULL )
     {
         result = EOK;
 
-        pTemplate = pState->pTemplates;
-        while( pTemplate != NULL )
+        /* the scratch memory of the previous cycle is no longer used */
+        ARENA_Reset( pState->pCycleArena );
+
+        VARCACHE_BeginCycle( pState->pVarCache );
+
+        /* only the dirty set is visited, in render order */
+        count = pState->numDirty;
+        if ( count > 1 )
         {
-            rc = ProcessTemplate( pState, pTemplate, hVar );
-            if ( rc != EOK )
+            qsort( pState->ppDirty, count, sizeof( Template * ), CompareRank );
+        }
+
+        /* fetch the union of the referenced variables */
+        for ( i = 0 ; i < count ; i++ )
+        {
+            pTemplate = pState->ppDirty[i];
+            if ( ( ( pTemplate->dirty == true ) ||
+                   ( pTemplate->deferred == true ) ) &&
+                 ( AdmitRender( pState, pTemplate ) == false ) )
             {
-                result = rc;
+                /* retry once the tenant's rate limit allows it */
+                waitNs = 1000000000ULL /
+                         pTemplate->pTenant->maxRendersPerSec;
+                if ( ( retryNs == 0 ) || ( waitNs < retryNs ) )
+                {
+                    retryNs = waitNs;
+                }
             }
 
-            pTemplate = pTemplate->pNext;
+            if ( pTemplate->dirty == true )
+            {
+                if ( pTemplate->pMetrics != NULL )
+                {
+                    start = METRICS_Now();
+                    FetchTemplate( pState, pTemplate );
+                    pTemplate->fetchNs = METRICS_Now() - start;
+                }
+                else
+                {
+                    FetchTemplate( pState, pTemplate );
+                }
+            }
+        }
+
+        /* render the templates from the snapshot, and keep the deferred
+           templates for a later cycle */
+        for ( i = 0 ; i < count ; i++ )
+        {
+            pTemplate = pState->ppDirty[i];
+            if ( pTemplate->dirty == true )
+            {
+                pTemplate->dirty = false;
+                pTemplate->queued = false;
+
+                rc = OutputTemplate( pState, pTemplate );
+                if ( rc != EOK )
+                {
+                    result = rc;
+                }
+            }
+            else if ( pTemplate->deferred == true )
+            {
+                pState->ppDirty[kept++] = pTemplate;
+            }
+            else
+            {
+                pTemplate->queued = false;
+            }
+        }
+
+        /* keep any templates queued while the cycle was rendered */
+        for ( i = count ; i < pState->numDirty ; i++ )
+        {
+            pState->ppDirty[kept++] = pState->ppDirty[i];
+        }
+
+        pState->numDirty = kept;
+
+        if ( retryNs != 0 )
+        {
+            ScheduleRender( pState, retryNs );
         }
     }
 
@@ -639,78 +1249,203 @@ static int ProcessTemplates( TemplateSvcState *pState, VAR_HANDLE hVar )
 }
 
 /*============================================================================*/
-/*  ProcessTemplate                                                          */
+/*  TEMPLATESVC_RescanWildcards                                               */
 /*!
-    Process a template
+    Expand the wildcard triggers to newly created variables
 
-    The ProcessTemplate function iterates through all of the trigger variables
-    associated with the template to see if any match the specified variable
-    handle.  If a match is found, the template is printed using the
-    PrintTemplate function.
+    The variable server does not notify the service when a variable is
+    created, so the TEMPLATESVC_RescanWildcards function queries it again
+    for the variables matching each wildcard trigger.  A matching
+    variable which does not already trigger the template is added to its
+    triggers, and its notification is requested.  The rescan runs
+    periodically while the service is attached to an event loop, and
+    after each reload.
 
     @param[in]
         pState
             pointer to the template service state
 
-    @param[in]
-        pTemplate
-            pointer to the template to process
+    @retval number of trigger variables added
+
+==============================================================================*/
+size_t TEMPLATESVC_RescanWildcards( TemplateSvcState *pState )
+{
+    Template *pTemplate;
+    TriggerVar *pTrigger;
+    size_t added = 0;
+    size_t before;
+    size_t i;
+
+    if ( pState != NULL )
+    {
+        if ( pState->reindex == true )
+        {
+            /* the index tells which variables already trigger a template */
+            (void)BuildIndex( pState );
+        }
+
+        for ( pTemplate = pState->pTemplates ;
+              pTemplate != NULL ;
+              pTemplate = pTemplate->pNext )
+        {
+            before = pTemplate->numTriggers;
+
+            for ( i = 0 ; i < pTemplate->numWildcards ; i++ )
+            {
+                (void)ExpandWildcard( pState,
+                                      pTemplate,
+                                      &pTemplate->pWildcards[i] );
+            }
+
+            if ( pTemplate->numTriggers > before )
+            {
+                (void)SetupTriggerNotifications(
+                            pState->hVarServer,
+                            pState->pVarCache,
+                            &pTemplate->pTriggers[before],
+                            pTemplate->numTriggers - before );
+
+                /* record the initial values of the conditional triggers */
+                for ( i = before ; i < pTemplate->numTriggers ; i++ )
+                {
+                    pTrigger = &pTemplate->pTriggers[i];
+                    if ( pTrigger->condition != TRIGGER_ALWAYS )
+                    {
+                        (void)CheckCondition( pState, pTrigger );
+                    }
+                }
+
+                added += pTemplate->numTriggers - before;
+            }
+        }
+
+        if ( added > 0 )
+        {
+            /* the trigger arrays may have moved */
+            pState->reindex = true;
+
+            LOGGER_Log( LOGGER_INFO,
+                        "Added %zu wildcard trigger variables",
+                        added );
+        }
+    }
+
+    return added;
+}
+
+/*============================================================================*/
+/*  TEMPLATESVC_ResolvePending                                                */
+/*!
+    Retry the variables which have not been found
+
+    Variables are often created after the service has started, so a
+    trigger, commit variable, output variable or template reference
+    which is not found when its template is set up is kept pending
+    rather than discarded.  The TEMPLATESVC_ResolvePending function
+    looks each pending variable up again, and activates the ones which
+    now exist: a trigger's notification is requested, and a template
+    reference is rendered from its value.  While the service is attached
+    to an event loop, the pending variables are retried in the
+    background, with a backoff, until all of them are found.
 
     @param[in]
-        hVar
-            variable handle to check against
+        pState
+            pointer to the template service state
 
-    @retval EOK - the template was successfully processed
-    @retval EINVAL - invalid arguments
-    @retval other - template processing failed
+    @retval number of variables still pending
 
 ==============================================================================*/
-static int ProcessTemplate( TemplateSvcState *pState,
-                            Template *pTemplate,
-                            VAR_HANDLE hVar )
+size_t TEMPLATESVC_ResolvePending( TemplateSvcState *pState )
 {
-    TriggerVar *pTriggerVar;
-    int result = EINVAL;
+    Template *pTemplate;
+    CompiledTemplate *pCompiled;
+    TriggerVar *pVar;
+    size_t pending = 0;
+    size_t resolved = 0;
+    size_t before;
+    size_t after;
+    size_t i;
 
-    if ( ( pState != NULL ) &&
-         ( pTemplate != NULL ) &&
-         ( hVar != VAR_INVALID ) )
+    if ( pState != NULL )
     {
-        pTriggerVar = pTemplate->pTriggers;
-        while( pTriggerVar != NULL )
+        for ( pTemplate = pState->pTemplates ;
+              pTemplate != NULL ;
+              pTemplate = pTemplate->pNext )
         {
-            if ( pTriggerVar->hVar == hVar )
-            {
-                switch( pTemplate->type )
-                {
-                    case TMPL_FD:
-                        result = PrintTemplateFD( pState, pTemplate );
-                        break;
+            resolved += ResolveTriggers( pState,
+                                         pTemplate->pTriggers,
+                                         pTemplate->numTriggers,
+                                         &pending );
 
-                    case TMPL_MQ:
-                        result = PrintTemplateMQ( pState, pTemplate );
-                        break;
+            if ( pTemplate->pCommit != NULL )
+            {
+                resolved += ResolveTriggers( pState,
+                                             pTemplate->pCommit,
+                                             1,
+                                             &pending );
+            }
 
-                    default:
-                        result = ENOTSUP;
-                        break;
+            for ( i = 0 ; i < pTemplate->numVars ; i++ )
+            {
+                pVar = &pTemplate->pVars[i];
+                if ( pVar->pEntry == NULL )
+                {
+                    pVar->pEntry = VARCACHE_Lookup( pState->pVarCache,
+                                                    pState->hVarServer,
+                                                    pVar->name );
+                    if ( pVar->pEntry != NULL )
+                    {
+                        pVar->hVar = pVar->pEntry->hVar;
+                        resolved++;
+                    }
+                    else
+                    {
+                        pending++;
+                    }
                 }
             }
 
-            pTriggerVar = pTriggerVar->pNext;
+            pCompiled = pTemplate->pCompiled;
+            before = UnresolvedRefs( pCompiled );
+            if ( before > 0 )
+            {
+                (void)RENDER_Resolve( pState->hVarServer,
+                                      pState->pVarCache,
+                                      pCompiled );
+                after = UnresolvedRefs( pCompiled );
+                resolved += before - after;
+                pending += after;
+            }
+        }
+
+        if ( resolved > 0 )
+        {
+            /* index the triggers which were found */
+            pState->reindex = true;
+
+            LOGGER_Log( LOGGER_INFO,
+                        "Found %zu variables, %zu still pending",
+                        resolved,
+                        pending );
         }
+
+        pState->unresolved = pending;
     }
 
-    return result;
+    return pending;
 }
 
 /*============================================================================*/
-/*  PrintTemplateFD                                                           */
+/*  TEMPLATESVC_PrintTemplateFD                                               */
 /*!
     Print a template to a file descriptor
 
-    The PrintTemplateFD function renders the template file to the specified
-    output stream.
+    The TEMPLATESVC_PrintTemplateFD function renders the compiled template
+    into the VARFP buffer and writes it to the specified output stream.  If the
+    rendered output does not fit in the VARFP buffer, the template file
+    is streamed directly to the output by the variable server instead.
+    The template is rendered from the variable snapshot of the current
+    render cycle, so its variables must have been fetched first.
 
     @param[in]
        pState
@@ -724,13 +1459,14 @@ static int ProcessTemplate( TemplateSvcState *pState,
     @retval EINVAL - invalid arguments
 
 ==============================================================================*/
-static int PrintTemplateFD( TemplateSvcState *pState, Template *pTemplate )
+int TEMPLATESVC_PrintTemplateFD( TemplateSvcState *pState, Template *pTemplate )
 {
     int result = EINVAL;
     int fd;
     char *pTemplateFile;
     char *pTarget;
-    int flags = O_WRONLY | O_CREAT;
+    char *pData;
+    size_t len;
 
     if ( ( pState != NULL ) &&
          ( pTemplate != NULL ) )
@@ -743,39 +1479,46 @@ static int PrintTemplateFD( TemplateSvcState *pState, Template *pTemplate )
         if ( ( pTemplateFile != NULL ) &&
              ( pTarget != NULL ) )
         {
-            printf("Printing template %s\n", pTemplateFile );
+            LOGGER_Log( LOGGER_DEBUG, "Printing template %s", pTemplateFile );
 
-            /* open input template */
-            fd = open( pTemplateFile, O_RDONLY );
+            result = RenderTemplate( pState, pTemplate, &pData, &len );
+            if ( ( result == EOK ) &&
+                 ( pTemplate->pCompressor != NULL ) )
+            {
+                result = CompressOutput( pState, pTemplate, &pData, &len );
+            }
 
             if ( pTemplate->fd == -1 )
             {
-                if ( pTemplate->append )
-                {
-                    flags |= O_APPEND;
-                }
-
                 /* open output stream */
-                pTemplate->fd = open( pTarget, flags );
+                OpenTarget( pState, pTemplate );
             }
 
-            if ( ( fd > 0 ) &&
-                 ( pTemplate->fd > 0 ) )
+            if ( pTemplate->fd > 0 )
             {
-                result = TEMPLATE_FileToFile( pState->hVarServer,
-                                              fd,
-                                              pTemplate->fd );
-
-                if ( pTemplate->keep_open == false )
+                if ( result == EOK )
                 {
-                    close( pTemplate->fd );
-                    pTemplate->fd = -1;
+                    result = WriteTarget( pState, pTemplate, pData, len );
+                }
+                else if ( ( result == E2BIG ) &&
+                          ( pTemplate->pCompressor == NULL ) )
+                {
+                    /* too big for the render buffer, so stream it */
+                    fd = open( pTemplateFile, O_RDONLY );
+                    if ( fd > 0 )
+                    {
+                        result = TEMPLATE_FileToFile( pState->hVarServer,
+                                                      fd,
+                                                      pTemplate->fd );
+                        close( fd );
+                    }
                 }
-            }
 
-            if ( fd > 0 )
+                CloseTarget( pTemplate );
+            }
+            else if ( result == EOK )
             {
-                close( fd );
+                result = ENOENT;
             }
         }
     }
@@ -784,12 +1527,14 @@ static int PrintTemplateFD( TemplateSvcState *pState, Template *pTemplate )
 }
 
 /*============================================================================*/
-/*  PrintTemplateMQ                                                           */
+/*  TEMPLATESVC_PrintTemplateMQ                                               */
 /*!
-    Print a template to a file descriptor
+    Print a template to a message queue
 
-    The PrintTemplateMQ function renders the template file to the VARFP
-    buffer and then sends the output to the assocated message queue.
+    The TEMPLATESVC_PrintTemplateMQ function renders the compiled template
+    to the VARFP buffer and then sends the output to the assocated message
+    queue.  The template is rendered from the variable snapshot of the
+    current render cycle, so its variables must have been fetched first.
 
     @param[in]
        pState
@@ -803,16 +1548,13 @@ static int PrintTemplateFD( TemplateSvcState *pState, Template *pTemplate )
     @retval EINVAL - invalid arguments
 
 ==============================================================================*/
-static int PrintTemplateMQ( TemplateSvcState *pState, Template *pTemplate )
+int TEMPLATESVC_PrintTemplateMQ( TemplateSvcState *pState, Template *pTemplate )
 {
     int result = EINVAL;
-    int fd;
     char *pTemplateFile;
     char *pTarget;
-    int flags = O_WRONLY | O_CREAT;
     char *pData;
     size_t n;
-    int rc;
 
     if ( ( pState != NULL ) &&
          ( pTemplate != NULL ) )
@@ -827,58 +1569,19 @@ static int PrintTemplateMQ( TemplateSvcState *pState, Template *pTemplate )
              ( pTemplateFile != NULL ) &&
              ( pTarget != NULL ) )
         {
-            printf("Printing template %s\n", pTemplateFile );
-
-            /* open input template */
-            fd = open( pTemplateFile, O_RDONLY );
+            LOGGER_Log( LOGGER_DEBUG, "Printing template %s", pTemplateFile );
 
-            if ( fd > 0 )
+            result = RenderTemplate( pState, pTemplate, &pData, &n );
+            if ( ( result == EOK ) &&
+                 ( pTemplate->pCompressor != NULL ) )
             {
-                lseek( pState->varFd, 0, SEEK_SET );
-
-                result = TEMPLATE_FileToFile( pState->hVarServer,
-                                              fd,
-                                              pState->varFd );
-
-                if ( result == EOK )
-                {
-                    if ( pTemplate->mq <= 0 )
-                    {
-                        pTemplate->mq = mq_open( pTemplate->target, O_WRONLY );
-                    }
-
-                    if ( pTemplate->mq > 0 )
-                    {
-                        /* get a handle to the output buffer */
-                        pData = VARFP_GetData( pState->pVarFP );
-                        if( pData != NULL )
-                        {
-                            /* send the messsage */
-                            rc = mq_send( pTemplate->mq,
-                                          pData,
-                                          strlen(pData ),
-                                          0 );
-
-                            result = ( rc != 0 ) ? errno : EOK;
-
-                            if ( ( result != EOK ) ||
-                                 ( pTemplate->keep_open == false ) )
-                            {
-                                mq_close( pTemplate->mq );
-                                pTemplate->mq = -1;
-                            }
-                        }
-                    }
-                    else
-                    {
-                        result = EBADF;
-                    }
-                }
+                result = CompressOutput( pState, pTemplate, &pData, &n );
             }
 
-            if ( fd > 0 )
+            if ( result == EOK )
             {
-                close( fd );
+                /* send the message */
+                result = DeliverOutput( pState, pTemplate, pData, n );
             }
         }
     }
@@ -887,160 +1590,5854 @@ static int PrintTemplateMQ( TemplateSvcState *pState, Template *pTemplate )
 }
 
 /*============================================================================*/
-/*  usage                                                                     */
+/*  TEMPLATESVC_Close                                                         */
 /*!
-    Display the application usage
+    Close the template service
 
-    The usage function dumps the application usage message
-    to stderr.
+    The TEMPLATESVC_Close function closes the connection with the variable
+    server, cleans up the VARFP shared memory, flushes the trigger
+    capture file, deletes the templates, closing their targets and
+    detaching them from the event loop, and deletes the variable cache,
+    trigger index, string table and arenas.  The state may be set up
+    again with TEMPLATESVC_Init.
 
     @param[in]
-       cmdname
-            pointer to the invoked command name
-
-    @return none
+        pState
+            pointer to the template service state
 
 ==============================================================================*/
-static void usage( char *cmdname )
+void TEMPLATESVC_Close( TemplateSvcState *pState )
 {
-    if( cmdname != NULL )
+    if ( pState != NULL )
     {
-        fprintf(stderr,
-                "usage: %s [-v] [-s size] [-h] -f filename\n"
-                " [-h] : display this help\n"
-                " [-v] : verbose output\n"
-                " [-s] : max message size (for mq targets)\n"
-                " -f <filename> : configuration file\n",
-                cmdname );
-    }
-}
+        if ( ( pState->hVarServer != NULL ) &&
+             ( VARSERVER_Close( pState->hVarServer ) == EOK ) )
+        {
+            pState->hVarServer = NULL;
+        }
 
-/*============================================================================*/
-/*  ProcessOptions                                                            */
-/*!
-    Process the command line options
+        /* the templates are not rendered again */
+        free( pState->ppDirty );
+        pState->ppDirty = NULL;
+        pState->numDirty = 0;
+        pState->dirtySize = 0;
 
-    The ProcessOptions function processes the command line options and
-    populates the TemplateSvcState object
+        if ( pState->pRegistrar != NULL )
+        {
+            /* close the variable registration connections */
+            VARREG_Delete( pState->pRegistrar );
+            pState->pRegistrar = NULL;
+        }
 
-    @param[in]
-        argC
-            number of arguments
-            (including the command itself)
+        if ( pState->pVarFP != NULL )
+        {
+            /* close the output memory buffer */
+            VARFP_Close( pState->pVarFP );
+            pState->pVarFP = NULL;
+        }
 
-    @param[in]
-        argv
-            array of pointers to the command line arguments
+        if ( pState->pFetchFP != NULL )
+        {
+            /* close the fetch scratch buffer */
+            VARFP_Close( pState->pFetchFP );
+            pState->pFetchFP = NULL;
+        }
 
-    @param[in]
-        pState
-            pointer to the TemplateSvc state object
+        if ( pState->pCapture != NULL )
+        {
+            /* flush and close the trigger capture */
+            VARCACHE_SetCapture( pState->pVarCache, NULL );
+            CAPTURE_Close( pState->pCapture );
+            pState->pCapture = NULL;
+        }
+        if ( pState->pTicker != NULL )
+        {
+            /* stop the periodic renders */
+            EVENTLOOP_DeleteTimer( pState->pEventLoop, pState->pTicker );
+            pState->pTicker = NULL;
+        }
 
-    @return always 0
+        if ( pState->pRetryTimer != NULL )
+        {
+            /* stop retrying the deferred renders */
+            EVENTLOOP_DeleteTimer( pState->pEventLoop, pState->pRetryTimer );
+            pState->pRetryTimer = NULL;
+        }
+
+        if ( pState->pRescanTimer != NULL )
+        {
+            /* stop rescanning the wildcard triggers */
+            EVENTLOOP_DeleteTimer( pState->pEventLoop, pState->pRescanTimer );
+            pState->pRescanTimer = NULL;
+        }
+
+        if ( pState->pResolveTimer != NULL )
+        {
+            /* stop retrying the variables which were not found */
+            EVENTLOOP_DeleteTimer( pState->pEventLoop, pState->pResolveTimer );
+            pState->pResolveTimer = NULL;
+            pState->resolveDelayMs = 0;
+        }
+
+        /* close the targets and detach the templates from the event loop */
+        DeleteTemplates( pState );
+        pState->pEventLoop = NULL;
+
+        if ( pState->pTrigIndex != NULL )
+        {
+            TRIGINDEX_Delete( pState->pTrigIndex );
+            pState->pTrigIndex = NULL;
+        }
+
+        if ( pState->pVarCache != NULL )
+        {
+            VARCACHE_Delete( pState->pVarCache );
+            pState->pVarCache = NULL;
+        }
+
+        if ( pState->pStrings != NULL )
+        {
+            STRTAB_Delete( pState->pStrings );
+            pState->pStrings = NULL;
+        }
+
+        if ( pState->pCycleArena != NULL )
+        {
+            ARENA_Delete( pState->pCycleArena );
+            pState->pCycleArena = NULL;
+        }
+
+        if ( pState->pArena != NULL )
+        {
+            /* release the objects set up with the templates */
+            ARENA_Delete( pState->pArena );
+            pState->pArena = NULL;
+        }
+
+        if ( pState->pNewConfCache != NULL )
+        {
+            /* discard a configuration cache left partially built */
+            CONFCACHE_Close( pState->pNewConfCache );
+            pState->pNewConfCache = NULL;
+        }
+
+        if ( pState->pConfCache != NULL )
+        {
+            /* unmap the configuration cache */
+            CONFCACHE_Close( pState->pConfCache );
+            pState->pConfCache = NULL;
+        }
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  ParseDefinition                                                           */
+/*!
+    Parse a template definition
+
+    The ParseDefinition function reads the attributes of a template
+    definition object (see TEMPLATESVC_SetupTemplate).  The strings of
+    the definition refer to the JSON configuration, and the trigger and
+    variable arrays must be freed with CONFCACHE_FreeDefinition.
+
+    @param[in]
+       pNode
+            pointer to the template definition node
+
+    @param[out]
+        pDef
+            pointer to the template definition to populate
+
+    @retval EOK - the template definition was parsed
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int ParseDefinition( JNode *pNode, ConfTemplate *pDef )
+{
+    int result = EINVAL;
+    int interval = 0;
+    char *trigger;
+
+    if ( ( pNode != NULL ) &&
+         ( pDef != NULL ) )
+    {
+        memset( pDef, 0, sizeof( ConfTemplate ) );
+
+        pDef->name = JSON_GetStr( pNode, "name" );
+        pDef->template = JSON_GetStr( pNode, "template" );
+        pDef->type = JSON_GetStr( pNode, "type" );
+        pDef->target = JSON_GetStr( pNode, "target" );
+        pDef->compress = JSON_GetStr( pNode, "compress" );
+        pDef->format = JSON_GetStr( pNode, "format" );
+        pDef->prefix = JSON_GetStr( pNode, "prefix" );
+        pDef->commit = JSON_GetStr( pNode, "commit" );
+        pDef->append = JSON_GetBool( pNode, "append" );
+        pDef->keep_open = JSON_GetBool( pNode, "keep_open" );
+        pDef->incremental = JSON_GetBool( pNode, "incremental" );
+        pDef->nativeFormat = JSON_GetBool( pNode, "native_format" );
+
+        (void)JSON_GetNum( pNode, "interval_ms", &interval );
+        pDef->intervalMs = ( interval > 0 ) ? (uint32_t)interval : 0;
+
+        trigger = JSON_GetStr( pNode, "trigger" );
+        pDef->autoTrigger = ( trigger != NULL ) &&
+                            ( strcmp( trigger, AUTO_TRIGGER ) == 0 );
+
+        (void)JSON_Iterate( (JArray *)JSON_Find( pNode, "trigger" ),
+                            ParseTrigger,
+                            (void *)pDef );
+
+        (void)JSON_Iterate( (JArray *)JSON_Find( pNode, "vars" ),
+                            ParseVar,
+                            (void *)pDef );
+
+        (void)JSON_Iterate( (JArray *)JSON_Find( pNode, "exclude" ),
+                            ParseExclude,
+                            (void *)pDef );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ParseTrigger                                                              */
+/*!
+    Parse a trigger of a template definition
+
+    The ParseTrigger function is a callback function for the JSON_Iterate
+    function which appends a trigger to a template definition.  Each
+    trigger is either a variable name, or an object naming the variable
+    and the condition under which its notifications trigger a render:
+
+    { "var" : "/sys/test/a", "on" : "change" }
+    { "var" : "/sys/test/a", "deadband" : 0.5 }
+    { "var" : "/sys/test/a", "rising_above" : 80 }
+    { "var" : "/sys/test/a", "falling_below" : 20 }
+
+    @param[in]
+       pNode
+            pointer to a JSON node which should be a string or an object
+
+    @param[in]
+        arg
+            opaque pointer argument used for the template definition
+
+    @retval EOK - the trigger was added
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - the node is not a trigger
+
+==============================================================================*/
+static int ParseTrigger( JNode *pNode, void *arg )
+{
+    ConfTemplate *pDef = (ConfTemplate *)arg;
+    ConfTrigger *pTriggers;
+    ConfTrigger *pTrigger;
+    char *name = ItemName( pNode );
+    int result = EINVAL;
+
+    if ( ( name != NULL ) && ( pDef != NULL ) )
+    {
+        pTriggers = realloc( pDef->pTriggers,
+                             ( pDef->numTriggers + 1 ) *
+                             sizeof( ConfTrigger ) );
+        if ( pTriggers != NULL )
+        {
+            pDef->pTriggers = pTriggers;
+            pTrigger = &pTriggers[pDef->numTriggers++];
+            memset( pTrigger, 0, sizeof( ConfTrigger ) );
+            pTrigger->name = name;
+
+            if ( pNode->type == JSON_OBJECT )
+            {
+                ParseTriggerCondition( pNode, pTrigger );
+            }
+
+            result = EOK;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ParseVar                                                                  */
+/*!
+    Parse a structured output variable of a template definition
+
+    The ParseVar function is a callback function for the JSON_Iterate
+    function which appends a variable name, or an object naming a
+    variable, to the structured output variables of a template
+    definition.
+
+    @param[in]
+       pNode
+            pointer to a JSON node which should be a string or an object
+
+    @param[in]
+        arg
+            opaque pointer argument used for the template definition
+
+    @retval EOK - the variable was added
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - the node is not a variable
+
+==============================================================================*/
+static int ParseVar( JNode *pNode, void *arg )
+{
+    ConfTemplate *pDef = (ConfTemplate *)arg;
+    char **pVars;
+    char *name = ItemName( pNode );
+    int result = EINVAL;
+
+    if ( ( name != NULL ) && ( pDef != NULL ) )
+    {
+        pVars = realloc( pDef->pVars,
+                         ( pDef->numVars + 1 ) * sizeof( char * ) );
+        if ( pVars != NULL )
+        {
+            pDef->pVars = pVars;
+            pVars[pDef->numVars++] = name;
+            result = EOK;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ParseExclude                                                              */
+/*!
+    Parse an excluded variable of a template definition
+
+    The ParseExclude function is a callback function for the JSON_Iterate
+    function which appends a variable name to the variables excluded
+    from the derived triggers of a template definition.
+
+    @param[in]
+       pNode
+            pointer to a JSON node which should be a string or an object
+
+    @param[in]
+        arg
+            opaque pointer argument used for the template definition
+
+    @retval EOK - the variable was added
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - the node is not a variable
+
+==============================================================================*/
+static int ParseExclude( JNode *pNode, void *arg )
+{
+    ConfTemplate *pDef = (ConfTemplate *)arg;
+    char **pExclude;
+    char *name = ItemName( pNode );
+    int result = EINVAL;
+
+    if ( ( name != NULL ) && ( pDef != NULL ) )
+    {
+        pExclude = realloc( pDef->pExclude,
+                            ( pDef->numExclude + 1 ) * sizeof( char * ) );
+        if ( pExclude != NULL )
+        {
+            pDef->pExclude = pExclude;
+            pExclude[pDef->numExclude++] = name;
+            result = EOK;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ItemName                                                                  */
+/*!
+    Get the variable name of a trigger or variable list item
+
+    @param[in]
+       pNode
+            pointer to a variable name, or an object with a "var" attribute
+
+    @retval pointer to the variable name
+    @retval NULL if the item does not name a variable
+
+==============================================================================*/
+static char *ItemName( JNode *pNode )
+{
+    char *name = NULL;
+    JVar *pVar;
+
+    if ( pNode != NULL )
+    {
+        if ( pNode->type == JSON_VAR )
+        {
+            pVar = (JVar *)pNode;
+            if ( pVar->var.type == JVARTYPE_STR )
+            {
+                name = pVar->var.val.str;
+            }
+        }
+        else if ( pNode->type == JSON_OBJECT )
+        {
+            name = JSON_GetStr( pNode, "var" );
+        }
+    }
+
+    return name;
+}
+
+/*============================================================================*/
+/*  ParseTriggerCondition                                                     */
+/*!
+    Parse the condition of a trigger
+
+    The ParseTriggerCondition function reads the optional condition of
+    a trigger object.  Triggers without a condition render on every
+    notification.
+
+    @param[in]
+       pNode
+            pointer to the trigger object
+
+    @param[in]
+        pTrigger
+            pointer to the trigger definition to populate
+
+==============================================================================*/
+static void ParseTriggerCondition( JNode *pNode, ConfTrigger *pTrigger )
+{
+    char *on = JSON_GetStr( pNode, "on" );
+
+    if ( GetLevel( pNode, "deadband", &pTrigger->level ) == EOK )
+    {
+        pTrigger->condition = TRIGGER_DEADBAND;
+    }
+    else if ( GetLevel( pNode, "rising_above", &pTrigger->level ) == EOK )
+    {
+        pTrigger->condition = TRIGGER_RISING_ABOVE;
+    }
+    else if ( GetLevel( pNode, "falling_below", &pTrigger->level ) == EOK )
+    {
+        pTrigger->condition = TRIGGER_FALLING_BELOW;
+    }
+    else if ( ( on != NULL ) && ( strcmp( on, "change" ) == 0 ) )
+    {
+        pTrigger->condition = TRIGGER_CHANGE;
+    }
+    else if ( ( on != NULL ) && ( strcmp( on, "always" ) != 0 ) )
+    {
+        LOGGER_Log( LOGGER_ERROR,
+                    "Unsupported trigger condition: %s",
+                    on );
+    }
+}
+
+/*============================================================================*/
+/*  CreateTemplate                                                            */
+/*!
+    Create a triggered template from its definition
+
+    The CreateTemplate function sets up a template from a parsed, or
+    cached, template definition, requests the notifications of its
+    triggers, and adds it to the template list.  The template refers to
+    the strings of the definition, so they must outlive the template.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pDef
+            pointer to the template definition
+
+    @param[in]
+        pCompiled
+            template file compiled ahead of time, which is owned by the
+            template from now on, or NULL to compile the template file
+
+    @retval EOK - the template was set up successfully
+    @retval ENOTSUP - the output compression is not supported
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int CreateTemplate( TemplateSvcState *pState,
+                           ConfTemplate *pDef,
+                           CompiledTemplate *pCompiled )
+{
+    VARSERVER_HANDLE hVarServer = pState->hVarServer;
+    Template *pTemplate = NULL;
+    Compressor *pCompressor = NULL;
+    TriggerVar *pTrigger;
+    int result = ENOSPC;
+    size_t i;
+
+    if ( TenantFull( pState->pTenant ) == true )
+    {
+        LOGGER_Log( LOGGER_ERROR,
+                    "Tenant %s is limited to %" PRIu32 " templates",
+                    pState->pTenant->name,
+                    pState->pTenant->maxTemplates );
+    }
+    else
+    {
+        result = EOK;
+        if ( pDef->compress != NULL )
+        {
+            /* set up the output compressor */
+            pCompressor = COMPRESS_Create(
+                                COMPRESS_TypeFromName( pDef->compress ) );
+            if ( pCompressor == NULL )
+            {
+                /* never fall back to writing the output uncompressed */
+                LOGGER_Log( LOGGER_ERROR,
+                            "Unsupported compression %s for template %s",
+                            pDef->compress,
+                            TemplateName( pDef ) );
+                result = ENOTSUP;
+            }
+        }
+    }
+
+    if ( result == EOK )
+    {
+        /* allocate memory for the template */
+        result = ENOMEM;
+        pTemplate = calloc( 1, sizeof( Template ) );
+    }
+
+    if( pTemplate != NULL )
+    {
+        /* the definition's strings only live as long as the configuration */
+        pTemplate->templateFileName = STRTAB_Intern( pState->pStrings,
+                                                     pDef->template );
+        pTemplate->append = pDef->append;
+        pTemplate->keep_open = pDef->keep_open;
+        pTemplate->incremental = pDef->incremental;
+        pTemplate->nativeFormat = pDef->nativeFormat;
+        pTemplate->intervalMs = pDef->intervalMs;
+        pTemplate->target = STRTAB_Intern( pState->pStrings, pDef->target );
+        pTemplate->fd = -1;
+        pTemplate->type = ( ( pDef->type != NULL ) &&
+                            ( strcmp( pDef->type, "mq" ) == 0 ) ) ? TMPL_MQ
+                                                                  : TMPL_FD;
+        pTemplate->name = STRTAB_Intern( pState->pStrings,
+                                         TemplateName( pDef ) );
+        pTemplate->pSignature = TemplateSignature( pDef );
+
+        if ( ( pState->pMetricsPrefix != NULL ) &&
+             ( pTemplate->name != NULL ) )
+        {
+            /* publish the render metrics for this template */
+            pTemplate->pMetrics = METRICS_Create( hVarServer,
+                                                  pState->pMetricsPrefix,
+                                                  pTemplate->name,
+                                                  pDef->compress != NULL );
+        }
+
+        if ( pCompressor != NULL )
+        {
+            /* the template owns the output compressor */
+            pTemplate->compress = COMPRESS_TypeFromName( pDef->compress );
+            pTemplate->pCompressor = pCompressor;
+        }
+
+        pTemplate->format = FormatFromName( pDef->format );
+        if ( pTemplate->format != FMT_TEXT )
+        {
+            /* set up the structured output variables */
+            SetupOutputVars( pState, pDef, pTemplate );
+        }
+        else if ( ( pCompiled != NULL ) ||
+                  ( RENDER_Compile( pDef->template, &pCompiled ) == EOK ) )
+        {
+            /* resolve the template variable references */
+            pTemplate->pCompiled = pCompiled;
+            pTemplate->pCompiled->incremental = pDef->incremental;
+            pTemplate->pCompiled->nativeFormat = pDef->nativeFormat;
+            RENDER_Resolve( hVarServer,
+                            pState->pVarCache,
+                            pTemplate->pCompiled );
+        }
+
+        /* set up the triggers */
+        if ( SetupTriggers( pState, pTemplate, pDef ) == EOK )
+        {
+            (void)SetupTriggerNotifications( hVarServer,
+                                             pState->pVarCache,
+                                             pTemplate->pTriggers,
+                                             pTemplate->numTriggers );
+        }
+
+        if ( pDef->commit != NULL )
+        {
+            /* set up the transaction commit trigger */
+            SetupCommit( pState, pTemplate, pDef->commit );
+        }
+
+        /* record the initial values of the conditional triggers */
+        for ( i = 0 ; i < pTemplate->numTriggers ; i++ )
+        {
+            pTrigger = &pTemplate->pTriggers[i];
+            if ( pTrigger->condition != TRIGGER_ALWAYS )
+            {
+                (void)CheckCondition( pState, pTrigger );
+            }
+        }
+
+        /* insert the template definition, ahead of the others in the
+           render order until the templates are sorted */
+        pTemplate->pState = pState;
+        pTemplate->rank = ( pState->pTemplates != NULL )
+                          ? pState->pTemplates->rank - 1
+                          : 0;
+        pTemplate->pNext = pState->pTemplates;
+        pState->pTemplates = pTemplate;
+
+        pTemplate->pTenant = pState->pTenant;
+        if ( pTemplate->pTenant != NULL )
+        {
+            pTemplate->pTenant->templates++;
+        }
+
+        /* index the new triggers before the next dispatch */
+        pState->reindex = true;
+
+        result = EOK;
+    }
+    else
+    {
+        COMPRESS_Delete( pCompressor );
+        RENDER_Free( pCompiled );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  FormatFromName                                                            */
+/*!
+    Get the output format of a template definition
+
+    @param[in]
+        format
+            structured output format name (or NULL)
+
+    @retval FMT_JSONL - JSON Lines output
+    @retval FMT_CBOR - CBOR output
+    @retval FMT_TEXT - output rendered from a template file
+
+==============================================================================*/
+static OutputFormat FormatFromName( const char *format )
+{
+    OutputFormat result = FMT_TEXT;
+
+    if ( format != NULL )
+    {
+        if ( strcmp( format, "jsonl" ) == 0 )
+        {
+            result = FMT_JSONL;
+        }
+        else if ( strcmp( format, "cbor" ) == 0 )
+        {
+            result = FMT_CBOR;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupTriggers                                                             */
+/*!
+    Set up the triggers of a template
+
+    The SetupTriggers function creates the template's array of trigger
+    records, with one record for each trigger of the template definition.
+    A trigger whose name ends in '*' is a wildcard: it is kept as a
+    pattern, and a trigger record is created for each variable whose
+    name starts with the text before the '*'.  If the trigger attribute
+    is "auto", the trigger records are derived from the variables which
+    the template references instead.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            pointer to the template
+
+    @param[in]
+        pDef
+            pointer to the template definition
+
+    @retval EOK - the triggers were set up
+    @retval ENOENT - the template has no triggers
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int SetupTriggers( TemplateSvcState *pState,
+                          Template *pTemplate,
+                          ConfTemplate *pDef )
+{
+    int result = ENOENT;
+    TriggerVar *pTriggerVar;
+    size_t numWildcards = 0;
+    size_t i;
+
+    for ( i = 0 ; i < pDef->numTriggers ; i++ )
+    {
+        if ( IsWildcard( pDef->pTriggers[i].name ) == true )
+        {
+            numWildcards++;
+        }
+    }
+
+    if ( pDef->numTriggers > numWildcards )
+    {
+        /* allocate the trigger records in one block */
+        pTemplate->pTriggers = calloc( pDef->numTriggers - numWildcards,
+                                       sizeof( TriggerVar ) );
+        result = ( pTemplate->pTriggers != NULL ) ? EOK : ENOMEM;
+    }
+
+    if ( ( result != ENOMEM ) && ( numWildcards > 0 ) )
+    {
+        pTemplate->pWildcards = calloc( numWildcards, sizeof( TriggerVar ) );
+        result = ( pTemplate->pWildcards != NULL ) ? EOK : ENOMEM;
+    }
+
+    for ( i = 0 ; ( result == EOK ) && ( i < pDef->numTriggers ) ; i++ )
+    {
+        /* populate the trigger record, or the wildcard pattern */
+        pTriggerVar = ( IsWildcard( pDef->pTriggers[i].name ) == true )
+                      ? &pTemplate->pWildcards[pTemplate->numWildcards++]
+                      : &pTemplate->pTriggers[pTemplate->numTriggers++];
+        pTriggerVar->name = STRTAB_Intern( pState->pStrings,
+                                           pDef->pTriggers[i].name );
+        pTriggerVar->hVar = VAR_INVALID;
+        pTriggerVar->condition =
+            (TriggerCondition)pDef->pTriggers[i].condition;
+        pTriggerVar->level = pDef->pTriggers[i].level;
+    }
+
+    for ( i = 0 ; ( result == EOK ) && ( i < pTemplate->numWildcards ) ; i++ )
+    {
+        /* add a trigger record for each matching variable */
+        result = ExpandWildcard( pState,
+                                 pTemplate,
+                                 &pTemplate->pWildcards[i] );
+    }
+
+    if ( pDef->autoTrigger == true )
+    {
+        /* add a trigger record for each referenced variable */
+        pTemplate->autoTrigger = true;
+        result = SetupExclude( pState, pTemplate, pDef );
+        if ( result == EOK )
+        {
+            result = DeriveTriggers( pState, pTemplate );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CacheDefinition                                                           */
+/*!
+    Add a template definition to the configuration cache being built
+
+    If the definition cannot be added, the cache is abandoned, so an
+    incomplete cache is never written.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pDef
+            pointer to the template definition
+
+==============================================================================*/
+static void CacheDefinition( TemplateSvcState *pState, ConfTemplate *pDef )
+{
+    if ( ( pState->pNewConfCache != NULL ) &&
+         ( CONFCACHE_Add( pState->pNewConfCache, pDef ) != EOK ) )
+    {
+        LOGGER_Log( LOGGER_WARNING,
+                    "Cannot cache the configuration in %s",
+                    pState->pCacheFile );
+        CONFCACHE_Close( pState->pNewConfCache );
+        pState->pNewConfCache = NULL;
+    }
+}
+
+/*============================================================================*/
+/*  LoadCache                                                                 */
+/*!
+    Load the template definitions from the configuration cache
+
+    The templates are set up from the definitions in the configuration
+    cache, in the same order as TEMPLATESVC_Load sets them up from the
+    configuration.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @retval EOK - the templates were loaded
+    @retval other - one or more templates could not be set up
+
+==============================================================================*/
+static int LoadCache( TemplateSvcState *pState )
+{
+    int result = EOK;
+    size_t count = CONFCACHE_Count( pState->pConfCache );
+    ConfTemplate def;
+    ConfTenant tenant;
+    size_t i;
+    int rc;
+
+    CONFCACHE_GetTenant( pState->pConfCache, &tenant );
+    pState->pTenant = SetupTenant( pState, &tenant, NULL );
+
+    for ( i = 0 ; i < count ; i++ )
+    {
+        rc = CONFCACHE_Get( pState->pConfCache, i, &def );
+        if ( rc == EOK )
+        {
+            rc = CreateTemplate( pState, &def, NULL );
+            CONFCACHE_FreeDefinition( &def );
+        }
+
+        if ( rc != EOK )
+        {
+            result = rc;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  LoadFile                                                                  */
+/*!
+    Load the template definitions from the configuration file
+
+    If a configuration cache file is specified, and it was built from the
+    current configuration file, the definitions are loaded from the cache
+    instead of parsing the configuration.  Otherwise the configuration is
+    parsed, and the cache file is rebuilt from it.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @retval EOK - the templates were loaded
+    @retval other - one or more templates could not be set up
+
+==============================================================================*/
+static int LoadFile( TemplateSvcState *pState )
+{
+    int result;
+    JNode *config;
+    ConfTenant tenant;
+    uint64_t start = METRICS_Now();
+
+    if ( pState->pCacheFile != NULL )
+    {
+        pState->pConfCache = CONFCACHE_Open( pState->pCacheFile,
+                                             pState->pFileName );
+    }
+
+    if ( pState->pConfCache != NULL )
+    {
+        result = LoadCache( pState );
+    }
+    else
+    {
+        if ( pState->pCacheFile != NULL )
+        {
+            /* identify the configuration before it is parsed */
+            pState->pNewConfCache = CONFCACHE_Create( pState->pCacheFile,
+                                                      pState->pFileName );
+        }
+
+        config = JSON_Process( pState->pFileName );
+
+        ParseTenant( config, &tenant );
+        pState->pTenant = SetupTenant( pState, &tenant, NULL );
+        if ( pState->pNewConfCache != NULL )
+        {
+            (void)CONFCACHE_SetTenant( pState->pNewConfCache, &tenant );
+        }
+
+        result = JSON_Iterate( (JArray *)JSON_Find( config, "config" ),
+                               TEMPLATESVC_SetupTemplate,
+                               (void *)pState );
+
+        if ( ( config != NULL ) &&
+             ( pState->pNewConfCache != NULL ) &&
+             ( CONFCACHE_Save( pState->pNewConfCache ) != EOK ) )
+        {
+            LOGGER_Log( LOGGER_WARNING,
+                        "Cannot write the configuration cache %s",
+                        pState->pCacheFile );
+        }
+
+        CONFCACHE_Close( pState->pNewConfCache );
+        pState->pNewConfCache = NULL;
+
+        if ( config != NULL )
+        {
+            /* the templates do not refer to the parsed configuration */
+            JSON_Free( config );
+        }
+    }
+
+    LOGGER_Log( LOGGER_INFO,
+                "Loaded %s%s in %" PRIu64 " us",
+                pState->pFileName,
+                ( pState->pConfCache != NULL ) ? " from the cache" : "",
+                ( METRICS_Now() - start ) / 1000 );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  LoadDirectory                                                             */
+/*!
+    Load the template definitions from the configuration directory
+
+    The files of the configuration directory are parsed, and their text
+    templates compiled, in parallel.  The templates are then set up on
+    the calling thread, file by file in name order, since setting them
+    up uses the variable server.  Each file is the rule set of its own
+    tenant.  A file which cannot be read or parsed is skipped, and the
+    other files are still loaded.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @retval EOK - the templates were loaded
+    @retval ENOENT - the configuration directory could not be read
+    @retval other - one or more files or templates could not be set up
+
+==============================================================================*/
+static int LoadDirectory( TemplateSvcState *pState )
+{
+    int result;
+    ConfDir *pDir;
+    ConfFile *pFile;
+    PreparedFile *pPrepared;
+    ConfTenant tenant;
+    uint64_t start = METRICS_Now();
+    size_t count;
+    size_t templates = 0;
+    size_t i;
+    size_t j;
+    int rc;
+
+    result = ParseDirectory( pState, PrepareFile, &pDir );
+
+    count = CONFDIR_Count( pDir );
+    for ( i = 0 ; i < count ; i++ )
+    {
+        pFile = CONFDIR_Get( pDir, i );
+        pPrepared = (PreparedFile *)pFile->pData;
+        if ( pPrepared != NULL )
+        {
+            ParseTenant( pFile->config, &tenant );
+            pState->pTenant = SetupTenant( pState, &tenant, pFile->path );
+
+            for ( j = 0 ; j < pPrepared->count ; j++ )
+            {
+                rc = CreateTemplate( pState,
+                                     &pPrepared->pTemplates[j].def,
+                                     pPrepared->pTemplates[j].pCompiled );
+                pPrepared->pTemplates[j].pCompiled = NULL;
+                if ( rc == EOK )
+                {
+                    templates++;
+                }
+                else
+                {
+                    result = rc;
+                }
+            }
+
+            FreePrepared( pPrepared );
+            pFile->pData = NULL;
+        }
+    }
+
+    LOGGER_Log( LOGGER_INFO,
+                "Loaded %zu templates from %zu files in %s in %" PRIu64 " us",
+                templates,
+                count,
+                pState->pConfigDir,
+                ( METRICS_Now() - start ) / 1000 );
+
+    CONFDIR_Close( pDir );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ParseDirectory                                                            */
+/*!
+    Parse the files of the configuration directory
+
+    The files are parsed in parallel, and each file which cannot be
+    parsed or prepared is logged.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        fn
+            callback which prepares each parsed file (or NULL)
+
+    @param[out]
+        ppDir
+            pointer to a location to store the configuration directory
+            (NULL if the directory could not be read)
+
+    @retval EOK - all of the files were parsed
+    @retval ENOENT - the configuration directory could not be read
+    @retval other - one or more files could not be parsed or prepared
+
+==============================================================================*/
+static int ParseDirectory( TemplateSvcState *pState,
+                           ConfFileFn fn,
+                           ConfDir **ppDir )
+{
+    int result = ENOENT;
+    ConfFile *pFile;
+    size_t i;
+
+    *ppDir = CONFDIR_Open( pState->pConfigDir );
+    if ( *ppDir == NULL )
+    {
+        LOGGER_Log( LOGGER_ERROR, "Cannot read %s", pState->pConfigDir );
+    }
+    else
+    {
+        result = CONFDIR_Parse( *ppDir, 0, fn, (void *)pState );
+        for ( i = 0 ; i < CONFDIR_Count( *ppDir ) ; i++ )
+        {
+            pFile = CONFDIR_Get( *ppDir, i );
+            if ( pFile->result != EOK )
+            {
+                LOGGER_Log( LOGGER_ERROR,
+                            "Cannot load %s: %s",
+                            pFile->path,
+                            strerror( pFile->result ) );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  PrepareFile                                                               */
+/*!
+    Prepare the template definitions of a configuration file
+
+    The PrepareFile function is a configuration directory callback which
+    runs on a parser worker thread.  It parses the template definitions
+    of the file, and compiles their template files.  It does not use
+    the variable server or the service state.
+
+    @param[in]
+       pFile
+            pointer to the parsed configuration file
+
+    @param[in]
+        arg
+            opaque pointer argument (unused)
+
+    @retval EOK - the template definitions were prepared
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int PrepareFile( ConfFile *pFile, void *arg )
+{
+    int result = ENOMEM;
+    PreparedFile *pPrepared;
+
+    (void)arg;
+
+    pPrepared = calloc( 1, sizeof( PreparedFile ) );
+    if ( pPrepared != NULL )
+    {
+        result = JSON_Iterate( (JArray *)JSON_Find( pFile->config, "config" ),
+                               PrepareTemplate,
+                               (void *)pPrepared );
+        if ( result == EOK )
+        {
+            pFile->pData = pPrepared;
+        }
+        else
+        {
+            FreePrepared( pPrepared );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  PrepareTemplate                                                           */
+/*!
+    Prepare a template definition
+
+    The PrepareTemplate function is a callback function for the
+    JSON_Iterate function which parses a template definition and, if it
+    is a text template, compiles its template file.  A template file
+    which cannot be compiled is compiled again when the template is
+    set up.
+
+    @param[in]
+       pNode
+            pointer to the template definition node
+
+    @param[in]
+        arg
+            pointer to the prepared file
+
+    @retval EOK - the template definition was prepared
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int PrepareTemplate( JNode *pNode, void *arg )
+{
+    int result = EOK;
+    PreparedFile *pPrepared = (PreparedFile *)arg;
+    PreparedTemplate *pTemplates;
+    PreparedTemplate *pTemplate;
+    size_t size;
+
+    if ( pPrepared->count == pPrepared->size )
+    {
+        size = ( pPrepared->size > 0 ) ? pPrepared->size * 2
+                                       : PREPARED_INITIAL_SIZE;
+        pTemplates = realloc( pPrepared->pTemplates,
+                              size * sizeof( PreparedTemplate ) );
+        if ( pTemplates != NULL )
+        {
+            pPrepared->pTemplates = pTemplates;
+            pPrepared->size = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( ( result == EOK ) &&
+         ( pNode != NULL ) )
+    {
+        pTemplate = &pPrepared->pTemplates[pPrepared->count];
+        pTemplate->pCompiled = NULL;
+
+        if ( ParseDefinition( pNode, &pTemplate->def ) == EOK )
+        {
+            if ( FormatFromName( pTemplate->def.format ) == FMT_TEXT )
+            {
+                (void)RENDER_Compile( pTemplate->def.template,
+                                      &pTemplate->pCompiled );
+            }
+
+            pPrepared->count++;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  FreePrepared                                                              */
+/*!
+    Free the template definitions prepared from a configuration file
+
+    @param[in]
+        pPrepared
+            pointer to the prepared file
+
+==============================================================================*/
+static void FreePrepared( PreparedFile *pPrepared )
+{
+    size_t i;
+
+    if ( pPrepared != NULL )
+    {
+        for ( i = 0 ; i < pPrepared->count ; i++ )
+        {
+            CONFCACHE_FreeDefinition( &pPrepared->pTemplates[i].def );
+            RENDER_Free( pPrepared->pTemplates[i].pCompiled );
+        }
+
+        free( pPrepared->pTemplates );
+        free( pPrepared );
+    }
+}
+
+/*============================================================================*/
+/*  ParseTenant                                                               */
+/*!
+    Parse the tenant of a configuration
+
+    The ParseTenant function reads the optional "tenant" object of a
+    template service configuration, which names the rule set of the
+    configuration and sets its resource limits:
+
+    "tenant" : {
+        "name" : "network",
+        "priority" : 10,
+        "max_templates" : 100,
+        "max_renders_per_sec" : 50
+    }
+
+    The strings of the tenant refer to the JSON configuration.
+
+    @param[in]
+        config
+            pointer to the parsed template service configuration
+
+    @param[out]
+        pConf
+            pointer to the tenant configuration to populate
+
+==============================================================================*/
+static void ParseTenant( JNode *config, ConfTenant *pConf )
+{
+    JNode *pNode;
+    int value;
+
+    memset( pConf, 0, sizeof( ConfTenant ) );
+
+    pNode = ( config != NULL ) ? JSON_Find( config, "tenant" ) : NULL;
+    if ( ( pNode != NULL ) &&
+         ( pNode->type == JSON_OBJECT ) )
+    {
+        pConf->name = JSON_GetStr( pNode, "name" );
+
+        value = 0;
+        (void)JSON_GetNum( pNode, "priority", &value );
+        pConf->priority = value;
+
+        value = 0;
+        (void)JSON_GetNum( pNode, "max_templates", &value );
+        pConf->maxTemplates = ( value > 0 ) ? (uint32_t)value : 0;
+
+        value = 0;
+        (void)JSON_GetNum( pNode, "max_renders_per_sec", &value );
+        pConf->maxRendersPerSec = ( value > 0 ) ? (uint32_t)value : 0;
+    }
+}
+
+/*============================================================================*/
+/*  SetupTenant                                                               */
+/*!
+    Set up the tenant of a configuration
+
+    The SetupTenant function looks up the tenant of a configuration by
+    name, creating it if it is not yet hosted by the service, and applies
+    its resource limits.  A file of the configuration directory which
+    does not name its tenant belongs to the tenant named after the file,
+    without the ".json" extension, and the configuration file belongs to
+    the "default" tenant.  The tenants share the
+    variable server connection, the trigger index and the value cache,
+    and their metrics are published under <prefix>/tenant/<name>.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pConf
+            pointer to the tenant configuration
+
+    @param[in]
+        source
+            name of the configuration directory file (or NULL)
+
+    @retval pointer to the tenant
+    @retval NULL if the tenant could not be created
+
+==============================================================================*/
+static Tenant *SetupTenant( TemplateSvcState *pState,
+                            ConfTenant *pConf,
+                            const char *source )
+{
+    Tenant *pTenant;
+    char name[MAX_TENANT_NAME + 1];
+    char metricName[MAX_TENANT_NAME + 8];
+    const char *p;
+    size_t len;
+
+    if ( pConf->name != NULL )
+    {
+        snprintf( name, sizeof( name ), "%s", pConf->name );
+    }
+    else if ( source != NULL )
+    {
+        p = strrchr( source, '/' );
+        p = ( p != NULL ) ? p + 1 : source;
+
+        len = strlen( p );
+        if ( ( len > 5 ) && ( strcmp( &p[len - 5], ".json" ) == 0 ) )
+        {
+            len -= 5;
+        }
+
+        snprintf( name,
+                  sizeof( name ),
+                  "%.*s",
+                  (int)( ( len < MAX_TENANT_NAME ) ? len : MAX_TENANT_NAME ),
+                  p );
+    }
+    else
+    {
+        snprintf( name, sizeof( name ), "%s", DEFAULT_TENANT );
+    }
+
+    pTenant = pState->pTenants;
+    while ( ( pTenant != NULL ) &&
+            ( strcmp( pTenant->name, name ) != 0 ) )
+    {
+        pTenant = pTenant->pNext;
+    }
+
+    if ( pTenant == NULL )
+    {
+        /* tenants live as long as the service */
+        pTenant = ARENA_Calloc( pState->pArena, sizeof( Tenant ) );
+        if ( pTenant != NULL )
+        {
+            pTenant->name = STRTAB_Intern( pState->pStrings, name );
+        }
+
+        if ( ( pTenant != NULL ) &&
+             ( pTenant->name != NULL ) )
+        {
+            if ( pState->pMetricsPrefix != NULL )
+            {
+                /* publish the metrics of the tenant */
+                snprintf( metricName,
+                          sizeof( metricName ),
+                          "tenant/%s",
+                          name );
+                pTenant->pMetrics = METRICS_Create( pState->hVarServer,
+                                                    pState->pMetricsPrefix,
+                                                    metricName,
+                                                    false );
+            }
+
+            pTenant->pNext = pState->pTenants;
+            pState->pTenants = pTenant;
+        }
+        else
+        {
+            pTenant = NULL;
+        }
+    }
+
+    if ( pTenant != NULL )
+    {
+        pTenant->priority = pConf->priority;
+        pTenant->maxTemplates = pConf->maxTemplates;
+
+        if ( pTenant->maxRendersPerSec != pConf->maxRendersPerSec )
+        {
+            /* start the rate limit with a full second of renders */
+            pTenant->maxRendersPerSec = pConf->maxRendersPerSec;
+            pTenant->tokens = (double)pConf->maxRendersPerSec;
+            pTenant->refillNs = METRICS_Now();
+        }
+    }
+    else
+    {
+        LOGGER_Log( LOGGER_ERROR, "Cannot create tenant %s", name );
+    }
+
+    return pTenant;
+}
+
+/*============================================================================*/
+/*  TenantFull                                                                */
+/*!
+    Check if a tenant has reached its template limit
+
+    @param[in]
+        pTenant
+            pointer to the tenant (or NULL)
+
+    @retval true - no more templates can be added to the tenant
+    @retval false - the tenant can have another template
+
+==============================================================================*/
+static bool TenantFull( Tenant *pTenant )
+{
+    return ( pTenant != NULL ) &&
+           ( pTenant->maxTemplates != 0 ) &&
+           ( pTenant->templates >= pTenant->maxTemplates );
+}
+
+/*============================================================================*/
+/*  SortTemplates                                                             */
+/*!
+    Order the templates by the priority of their tenants
+
+    The templates are stably sorted so the templates of higher priority
+    tenants are fetched and rendered first in each render cycle, and the
+    templates of each tenant keep their order.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+==============================================================================*/
+static void SortTemplates( TemplateSvcState *pState )
+{
+    Template *pLists[64] = { NULL };
+    Template *pTemplate;
+    Template *pNext;
+    int64_t rank;
+    size_t i;
+
+    /* bottom-up merge sort of the template list */
+    for ( pTemplate = pState->pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pNext )
+    {
+        pNext = pTemplate->pNext;
+        pTemplate->pNext = NULL;
+
+        for ( i = 0 ; ( i < 63 ) && ( pLists[i] != NULL ) ; i++ )
+        {
+            pTemplate = MergeTemplates( pLists[i], pTemplate );
+            pLists[i] = NULL;
+        }
+
+        pLists[i] = MergeTemplates( pLists[i], pTemplate );
+    }
+
+    pTemplate = NULL;
+    for ( i = 0 ; i < 64 ; i++ )
+    {
+        pTemplate = MergeTemplates( pLists[i], pTemplate );
+    }
+
+    pState->pTemplates = pTemplate;
+
+    /* number the templates, so the dirty set is rendered in this order */
+    for ( rank = 0 ; pTemplate != NULL ; pTemplate = pTemplate->pNext )
+    {
+        pTemplate->rank = rank++;
+    }
+}
+
+/*============================================================================*/
+/*  MergeTemplates                                                            */
+/*!
+    Merge two template lists ordered by tenant priority
+
+    @param[in]
+        pA
+            template list which precedes pB in the original order
+
+    @param[in]
+        pB
+            template list which follows pA in the original order
+
+    @retval pointer to the merged template list
+
+==============================================================================*/
+static Template *MergeTemplates( Template *pA, Template *pB )
+{
+    Template *pHead = NULL;
+    Template **ppTail = &pHead;
+    int32_t a;
+    int32_t b;
+
+    while ( ( pA != NULL ) && ( pB != NULL ) )
+    {
+        a = ( pA->pTenant != NULL ) ? pA->pTenant->priority : 0;
+        b = ( pB->pTenant != NULL ) ? pB->pTenant->priority : 0;
+
+        if ( a >= b )
+        {
+            *ppTail = pA;
+            pA = pA->pNext;
+        }
+        else
+        {
+            *ppTail = pB;
+            pB = pB->pNext;
+        }
+
+        ppTail = &(*ppTail)->pNext;
+    }
+
+    *ppTail = ( pA != NULL ) ? pA : pB;
+
+    return pHead;
+}
+
+/*============================================================================*/
+/*  GetLevel                                                                  */
+/*!
+    Get a numeric attribute of a JSON object
+
+    @param[in]
+       pNode
+            pointer to the JSON object
+
+    @param[in]
+        name
+            name of the attribute
+
+    @param[out]
+        pLevel
+            pointer to a location to store the attribute value
+
+    @retval EOK - the attribute value was retrieved
+    @retval ENOENT - the object has no numeric attribute of that name
+
+==============================================================================*/
+static int GetLevel( JNode *pNode, char *name, double *pLevel )
+{
+    int result = ENOENT;
+    JVar *pVar = (JVar *)JSON_Find( pNode, name );
+
+    if ( ( pVar != NULL ) &&
+         ( pVar->node.type == JSON_VAR ) )
+    {
+        if ( pVar->var.type == JVARTYPE_INT )
+        {
+            *pLevel = pVar->var.val.num;
+            result = EOK;
+        }
+        else if ( pVar->var.type == JVARTYPE_FLOAT )
+        {
+            *pLevel = pVar->var.val.f;
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CheckCondition                                                            */
+/*!
+    Check if a trigger notification meets the trigger's condition
+
+    The CheckCondition function brings the trigger variable's value
+    snapshot up to date, and compares it with the last value which met
+    the condition.  The snapshot is shared with the next render, so
+    checking the condition does not cost an extra fetch.  Non-numeric
+    variables only support change detection, so every condition is
+    treated as "change" for them.  If the value cannot be fetched, the
+    notification is not filtered.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTriggerVar
+            pointer to the notified trigger
+
+    @retval true - the notification should trigger a render
+    @retval false - the notification should be filtered out
+
+==============================================================================*/
+static bool CheckCondition( TemplateSvcState *pState,
+                            TriggerVar *pTriggerVar )
+{
+    bool result = true;
+    VarEntry *pEntry = pTriggerVar->pEntry;
+    VarObject *pValue;
+
+    if ( VARCACHE_Refresh( pState->pVarCache,
+                           pState->hVarServer,
+                           pEntry ) == EOK )
+    {
+        pValue = &pEntry->value;
+
+        switch( pEntry->type )
+        {
+            case VARTYPE_UINT16:
+                result = CheckLevel( pTriggerVar, pValue->val.ui );
+                break;
+
+            case VARTYPE_INT16:
+                result = CheckLevel( pTriggerVar, pValue->val.i );
+                break;
+
+            case VARTYPE_UINT32:
+                result = CheckLevel( pTriggerVar, pValue->val.ul );
+                break;
+
+            case VARTYPE_INT32:
+                result = CheckLevel( pTriggerVar, pValue->val.l );
+                break;
+
+            case VARTYPE_UINT64:
+                result = CheckWide( pTriggerVar,
+                                    pValue->val.ull,
+                                    (double)pValue->val.ull );
+                break;
+
+            case VARTYPE_INT64:
+                result = CheckWide( pTriggerVar,
+                                    (uint64_t)pValue->val.ll,
+                                    (double)pValue->val.ll );
+                break;
+
+            case VARTYPE_FLOAT:
+                result = CheckLevel( pTriggerVar, pValue->val.f );
+                break;
+
+            default:
+                result = CheckText( pTriggerVar, pEntry );
+                break;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CheckLevel                                                                */
+/*!
+    Check a numeric value against a trigger condition
+
+    The last value is updated when the value meets a "change" or
+    "deadband" condition, so slow drift accumulates until it exceeds the
+    deadband.  For the threshold conditions it is updated on every
+    notification, so only a crossing of the level triggers a render.
+    The first value only primes the condition.
+
+    @param[in]
+        pTriggerVar
+            pointer to the notified trigger
+
+    @param[in]
+        value
+            current value of the trigger variable
+
+    @retval true - the value meets the condition
+    @retval false - the value does not meet the condition
+
+==============================================================================*/
+static bool CheckLevel( TriggerVar *pTriggerVar, double value )
+{
+    bool result = false;
+    double last = pTriggerVar->last;
+    double delta = ( value > last ) ? value - last : last - value;
+
+    if ( pTriggerVar->primed == true )
+    {
+        switch( pTriggerVar->condition )
+        {
+            case TRIGGER_DEADBAND:
+                result = ( delta >= pTriggerVar->level );
+                break;
+
+            case TRIGGER_RISING_ABOVE:
+                result = ( last <= pTriggerVar->level ) &&
+                         ( value > pTriggerVar->level );
+                break;
+
+            case TRIGGER_FALLING_BELOW:
+                result = ( last >= pTriggerVar->level ) &&
+                         ( value < pTriggerVar->level );
+                break;
+
+            default:
+                result = ( value != last );
+                break;
+        }
+    }
+
+    if ( ( pTriggerVar->primed == false ) ||
+         ( result == true ) ||
+         ( pTriggerVar->condition == TRIGGER_RISING_ABOVE ) ||
+         ( pTriggerVar->condition == TRIGGER_FALLING_BELOW ) )
+    {
+        pTriggerVar->last = value;
+        pTriggerVar->primed = true;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CheckWide                                                                 */
+/*!
+    Check a 64-bit integer value against a trigger condition
+
+    A double cannot hold every 64-bit integer, so neighbouring values
+    above 2^53 compare equal once converted.  A "change" condition
+    therefore compares the integer value itself.  The deadband and
+    threshold conditions compare against a floating point level, and
+    are checked on the converted value by CheckLevel.
+
+    @param[in]
+        pTriggerVar
+            pointer to the notified trigger
+
+    @param[in]
+        wide
+            current value of the trigger variable, as stored
+
+    @param[in]
+        value
+            current value of the trigger variable, converted to a double
+
+    @retval true - the value meets the condition
+    @retval false - the value does not meet the condition
+
+==============================================================================*/
+static bool CheckWide( TriggerVar *pTriggerVar, uint64_t wide, double value )
+{
+    bool result;
+
+    if ( pTriggerVar->condition == TRIGGER_CHANGE )
+    {
+        result = ( pTriggerVar->primed == true ) &&
+                 ( wide != pTriggerVar->lastWide );
+
+        pTriggerVar->lastWide = wide;
+        pTriggerVar->last = value;
+        pTriggerVar->primed = true;
+    }
+    else
+    {
+        result = CheckLevel( pTriggerVar, value );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CheckText                                                                 */
+/*!
+    Check if the formatted text of a trigger variable has changed
+
+    @param[in]
+        pTriggerVar
+            pointer to the notified trigger
+
+    @param[in]
+        pEntry
+            pointer to the trigger variable's current value snapshot
+
+    @retval true - the text differs from the last text
+    @retval false - the text is unchanged
+
+==============================================================================*/
+static bool CheckText( TriggerVar *pTriggerVar, VarEntry *pEntry )
+{
+    bool result = true;
+    char *p;
+
+    if ( pEntry->pText == NULL )
+    {
+        /* there is no text to compare */
+    }
+    else if ( ( pTriggerVar->primed == true ) &&
+              ( strcmp( pTriggerVar->pLastText, pEntry->pText ) == 0 ) )
+    {
+        result = false;
+    }
+    else if ( pEntry->textLen < pTriggerVar->lastSize )
+    {
+        memcpy( pTriggerVar->pLastText, pEntry->pText, pEntry->textLen + 1 );
+        pTriggerVar->primed = true;
+    }
+    else
+    {
+        /* match the size of the cached text, which grows in steps, so
+           a length which varies does not re-allocate the last text */
+        p = realloc( pTriggerVar->pLastText, pEntry->textSize );
+        if ( p != NULL )
+        {
+            memcpy( p, pEntry->pText, pEntry->textLen + 1 );
+            pTriggerVar->pLastText = p;
+            pTriggerVar->lastSize = pEntry->textSize;
+            pTriggerVar->primed = true;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupCommit                                                               */
+/*!
+    Set up the commit trigger of a transactional template
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            pointer to the template
+
+    @param[in]
+        name
+            name of the commit variable
+
+    @retval EOK - the commit trigger was set up
+    @retval ENOMEM - memory allocation failure
+    @retval other - the commit notification could not be set up
+
+==============================================================================*/
+static int SetupCommit( TemplateSvcState *pState,
+                        Template *pTemplate,
+                        char *name )
+{
+    int result = ENOMEM;
+
+    pTemplate->pCommit = calloc( 1, sizeof( TriggerVar ) );
+    if ( pTemplate->pCommit != NULL )
+    {
+        pTemplate->pCommit->name = STRTAB_Intern( pState->pStrings, name );
+        result = SetupTriggerNotification( pState->hVarServer,
+                                           pState->pVarCache,
+                                           pTemplate->pCommit );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupTriggerNotifications                                                 */
+/*!
+    Set up all the NOTIFY_MODIFIED trigger notifications
+
+    The SetupTriggerNotifications function iterates through an array of
+    TriggerVars and sets up all the NOTIFY_MODIFIED trigger notification
+    requests with the variable server.
+
+    @param[in]
+        hVarServer
+            Handle to the variable server
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        pTriggerVars
+            pointer to the TriggerVar array
+
+    @param[in]
+        numTriggerVars
+            number of TriggerVars in the array
+
+    @retval EOK - all the triggers were successfully set up
+    @retval ENOENT - one or more of the trigger variables were not found
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int SetupTriggerNotifications( VARSERVER_HANDLE hVarServer,
+                                      VarCache *pVarCache,
+                                      TriggerVar *pTriggerVars,
+                                      size_t numTriggerVars )
+{
+    int result = EINVAL;
+    size_t i;
+    int rc;
+
+    if ( ( hVarServer != NULL ) &&
+         ( pTriggerVars != NULL ) )
+    {
+        result = EOK;
+
+        for ( i = 0 ; i < numTriggerVars ; i++ )
+        {
+            /* set up a trigger notification */
+            rc = SetupTriggerNotification( hVarServer,
+                                           pVarCache,
+                                           &pTriggerVars[i] );
+            if ( rc != EOK )
+            {
+                result = rc;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupTriggerNotification                                                  */
+/*!
+    Set up a NOTIFY_MODIFIED trigger notification
+
+    The SetupTriggerNotification function sets up a TriggerVar NOTIFY_MODIFIED
+    trigger notification request with the variable server.  The variable
+    is looked up, and the request is made, through the variable cache,
+    so that each variable is only looked up and registered once
+    regardless of how many templates it triggers.
+
+    @param[in]
+        hVarServer
+            Handle to the variable server
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        pTriggerVar
+            pointer to the TriggerVar to set up
+
+    @retval EOK - the notification was successfully set up
+    @retval ENOENT - the trigger variable was not found
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int SetupTriggerNotification( VARSERVER_HANDLE hVarServer,
+                                     VarCache *pVarCache,
+                                     TriggerVar *pTriggerVar )
+{
+    int result = EINVAL;
+
+    if ( ( hVarServer != NULL ) &&
+         ( pTriggerVar != NULL ) )
+    {
+        if ( pTriggerVar->name != NULL )
+        {
+            /* get a handle to the trigger variable */
+            pTriggerVar->pEntry = VARCACHE_Lookup( pVarCache,
+                                                   hVarServer,
+                                                   pTriggerVar->name );
+            if ( pTriggerVar->pEntry != NULL )
+            {
+                pTriggerVar->hVar = pTriggerVar->pEntry->hVar;
+
+                /* request a MODIFIED notification on the trigger variable */
+                result = VARCACHE_Watch( pVarCache,
+                                         hVarServer,
+                                         pTriggerVar->pEntry );
+            }
+            else
+            {
+                pTriggerVar->hVar = VAR_INVALID;
+                result = ENOENT;
+                if ( VARCACHE_Deferred( pVarCache ) == false )
+                {
+                    LOGGER_Log( LOGGER_WARNING,
+                                "Waiting for variable: %s",
+                                pTriggerVar->name );
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupOutputVars                                                           */
+/*!
+    Set up the output variables for a structured output template
+
+    The SetupOutputVars function builds the array of variables to be
+    emitted by a JSON Lines or CBOR template from the "vars" array and
+    the "prefix" attribute of the template definition, and looks up
+    the handle of each variable.  Variables are emitted in the order
+    they are listed, followed by any variables matching the prefix.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        pDef
+            pointer to the template definition
+
+    @param[in]
+        pTemplate
+            pointer to the template to set up
+
+    @retval EOK - the output variables were set up
+    @retval ENOENT - one or more output variables were not found
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int SetupOutputVars( TemplateSvcState *pState,
+                            ConfTemplate *pDef,
+                            Template *pTemplate )
+{
+    int result = EINVAL;
+    TriggerVar *pVar;
+    size_t i;
+
+    if ( ( pState != NULL ) &&
+         ( pDef != NULL ) &&
+         ( pTemplate != NULL ) )
+    {
+        result = EOK;
+
+        if ( pDef->numVars > 0 )
+        {
+            /* allocate the variable records in one block */
+            pTemplate->pVars = calloc( pDef->numVars, sizeof( TriggerVar ) );
+            result = ( pTemplate->pVars != NULL ) ? EOK : ENOMEM;
+        }
+
+        for ( i = 0 ;
+              ( pTemplate->pVars != NULL ) && ( i < pDef->numVars ) ;
+              i++ )
+        {
+            pVar = &pTemplate->pVars[pTemplate->numVars++];
+            pVar->name = STRTAB_Intern( pState->pStrings, pDef->pVars[i] );
+            pVar->hVar = VAR_INVALID;
+            pVar->pEntry = VARCACHE_Lookup( pState->pVarCache,
+                                            pState->hVarServer,
+                                            pVar->name );
+            if ( pVar->pEntry != NULL )
+            {
+                pVar->hVar = pVar->pEntry->hVar;
+            }
+            else
+            {
+                if ( VARCACHE_Deferred( pState->pVarCache ) == false )
+                {
+                    LOGGER_Log( LOGGER_WARNING,
+                                "Waiting for variable: %s",
+                                pVar->name );
+                }
+
+                result = ENOENT;
+            }
+        }
+
+        if ( pDef->prefix != NULL )
+        {
+            /* append the prefix matches to the end of the array */
+            SetupPrefixVars( pState, pDef->prefix, pTemplate );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupPrefixVars                                                           */
+/*!
+    Find all variables whose names start with a prefix
+
+    The SetupPrefixVars function queries the variable server for all
+    variables matching the specified name prefix and appends them to
+    the template's array of output variables.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        prefix
+            variable name prefix to search for
+
+    @param[in,out]
+        pTemplate
+            pointer to the template to append the variables to
+
+    @retval EOK - the prefix variables were added
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int SetupPrefixVars( TemplateSvcState *pState,
+                            char *prefix,
+                            Template *pTemplate )
+{
+    int result = EINVAL;
+    PrefixMatches matches;
+
+    if ( ( pState != NULL ) &&
+         ( prefix != NULL ) &&
+         ( pTemplate != NULL ) )
+    {
+        matches.pTemplate = pTemplate;
+        matches.pWildcard = NULL;
+        matches.size = pTemplate->numVars;
+
+        result = QueryPrefix( pState, prefix, AddPrefixVar, &matches );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  AddPrefixVar                                                              */
+/*!
+    Append a variable matching a prefix to the output variables
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        name
+            name of the matching variable
+
+    @param[in]
+        hVar
+            handle of the matching variable
+
+    @param[in,out]
+        arg
+            pointer to the PrefixMatches of the template
+
+    @retval EOK - the variable was added
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int AddPrefixVar( TemplateSvcState *pState,
+                         const char *name,
+                         VAR_HANDLE hVar,
+                         void *arg )
+{
+    int result = EOK;
+    PrefixMatches *pMatches = (PrefixMatches *)arg;
+    Template *pTemplate = pMatches->pTemplate;
+    TriggerVar *pVars;
+    TriggerVar *pVar;
+
+    if ( pTemplate->numVars == pMatches->size )
+    {
+        pMatches->size = ( pMatches->size > 0 ) ? pMatches->size * 2
+                                                : PREFIX_VARS_INITIAL_SIZE;
+        pVars = realloc( pTemplate->pVars,
+                         pMatches->size * sizeof( TriggerVar ) );
+        if ( pVars != NULL )
+        {
+            pTemplate->pVars = pVars;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        pVar = &pTemplate->pVars[pTemplate->numVars++];
+        memset( pVar, 0, sizeof( TriggerVar ) );
+        pVar->name = STRTAB_Intern( pState->pStrings, name );
+        pVar->hVar = hVar;
+        pVar->pEntry = VARCACHE_Add( pState->pVarCache,
+                                     pVar->hVar,
+                                     pVar->name );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  QueryPrefix                                                               */
+/*!
+    Visit the variables whose names start with a prefix
+
+    The QueryPrefix function queries the variable server for the
+    variables matching the prefix, and calls the specified function for
+    each one.  The query is a substring match, so the names which only
+    contain the prefix are skipped.  The query stops at the first error
+    returned by the function.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        prefix
+            variable name prefix to search for
+
+    @param[in]
+        fn
+            function to call for each matching variable
+
+    @param[in]
+        arg
+            argument passed to the function
+
+    @retval EOK - every matching variable was visited
+    @retval other - error returned by the function
+
+==============================================================================*/
+static int QueryPrefix( TemplateSvcState *pState,
+                        char *prefix,
+                        PrefixMatchFn fn,
+                        void *arg )
+{
+    int result = EOK;
+    VarQuery query;
+    VarObject obj;
+    size_t len = strlen( prefix );
+    int rc;
+
+    memset( &query, 0, sizeof( query ) );
+    query.type = QUERY_MATCH;
+    query.match = prefix;
+
+    rc = VAR_GetFirst( pState->hVarServer, &query, &obj );
+    while ( ( rc == EOK ) && ( result == EOK ) )
+    {
+        if ( strncmp( query.name, prefix, len ) == 0 )
+        {
+            result = fn( pState, query.name, query.hVar, arg );
+        }
+
+        rc = VAR_GetNext( pState->hVarServer, &query, &obj );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  IsWildcard                                                                */
+/*!
+    Determine if a trigger name is a wildcard pattern
+
+    @param[in]
+        name
+            trigger variable name (or NULL)
+
+    @retval true - the name ends in the wildcard character
+    @retval false - the name is a variable name
+
+==============================================================================*/
+static bool IsWildcard( const char *name )
+{
+    size_t len = ( name != NULL ) ? strlen( name ) : 0;
+
+    return ( len > 0 ) && ( name[len - 1] == WILDCARD_CHAR );
+}
+
+/*============================================================================*/
+/*  ExpandWildcard                                                            */
+/*!
+    Add a trigger record for each variable matching a wildcard
+
+    The ExpandWildcard function queries the variable server for the
+    variables whose names start with the wildcard's prefix, and appends
+    a trigger record, with the wildcard's condition, for each one which
+    does not already trigger the template.  The trigger array may be
+    moved, so the trigger index must be rebuilt if any are added.  The
+    notifications of the new triggers are not requested here.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in,out]
+        pTemplate
+            pointer to the template to append the triggers to
+
+    @param[in]
+        pWildcard
+            pointer to the wildcard pattern
+
+    @retval EOK - the matching variables were added
+    @retval ENOMEM - memory allocation failure
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int ExpandWildcard( TemplateSvcState *pState,
+                           Template *pTemplate,
+                           TriggerVar *pWildcard )
+{
+    int result = EINVAL;
+    char prefix[MAX_NAME_LEN + 1];
+    PrefixMatches matches;
+    size_t len;
+
+    if ( ( pState != NULL ) &&
+         ( pTemplate != NULL ) &&
+         ( pWildcard != NULL ) &&
+         ( IsWildcard( pWildcard->name ) == true ) &&
+         ( strlen( pWildcard->name ) <= sizeof( prefix ) ) )
+    {
+        /* the prefix is the pattern without the wildcard character */
+        len = strlen( pWildcard->name ) - 1;
+        memcpy( prefix, pWildcard->name, len );
+        prefix[len] = '\0';
+
+        matches.pTemplate = pTemplate;
+        matches.pWildcard = pWildcard;
+        matches.size = pTemplate->numTriggers;
+
+        result = QueryPrefix( pState, prefix, AddWildcardTrigger, &matches );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  AddWildcardTrigger                                                        */
+/*!
+    Append a trigger record for a variable matching a wildcard
+
+    The trigger takes the wildcard's condition.  It is not added if the
+    variable already triggers the template.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        name
+            name of the matching variable
+
+    @param[in]
+        hVar
+            handle of the matching variable
+
+    @param[in,out]
+        arg
+            pointer to the PrefixMatches of the template and wildcard
+
+    @retval EOK - the variable triggers the template
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int AddWildcardTrigger( TemplateSvcState *pState,
+                               const char *name,
+                               VAR_HANDLE hVar,
+                               void *arg )
+{
+    int result = EOK;
+    PrefixMatches *pMatches = (PrefixMatches *)arg;
+    Template *pTemplate = pMatches->pTemplate;
+    TriggerVar *pTriggers;
+    TriggerVar *pTrigger;
+
+    if ( HasTrigger( pState, pTemplate, hVar ) == false )
+    {
+        if ( pTemplate->numTriggers == pMatches->size )
+        {
+            pMatches->size = ( pMatches->size > 0 ) ? pMatches->size * 2
+                                                    : PREFIX_VARS_INITIAL_SIZE;
+            pTriggers = realloc( pTemplate->pTriggers,
+                                 pMatches->size * sizeof( TriggerVar ) );
+            if ( pTriggers != NULL )
+            {
+                pTemplate->pTriggers = pTriggers;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pTrigger = &pTemplate->pTriggers[pTemplate->numTriggers++];
+            memset( pTrigger, 0, sizeof( TriggerVar ) );
+            pTrigger->name = STRTAB_Intern( pState->pStrings, name );
+            pTrigger->hVar = hVar;
+            pTrigger->condition = pMatches->pWildcard->condition;
+            pTrigger->level = pMatches->pWildcard->level;
+            pTrigger->pEntry = VARCACHE_Add( pState->pVarCache,
+                                             pTrigger->hVar,
+                                             pTrigger->name );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  HasTrigger                                                                */
+/*!
+    Determine if a variable already triggers a template
+
+    The trigger index is searched, so the answer only covers the
+    triggers which were indexed.  A template which is still being set up
+    is not indexed, and a variable matching two of its wildcards is
+    added twice, which the index ignores when it is rebuilt.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        pTemplate
+            pointer to the template
+
+    @param[in]
+        hVar
+            handle of the variable
+
+    @retval true - the variable triggers the template
+    @retval false - the variable does not trigger the template
+
+==============================================================================*/
+static bool HasTrigger( TemplateSvcState *pState,
+                        Template *pTemplate,
+                        VAR_HANDLE hVar )
+{
+    bool result = false;
+    size_t first = 0;
+    size_t n;
+    size_t i;
+
+    n = TRIGINDEX_Find( pState->pTrigIndex, hVar, &first );
+    for ( i = first ; ( result == false ) && ( i < first + n ) ; i++ )
+    {
+        result = ( TRIGINDEX_Template( pState->pTrigIndex, i ) == pTemplate );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupExclude                                                              */
+/*!
+    Set up the variables excluded from the derived triggers of a template
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in,out]
+        pTemplate
+            pointer to the template
+
+    @param[in]
+        pDef
+            pointer to the template definition
+
+    @retval EOK - the excluded variables were set up
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int SetupExclude( TemplateSvcState *pState,
+                         Template *pTemplate,
+                         ConfTemplate *pDef )
+{
+    int result = EOK;
+    size_t i;
+
+    if ( pDef->numExclude > 0 )
+    {
+        pTemplate->ppExclude = calloc( pDef->numExclude, sizeof( char * ) );
+        result = ( pTemplate->ppExclude != NULL ) ? EOK : ENOMEM;
+    }
+
+    for ( i = 0 ; ( result == EOK ) && ( i < pDef->numExclude ) ; i++ )
+    {
+        pTemplate->ppExclude[pTemplate->numExclude++] =
+            STRTAB_Intern( pState->pStrings, pDef->pExclude[i] );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  DeriveTriggers                                                            */
+/*!
+    Derive the triggers of a template from the variables it references
+
+    The DeriveTriggers function replaces the template's trigger records
+    with one record for each distinct variable referenced by the
+    compiled template, or output by a structured output template, which
+    is not excluded.  The references are taken from the compiled
+    template, so they are derived again whenever the template file is
+    recompiled.  The trigger array is replaced, so the trigger index
+    must be rebuilt, and the notifications of the new triggers are not
+    requested here.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in,out]
+        pTemplate
+            pointer to the template
+
+    @retval EOK - the triggers were derived
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int DeriveTriggers( TemplateSvcState *pState, Template *pTemplate )
+{
+    int result = EOK;
+    CompiledTemplate *pCompiled = pTemplate->pCompiled;
+    size_t size = 0;
+    size_t i;
+
+    for ( i = 0 ; i < pTemplate->numTriggers ; i++ )
+    {
+        free( pTemplate->pTriggers[i].pLastText );
+    }
+
+    free( pTemplate->pTriggers );
+    pTemplate->pTriggers = NULL;
+    pTemplate->numTriggers = 0;
+
+    if ( pTemplate->format != FMT_TEXT )
+    {
+        for ( i = 0 ; ( result == EOK ) && ( i < pTemplate->numVars ) ; i++ )
+        {
+            result = AddDerivedTrigger( pState,
+                                        pTemplate,
+                                        pTemplate->pVars[i].name,
+                                        &size );
+        }
+    }
+    else if ( pCompiled != NULL )
+    {
+        for ( i = 0 ;
+              ( result == EOK ) && ( i < pCompiled->numSegments ) ;
+              i++ )
+        {
+            if ( pCompiled->pSegments[i].type == SEG_VAR )
+            {
+                result = AddDerivedTrigger( pState,
+                                            pTemplate,
+                                            pCompiled->pSegments[i].name,
+                                            &size );
+            }
+        }
+    }
+
+    /* the trigger array has been replaced */
+    pState->reindex = true;
+
+    return result;
+}
+
+/*============================================================================*/
+/*  AddDerivedTrigger                                                         */
+/*!
+    Add a referenced variable to the derived triggers of a template
+
+    The variable is not added if it is excluded, or if it already
+    triggers the template.  The names are interned, so a repeated
+    reference is found by comparing the name pointers.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in,out]
+        pTemplate
+            pointer to the template
+
+    @param[in]
+        name
+            name of the referenced variable
+
+    @param[in,out]
+        pSize
+            allocated number of trigger records
+
+    @retval EOK - the variable triggers the template
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int AddDerivedTrigger( TemplateSvcState *pState,
+                              Template *pTemplate,
+                              const char *name,
+                              size_t *pSize )
+{
+    int result = EOK;
+    TriggerVar *pTriggers;
+    TriggerVar *pTrigger;
+    char *interned;
+    size_t i = 0;
+
+    interned = STRTAB_Intern( pState->pStrings, name );
+    if ( interned == NULL )
+    {
+        result = ( name != NULL ) ? ENOMEM : EOK;
+    }
+    else if ( IsExcluded( pTemplate, interned ) == false )
+    {
+        while ( ( i < pTemplate->numTriggers ) &&
+                ( pTemplate->pTriggers[i].name != interned ) )
+        {
+            i++;
+        }
+
+        if ( ( i == pTemplate->numTriggers ) &&
+             ( pTemplate->numTriggers == *pSize ) )
+        {
+            *pSize = ( *pSize > 0 ) ? *pSize * 2 : PREFIX_VARS_INITIAL_SIZE;
+            pTriggers = realloc( pTemplate->pTriggers,
+                                 *pSize * sizeof( TriggerVar ) );
+            if ( pTriggers != NULL )
+            {
+                pTemplate->pTriggers = pTriggers;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( ( result == EOK ) && ( i == pTemplate->numTriggers ) )
+        {
+            pTrigger = &pTemplate->pTriggers[pTemplate->numTriggers++];
+            memset( pTrigger, 0, sizeof( TriggerVar ) );
+            pTrigger->name = interned;
+            pTrigger->hVar = VAR_INVALID;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  IsExcluded                                                                */
+/*!
+    Determine if a variable is excluded from the derived triggers
+
+    An exclusion ending in '*' excludes every variable whose name starts
+    with the text before the '*'.
+
+    @param[in]
+        pTemplate
+            pointer to the template
+
+    @param[in]
+        name
+            variable name
+
+    @retval true - the variable is excluded
+    @retval false - the variable is not excluded
+
+==============================================================================*/
+static bool IsExcluded( Template *pTemplate, const char *name )
+{
+    bool result = false;
+    const char *exclude;
+    size_t i;
+
+    for ( i = 0 ; ( result == false ) && ( i < pTemplate->numExclude ) ; i++ )
+    {
+        exclude = pTemplate->ppExclude[i];
+        result = ( IsWildcard( exclude ) == true )
+                 ? ( strncmp( name, exclude, strlen( exclude ) - 1 ) == 0 )
+                 : ( strcmp( name, exclude ) == 0 );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupVarFP                                                                */
+/*!
+    Set up a variable output stream for rendering variables to text
+
+    The SetupVarFP function sets up a shared memory buffer backed by an
+    output stream to allow us to render templates into a memory buffer,
+    so we can send them to a message queue.  A second, smaller buffer
+    is set up as scratch space for fetching non-numeric variables.
+
+    @param[in]
+        pState
+            pointer to the Template Service State object to initialize
+
+    @retval EOK the template rendering buffer was created
+    @retval EBADF failed to create the memory buffer
+    @retval EINVAL invalid arguments
+
+==============================================================================*/
+static int SetupVarFP( TemplateSvcState *pState )
+{
+    int result = EINVAL;
+    char varfp_name[64];
+    time_t now;
+    int n;
+    size_t len = sizeof(varfp_name);
+
+    if ( pState != NULL )
+    {
+        result = EBADF;
+
+        /* generate a temporary name for the VarFP */
+        now = time(NULL);
+        n = snprintf(varfp_name, sizeof(varfp_name), "templatesvc_%ld", now );
+        if ( ( n > 0 ) && ( (size_t)n < len ) )
+        {
+            /* open a VarFP object for printing */
+            pState->pVarFP = VARFP_Open( varfp_name, pState->varfpSize );
+            if ( pState->pVarFP != NULL )
+            {
+                /* get a file descriptor for the memory buffer */
+                pState->varFd = VARFP_GetFd( pState->pVarFP );
+                if ( pState->varFd != -1 )
+                {
+                    result = EOK;
+                }
+            }
+        }
+
+        n = snprintf( varfp_name, len, "templatesvc_fetch_%ld", now );
+        if ( ( result == EOK ) && ( n > 0 ) && ( (size_t)n < len ) )
+        {
+            /* open a scratch VarFP object for fetching variables */
+            pState->pFetchFP = VARFP_Open( varfp_name, VARFP_FETCH_SIZE );
+            if ( pState->pFetchFP != NULL )
+            {
+                pState->fetchFd = VARFP_GetFd( pState->pFetchFP );
+            }
+
+            if ( pState->fetchFd == -1 )
+            {
+                result = EBADF;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ProcessTrigger                                                            */
+/*!
+    Process a notification of a trigger variable
+
+    The ProcessTrigger function checks the condition of a trigger record
+    whose variable has been modified, and if the change is significant,
+    marks the template dirty so it will be rendered in the current render
+    cycle.
+
+    If the template has a commit variable, a trigger only marks the
+    template as pending, and the template is marked dirty when the commit
+    variable is notified, if any trigger has marked it since the last
+    commit.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        pTemplate
+            pointer to the triggered template
+
+    @param[in]
+        pTriggerVar
+            pointer to the trigger record, or the commit record, of the
+            modified variable
+
+    @retval EOK - the trigger was successfully processed
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int ProcessTrigger( TemplateSvcState *pState,
+                           Template *pTemplate,
+                           TriggerVar *pTriggerVar )
+{
+    int result = EINVAL;
+
+    if ( ( pState != NULL ) &&
+         ( pTemplate != NULL ) &&
+         ( pTriggerVar != NULL ) )
+    {
+        result = EOK;
+
+        if ( pTriggerVar == pTemplate->pCommit )
+        {
+            if ( pTemplate->pending == true )
+            {
+                /* the transaction is complete */
+                pTemplate->pending = false;
+                MarkDirty( pTemplate );
+            }
+        }
+        else if ( ( pTriggerVar->condition != TRIGGER_ALWAYS ) &&
+                  ( CheckCondition( pState, pTriggerVar ) == false ) )
+        {
+            /* the change is not significant */
+            pTriggerVar->filtered++;
+            pTemplate->filtered++;
+            METRICS_Filtered( pTemplate->pMetrics );
+            if ( pTemplate->pTenant != NULL )
+            {
+                METRICS_Filtered( pTemplate->pTenant->pMetrics );
+            }
+        }
+        else if ( pTemplate->pCommit != NULL )
+        {
+            /* wait for the transaction to be committed */
+            pTemplate->pending = true;
+        }
+        else
+        {
+            MarkDirty( pTemplate );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  BuildIndex                                                                */
+/*!
+    Rebuild the trigger index
+
+    The BuildIndex function indexes the trigger records of all of the
+    templates by variable handle.  The commit record of a template is
+    indexed before its triggers, so a commit completes the transaction
+    before a trigger of the same variable starts the next one.  A
+    variable which is listed more than once in the triggers of a template
+    only triggers it once: each template is given a new stamp, and a
+    trigger is skipped if its variable already carries the stamp, so
+    the duplicates are dropped in a single pass.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @retval EOK - the trigger index was rebuilt
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int BuildIndex( TemplateSvcState *pState )
+{
+    int result = EOK;
+    Template *pTemplate;
+    TriggerVar *pTriggers;
+    VarEntry *pEntry;
+    size_t i;
+    int rc;
+
+    TRIGINDEX_Clear( pState->pTrigIndex );
+
+    for ( pTemplate = pState->pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pTemplate->pNext )
+    {
+        pState->indexStamp++;
+
+        if ( ( pTemplate->pCommit != NULL ) &&
+             ( pTemplate->pCommit->hVar != VAR_INVALID ) )
+        {
+            rc = TRIGINDEX_Add( pState->pTrigIndex,
+                                pTemplate->pCommit->hVar,
+                                pTemplate,
+                                pTemplate->pCommit );
+            if ( rc != EOK )
+            {
+                result = rc;
+            }
+        }
+
+        pTriggers = pTemplate->pTriggers;
+        for ( i = 0 ; i < pTemplate->numTriggers ; i++ )
+        {
+            pEntry = pTriggers[i].pEntry;
+            if ( ( pTriggers[i].hVar == VAR_INVALID ) ||
+                 ( ( pEntry != NULL ) &&
+                   ( pEntry->indexStamp == pState->indexStamp ) ) )
+            {
+                /* the variable is not found, or is already indexed for
+                   this template */
+            }
+            else
+            {
+                if ( pEntry != NULL )
+                {
+                    pEntry->indexStamp = pState->indexStamp;
+                }
+
+                rc = TRIGINDEX_Add( pState->pTrigIndex,
+                                    pTriggers[i].hVar,
+                                    pTemplate,
+                                    &pTriggers[i] );
+                if ( rc != EOK )
+                {
+                    result = rc;
+                }
+            }
+        }
+    }
+
+    rc = TRIGINDEX_Build( pState->pTrigIndex );
+    if ( ( result == EOK ) && ( rc == EOK ) )
+    {
+        pState->reindex = false;
+    }
+    else
+    {
+        LOGGER_Log( LOGGER_ERROR, "Cannot build the trigger index" );
+        result = ENOMEM;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  MarkDirty                                                                 */
+/*!
+    Mark a triggered template to be rendered in the current render cycle
+
+    @param[in]
+        pTemplate
+            pointer to the triggered template
+
+==============================================================================*/
+static void MarkDirty( Template *pTemplate )
+{
+    if ( ( pTemplate->dirty == false ) &&
+         ( pTemplate->pMetrics != NULL ) )
+    {
+        pTemplate->triggerNs = METRICS_Now();
+    }
+
+    if ( pTemplate->intervalMs != 0 )
+    {
+        /* defer the next periodic render */
+        pTemplate->triggeredNs = METRICS_Now();
+    }
+
+    pTemplate->dirty = true;
+    (void)QueueTemplate( pTemplate );
+}
+
+/*============================================================================*/
+/*  ScheduleRender                                                            */
+/*!
+    Schedule a render cycle from the event loop
+
+    The render cycle runs from the retry timer, so a cycle scheduled
+    while the deferred templates are waiting replaces their retry.  The
+    cycle reschedules the retry while templates remain deferred.  Nothing
+    is scheduled if the service is not attached to an event loop.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        delayNs
+            time until the render cycle, in nanoseconds
+
+==============================================================================*/
+static void ScheduleRender( TemplateSvcState *pState, uint64_t delayNs )
+{
+    if ( pState->pEventLoop != NULL )
+    {
+        if ( pState->pRetryTimer == NULL )
+        {
+            pState->pRetryTimer = EVENTLOOP_CreateTimer( pState->pEventLoop,
+                                                         RetryDeferred,
+                                                         pState );
+        }
+
+        if ( pState->pRetryTimer != NULL )
+        {
+            (void)EVENTLOOP_SetTimer( pState->pRetryTimer, delayNs, 0 );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  QueueTemplate                                                             */
+/*!
+    Add a template to the dirty set of its template service
+
+    The render cycle only visits the templates of the dirty set, so a
+    notification costs the same no matter how many templates are loaded.
+    A template is only added once, however often it is triggered.
+
+    @param[in]
+        pTemplate
+            pointer to the dirty template
+
+    @retval EOK - the template is in the dirty set
+    @retval ENOMEM - the dirty set could not be grown
+
+==============================================================================*/
+static int QueueTemplate( Template *pTemplate )
+{
+    int result = EOK;
+    TemplateSvcState *pState = pTemplate->pState;
+    Template **ppDirty;
+    size_t size;
+
+    if ( ( pState != NULL ) &&
+         ( pTemplate->queued == false ) )
+    {
+        if ( pState->numDirty == pState->dirtySize )
+        {
+            size = ( pState->dirtySize > 0 ) ? pState->dirtySize * 2
+                                             : DIRTY_INITIAL_SIZE;
+            ppDirty = realloc( pState->ppDirty, size * sizeof( Template * ) );
+            if ( ppDirty != NULL )
+            {
+                pState->ppDirty = ppDirty;
+                pState->dirtySize = size;
+            }
+            else
+            {
+                result = ENOMEM;
+                LOGGER_Log( LOGGER_ERROR,
+                            "Cannot queue template %s",
+                            pTemplate->name );
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pState->ppDirty[pState->numDirty++] = pTemplate;
+            pTemplate->queued = true;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  DequeueTemplate                                                           */
+/*!
+    Remove a template from the dirty set
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            pointer to the template to remove
+
+==============================================================================*/
+static void DequeueTemplate( TemplateSvcState *pState, Template *pTemplate )
+{
+    size_t i;
+
+    for ( i = 0 ; ( pTemplate->queued == true ) && ( i < pState->numDirty ) ;
+          i++ )
+    {
+        if ( pState->ppDirty[i] == pTemplate )
+        {
+            pState->ppDirty[i] = pState->ppDirty[--pState->numDirty];
+            pTemplate->queued = false;
+        }
+    }
+}
+
+/*============================================================================*/
+/*  CompareRank                                                               */
+/*!
+    Compare two dirty templates by their position in the render order
+
+    @param[in]
+        pA
+            pointer to the first template pointer
+
+    @param[in]
+        pB
+            pointer to the second template pointer
+
+    @retval <0, 0 or >0 as the first template renders before, with, or
+            after the second
+
+==============================================================================*/
+static int CompareRank( const void *pA, const void *pB )
+{
+    int64_t a = ( *(Template * const *)pA )->rank;
+    int64_t b = ( *(Template * const *)pB )->rank;
+
+    return ( a > b ) - ( a < b );
+}
+
+/*============================================================================*/
+/*  AdmitRender                                                               */
+/*!
+    Apply the tenant's render rate limit to a triggered template
+
+    The AdmitRender function is called for each template which is dirty,
+    or was deferred in an earlier render cycle.  The renders of a tenant
+    are limited by a token bucket which holds up to one second of its
+    render rate.  A template which is admitted is marked dirty, and a
+    template which is not is deferred until a later render cycle.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            pointer to the triggered template
+
+    @retval true - the template is rendered in this cycle
+    @retval false - the template is deferred
+
+==============================================================================*/
+static bool AdmitRender( TemplateSvcState *pState, Template *pTemplate )
+{
+    Tenant *pTenant = pTemplate->pTenant;
+    bool result = true;
+    uint64_t now;
+    double rate;
+
+    (void)pState;
+
+    if ( ( pTenant != NULL ) &&
+         ( pTenant->maxRendersPerSec != 0 ) )
+    {
+        /* top up the renders available to the tenant */
+        now = METRICS_Now();
+        rate = (double)pTenant->maxRendersPerSec;
+        pTenant->tokens += ( ( now - pTenant->refillNs ) * rate ) / 1e9;
+        if ( pTenant->tokens > rate )
+        {
+            pTenant->tokens = rate;
+        }
+
+        pTenant->refillNs = now;
+
+        if ( pTenant->tokens >= 1.0 )
+        {
+            pTenant->tokens -= 1.0;
+        }
+        else
+        {
+            result = false;
+        }
+    }
+
+    if ( result == true )
+    {
+        pTemplate->dirty = true;
+        pTemplate->deferred = false;
+    }
+    else
+    {
+        if ( pTemplate->deferred == false )
+        {
+            /* count each deferred trigger once */
+            pTemplate->throttled++;
+            pTenant->throttled++;
+            METRICS_Throttled( pTemplate->pMetrics );
+            METRICS_Throttled( pTenant->pMetrics );
+        }
+
+        pTemplate->dirty = false;
+        pTemplate->deferred = true;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RetryDeferred                                                             */
+/*!
+    Render the templates deferred by a tenant's rate limit
+
+    The RetryDeferred function is an event loop timer handler which runs
+    a render cycle once a deferred template may be admitted, or when a
+    cycle is scheduled outside of a notification (see ScheduleRender).
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        pTimer
+            pointer to the retry timer
+
+    @param[in]
+        expirations
+            number of expirations since the last call
+
+    @param[in]
+        arg
+            pointer to the template service state
+
+==============================================================================*/
+static void RetryDeferred( EventLoop *pLoop,
+                           EventTimer *pTimer,
+                           uint64_t expirations,
+                           void *arg )
+{
+    (void)pLoop;
+    (void)pTimer;
+    (void)expirations;
+
+    TEMPLATESVC_RenderTemplates( (TemplateSvcState *)arg );
+}
+
+/*============================================================================*/
+/*  StartRescan                                                               */
+/*!
+    Start the wildcard trigger rescan timer
+
+    The timer is only started if one of the templates has a wildcard
+    trigger, and is left running if it has already been started.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @retval EOK - the timer was started, or no triggers are wildcards
+    @retval ENOMEM - the timer could not be created
+    @retval other - the timer could not be set
+
+==============================================================================*/
+static int StartRescan( TemplateSvcState *pState )
+{
+    int result = EOK;
+    Template *pTemplate = pState->pTemplates;
+    uint64_t intervalNs = (uint64_t)WILDCARD_RESCAN_MS * 1000000;
+
+    while ( ( pTemplate != NULL ) && ( pTemplate->numWildcards == 0 ) )
+    {
+        pTemplate = pTemplate->pNext;
+    }
+
+    if ( ( pTemplate != NULL ) && ( pState->pRescanTimer == NULL ) )
+    {
+        pState->pRescanTimer = EVENTLOOP_CreateTimer( pState->pEventLoop,
+                                                      RescanTimer,
+                                                      pState );
+        result = ( pState->pRescanTimer != NULL )
+                 ? EVENTLOOP_SetTimer( pState->pRescanTimer,
+                                       intervalNs,
+                                       intervalNs )
+                 : ENOMEM;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RescanTimer                                                               */
+/*!
+    Expand the wildcard triggers to newly created variables
+
+    The RescanTimer function is an event loop timer handler which runs
+    a wildcard trigger rescan.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        pTimer
+            pointer to the rescan timer
+
+    @param[in]
+        expirations
+            number of expirations since the last call
+
+    @param[in]
+        arg
+            pointer to the template service state
+
+==============================================================================*/
+static void RescanTimer( EventLoop *pLoop,
+                         EventTimer *pTimer,
+                         uint64_t expirations,
+                         void *arg )
+{
+    (void)pLoop;
+    (void)pTimer;
+    (void)expirations;
+
+    (void)TEMPLATESVC_RescanWildcards( (TemplateSvcState *)arg );
+}
+
+/*============================================================================*/
+/*  StartResolver                                                             */
+/*!
+    Start retrying the variables which have not been found
+
+    The retry timer is only started if the service is attached to an
+    event loop and a variable is pending, and is left running if the
+    variables are already being retried.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+==============================================================================*/
+static void StartResolver( TemplateSvcState *pState )
+{
+    uint64_t delayNs;
+
+    if ( ( pState->pEventLoop != NULL ) &&
+         ( pState->resolveDelayMs == 0 ) &&
+         ( CountPending( pState ) > 0 ) )
+    {
+        if ( pState->pResolveTimer == NULL )
+        {
+            pState->pResolveTimer = EVENTLOOP_CreateTimer( pState->pEventLoop,
+                                                           ResolveTimer,
+                                                           pState );
+        }
+
+        if ( pState->pResolveTimer != NULL )
+        {
+            pState->resolveDelayMs = RESOLVE_MIN_DELAY_MS;
+            delayNs = (uint64_t)pState->resolveDelayMs * 1000000;
+            (void)EVENTLOOP_SetTimer( pState->pResolveTimer, delayNs, 0 );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  ResolveTimer                                                              */
+/*!
+    Retry the variables which have not been found
+
+    The ResolveTimer function is an event loop timer handler which
+    retries the pending variables.  The retry delay doubles each time
+    no more variables are found, up to a limit, and is reset when some
+    are, since variables are usually created in bursts.  The retries
+    stop once every variable has been found.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        pTimer
+            pointer to the retry timer
+
+    @param[in]
+        expirations
+            number of expirations since the last call
+
+    @param[in]
+        arg
+            pointer to the template service state
+
+==============================================================================*/
+static void ResolveTimer( EventLoop *pLoop,
+                          EventTimer *pTimer,
+                          uint64_t expirations,
+                          void *arg )
+{
+    TemplateSvcState *pState = (TemplateSvcState *)arg;
+    size_t before = pState->unresolved;
+    size_t pending;
+    uint32_t delayMs;
+
+    (void)pLoop;
+    (void)expirations;
+
+    pending = TEMPLATESVC_ResolvePending( pState );
+    if ( pending == 0 )
+    {
+        pState->resolveDelayMs = 0;
+    }
+    else
+    {
+        delayMs = pState->resolveDelayMs * 2;
+        if ( pending < before )
+        {
+            delayMs = RESOLVE_MIN_DELAY_MS;
+        }
+        else if ( delayMs > RESOLVE_MAX_DELAY_MS )
+        {
+            delayMs = RESOLVE_MAX_DELAY_MS;
+        }
+
+        pState->resolveDelayMs = delayMs;
+        (void)EVENTLOOP_SetTimer( pTimer, (uint64_t)delayMs * 1000000, 0 );
+    }
+}
+
+/*============================================================================*/
+/*  CountPending                                                              */
+/*!
+    Count the variables which have not been found
+
+    The variables are counted without looking them up.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @retval number of pending variables
+
+==============================================================================*/
+static size_t CountPending( TemplateSvcState *pState )
+{
+    Template *pTemplate;
+    size_t pending = 0;
+    size_t i;
+
+    for ( pTemplate = pState->pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pTemplate->pNext )
+    {
+        for ( i = 0 ; i < pTemplate->numTriggers ; i++ )
+        {
+            pending += ( pTemplate->pTriggers[i].hVar == VAR_INVALID ) ? 1 : 0;
+        }
+
+        if ( pTemplate->pCommit != NULL )
+        {
+            pending += ( pTemplate->pCommit->hVar == VAR_INVALID ) ? 1 : 0;
+        }
+
+        for ( i = 0 ; i < pTemplate->numVars ; i++ )
+        {
+            pending += ( pTemplate->pVars[i].pEntry == NULL ) ? 1 : 0;
+        }
+
+        pending += UnresolvedRefs( pTemplate->pCompiled );
+    }
+
+    pState->unresolved = pending;
+
+    return pending;
+}
+
+/*============================================================================*/
+/*  ResolveTriggers                                                           */
+/*!
+    Retry the trigger variables which have not been found
+
+    The notification of each trigger variable which is found is
+    requested, and the initial value of a conditional trigger is
+    recorded.  The variables are looked up quietly, since they were
+    reported when their templates were set up.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTriggers
+            pointer to the array of trigger records
+
+    @param[in]
+        numTriggers
+            number of trigger records
+
+    @param[in,out]
+        pPending
+            pointer to the count of pending variables to add to
+
+    @retval number of trigger variables found
+
+==============================================================================*/
+static size_t ResolveTriggers( TemplateSvcState *pState,
+                               TriggerVar *pTriggers,
+                               size_t numTriggers,
+                               size_t *pPending )
+{
+    TriggerVar *pTrigger;
+    size_t resolved = 0;
+    size_t i;
+
+    for ( i = 0 ; i < numTriggers ; i++ )
+    {
+        pTrigger = &pTriggers[i];
+        if ( pTrigger->hVar == VAR_INVALID )
+        {
+            if ( VARCACHE_Lookup( pState->pVarCache,
+                                  pState->hVarServer,
+                                  pTrigger->name ) == NULL )
+            {
+                (*pPending)++;
+            }
+            else if ( SetupTriggerNotification( pState->hVarServer,
+                                                pState->pVarCache,
+                                                pTrigger ) == EOK )
+            {
+                if ( pTrigger->condition != TRIGGER_ALWAYS )
+                {
+                    (void)CheckCondition( pState, pTrigger );
+                }
+
+                resolved++;
+            }
+        }
+    }
+
+    return resolved;
+}
+
+/*============================================================================*/
+/*  UnresolvedRefs                                                            */
+/*!
+    Count the variable references of a compiled template not yet found
+
+    @param[in]
+        pCompiled
+            pointer to the compiled template (or NULL)
+
+    @retval number of unresolved variable references
+
+==============================================================================*/
+static size_t UnresolvedRefs( CompiledTemplate *pCompiled )
+{
+    size_t count = 0;
+    size_t i;
+
+    if ( pCompiled != NULL )
+    {
+        for ( i = 0 ; i < pCompiled->numSegments ; i++ )
+        {
+            if ( ( pCompiled->pSegments[i].type == SEG_VAR ) &&
+                 ( pCompiled->pSegments[i].hVar == VAR_INVALID ) )
+            {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+/*============================================================================*/
+/*  RegisterVars                                                              */
+/*!
+    Register the variables of the loaded templates together
+
+    The RegisterVars function looks up the variables which the templates
+    were set up without, since the lookups were deferred while they were
+    loaded, and requests the notifications of the trigger variables.
+    Each lookup and request is a variable server round trip, so the
+    distinct variables of all of the templates are registered at once,
+    spread over several variable server connections (see VARREG_Run).
+    The variables are then added to the variable cache, and the
+    templates are set up from it, without any further round trips.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @retval EOK - the variables were registered
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int RegisterVars( TemplateSvcState *pState )
+{
+    int result = ENOMEM;
+    Template *pTemplate;
+    CompiledTemplate *pCompiled;
+    VarRegItem *pItem;
+    VarEntry *pEntry;
+    uint64_t start = METRICS_Now();
+    size_t connections;
+    size_t count;
+    size_t found = 0;
+    size_t i;
+    int rc;
+
+    if ( pState->pRegistrar == NULL )
+    {
+        pState->pRegistrar = VARREG_Create();
+    }
+
+    if ( pState->pRegistrar != NULL )
+    {
+        result = EOK;
+        VARREG_Clear( pState->pRegistrar );
+
+        for ( pTemplate = pState->pTemplates ;
+              pTemplate != NULL ;
+              pTemplate = pTemplate->pNext )
+        {
+            rc = AddTriggers( pState->pRegistrar,
+                              pTemplate->pTriggers,
+                              pTemplate->numTriggers );
+            if ( ( rc == EOK ) && ( pTemplate->pCommit != NULL ) )
+            {
+                rc = AddTriggers( pState->pRegistrar, pTemplate->pCommit, 1 );
+            }
+
+            for ( i = 0 ; ( rc == EOK ) && ( i < pTemplate->numVars ) ; i++ )
+            {
+                if ( pTemplate->pVars[i].pEntry == NULL )
+                {
+                    rc = VARREG_Add( pState->pRegistrar,
+                                     pTemplate->pVars[i].name,
+                                     VAR_INVALID,
+                                     false );
+                }
+            }
+
+            /* the references of an incremental template are watched */
+            pCompiled = pTemplate->pCompiled;
+            for ( i = 0 ;
+                  ( rc == EOK ) &&
+                  ( pCompiled != NULL ) &&
+                  ( i < pCompiled->numSegments ) ;
+                  i++ )
+            {
+                if ( ( pCompiled->pSegments[i].type == SEG_VAR ) &&
+                     ( pCompiled->pSegments[i].hVar == VAR_INVALID ) )
+                {
+                    rc = VARREG_Add( pState->pRegistrar,
+                                     pCompiled->pSegments[i].name,
+                                     VAR_INVALID,
+                                     pCompiled->incremental );
+                }
+            }
+
+            if ( rc != EOK )
+            {
+                /* the variables left out are retried in the background */
+                result = rc;
+            }
+        }
+
+        connections = VARREG_Run( pState->pRegistrar,
+                                  pState->hVarServer,
+                                  pState->connections );
+
+        count = VARREG_Count( pState->pRegistrar );
+        for ( i = 0 ; i < count ; i++ )
+        {
+            pItem = VARREG_Get( pState->pRegistrar, i );
+            if ( pItem->hVar != VAR_INVALID )
+            {
+                pEntry = VARCACHE_Add( pState->pVarCache,
+                                       pItem->hVar,
+                                       pItem->name );
+                if ( pItem->hWatch != NULL )
+                {
+                    VARCACHE_SetWatched( pEntry,
+                                         ( pItem->hWatch != pState->hVarServer )
+                                            ? pItem->hWatch
+                                            : NULL );
+                }
+
+                found++;
+            }
+            else
+            {
+                LOGGER_Log( LOGGER_WARNING,
+                            "Waiting for variable: %s",
+                            pItem->name );
+            }
+        }
+
+        /* set up the templates from the variable cache */
+        (void)TEMPLATESVC_ResolvePending( pState );
+
+        LOGGER_Log( LOGGER_INFO,
+                    "Registered %zu of %zu variables on %zu connections "
+                    "in %" PRIu64 " us",
+                    found,
+                    count,
+                    connections,
+                    ( METRICS_Now() - start ) / 1000 );
+
+        VARREG_Clear( pState->pRegistrar );
+    }
+
+    VARCACHE_Defer( pState->pVarCache, false );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  AddTriggers                                                               */
+/*!
+    Add the trigger variables which have not been found to the registrar
+
+    @param[in]
+        pReg
+            pointer to the variable registrar
+
+    @param[in]
+        pTriggers
+            pointer to the array of trigger records
+
+    @param[in]
+        numTriggers
+            number of trigger records
+
+    @retval EOK - the trigger variables were added
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int AddTriggers( VarReg *pReg,
+                        TriggerVar *pTriggers,
+                        size_t numTriggers )
+{
+    int result = EOK;
+    size_t i;
+
+    for ( i = 0 ; ( result == EOK ) && ( i < numTriggers ) ; i++ )
+    {
+        if ( pTriggers[i].hVar == VAR_INVALID )
+        {
+            result = VARREG_Add( pReg, pTriggers[i].name, VAR_INVALID, true );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RenderAll                                                                 */
+/*!
+    Render every template once
+
+    The RenderAll function renders the templates once their notifications
+    are in place, so the output reflects any change made while the
+    notifications were being requested.  A transactional template is
+    left until its next commit, so an incomplete transaction is not
+    rendered.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+==============================================================================*/
+static void RenderAll( TemplateSvcState *pState )
+{
+    Template *pTemplate;
+    uint64_t start = METRICS_Now();
+    size_t count = 0;
+
+    for ( pTemplate = pState->pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pTemplate->pNext )
+    {
+        if ( pTemplate->pCommit == NULL )
+        {
+            MarkDirty( pTemplate );
+            count++;
+        }
+    }
+
+    if ( count > 0 )
+    {
+        (void)TEMPLATESVC_RenderTemplates( pState );
+    }
+
+    LOGGER_Log( LOGGER_INFO,
+                "Rendered %zu templates in %" PRIu64 " us",
+                count,
+                ( METRICS_Now() - start ) / 1000 );
+}
+
+/*============================================================================*/
+/*  ProcessPendingSignals                                                     */
+/*!
+    Process pending trigger signals
+
+    The ProcessPendingSignals function collects any MODIFIED signals which
+    are already queued, without blocking, and marks the templates they
+    trigger as dirty.  This batches a burst of triggers into a single
+    render cycle.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @retval EOK - the pending signals were processed
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int ProcessPendingSignals( TemplateSvcState *pState )
+{
+    int result = EINVAL;
+    sigset_t mask;
+    siginfo_t info;
+    struct timespec timeout;
+    int count = 0;
+
+    if ( pState != NULL )
+    {
+        result = EOK;
+
+        sigemptyset( &mask );
+        sigaddset( &mask, SIG_VAR_MODIFIED );
+
+        timeout.tv_sec = 0;
+        timeout.tv_nsec = 0;
+
+        while ( ( count++ < MAX_CYCLE_SIGNALS ) &&
+                ( sigtimedwait( &mask, &info, &timeout ) == SIG_VAR_MODIFIED ) )
+        {
+            if ( pState->pCapture != NULL )
+            {
+                CaptureSignal( pState,
+                               SIG_VAR_MODIFIED,
+                               info.si_value.sival_int );
+            }
+
+            TEMPLATESVC_ProcessTemplates( pState,
+                                          (VAR_HANDLE)info.si_value.sival_int );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  FetchTemplate                                                             */
+/*!
+    Fetch the variables referenced by a template
+
+    The FetchTemplate function adds the variables referenced by the
+    template to the current cycle's snapshot.  The template is compiled
+    (or re-compiled) first if necessary.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        pTemplate
+            pointer to the template
+
+    @retval EOK - the variables were fetched
+    @retval EINVAL - invalid arguments
+    @retval other - one or more variables could not be fetched
+
+==============================================================================*/
+static int FetchTemplate( TemplateSvcState *pState, Template *pTemplate )
+{
+    int result = EINVAL;
+    TriggerVar *pVar;
+    CompiledTemplate *pCompiled;
+    size_t i;
+
+    if ( ( pState != NULL ) &&
+         ( pTemplate != NULL ) )
+    {
+        result = EOK;
+
+        if ( pTemplate->format != FMT_TEXT )
+        {
+            for ( i = 0 ; i < pTemplate->numVars ; i++ )
+            {
+                pVar = &pTemplate->pVars[i];
+                if ( pVar->pEntry != NULL )
+                {
+                    VARCACHE_Fetch( pState->pVarCache,
+                                    pState->hVarServer,
+                                    pVar->pEntry );
+                }
+            }
+        }
+        else
+        {
+            if ( ( pTemplate->pCompiled == NULL ) ||
+                 ( ( pTemplate->watched == true )
+                        ? pTemplate->stale
+                        : RENDER_IsStale( pTemplate->pCompiled ) ) )
+            {
+                result = RENDER_Compile( pTemplate->templateFileName,
+                                         &pCompiled );
+                if ( result == EOK )
+                {
+                    pTemplate->stale = false;
+                    RENDER_Free( pTemplate->pCompiled );
+                    pTemplate->pCompiled = pCompiled;
+                    pCompiled->incremental = pTemplate->incremental;
+                    pCompiled->nativeFormat = pTemplate->nativeFormat;
+                    RENDER_Resolve( pState->hVarServer,
+                                    pState->pVarCache,
+                                    pCompiled );
+
+                    if ( pTemplate->autoTrigger == true )
+                    {
+                        /* follow the template's new references */
+                        (void)DeriveTriggers( pState, pTemplate );
+                        (void)SetupTriggerNotifications(
+                                    pState->hVarServer,
+                                    pState->pVarCache,
+                                    pTemplate->pTriggers,
+                                    pTemplate->numTriggers );
+                        (void)SweepNotifications( pState );
+                        StartResolver( pState );
+                    }
+                }
+            }
+
+            if ( pTemplate->pCompiled != NULL )
+            {
+                result = RENDER_Fetch( pState->hVarServer,
+                                       pTemplate->pCompiled );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  OutputTemplate                                                            */
+/*!
+    Render a template and deliver it to its target
+
+    The OutputTemplate function renders the template using the output
+    path for its format and target type.  If the template publishes
+    metrics, the render, sink and trigger-to-output times are recorded.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        pTemplate
+            pointer to the template
+
+    @retval EOK - the template was rendered and delivered
+    @retval ENOTSUP - unsupported template type
+    @retval EINVAL - invalid arguments
+    @retval other - template processing failed
+
+==============================================================================*/
+static int OutputTemplate( TemplateSvcState *pState, Template *pTemplate )
+{
+    int result = EINVAL;
+    uint64_t start = 0;
+    uint64_t end;
+
+    if ( ( pState != NULL ) &&
+         ( pTemplate != NULL ) )
+    {
+        if ( pTemplate->pMetrics != NULL )
+        {
+            start = METRICS_Now();
+            pTemplate->renderedNs = start;
+        }
+
+        if ( pTemplate->format != FMT_TEXT )
+        {
+            result = PrintStructured( pState, pTemplate );
+        }
+        else
+        {
+            switch( pTemplate->type )
+            {
+                case TMPL_FD:
+                    result = TEMPLATESVC_PrintTemplateFD( pState, pTemplate );
+                    break;
+
+                case TMPL_MQ:
+                    result = TEMPLATESVC_PrintTemplateMQ( pState, pTemplate );
+                    break;
+
+                default:
+                    result = ENOTSUP;
+                    break;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pTemplate->renders++;
+            if ( pTemplate->pTenant != NULL )
+            {
+                pTemplate->pTenant->renders++;
+            }
+        }
+        else
+        {
+            LOGGER_Log( LOGGER_ERROR,
+                        "Cannot output %s: %s",
+                        pTemplate->target,
+                        strerror( result ) );
+        }
+
+        if ( ( pTemplate->pMetrics != NULL ) &&
+             ( result == EOK ) )
+        {
+            end = METRICS_Now();
+
+            METRICS_Record( pTemplate->pMetrics,
+                            METRIC_RENDER,
+                            pTemplate->fetchNs +
+                                ( pTemplate->renderedNs - start ) );
+
+            METRICS_Record( pTemplate->pMetrics,
+                            METRIC_SINK,
+                            end - pTemplate->renderedNs );
+
+            METRICS_Record( pTemplate->pMetrics,
+                            METRIC_LATENCY,
+                            end - pTemplate->triggerNs );
+
+            if ( pTemplate->pTenant != NULL )
+            {
+                /* attribute the render cost to the tenant */
+                METRICS_Record( pTemplate->pTenant->pMetrics,
+                                METRIC_RENDER,
+                                pTemplate->fetchNs +
+                                    ( pTemplate->renderedNs - start ) );
+
+                METRICS_Record( pTemplate->pTenant->pMetrics,
+                                METRIC_SINK,
+                                end - pTemplate->renderedNs );
+
+                METRICS_Record( pTemplate->pTenant->pMetrics,
+                                METRIC_LATENCY,
+                                end - pTemplate->triggerNs );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TemplateName                                                              */
+/*!
+    Get the name of a template
+
+    The TemplateName function gets the name used to publish the template's
+    metrics.  This is the "name" attribute of the template definition if
+    it is specified, otherwise it is the base name of the template file,
+    or of the target for structured output templates.
+
+    @param[in]
+        pDef
+            pointer to the template definition
+
+    @retval pointer to the template name
+    @retval NULL if the template has no name
+
+==============================================================================*/
+static char *TemplateName( ConfTemplate *pDef )
+{
+    char *name = NULL;
+    char *p;
+
+    if ( pDef != NULL )
+    {
+        name = pDef->name;
+        if ( name == NULL )
+        {
+            name = ( pDef->template != NULL ) ? pDef->template
+                                              : pDef->target;
+
+            p = ( name != NULL ) ? strrchr( name, '/' ) : NULL;
+            if ( p != NULL )
+            {
+                name = p + 1;
+            }
+        }
+    }
+
+    return name;
+}
+
+/*============================================================================*/
+/*  PrintMetrics                                                              */
+/*!
+    Print a template metric
+
+    The PrintMetrics function handles a PRINT notification for one of the
+    metric variables published by the template service.  It opens a print
+    session with the requesting client and prints the histogram summary
+    of the metric being read.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        id
+            print session identifier
+
+    @retval EOK - the metric was printed
+    @retval ENOENT - the variable is not a template metric
+    @retval EINVAL - invalid arguments
+    @retval other - the print session could not be opened
+
+==============================================================================*/
+static int PrintMetrics( TemplateSvcState *pState, int32_t id )
+{
+    int result = EINVAL;
+    Template *pTemplate;
+    Tenant *pTenant;
+    VAR_HANDLE hVar;
+    int fd;
+
+    if ( pState != NULL )
+    {
+        result = VAR_OpenPrintSession( pState->hVarServer, id, &hVar, &fd );
+        if ( result == EOK )
+        {
+            result = ENOENT;
+
+            pTemplate = pState->pTemplates;
+            while ( ( pTemplate != NULL ) && ( result == ENOENT ) )
+            {
+                result = METRICS_Print( pTemplate->pMetrics, hVar, fd );
+                pTemplate = pTemplate->pNext;
+            }
+
+            pTenant = pState->pTenants;
+            while ( ( pTenant != NULL ) && ( result == ENOENT ) )
+            {
+                result = METRICS_Print( pTenant->pMetrics, hVar, fd );
+                pTenant = pTenant->pNext;
+            }
+
+            VAR_ClosePrintSession( pState->hVarServer, id, fd );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  StartCapture                                                              */
+/*!
+    Start recording the received triggers
+
+    The StartCapture function creates the trigger capture file and writes
+    the name table of every variable referenced by the templates, so the
+    capture can be replayed without access to the variable server.  If
+    value capture is enabled, every value fetched from the variable server
+    is recorded from then on.
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @retval EOK - the capture was started
+    @retval EBADF - the capture file could not be created
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int StartCapture( TemplateSvcState *pState )
+{
+    int result = EINVAL;
+    Template *pTemplate;
+    TriggerVar *pVar;
+    Segment *pSegment;
+    size_t i;
+
+    if ( ( pState != NULL ) &&
+         ( pState->pCaptureFile != NULL ) )
+    {
+        result = EBADF;
+
+        pState->pCapture = CAPTURE_Create( pState->pCaptureFile,
+                                           pState->captureFlags );
+        if ( pState->pCapture != NULL )
+        {
+            for ( pTemplate = pState->pTemplates ;
+                  pTemplate != NULL ;
+                  pTemplate = pTemplate->pNext )
+            {
+                for ( i = 0 ; i < pTemplate->numTriggers ; i++ )
+                {
+                    pVar = &pTemplate->pTriggers[i];
+                    CaptureVar( pState, pVar->hVar, pVar->name );
+                }
+
+                for ( i = 0 ; i < pTemplate->numVars ; i++ )
+                {
+                    pVar = &pTemplate->pVars[i];
+                    CaptureVar( pState, pVar->hVar, pVar->name );
+                }
+
+                for ( i = 0 ;
+                      ( pTemplate->pCompiled != NULL ) &&
+                      ( i < pTemplate->pCompiled->numSegments ) ;
+                      i++ )
+                {
+                    pSegment = &pTemplate->pCompiled->pSegments[i];
+                    if ( pSegment->type == SEG_VAR )
+                    {
+                        CaptureVar( pState, pSegment->hVar, pSegment->name );
+                    }
+                }
+            }
+
+            VARCACHE_SetCapture( pState->pVarCache, pState->pCapture );
+            result = EOK;
+        }
+        else
+        {
+            LOGGER_Log( LOGGER_ERROR,
+                        "Cannot create capture file: %s",
+                        pState->pCaptureFile );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CaptureVar                                                                */
+/*!
+    Add a variable to the trigger capture name table
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        hVar
+            handle of the variable
+
+    @param[in]
+        name
+            name of the variable
+
+==============================================================================*/
+static void CaptureVar( TemplateSvcState *pState,
+                        VAR_HANDLE hVar,
+                        const char *name )
+{
+    VarType type = VARTYPE_INVALID;
+
+    if ( ( hVar != VAR_INVALID ) && ( name != NULL ) )
+    {
+        VAR_GetType( pState->hVarServer, hVar, &type );
+        CAPTURE_Var( pState->pCapture, hVar, type, name );
+    }
+}
+
+/*============================================================================*/
+/*  CaptureSignal                                                             */
+/*!
+    Record a received signal to the trigger capture
+
+    @param[in]
+        pState
+            pointer to the template service state
+
+    @param[in]
+        sig
+            the signal received from the variable server
+
+    @param[in]
+        sigval
+            the value associated with the signal
+
+==============================================================================*/
+static void CaptureSignal( TemplateSvcState *pState, int sig, int sigval )
+{
+    VarEntry *pEntry;
+
+    if ( sig == SIG_VAR_MODIFIED )
+    {
+        pEntry = VARCACHE_Find( pState->pVarCache, (VAR_HANDLE)sigval );
+        CAPTURE_Modified( pState->pCapture,
+                          (VAR_HANDLE)sigval,
+                          ( pEntry != NULL ) ? pEntry->name : NULL );
+    }
+    else if ( sig == SIG_VAR_PRINT )
+    {
+        CAPTURE_Print( pState->pCapture, sigval );
+    }
+}
+
+/*============================================================================*/
+/*  PrintStructured                                                           */
+/*!
+    Print a structured output record
+
+    The PrintStructured function serializes the current cycle's snapshot
+    of all of the template's output variables directly into the VARFP
+    buffer as a single JSON Lines record or CBOR map, bypassing the text
+    template engine.  Non-numeric variables are encoded as strings.
+    The record is then delivered to the template target.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            Pointer to the template to generate
+
+    @retval EOK - record generated successfully
+    @retval E2BIG - the record does not fit in the rendering buffer
+    @retval EBADF - the rendering buffer is not available
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int PrintStructured( TemplateSvcState *pState, Template *pTemplate )
+{
+    int result = EINVAL;
+    TriggerVar *pVar;
+    VarEntry *pEntry;
+    VarObject obj;
+    VarObject *pObj;
+    SerBuf sb;
+    char *pData;
+    size_t len;
+    size_t i;
+
+    if ( ( pState != NULL ) &&
+         ( pTemplate != NULL ) )
+    {
+        result = EBADF;
+
+        pData = VARFP_GetData( pState->pVarFP );
+        if ( pData != NULL )
+        {
+            SER_Init( &sb, pData, pState->varfpSize );
+
+            if ( pTemplate->format == FMT_CBOR )
+            {
+                SER_CborMapBegin( &sb, pTemplate->numVars );
+            }
+            else
+            {
+                SER_JsonBegin( &sb );
+            }
+
+            for ( i = 0 ; i < pTemplate->numVars ; i++ )
+            {
+                /* unavailable variables are encoded as null */
+                pVar = &pTemplate->pVars[i];
+                pObj = NULL;
+                pEntry = pVar->pEntry;
+                if ( ( pEntry != NULL ) && ( pEntry->valid == true ) )
+                {
+                    if ( pEntry->value.type != VARTYPE_INVALID )
+                    {
+                        pObj = &pEntry->value;
+                    }
+                    else
+                    {
+                        obj.type = VARTYPE_STR;
+                        obj.len = pEntry->textLen + 1;
+                        obj.val.str = pEntry->pText;
+                        pObj = &obj;
+                    }
+                }
+
+                if ( pTemplate->format == FMT_CBOR )
+                {
+                    SER_CborMember( &sb, pVar->name, pObj );
+                }
+                else
+                {
+                    SER_JsonMember( &sb, pVar->name, pObj );
+                }
+            }
+
+            if ( pTemplate->format != FMT_CBOR )
+            {
+                SER_JsonEnd( &sb );
+            }
+
+            if ( pTemplate->pMetrics != NULL )
+            {
+                pTemplate->renderedNs = METRICS_Now();
+            }
+
+            if ( sb.overflow == true )
+            {
+                result = E2BIG;
+            }
+            else
+            {
+                len = sb.len;
+                result = EOK;
+
+                if ( pTemplate->pCompressor != NULL )
+                {
+                    result = CompressOutput( pState,
+                                             pTemplate,
+                                             &pData,
+                                             &len );
+                }
+
+                if ( result == EOK )
+                {
+                    result = DeliverOutput( pState, pTemplate, pData, len );
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  DeliverOutput                                                             */
+/*!
+    Deliver rendered output to a template target
+
+    The DeliverOutput function opens the template's target (if it is not
+    already open), writes the output buffer to it, and closes the target
+    again unless the template is configured to keep it open.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            Pointer to the template being generated
+
+    @param[in]
+        pData
+            pointer to the output data
+
+    @param[in]
+        len
+            length of the output data
+
+    @retval EOK - output delivered successfully
+    @retval EBADF - the target could not be opened
+    @retval EINVAL - invalid arguments
+    @retval other - error returned by the output write
+
+==============================================================================*/
+static int DeliverOutput( TemplateSvcState *pState,
+                          Template *pTemplate,
+                          char *pData,
+                          size_t len )
+{
+    int result = EINVAL;
+    int rc;
+
+    if ( ( pTemplate != NULL ) &&
+         ( pTemplate->target != NULL ) &&
+         ( pData != NULL ) )
+    {
+        result = EBADF;
+
+        switch( pTemplate->type )
+        {
+            case TMPL_FD:
+                if ( pTemplate->fd == -1 )
+                {
+                    OpenTarget( pState, pTemplate );
+                }
+
+                if ( pTemplate->fd > 0 )
+                {
+                    result = WriteTarget( pState, pTemplate, pData, len );
+                    CloseTarget( pTemplate );
+                }
+                break;
+
+            case TMPL_MQ:
+                if ( pTemplate->mq <= 0 )
+                {
+                    pTemplate->mq = mq_open( pTemplate->target, O_WRONLY );
+                }
+
+                if ( pTemplate->mq > 0 )
+                {
+                    rc = mq_send( pTemplate->mq, pData, len, 0 );
+
+                    result = ( rc != 0 ) ? errno : EOK;
+
+                    if ( ( result != EOK ) ||
+                         ( pTemplate->keep_open == false ) )
+                    {
+                        mq_close( pTemplate->mq );
+                        pTemplate->mq = -1;
+                    }
+                }
+                break;
+
+            default:
+                result = ENOTSUP;
+                break;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RenderTemplate                                                            */
+/*!
+    Render a template into the VARFP memory buffer
+
+    The RenderTemplate function renders the template's compiled template
+    into the shared VARFP rendering buffer, using the variable values
+    from the current render cycle's snapshot.  The output of a compressed
+    template may be larger than the buffer: each time the buffer fills it
+    is passed to the compressor, and only the last part of the output is
+    returned, to be passed to CompressOutput.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            pointer to the template to render
+
+    @param[out]
+        ppData
+            pointer to a location to store the rendered data pointer
+
+    @param[out]
+        pLen
+            pointer to a location to store the rendered data length
+
+    @retval EOK - template rendered successfully
+    @retval E2BIG - the output does not fit in the rendering buffer
+    @retval EBADF - the rendering buffer is not available
+    @retval ENOENT - the template has not been compiled
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+static int RenderTemplate( TemplateSvcState *pState,
+                           Template *pTemplate,
+                           char **ppData,
+                           size_t *pLen )
+{
+    int result = EINVAL;
+    RenderBuf rb;
+
+    if ( ( pState != NULL ) &&
+         ( pTemplate != NULL ) &&
+         ( ppData != NULL ) &&
+         ( pLen != NULL ) )
+    {
+        result = ENOENT;
+
+        if ( pTemplate->pCompiled != NULL )
+        {
+            result = EBADF;
+
+            rb.pBuf = VARFP_GetData( pState->pVarFP );
+            rb.size = pState->varfpSize;
+            rb.len = 0;
+            rb.flush = ( pTemplate->pCompressor != NULL ) ? CompressChunk
+                                                           : NULL;
+            rb.arg = pTemplate->pCompressor;
+
+            if ( rb.pBuf != NULL )
+            {
+                result = RENDER_Template( pState->hVarServer,
+                                          pTemplate->pCompiled,
+                                          &rb );
+                if ( result == EOK )
+                {
+                    *ppData = rb.pBuf;
+                    *pLen = rb.len;
+                }
+                else
+                {
+                    /* discard a partly compressed render */
+                    COMPRESS_Abort( pTemplate->pCompressor );
+                }
+
+                if ( pTemplate->pMetrics != NULL )
+                {
+                    pTemplate->renderedNs = METRICS_Now();
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CompressChunk                                                             */
+/*!
+    Compress the contents of a full render buffer
+
+    The CompressChunk function is the flush function of the render buffer
+    of a compressed template.
+
+    @param[in]
+        pData
+            pointer to the rendered data
+
+    @param[in]
+        len
+            length of the rendered data
+
+    @param[in]
+        arg
+            pointer to the template's compressor
+
+    @retval EOK - the data was compressed
+    @retval other - compression failed
+
+==============================================================================*/
+static int CompressChunk( const char *pData, size_t len, void *arg )
+{
+    return COMPRESS_Update( (Compressor *)arg, pData, len );
+}
+
+/*============================================================================*/
+/*  CompressOutput                                                            */
+/*!
+    Compress rendered template output
+
+    The CompressOutput function compresses the rendered output into a
+    single frame using the template's compressor, and replaces the
+    output data pointer and length with the compressed frame.  The frame
+    is allocated from the cycle arena, unless the render was too large
+    for the render buffer, in which case the frame started while it was
+    rendered is terminated in the compressor's own buffer.
+    The compression ratio and time are recorded in the template's
+    metrics, and logged at the info level.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            Pointer to the template being generated
+
+    @param[in,out]
+        ppData
+            pointer to the output data pointer
+
+    @param[in,out]
+        pLen
+            pointer to the output data length
+
+    @retval EOK - output compressed successfully
+    @retval EINVAL - invalid arguments
+    @retval other - compression failed
+
+==============================================================================*/
+static int CompressOutput( TemplateSvcState *pState,
+                           Template *pTemplate,
+                           char **ppData,
+                           size_t *pLen )
+{
+    int result = EINVAL;
+    const char *pOut;
+    size_t outlen;
+    const CompressStats *pStats;
+
+    if ( ( pState != NULL ) &&
+         ( pTemplate != NULL ) &&
+         ( ppData != NULL ) &&
+         ( pLen != NULL ) )
+    {
+        result = COMPRESS_Frame( pTemplate->pCompressor,
+                                 pState->pCycleArena,
+                                 *ppData,
+                                 *pLen,
+                                 &pOut,
+                                 &outlen );
+        if ( result == EOK )
+        {
+            *ppData = (char *)pOut;
+            *pLen = outlen;
+
+            pStats = COMPRESS_GetStats( pTemplate->pCompressor );
+            if ( pStats != NULL )
+            {
+                METRICS_Compressed( pTemplate->pMetrics,
+                                    pStats->lastIn,
+                                    pStats->lastOut,
+                                    pStats->lastNs );
+            }
+
+            if ( ( pStats != NULL ) &&
+                 ( LOGGER_Enabled( LOGGER_INFO ) == true ) )
+            {
+                LOGGER_Log( LOGGER_INFO,
+                            "%s: %s %zu -> %zu bytes (ratio %.2f) in %lu ns",
+                            pTemplate->target,
+                            COMPRESS_Name( pTemplate->compress ),
+                            pStats->lastIn,
+                            pStats->lastOut,
+                            ( pStats->lastOut > 0 )
+                                ? (double)pStats->lastIn / pStats->lastOut
+                                : 0.0,
+                            (unsigned long)pStats->lastNs );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  OpenTarget                                                                */
+/*!
+    Open the output stream of a file descriptor template
+
+    The target is opened to append to, or to replace, the previous output.
+    When the template service is attached to an event loop, the target is
+    opened non-blocking, so a slow reader cannot stall the render cycle.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            Pointer to the template
+
+    @retval the target file descriptor
+    @retval -1 if the target could not be opened
+
+==============================================================================*/
+static int OpenTarget( TemplateSvcState *pState, Template *pTemplate )
+{
+    int flags = O_WRONLY | O_CREAT;
+
+    /* append to, or replace the previous output */
+    flags |= ( pTemplate->append ) ? O_APPEND : O_TRUNC;
+
+    if ( pState->pEventLoop != NULL )
+    {
+        flags |= O_NONBLOCK;
+    }
+
+    pTemplate->fd = open( pTemplate->target, flags, 0644 );
+
+    return pTemplate->fd;
+}
+
+/*============================================================================*/
+/*  WriteTarget                                                               */
+/*!
+    Write output to the target of a file descriptor template
+
+    The WriteTarget function writes the output to the template's open
+    target.  If the target is not ready to accept all of it, the rest is
+    queued and written by TargetWritable when the event loop reports the
+    target writable.  Output is queued behind any output already pending,
+    so it is never re-ordered.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            Pointer to the template
+
+    @param[in]
+        pData
+            pointer to the output data
+
+    @param[in]
+        len
+            length of the output data
+
+    @retval EOK - the output was written or queued
+    @retval ENOBUFS - too much output is already queued for the target
+    @retval other - error returned by the output write
+
+==============================================================================*/
+static int WriteTarget( TemplateSvcState *pState,
+                        Template *pTemplate,
+                        const char *pData,
+                        size_t len )
+{
+    int result;
+    size_t written = 0;
+
+    if ( pTemplate->pendingLen > 0 )
+    {
+        result = QueueOutput( pTemplate, pData, len );
+    }
+    else
+    {
+        result = WriteOutput( pTemplate->fd, pData, len, &written );
+        if ( ( result == EAGAIN ) && ( pState->pEventLoop != NULL ) )
+        {
+            result = QueueOutput( pTemplate,
+                                  pData + written,
+                                  len - written );
+            if ( result == EOK )
+            {
+                result = EVENTLOOP_AddFd( pState->pEventLoop,
+                                          pTemplate->fd,
+                                          EPOLLOUT,
+                                          TargetWritable,
+                                          pTemplate );
+            }
+
+            if ( result != EOK )
+            {
+                pTemplate->pendingLen = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CloseTarget                                                               */
+/*!
+    Close the target of a file descriptor template after a render
+
+    The target is kept open if the template is configured to keep it
+    open, or until its queued output has been written.
+
+    @param[in]
+        pTemplate
+            Pointer to the template
+
+==============================================================================*/
+static void CloseTarget( Template *pTemplate )
+{
+    if ( ( pTemplate->keep_open == false ) &&
+         ( pTemplate->pendingLen == 0 ) &&
+         ( pTemplate->fd != -1 ) )
+    {
+        close( pTemplate->fd );
+        pTemplate->fd = -1;
+    }
+}
+
+/*============================================================================*/
+/*  QueueOutput                                                               */
+/*!
+    Queue output for a target which is not ready for writing
+
+    @param[in]
+        pTemplate
+            Pointer to the template
+
+    @param[in]
+        pData
+            pointer to the output data
+
+    @param[in]
+        len
+            length of the output data
+
+    @retval EOK - the output was queued
+    @retval ENOBUFS - the output would exceed MAX_PENDING_OUTPUT
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int QueueOutput( Template *pTemplate, const char *pData, size_t len )
+{
+    int result = EOK;
+    size_t needed = pTemplate->pendingLen + len;
+    size_t size;
+    char *p;
+
+    if ( needed > MAX_PENDING_OUTPUT )
+    {
+        result = ENOBUFS;
+    }
+    else if ( needed > pTemplate->pendingSize )
+    {
+        size = ( pTemplate->pendingSize > 0 ) ? pTemplate->pendingSize : 4096;
+        while ( size < needed )
+        {
+            size *= 2;
+        }
+
+        p = realloc( pTemplate->pPending, size );
+        if ( p != NULL )
+        {
+            pTemplate->pPending = p;
+            pTemplate->pendingSize = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        memcpy( &pTemplate->pPending[pTemplate->pendingLen], pData, len );
+        pTemplate->pendingLen = needed;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TargetWritable                                                            */
+/*!
+    Write queued output to a target which has become writable
+
+    The TargetWritable function is an event loop handler.  Once all the
+    queued output has been written, the target is no longer monitored,
+    and is closed unless the template keeps it open.  If the write fails,
+    the queued output is discarded and the target is closed.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        fd
+            target file descriptor
+
+    @param[in]
+        events
+            ready epoll events
+
+    @param[in]
+        arg
+            pointer to the template
+
+==============================================================================*/
+static void TargetWritable( EventLoop *pLoop,
+                            int fd,
+                            uint32_t events,
+                            void *arg )
+{
+    Template *pTemplate = (Template *)arg;
+    size_t written = 0;
+    int result;
+
+    (void)events;
+
+    result = WriteOutput( fd,
+                          pTemplate->pPending,
+                          pTemplate->pendingLen,
+                          &written );
+
+    pTemplate->pendingLen -= written;
+    memmove( pTemplate->pPending,
+             &pTemplate->pPending[written],
+             pTemplate->pendingLen );
+
+    if ( result != EAGAIN )
+    {
+        EVENTLOOP_RemoveFd( pLoop, fd );
+
+        if ( result != EOK )
+        {
+            LOGGER_Log( LOGGER_ERROR,
+                        "Cannot output %s: %s",
+                        pTemplate->target,
+                        strerror( result ) );
+
+            pTemplate->pendingLen = 0;
+            close( pTemplate->fd );
+            pTemplate->fd = -1;
+        }
+        else
+        {
+            CloseTarget( pTemplate );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  SignalReceived                                                            */
+/*!
+    Handle a variable server signal received by the event loop
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        sig
+            the signal received from the variable server
+
+    @param[in]
+        sigval
+            the value associated with the signal
+
+    @param[in]
+        arg
+            pointer to the template service state
+
+==============================================================================*/
+static void SignalReceived( EventLoop *pLoop,
+                            int sig,
+                            int sigval,
+                            void *arg )
+{
+    (void)pLoop;
+
+    TEMPLATESVC_HandleSignal( (TemplateSvcState *)arg, sig, sigval );
+}
+
+/*============================================================================*/
+/*  WatchTemplate                                                             */
+/*!
+    Watch a template file for changes
+
+    The template file's directory is watched, rather than the file, so
+    that a template replaced by renaming a new file over it is detected.
+    A watched template is only recompiled when it changes, instead of
+    checking the file on every render.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            Pointer to the template
+
+    @retval EOK - the template file is watched
+    @retval ENAMETOOLONG - the template file name is too long
+    @retval other - the watch could not be added
+
+==============================================================================*/
+static int WatchTemplate( TemplateSvcState *pState, Template *pTemplate )
+{
+    int result = ENAMETOOLONG;
+    char dir[PATH_MAX];
+    char *p;
+
+    if ( strlen( pTemplate->templateFileName ) < sizeof( dir ) )
+    {
+        strcpy( dir, pTemplate->templateFileName );
+
+        p = strrchr( dir, '/' );
+        if ( p == NULL )
+        {
+            strcpy( dir, "." );
+        }
+        else if ( p == dir )
+        {
+            p[1] = 0;
+        }
+        else
+        {
+            *p = 0;
+        }
+
+        result = EVENTLOOP_AddWatch( pState->pEventLoop,
+                                     dir,
+                                     TEMPLATE_WATCH_MASK,
+                                     TemplateChanged,
+                                     pTemplate );
+        if ( result == EOK )
+        {
+            pTemplate->watched = true;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TemplateChanged                                                           */
+/*!
+    Handle a change in a watched template directory
+
+    The template is marked stale if the changed entry is its template
+    file, so it is recompiled before its next render.  A template whose
+    triggers are derived from its references is also marked dirty, and a
+    render cycle is scheduled for once the inotify events have been
+    handled, so its triggers follow the new references even if none of
+    its old references change.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        mask
+            inotify event mask
+
+    @param[in]
+        name
+            name of the changed directory entry
+
+    @param[in]
+        arg
+            pointer to the template
+
+==============================================================================*/
+static void TemplateChanged( EventLoop *pLoop,
+                             uint32_t mask,
+                             const char *name,
+                             void *arg )
+{
+    Template *pTemplate = (Template *)arg;
+    const char *base;
+
+    (void)pLoop;
+    (void)mask;
+
+    base = strrchr( pTemplate->templateFileName, '/' );
+    base = ( base != NULL ) ? base + 1 : pTemplate->templateFileName;
+
+    if ( ( name != NULL ) && ( strcmp( name, base ) == 0 ) )
+    {
+        pTemplate->stale = true;
+
+        if ( pTemplate->autoTrigger == true )
+        {
+            MarkDirty( pTemplate );
+            ScheduleRender( pTemplate->pState, RENDER_SOON_NS );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  DeleteTemplates                                                           */
+/*!
+    Delete all of the templates
+
+    The loaded templates, and any retired templates which were not
+    reloaded, are deleted: their watches and pending target writes are
+    removed from the event loop, their targets are closed, and output
+    which has not been written is discarded.  The metrics of the rule
+    sets are deleted with them.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+==============================================================================*/
+static void DeleteTemplates( TemplateSvcState *pState )
+{
+    Template *pTemplate;
+    Tenant *pTenant;
+
+    while ( pState->pTemplates != NULL )
+    {
+        pTemplate = pState->pTemplates;
+        pState->pTemplates = pTemplate->pNext;
+        DeleteTemplate( pState, pTemplate );
+    }
+
+    if ( pState->ppRetired != NULL )
+    {
+        (void)DeleteRetired( pState );
+    }
+
+    /* the rule sets are allocated from the setup arena */
+    for ( pTenant = pState->pTenants ;
+          pTenant != NULL ;
+          pTenant = pTenant->pNext )
+    {
+        METRICS_Delete( pTenant->pMetrics );
+        pTenant->pMetrics = NULL;
+    }
+
+    pState->pTenants = NULL;
+    pState->pTenant = NULL;
+}
+
+/*============================================================================*/
+/*  StartTicker                                                               */
+/*!
+    Start the periodic render timer
+
+    A single timer drives all the periodic templates.  It ticks at the
+    greatest common divisor of their intervals, aligned to a multiple of
+    the tick on the monotonic clock, and a template is due each time the
+    elapsed ticks cross a multiple of its interval.  Templates with the
+    same interval therefore always fall due on the same tick.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @retval EOK - the timer was started, or no templates are periodic
+    @retval ENOMEM - the timer could not be created
+    @retval other - the timer could not be set
+
+==============================================================================*/
+static int StartTicker( TemplateSvcState *pState )
+{
+    int result = EOK;
+    Template *pTemplate;
+    uint64_t tickMs = 0;
+    uint64_t now;
+    uint64_t initial;
+
+    for ( pTemplate = pState->pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pTemplate->pNext )
+    {
+        if ( pTemplate->intervalMs != 0 )
+        {
+            tickMs = GCD( tickMs, pTemplate->intervalMs );
+        }
+    }
+
+    if ( tickMs != 0 )
+    {
+        pState->pTicker = EVENTLOOP_CreateTimer( pState->pEventLoop,
+                                                 PeriodicTick,
+                                                 pState );
+        if ( pState->pTicker != NULL )
+        {
+            pState->tickNs = tickMs * 1000000;
+            pState->ticks = 0;
+
+            /* align the first tick to a multiple of the tick */
+            now = METRICS_Now();
+            initial = pState->tickNs - ( now % pState->tickNs );
+            pState->tickBaseNs = now + initial - pState->tickNs;
+
+            result = EVENTLOOP_SetTimer( pState->pTicker,
+                                         initial,
+                                         pState->tickNs );
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  PeriodicTick                                                              */
+/*!
+    Render the periodic templates which are due
+
+    The PeriodicTick function is an event loop timer handler.  Each due
+    template is rendered, unless it was triggered within its interval
+    before this tick, and the due templates are rendered as one batch.
+    Ticks missed while the service was busy are counted, but their
+    renders are merged into this one.
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        pTimer
+            pointer to the periodic render timer
+
+    @param[in]
+        expirations
+            number of ticks since the last call
+
+    @param[in]
+        arg
+            pointer to the template service state
 
 ==============================================================================*/
-static int ProcessOptions( int argC, char *argV[], TemplateSvcState *pState )
+static void PeriodicTick( EventLoop *pLoop,
+                          EventTimer *pTimer,
+                          uint64_t expirations,
+                          void *arg )
 {
-    int c;
-    int result = EINVAL;
-    const char *options = "hvf:s:";
+    TemplateSvcState *pState = (TemplateSvcState *)arg;
+    Template *pTemplate;
+    uint64_t before;
+    uint64_t elapsed;
+    uint64_t dueNs;
+    uint64_t intervalNs;
+    size_t n = 0;
+
+    (void)pLoop;
+    (void)pTimer;
 
-    if( ( pState != NULL ) &&
-        ( argV != NULL ) )
+    before = pState->ticks * pState->tickNs;
+    pState->ticks += expirations;
+    elapsed = pState->ticks * pState->tickNs;
+
+    /* scheduled time of this tick */
+    dueNs = pState->tickBaseNs + elapsed;
+
+    for ( pTemplate = pState->pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pTemplate->pNext )
     {
-        while( ( c = getopt( argC, argV, options ) ) != -1 )
+        intervalNs = (uint64_t)pTemplate->intervalMs * 1000000;
+
+        if ( ( intervalNs != 0 ) &&
+             ( ( before / intervalNs ) != ( elapsed / intervalNs ) ) &&
+             ( pTemplate->triggeredNs + intervalNs <= dueNs ) )
         {
-            switch( c )
+            if ( ( pTemplate->dirty == false ) &&
+                 ( pTemplate->pMetrics != NULL ) )
             {
-                case 'v':
-                    pState->verbose = true;
-                    break;
+                pTemplate->triggerNs = METRICS_Now();
+            }
 
-                case 's':
-                    pState->varfpSize = strtoul( optarg, NULL, 0 );
-                    break;
+            pTemplate->dirty = true;
+            (void)QueueTemplate( pTemplate );
+            n++;
+        }
+    }
 
-                case 'h':
-                    usage( argV[0] );
-                    break;
+    if ( n > 0 )
+    {
+        TEMPLATESVC_RenderTemplates( pState );
+    }
+}
 
-                case 'f':
-                    pState->pFileName = strdup(optarg);
-                    break;
+/*============================================================================*/
+/*  GCD                                                                       */
+/*!
+    Calculate the greatest common divisor of two intervals
 
-                default:
-                    break;
+    @param[in]
+        a
+            first interval (0 if none)
+
+    @param[in]
+        b
+            second interval
+
+    @retval the greatest common divisor of a and b
+
+==============================================================================*/
+static uint64_t GCD( uint64_t a, uint64_t b )
+{
+    uint64_t t;
+
+    while ( b != 0 )
+    {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+/*============================================================================*/
+/*  ReloadTemplate                                                            */
+/*!
+    Reload a template definition
+
+    The ReloadTemplate function is a callback function for the
+    JSON_Iterate function.  If a template of the previous configuration
+    has the same definition, it is moved back into the running template
+    list unchanged.  Otherwise a new template is set up.
+
+    @param[in]
+       pNode
+            pointer to the template definition node
+
+    @param[in]
+        arg
+            opaque pointer argument used for the templatesvc state object
+
+    @retval EOK - the template was reloaded
+    @retval other - a new template could not be set up
+
+==============================================================================*/
+static int ReloadTemplate( JNode *pNode, void *arg )
+{
+    TemplateSvcState *pState = (TemplateSvcState *)arg;
+    Template *pTemplate = NULL;
+    ConfTemplate def;
+    char *pSignature;
+    int result;
+
+    result = ParseDefinition( pNode, &def );
+    if ( result == EOK )
+    {
+        CacheDefinition( pState, &def );
+
+        pSignature = TemplateSignature( &def );
+        if ( pSignature != NULL )
+        {
+            pTemplate = TakeRetired( pState, pSignature );
+            free( pSignature );
+        }
 
+        if ( ( pTemplate != NULL ) &&
+             ( TenantFull( pTemplate->pTenant ) == false ) )
+        {
+            /* keep the unchanged template */
+            pTemplate->pNext = pState->pTemplates;
+            pState->pTemplates = pTemplate;
+
+            if ( pTemplate->pTenant != NULL )
+            {
+                pTemplate->pTenant->templates++;
+            }
+        }
+        else if ( pTemplate != NULL )
+        {
+            /* the tenant's template limit has been lowered */
+            RetireTemplate( pState, pTemplate );
+            result = CreateTemplate( pState, &def, NULL );
+        }
+        else
+        {
+            result = CreateTemplate( pState, &def, NULL );
+            if ( ( result == EOK ) &&
+                 ( pState->pEventLoop != NULL ) &&
+                 ( pState->pTemplates->format == FMT_TEXT ) )
+            {
+                WatchTemplate( pState, pState->pTemplates );
             }
         }
+
+        CONFCACHE_FreeDefinition( &def );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RetireTemplates                                                           */
+/*!
+    Retire the running templates before the configuration is reloaded
+
+    The running templates are moved into a hash table keyed by their
+    signature, so each reloaded definition finds an unchanged template
+    without searching all of them.  Retired templates are chained
+    through their pNext pointers.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[out]
+        pCount
+            number of templates retired
+
+    @retval EOK - the templates were retired
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int RetireTemplates( TemplateSvcState *pState, size_t *pCount )
+{
+    int result = ENOMEM;
+    Template *pTemplate;
+    size_t count = 0;
+    size_t buckets = RETIRED_MIN_BUCKETS;
+
+    for ( pTemplate = pState->pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pTemplate->pNext )
+    {
+        count++;
+    }
+
+    while ( buckets < count )
+    {
+        buckets *= 2;
+    }
+
+    pState->ppRetired = calloc( buckets, sizeof( Template * ) );
+    if ( pState->ppRetired != NULL )
+    {
+        pState->retiredBuckets = buckets;
+
+        while ( pState->pTemplates != NULL )
+        {
+            pTemplate = pState->pTemplates;
+            pState->pTemplates = pTemplate->pNext;
+            RetireTemplate( pState, pTemplate );
+        }
+
+        *pCount = count;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RetireTemplate                                                            */
+/*!
+    Add a template to the retired template hash table
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            pointer to the template to retire
+
+==============================================================================*/
+static void RetireTemplate( TemplateSvcState *pState, Template *pTemplate )
+{
+    size_t idx;
+
+    idx = SignatureHash( pTemplate->pSignature ) &
+          ( pState->retiredBuckets - 1 );
+    pTemplate->pNext = pState->ppRetired[idx];
+    pState->ppRetired[idx] = pTemplate;
+}
+
+/*============================================================================*/
+/*  TakeRetired                                                               */
+/*!
+    Take a retired template with a matching definition
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pSignature
+            signature of the reloaded definition
+
+    @retval pointer to the retired template of the current rule set with
+            the same signature, which is removed from the hash table
+    @retval NULL if no retired template matches
+
+==============================================================================*/
+static Template *TakeRetired( TemplateSvcState *pState,
+                              const char *pSignature )
+{
+    Template **ppTemplate;
+    Template *pTemplate = NULL;
+    size_t idx;
+
+    idx = SignatureHash( pSignature ) & ( pState->retiredBuckets - 1 );
+    for ( ppTemplate = &pState->ppRetired[idx] ;
+          *ppTemplate != NULL ;
+          ppTemplate = &(*ppTemplate)->pNext )
+    {
+        if ( ( (*ppTemplate)->pSignature != NULL ) &&
+             ( (*ppTemplate)->pTenant == pState->pTenant ) &&
+             ( strcmp( (*ppTemplate)->pSignature, pSignature ) == 0 ) )
+        {
+            pTemplate = *ppTemplate;
+            *ppTemplate = pTemplate->pNext;
+            break;
+        }
     }
 
-    return 0;
+    return pTemplate;
 }
 
 /*============================================================================*/
-/*  SetupTerminationHandler                                                   */
+/*  DeleteRetired                                                             */
 /*!
-    Set up an abnormal termination handler
+    Tear down the retired templates which were not reloaded
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
 
-    The SetupTerminationHandler function registers a termination handler
-    function with the kernel in case of an abnormal termination of this
-    process.
+    @retval number of templates torn down
 
 ==============================================================================*/
-static void SetupTerminationHandler( void )
+static size_t DeleteRetired( TemplateSvcState *pState )
 {
-    static struct sigaction sigact;
+    Template *pTemplate;
+    size_t count = 0;
+    size_t i;
+
+    for ( i = 0 ; i < pState->retiredBuckets ; i++ )
+    {
+        while ( pState->ppRetired[i] != NULL )
+        {
+            pTemplate = pState->ppRetired[i];
+            pState->ppRetired[i] = pTemplate->pNext;
+            DeleteTemplate( pState, pTemplate );
+            count++;
+        }
+    }
 
-    memset( &sigact, 0, sizeof(sigact) );
+    free( pState->ppRetired );
+    pState->ppRetired = NULL;
+    pState->retiredBuckets = 0;
 
-    sigact.sa_sigaction = TerminationHandler;
-    sigact.sa_flags = SA_SIGINFO;
+    return count;
+}
+
+/*============================================================================*/
+/*  SignatureHash                                                             */
+/*!
+    Calculate the FNV-1a hash of a template signature
+
+    @param[in]
+        pSignature
+            template signature (or NULL)
+
+    @retval hash of the signature
+
+==============================================================================*/
+static uint32_t SignatureHash( const char *pSignature )
+{
+    uint32_t h = 2166136261u;
 
-    sigaction( SIGTERM, &sigact, NULL );
-    sigaction( SIGINT, &sigact, NULL );
+    while ( ( pSignature != NULL ) && ( *pSignature != '\0' ) )
+    {
+        h ^= (unsigned char)*pSignature++;
+        h *= 16777619u;
+    }
 
+    return h;
 }
 
 /*============================================================================*/
-/*  TerminationHandler                                                        */
+/*  DeleteTemplate                                                            */
 /*!
-    Abnormal termination handler
+    Tear down a template which is no longer defined
+
+    The template is detached from the event loop, its target is closed,
+    and all of its resources are freed.  Output queued for the target is
+    discarded.
+
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
+
+    @param[in]
+        pTemplate
+            pointer to the template to delete
+
+==============================================================================*/
+static void DeleteTemplate( TemplateSvcState *pState, Template *pTemplate )
+{
+    size_t i;
+
+    /* the template's triggers must be removed from the trigger index */
+    pState->reindex = true;
+    DequeueTemplate( pState, pTemplate );
+
+    if ( pState->pEventLoop != NULL )
+    {
+        EVENTLOOP_RemoveWatches( pState->pEventLoop, pTemplate );
+
+        if ( pTemplate->pendingLen > 0 )
+        {
+            EVENTLOOP_RemoveFd( pState->pEventLoop, pTemplate->fd );
+        }
+    }
+
+    if ( pTemplate->fd != -1 )
+    {
+        close( pTemplate->fd );
+    }
+
+    if ( pTemplate->mq > 0 )
+    {
+        mq_close( pTemplate->mq );
+    }
+
+    for ( i = 0 ; i < pTemplate->numTriggers ; i++ )
+    {
+        free( pTemplate->pTriggers[i].pLastText );
+    }
+
+    free( pTemplate->pTriggers );
+    free( pTemplate->pWildcards );
+    free( pTemplate->ppExclude );
+    free( pTemplate->pVars );
+    free( pTemplate->pCommit );
+    RENDER_Free( pTemplate->pCompiled );
+    COMPRESS_Delete( pTemplate->pCompressor );
+    METRICS_Delete( pTemplate->pMetrics );
+    free( pTemplate->pPending );
+    free( pTemplate->pSignature );
+    free( pTemplate );
+}
 
-    The TerminationHandler function will be invoked in case of an abnormal
-    termination of this process.  The termination handler closes
-    the connection with the variable server and cleans up its VARFP shared
-    memory.
+/*============================================================================*/
+/*  SweepNotifications                                                        */
+/*!
+    Cancel the notifications of variables which are no longer referenced
 
-@param[in]
-    signum
-        The signal which caused the abnormal termination (unused)
+    The variables which the templates are watching are marked: their
+    triggers, their commit variables, and the references of incremental
+    templates.  The notifications of all other watched variables are
+    cancelled.
 
-@param[in]
-    info
-        pointer to a siginfo_t object (unused)
+    @param[in]
+       pState
+            pointer to the TemplateSvc state object
 
-@param[in]
-    ptr
-        signal context information (ucontext_t) (unused)
+    @retval number of notifications cancelled
 
 ==============================================================================*/
-static void TerminationHandler( int signum, siginfo_t *info, void *ptr )
+static size_t SweepNotifications( TemplateSvcState *pState )
 {
-    if ( VARSERVER_Close( state.hVarServer ) == EOK )
+    Template *pTemplate;
+    CompiledTemplate *pCompiled;
+    size_t i;
+
+    VARCACHE_ClearMarks( pState->pVarCache );
+
+    for ( pTemplate = pState->pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pTemplate->pNext )
     {
-        state.hVarServer = NULL;
+        for ( i = 0 ; i < pTemplate->numTriggers ; i++ )
+        {
+            VARCACHE_Mark( pTemplate->pTriggers[i].pEntry );
+        }
+
+        if ( pTemplate->pCommit != NULL )
+        {
+            VARCACHE_Mark( pTemplate->pCommit->pEntry );
+        }
+
+        pCompiled = pTemplate->pCompiled;
+        if ( ( pCompiled != NULL ) && ( pCompiled->incremental == true ) )
+        {
+            for ( i = 0 ; i < pCompiled->numSegments ; i++ )
+            {
+                VARCACHE_Mark( pCompiled->pSegments[i].pEntry );
+            }
+        }
     }
 
-    if ( state.pVarFP != NULL )
+    return VARCACHE_Sweep( pState->pVarCache, pState->hVarServer );
+}
+
+/*============================================================================*/
+/*  TemplateSignature                                                         */
+/*!
+    Build the signature of a template definition
+
+    The signature is a canonical text form of every attribute of the
+    template definition, so two definitions with the same signature set
+    up identical templates.  Attributes added to the template definition
+    must be added here too.
+
+    @param[in]
+       pDef
+            pointer to the template definition
+
+    @retval pointer to the signature, which the caller must free
+    @retval NULL if the signature could not be built
+
+==============================================================================*/
+static char *TemplateSignature( ConfTemplate *pDef )
+{
+    char *strAttrs[] =
     {
-        /* close the output memory buffer */
-        VARFP_Close( state.pVarFP );
+        "name", pDef->name,
+        "template", pDef->template,
+        "type", pDef->type,
+        "target", pDef->target,
+        "compress", pDef->compress,
+        "format", pDef->format,
+        "prefix", pDef->prefix,
+        "commit", pDef->commit
+    };
+    char *pSignature = NULL;
+    size_t size = 0;
+    FILE *fp;
+    size_t i;
+
+    fp = open_memstream( &pSignature, &size );
+    if ( fp != NULL )
+    {
+        for ( i = 0 ; i < sizeof( strAttrs ) / sizeof( strAttrs[0] ) ; i += 2 )
+        {
+            if ( strAttrs[i + 1] != NULL )
+            {
+                fprintf( fp, "%s=%s\n", strAttrs[i], strAttrs[i + 1] );
+            }
+        }
+
+        fprintf( fp,
+                 "append=%d\nkeep_open=%d\nincremental=%d\n"
+                 "native_format=%d\ninterval_ms=%" PRIu32 "\n",
+                 pDef->append,
+                 pDef->keep_open,
+                 pDef->incremental,
+                 pDef->nativeFormat,
+                 pDef->intervalMs );
+
+        fputs( "trigger=", fp );
+        for ( i = 0 ; i < pDef->numTriggers ; i++ )
+        {
+            fprintf( fp,
+                     "{%s,%" PRIu32 ",%.17g};",
+                     pDef->pTriggers[i].name,
+                     pDef->pTriggers[i].condition,
+                     pDef->pTriggers[i].level );
+        }
+
+        fputs( "\nvars=", fp );
+        for ( i = 0 ; i < pDef->numVars ; i++ )
+        {
+            fprintf( fp, "%s;", pDef->pVars[i] );
+        }
+
+        fprintf( fp, "\nauto_trigger=%d\nexclude=", pDef->autoTrigger );
+        for ( i = 0 ; i < pDef->numExclude ; i++ )
+        {
+            fprintf( fp, "%s;", pDef->pExclude[i] );
+        }
+
+        fclose( fp );
     }
 
-    syslog( LOG_ERR, "Abnormal termination of templatesvc" );
+    return pSignature;
+}
+
+/*============================================================================*/
+/*  WriteOutput                                                               */
+/*!
+    Write a buffer to a file descriptor
+
+    The WriteOutput function writes the entire buffer to the output
+    file descriptor, handling partial writes.
+
+    @param[in]
+        fd
+            output file descriptor
+
+    @param[in]
+        pData
+            pointer to the data to write
+
+    @param[in]
+        len
+            number of bytes to write
+
+    @param[out]
+        pWritten
+            pointer to a location to store the number of bytes written
+
+    @retval EOK - all data was written
+    @retval EAGAIN - the file descriptor is non-blocking and is full
+    @retval other - error returned by write()
+
+==============================================================================*/
+static int WriteOutput( int fd,
+                        const char *pData,
+                        size_t len,
+                        size_t *pWritten )
+{
+    int result = EOK;
+    ssize_t n;
+
+    *pWritten = 0;
+
+    while ( ( len > 0 ) && ( result == EOK ) )
+    {
+        n = write( fd, pData, len );
+        if ( n > 0 )
+        {
+            pData += n;
+            len -= (size_t)n;
+            *pWritten += (size_t)n;
+        }
+        else if ( ( n < 0 ) && ( errno == EINTR ) )
+        {
+            continue;
+        }
+        else
+        {
+            result = ( n < 0 ) ? errno : EIO;
+        }
+    }
 
-    exit( 1 );
+    return result;
 }
 
 /*! @}
@@ -0,0 +1,532 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup trigindex trigindex
+ * @brief Variable handle to trigger dispatch index
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file trigindex.c
+
+    Trigger Index
+
+    The trigindex module maps the handle of a MODIFIED notification to
+    the trigger records it fires, so a notification only touches the
+    templates it triggers, rather than every trigger of every template.
+
+    The index is held as a structure of arrays, sorted by variable
+    handle.  A lookup is a binary search of the contiguous handle array
+    alone, and the matching entries are adjacent, so dispatching a
+    notification reads a handful of cache lines no matter how many
+    templates are loaded.  Entries with the same handle keep the order in
+    which they were added.
+
+    The index is built in two steps: the entries are added in any order,
+    and then sorted once with TRIGINDEX_Build.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include "trigindex.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! initial number of index entries allocated */
+#define TRIGINDEX_INITIAL_SIZE      ( 64 )
+
+/*! sort key of an index entry */
+typedef struct trigKey
+{
+    /*! variable handle */
+    VAR_HANDLE hVar;
+
+    /*! position at which the entry was added */
+    size_t pos;
+} TrigKey;
+
+/*! trigger index */
+struct trigIndex
+{
+    /*! variable handle of each entry */
+    VAR_HANDLE *pHandles;
+
+    /*! triggered template of each entry */
+    struct template **ppTemplates;
+
+    /*! trigger record of each entry */
+    struct triggerVar **ppTriggers;
+
+    /*! number of entries */
+    size_t count;
+
+    /*! number of entries allocated */
+    size_t size;
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int Resize( TrigIndex *pIndex, size_t size );
+static int CompareKeys( const void *pA, const void *pB );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  TRIGINDEX_Create                                                          */
+/*!
+    Create an empty trigger index
+
+    @retval pointer to the new trigger index
+    @retval NULL if memory allocation failed
+
+==============================================================================*/
+TrigIndex *TRIGINDEX_Create( void )
+{
+    return calloc( 1, sizeof( TrigIndex ) );
+}
+
+/*============================================================================*/
+/*  TRIGINDEX_Delete                                                          */
+/*!
+    Delete a trigger index
+
+    @param[in]
+        pIndex
+            pointer to the trigger index to delete (may be NULL)
+
+==============================================================================*/
+void TRIGINDEX_Delete( TrigIndex *pIndex )
+{
+    if ( pIndex != NULL )
+    {
+        free( pIndex->pHandles );
+        free( pIndex->ppTemplates );
+        free( pIndex->ppTriggers );
+        free( pIndex );
+    }
+}
+
+/*============================================================================*/
+/*  TRIGINDEX_Clear                                                           */
+/*!
+    Remove all of the entries of a trigger index
+
+    The memory of the index is kept, so it can be rebuilt without
+    allocating.
+
+    @param[in]
+        pIndex
+            pointer to the trigger index
+
+==============================================================================*/
+void TRIGINDEX_Clear( TrigIndex *pIndex )
+{
+    if ( pIndex != NULL )
+    {
+        pIndex->count = 0;
+    }
+}
+
+/*============================================================================*/
+/*  TRIGINDEX_Add                                                             */
+/*!
+    Add an entry to a trigger index
+
+    The entry cannot be found until the index is next built.
+
+    @param[in]
+        pIndex
+            pointer to the trigger index
+
+    @param[in]
+        hVar
+            handle of the trigger variable
+
+    @param[in]
+        pTemplate
+            pointer to the triggered template
+
+    @param[in]
+        pTrigger
+            pointer to the trigger record
+
+    @retval EOK - the entry was added
+    @retval EINVAL - invalid arguments
+    @retval ENOMEM - memory allocation failed
+
+==============================================================================*/
+int TRIGINDEX_Add( TrigIndex *pIndex,
+                   VAR_HANDLE hVar,
+                   struct template *pTemplate,
+                   struct triggerVar *pTrigger )
+{
+    int result = EINVAL;
+
+    if ( ( pIndex != NULL ) &&
+         ( hVar != VAR_INVALID ) )
+    {
+        result = EOK;
+
+        if ( pIndex->count == pIndex->size )
+        {
+            result = Resize( pIndex,
+                             ( pIndex->size > 0 ) ? pIndex->size * 2
+                                                  : TRIGINDEX_INITIAL_SIZE );
+        }
+
+        if ( result == EOK )
+        {
+            pIndex->pHandles[pIndex->count] = hVar;
+            pIndex->ppTemplates[pIndex->count] = pTemplate;
+            pIndex->ppTriggers[pIndex->count] = pTrigger;
+            pIndex->count++;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TRIGINDEX_Build                                                           */
+/*!
+    Sort the entries of a trigger index by variable handle
+
+    @param[in]
+        pIndex
+            pointer to the trigger index
+
+    @retval EOK - the index was built
+    @retval EINVAL - invalid arguments
+    @retval ENOMEM - memory allocation failed
+
+==============================================================================*/
+int TRIGINDEX_Build( TrigIndex *pIndex )
+{
+    int result = EINVAL;
+    TrigKey *pKeys;
+    struct template **ppTemplates;
+    struct triggerVar **ppTriggers;
+    size_t n;
+    size_t i;
+
+    if ( pIndex != NULL )
+    {
+        result = EOK;
+        n = pIndex->count;
+
+        pKeys = ( n > 0 ) ? malloc( n * sizeof( TrigKey ) ) : NULL;
+        ppTemplates = ( n > 0 ) ? malloc( n * sizeof( *ppTemplates ) ) : NULL;
+        ppTriggers = ( n > 0 ) ? malloc( n * sizeof( *ppTriggers ) ) : NULL;
+
+        if ( ( n > 0 ) &&
+             ( ( pKeys == NULL ) ||
+               ( ppTemplates == NULL ) ||
+               ( ppTriggers == NULL ) ) )
+        {
+            result = ENOMEM;
+        }
+        else if ( n > 0 )
+        {
+            for ( i = 0 ; i < n ; i++ )
+            {
+                pKeys[i].hVar = pIndex->pHandles[i];
+                pKeys[i].pos = i;
+            }
+
+            qsort( pKeys, n, sizeof( TrigKey ), CompareKeys );
+
+            /* permute the entries into handle order */
+            for ( i = 0 ; i < n ; i++ )
+            {
+                pIndex->pHandles[i] = pKeys[i].hVar;
+                ppTemplates[i] = pIndex->ppTemplates[pKeys[i].pos];
+                ppTriggers[i] = pIndex->ppTriggers[pKeys[i].pos];
+            }
+
+            memcpy( pIndex->ppTemplates,
+                    ppTemplates,
+                    n * sizeof( *ppTemplates ) );
+            memcpy( pIndex->ppTriggers,
+                    ppTriggers,
+                    n * sizeof( *ppTriggers ) );
+        }
+
+        free( pKeys );
+        free( ppTemplates );
+        free( ppTriggers );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TRIGINDEX_Find                                                            */
+/*!
+    Find the entries of a variable handle
+
+    @param[in]
+        pIndex
+            pointer to the trigger index
+
+    @param[in]
+        hVar
+            handle of the modified variable
+
+    @param[out]
+        pFirst
+            pointer to a location to store the position of the first entry
+
+    @retval number of entries for the handle
+
+==============================================================================*/
+size_t TRIGINDEX_Find( TrigIndex *pIndex, VAR_HANDLE hVar, size_t *pFirst )
+{
+    size_t result = 0;
+    size_t lo = 0;
+    size_t hi;
+    size_t mid;
+
+    if ( ( pIndex != NULL ) &&
+         ( pFirst != NULL ) )
+    {
+        /* find the first entry which is not below the handle */
+        hi = pIndex->count;
+        while ( lo < hi )
+        {
+            mid = lo + ( ( hi - lo ) / 2 );
+            if ( pIndex->pHandles[mid] < hVar )
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        *pFirst = lo;
+        while ( ( ( lo + result ) < pIndex->count ) &&
+                ( pIndex->pHandles[lo + result] == hVar ) )
+        {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TRIGINDEX_Template                                                        */
+/*!
+    Get the triggered template of an index entry
+
+    @param[in]
+        pIndex
+            pointer to the trigger index
+
+    @param[in]
+        i
+            position of the entry (see TRIGINDEX_Find)
+
+    @retval pointer to the triggered template
+
+==============================================================================*/
+struct template *TRIGINDEX_Template( TrigIndex *pIndex, size_t i )
+{
+    return ( ( pIndex != NULL ) && ( i < pIndex->count ) )
+            ? pIndex->ppTemplates[i]
+            : NULL;
+}
+
+/*============================================================================*/
+/*  TRIGINDEX_Trigger                                                         */
+/*!
+    Get the trigger record of an index entry
+
+    @param[in]
+        pIndex
+            pointer to the trigger index
+
+    @param[in]
+        i
+            position of the entry (see TRIGINDEX_Find)
+
+    @retval pointer to the trigger record
+
+==============================================================================*/
+struct triggerVar *TRIGINDEX_Trigger( TrigIndex *pIndex, size_t i )
+{
+    return ( ( pIndex != NULL ) && ( i < pIndex->count ) )
+            ? pIndex->ppTriggers[i]
+            : NULL;
+}
+
+/*============================================================================*/
+/*  TRIGINDEX_Count                                                           */
+/*!
+    Get the number of entries of a trigger index
+
+    @param[in]
+        pIndex
+            pointer to the trigger index
+
+    @retval number of entries
+
+==============================================================================*/
+size_t TRIGINDEX_Count( TrigIndex *pIndex )
+{
+    return ( pIndex != NULL ) ? pIndex->count : 0;
+}
+
+/*============================================================================*/
+/*  TRIGINDEX_Size                                                            */
+/*!
+    Get the memory used by a trigger index
+
+    @param[in]
+        pIndex
+            pointer to the trigger index
+
+    @retval number of bytes allocated for the index
+
+==============================================================================*/
+size_t TRIGINDEX_Size( TrigIndex *pIndex )
+{
+    size_t result = 0;
+
+    if ( pIndex != NULL )
+    {
+        result = sizeof( TrigIndex ) +
+                 ( pIndex->size * ( sizeof( VAR_HANDLE ) +
+                                    sizeof( struct template * ) +
+                                    sizeof( struct triggerVar * ) ) );
+    }
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Resize                                                                    */
+/*!
+    Resize the entry arrays of a trigger index
+
+    @param[in]
+        pIndex
+            pointer to the trigger index
+
+    @param[in]
+        size
+            new number of entries
+
+    @retval EOK - the arrays were resized
+    @retval ENOMEM - memory allocation failed
+
+==============================================================================*/
+static int Resize( TrigIndex *pIndex, size_t size )
+{
+    int result = ENOMEM;
+    VAR_HANDLE *pHandles;
+    struct template **ppTemplates;
+    struct triggerVar **ppTriggers;
+
+    pHandles = realloc( pIndex->pHandles, size * sizeof( VAR_HANDLE ) );
+    if ( pHandles != NULL )
+    {
+        pIndex->pHandles = pHandles;
+        ppTemplates = realloc( pIndex->ppTemplates,
+                               size * sizeof( *ppTemplates ) );
+        if ( ppTemplates != NULL )
+        {
+            pIndex->ppTemplates = ppTemplates;
+            ppTriggers = realloc( pIndex->ppTriggers,
+                                  size * sizeof( *ppTriggers ) );
+            if ( ppTriggers != NULL )
+            {
+                pIndex->ppTriggers = ppTriggers;
+                pIndex->size = size;
+                result = EOK;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CompareKeys                                                               */
+/*!
+    Order two index entries by handle, then by the order they were added
+
+    @param[in]
+        pA
+            pointer to the first sort key
+
+    @param[in]
+        pB
+            pointer to the second sort key
+
+    @retval <0, 0 or >0 as the first key sorts before, with or after
+            the second
+
+==============================================================================*/
+static int CompareKeys( const void *pA, const void *pB )
+{
+    const TrigKey *a = (const TrigKey *)pA;
+    const TrigKey *b = (const TrigKey *)pB;
+    int result;
+
+    if ( a->hVar != b->hVar )
+    {
+        result = ( a->hVar < b->hVar ) ? -1 : 1;
+    }
+    else
+    {
+        result = ( a->pos < b->pos ) ? -1 : ( a->pos > b->pos ) ? 1 : 0;
+    }
+
+    return result;
+}
+
+/*! @}
+ * end of trigindex group */
@@ -0,0 +1,1280 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup varcache varcache
+ * @brief Variable handle index and modification tracking
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file varcache.c
+
+    Variable Cache
+
+    The varcache module maintains a hash table of the variables used by
+    the template service, indexed by variable handle.  Each entry tracks
+    a modification version which is incremented whenever a MODIFIED
+    notification is received for the variable, allowing renderers to
+    determine if a previously formatted value is still current.
+
+    The variable cache also ensures that only one MODIFIED notification
+    is requested for each variable, no matter how many templates
+    reference it.  A second hash table indexes the entries by name, so
+    the variable server is only asked to look up each variable name
+    once, no matter how many templates reference it.
+
+    Each entry holds a snapshot of the variable value and its formatted
+    text.  Rendering is performed in event cycles: the snapshot of a
+    variable is fetched from the variable server at most once per cycle,
+    so every template rendered in the same cycle sees a consistent set
+    of values.  A watched variable whose version has not changed since
+    its snapshot was taken is not fetched again at all.
+
+    Numeric values are fetched with VAR_Get.  Their text is printed by
+    the variable server with VAR_Print, so it keeps the variable's own
+    formatting, unless every template which references the variable
+    formats numbers natively, in which case it is formatted with the
+    numfmt module.  All other types are rendered by the variable server
+    with VAR_Print into a scratch buffer.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "varcache.h"
+#include "numfmt.h"
+#include "capture.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! initial number of hash buckets (must be a power of 2) */
+#define VARCACHE_INITIAL_BUCKETS    ( 64 )
+
+/*! variable cache */
+struct varCache
+{
+    /*! hash bucket array */
+    VarEntry **ppBuckets;
+
+    /*! name hash bucket array */
+    VarEntry **ppNames;
+
+    /*! number of hash buckets (power of 2) */
+    size_t numBuckets;
+
+    /*! number of entries in the cache */
+    size_t count;
+
+    /*! current event cycle */
+    uint32_t cycle;
+
+    /*! scratch file descriptor used for VAR_Print */
+    int scratchFd;
+
+    /*! pointer to the memory backing the scratch file descriptor */
+    char *pScratch;
+
+    /*! size of the scratch memory */
+    size_t scratchSize;
+
+    /*! capture file recording the fetched values (NULL if not captured) */
+    struct capture *pCapture;
+
+    /*! lookups which miss the cache are deferred (see VARCACHE_Defer) */
+    bool deferred;
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static size_t Hash( VAR_HANDLE hVar, size_t numBuckets );
+static size_t HashName( const char *name, size_t numBuckets );
+static int Grow( VarCache *pVarCache );
+static void FetchEntry( VarCache *pVarCache,
+                        VARSERVER_HANDLE hVarServer,
+                        VarEntry *pEntry );
+static int FetchNumeric( VARSERVER_HANDLE hVarServer, VarEntry *pEntry );
+static int FetchPrint( VarCache *pVarCache,
+                       VARSERVER_HANDLE hVarServer,
+                       VarEntry *pEntry );
+static int SetText( VarEntry *pEntry, const char *p, size_t len );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  VARCACHE_Create                                                           */
+/*!
+    Create a variable cache
+
+    @retval pointer to the new variable cache
+    @retval NULL if memory allocation failed
+
+==============================================================================*/
+VarCache *VARCACHE_Create( void )
+{
+    VarCache *pVarCache;
+
+    pVarCache = calloc( 1, sizeof( VarCache ) );
+    if ( pVarCache != NULL )
+    {
+        pVarCache->ppBuckets = calloc( VARCACHE_INITIAL_BUCKETS,
+                                       sizeof( VarEntry * ) );
+        pVarCache->ppNames = calloc( VARCACHE_INITIAL_BUCKETS,
+                                     sizeof( VarEntry * ) );
+        if ( ( pVarCache->ppBuckets != NULL ) &&
+             ( pVarCache->ppNames != NULL ) )
+        {
+            pVarCache->numBuckets = VARCACHE_INITIAL_BUCKETS;
+            pVarCache->scratchFd = -1;
+        }
+        else
+        {
+            free( pVarCache->ppBuckets );
+            free( pVarCache->ppNames );
+            free( pVarCache );
+            pVarCache = NULL;
+        }
+    }
+
+    return pVarCache;
+}
+
+/*============================================================================*/
+/*  VARCACHE_Delete                                                           */
+/*!
+    Delete a variable cache
+
+    The VARCACHE_Delete function frees the variable cache and all of its
+    entries.  Notifications requested for watched variables are not
+    cancelled.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache to delete
+
+==============================================================================*/
+void VARCACHE_Delete( VarCache *pVarCache )
+{
+    VarEntry *pEntry;
+    VarEntry *pNext;
+    size_t i;
+
+    if ( pVarCache != NULL )
+    {
+        for ( i = 0 ; i < pVarCache->numBuckets ; i++ )
+        {
+            pEntry = pVarCache->ppBuckets[i];
+            while ( pEntry != NULL )
+            {
+                pNext = pEntry->pNext;
+                free( pEntry->name );
+                free( pEntry->pText );
+                free( pEntry );
+                pEntry = pNext;
+            }
+        }
+
+        free( pVarCache->ppBuckets );
+        free( pVarCache->ppNames );
+        free( pVarCache );
+    }
+}
+
+/*============================================================================*/
+/*  VARCACHE_Find                                                             */
+/*!
+    Find a variable cache entry
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVar
+            handle of the variable to find
+
+    @retval pointer to the variable cache entry
+    @retval NULL if the variable is not in the cache
+
+==============================================================================*/
+VarEntry *VARCACHE_Find( VarCache *pVarCache, VAR_HANDLE hVar )
+{
+    VarEntry *pEntry = NULL;
+
+    if ( pVarCache != NULL )
+    {
+        pEntry = pVarCache->ppBuckets[Hash( hVar, pVarCache->numBuckets )];
+        while ( ( pEntry != NULL ) && ( pEntry->hVar != hVar ) )
+        {
+            pEntry = pEntry->pNext;
+        }
+    }
+
+    return pEntry;
+}
+
+/*============================================================================*/
+/*  VARCACHE_Add                                                              */
+/*!
+    Add a variable to the variable cache
+
+    The VARCACHE_Add function returns the existing cache entry for the
+    variable, or creates a new one if the variable is not yet cached.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVar
+            handle of the variable to add
+
+    @param[in]
+        name
+            name of the variable to add
+
+    @retval pointer to the variable cache entry
+    @retval NULL if the entry could not be created
+
+==============================================================================*/
+VarEntry *VARCACHE_Add( VarCache *pVarCache,
+                        VAR_HANDLE hVar,
+                        const char *name )
+{
+    VarEntry *pEntry = NULL;
+    size_t idx;
+
+    if ( ( pVarCache != NULL ) &&
+         ( hVar != VAR_INVALID ) )
+    {
+        pEntry = VARCACHE_Find( pVarCache, hVar );
+        if ( pEntry == NULL )
+        {
+            if ( pVarCache->count >= pVarCache->numBuckets )
+            {
+                Grow( pVarCache );
+            }
+
+            pEntry = calloc( 1, sizeof( VarEntry ) );
+            if ( pEntry != NULL )
+            {
+                pEntry->hVar = hVar;
+                pEntry->name = ( name != NULL ) ? strdup( name ) : NULL;
+                pEntry->version = 1;
+
+                idx = Hash( hVar, pVarCache->numBuckets );
+                pEntry->pNext = pVarCache->ppBuckets[idx];
+                pVarCache->ppBuckets[idx] = pEntry;
+                pVarCache->count++;
+
+                if ( pEntry->name != NULL )
+                {
+                    idx = HashName( pEntry->name, pVarCache->numBuckets );
+                    pEntry->pNameNext = pVarCache->ppNames[idx];
+                    pVarCache->ppNames[idx] = pEntry;
+                }
+            }
+        }
+    }
+
+    return pEntry;
+}
+
+/*============================================================================*/
+/*  VARCACHE_Lookup                                                           */
+/*!
+    Look up a variable by name
+
+    The VARCACHE_Lookup function returns the cache entry of the named
+    variable.  If the name is not in the cache, its handle is looked up
+    with the variable server and a cache entry is added for it, unless
+    the lookups are deferred.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        name
+            name of the variable to look up
+
+    @retval pointer to the variable cache entry
+    @retval NULL if the variable was not found
+
+==============================================================================*/
+VarEntry *VARCACHE_Lookup( VarCache *pVarCache,
+                           VARSERVER_HANDLE hVarServer,
+                           const char *name )
+{
+    VarEntry *pEntry = NULL;
+    VAR_HANDLE hVar;
+
+    if ( ( pVarCache != NULL ) &&
+         ( name != NULL ) )
+    {
+        pEntry = pVarCache->ppNames[HashName( name, pVarCache->numBuckets )];
+        while ( ( pEntry != NULL ) && ( strcmp( pEntry->name, name ) != 0 ) )
+        {
+            pEntry = pEntry->pNameNext;
+        }
+
+        if ( ( pEntry == NULL ) &&
+             ( hVarServer != NULL ) &&
+             ( pVarCache->deferred == false ) )
+        {
+            hVar = VAR_FindByName( hVarServer, (char *)name );
+            pEntry = VARCACHE_Add( pVarCache, hVar, name );
+        }
+    }
+
+    return pEntry;
+}
+
+/*============================================================================*/
+/*  VARCACHE_SetWatched                                                       */
+/*!
+    Record a MODIFIED notification requested for a cached variable
+
+    The VARCACHE_SetWatched function records a notification which was
+    requested outside of the cache, such as by a bulk registration,
+    along with the connection it was requested on, so that
+    VARCACHE_Sweep cancels it through the same connection.
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry (may be NULL)
+
+    @param[in]
+        hVarServer
+            connection the notification was requested on, or NULL for
+            the connection passed to VARCACHE_Sweep
+
+==============================================================================*/
+void VARCACHE_SetWatched( VarEntry *pEntry, VARSERVER_HANDLE hVarServer )
+{
+    if ( pEntry != NULL )
+    {
+        pEntry->watched = true;
+        pEntry->hWatch = hVarServer;
+    }
+}
+
+/*============================================================================*/
+/*  VARCACHE_SetPrinted                                                       */
+/*!
+    Keep the variable server's formatting of a cached variable
+
+    The VARCACHE_SetPrinted function is called for each variable which is
+    referenced by a template that does not format numbers natively.  The
+    text of a numeric value of the variable is then printed by the
+    variable server with VAR_Print, as well as its value being fetched,
+    so the output keeps the variable's own formatting.  A snapshot which
+    was formatted natively is fetched again.
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry (may be NULL)
+
+==============================================================================*/
+void VARCACHE_SetPrinted( VarEntry *pEntry )
+{
+    if ( ( pEntry != NULL ) &&
+         ( pEntry->printed == false ) )
+    {
+        pEntry->printed = true;
+        pEntry->valid = false;
+    }
+}
+
+/*============================================================================*/
+/*  VARCACHE_Defer                                                            */
+/*!
+    Defer the lookups which miss the variable cache
+
+    While the lookups are deferred, VARCACHE_Lookup only searches the
+    cache, so a bulk setup can collect the names it needs, and look
+    them up together, before adding them with VARCACHE_Add.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        defer
+            true to defer the lookups, false to resume them
+
+==============================================================================*/
+void VARCACHE_Defer( VarCache *pVarCache, bool defer )
+{
+    if ( pVarCache != NULL )
+    {
+        pVarCache->deferred = defer;
+    }
+}
+
+/*============================================================================*/
+/*  VARCACHE_Deferred                                                         */
+/*!
+    Determine if the lookups which miss the variable cache are deferred
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @retval true - the lookups are deferred
+    @retval false - the lookups are made with the variable server
+
+==============================================================================*/
+bool VARCACHE_Deferred( VarCache *pVarCache )
+{
+    return ( pVarCache != NULL ) ? pVarCache->deferred : false;
+}
+
+/*============================================================================*/
+/*  VARCACHE_Watch                                                            */
+/*!
+    Request MODIFIED notifications for a cached variable
+
+    The VARCACHE_Watch function requests a MODIFIED notification for the
+    variable from the variable server, unless one has already been
+    requested.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry
+
+    @retval EOK - the variable is being watched
+    @retval EINVAL - invalid arguments
+    @retval other - error returned by VAR_Notify
+
+==============================================================================*/
+int VARCACHE_Watch( VarCache *pVarCache,
+                    VARSERVER_HANDLE hVarServer,
+                    VarEntry *pEntry )
+{
+    int result = EINVAL;
+
+    if ( ( pVarCache != NULL ) &&
+         ( hVarServer != NULL ) &&
+         ( pEntry != NULL ) )
+    {
+        result = EOK;
+
+        if ( pEntry->watched == false )
+        {
+            result = VAR_Notify( hVarServer, pEntry->hVar, NOTIFY_MODIFIED );
+            if ( result == EOK )
+            {
+                VARCACHE_SetWatched( pEntry, NULL );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VARCACHE_ClearMarks                                                       */
+/*!
+    Clear the reference marks of all cached variables
+
+    The VARCACHE_ClearMarks function starts a mark and sweep of the watched
+    variables.  The variables which are still referenced are then marked
+    with VARCACHE_Mark, and the notifications of the others are cancelled
+    with VARCACHE_Sweep.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+==============================================================================*/
+void VARCACHE_ClearMarks( VarCache *pVarCache )
+{
+    VarEntry *pEntry;
+    size_t i;
+
+    if ( pVarCache != NULL )
+    {
+        for ( i = 0 ; i < pVarCache->numBuckets ; i++ )
+        {
+            for ( pEntry = pVarCache->ppBuckets[i] ;
+                  pEntry != NULL ;
+                  pEntry = pEntry->pNext )
+            {
+                pEntry->marked = false;
+            }
+        }
+    }
+}
+
+/*============================================================================*/
+/*  VARCACHE_Mark                                                             */
+/*!
+    Mark a cached variable as still referenced
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry (may be NULL)
+
+==============================================================================*/
+void VARCACHE_Mark( VarEntry *pEntry )
+{
+    if ( pEntry != NULL )
+    {
+        pEntry->marked = true;
+    }
+}
+
+/*============================================================================*/
+/*  VARCACHE_Sweep                                                            */
+/*!
+    Cancel the notifications of unreferenced variables
+
+    The VARCACHE_Sweep function cancels the MODIFIED notification of each
+    watched variable which has not been marked since VARCACHE_ClearMarks,
+    through the connection the notification was requested on.
+    The cache entries are kept, so a variable which is referenced again
+    is watched again by VARCACHE_Watch.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @retval number of notifications cancelled
+
+==============================================================================*/
+size_t VARCACHE_Sweep( VarCache *pVarCache, VARSERVER_HANDLE hVarServer )
+{
+    VarEntry *pEntry;
+    size_t count = 0;
+    size_t i;
+
+    if ( ( pVarCache != NULL ) &&
+         ( hVarServer != NULL ) )
+    {
+        for ( i = 0 ; i < pVarCache->numBuckets ; i++ )
+        {
+            for ( pEntry = pVarCache->ppBuckets[i] ;
+                  pEntry != NULL ;
+                  pEntry = pEntry->pNext )
+            {
+                if ( ( pEntry->watched == true ) &&
+                     ( pEntry->marked == false ) &&
+                     ( VAR_NotifyCancel( ( pEntry->hWatch != NULL )
+                                           ? pEntry->hWatch
+                                           : hVarServer,
+                                         pEntry->hVar,
+                                         NOTIFY_MODIFIED ) == EOK ) )
+                {
+                    pEntry->watched = false;
+                    pEntry->hWatch = NULL;
+                    count++;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+/*============================================================================*/
+/*  VARCACHE_Modified                                                         */
+/*!
+    Record a variable modification
+
+    The VARCACHE_Modified function increments the modification version
+    of the specified variable.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVar
+            handle of the modified variable
+
+    @retval pointer to the modified variable's cache entry
+    @retval NULL if the variable is not in the cache
+
+==============================================================================*/
+VarEntry *VARCACHE_Modified( VarCache *pVarCache, VAR_HANDLE hVar )
+{
+    VarEntry *pEntry;
+
+    pEntry = VARCACHE_Find( pVarCache, hVar );
+    if ( pEntry != NULL )
+    {
+        pEntry->version++;
+    }
+
+    return pEntry;
+}
+
+/*============================================================================*/
+/*  VARCACHE_SetScratch                                                       */
+/*!
+    Set the scratch buffer used to render non-numeric values
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        fd
+            file descriptor which VAR_Print writes to
+
+    @param[in]
+        pBuf
+            pointer to the memory backing the file descriptor
+
+    @param[in]
+        size
+            size of the scratch memory
+
+==============================================================================*/
+void VARCACHE_SetScratch( VarCache *pVarCache,
+                          int fd,
+                          char *pBuf,
+                          size_t size )
+{
+    if ( pVarCache != NULL )
+    {
+        pVarCache->scratchFd = fd;
+        pVarCache->pScratch = pBuf;
+        pVarCache->scratchSize = size;
+    }
+}
+
+/*============================================================================*/
+/*  VARCACHE_SetCapture                                                       */
+/*!
+    Record fetched values to a capture file
+
+    The VARCACHE_SetCapture function sets the capture file which every
+    value fetched from the variable server is recorded to.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        pCapture
+            pointer to the capture file (NULL to stop capturing)
+
+==============================================================================*/
+void VARCACHE_SetCapture( VarCache *pVarCache, struct capture *pCapture )
+{
+    if ( pVarCache != NULL )
+    {
+        pVarCache->pCapture = pCapture;
+    }
+}
+
+/*============================================================================*/
+/*  VARCACHE_BeginCycle                                                       */
+/*!
+    Begin a new event cycle
+
+    The VARCACHE_BeginCycle function starts a new event cycle.  Variable
+    values fetched during the cycle are only fetched once.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @retval the new cycle number
+
+==============================================================================*/
+uint32_t VARCACHE_BeginCycle( VarCache *pVarCache )
+{
+    uint32_t cycle = 0;
+
+    if ( pVarCache != NULL )
+    {
+        /* cycle 0 is never used so new entries are never current */
+        if ( ++pVarCache->cycle == 0 )
+        {
+            pVarCache->cycle = 1;
+        }
+
+        cycle = pVarCache->cycle;
+    }
+
+    return cycle;
+}
+
+/*============================================================================*/
+/*  VARCACHE_Fetch                                                            */
+/*!
+    Take a snapshot of a variable value for the current cycle
+
+    The VARCACHE_Fetch function makes sure the variable's value snapshot
+    is current for this cycle.  The value is fetched from the variable
+    server only if it has not already been fetched in this cycle, and
+    (for watched variables) only if it has been modified since it was
+    last fetched.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry
+
+    @retval EOK - the value snapshot is current
+    @retval EINVAL - invalid arguments
+    @retval other - the value could not be fetched
+
+==============================================================================*/
+int VARCACHE_Fetch( VarCache *pVarCache,
+                    VARSERVER_HANDLE hVarServer,
+                    VarEntry *pEntry )
+{
+    int result = EINVAL;
+
+    if ( ( pVarCache != NULL ) &&
+         ( hVarServer != NULL ) &&
+         ( pEntry != NULL ) )
+    {
+        result = EOK;
+
+        if ( ( pEntry->cycle != pVarCache->cycle ) &&
+             ( ( pEntry->valid == false ) ||
+               ( pEntry->watched == false ) ||
+               ( pEntry->fetchedVersion != pEntry->version ) ) )
+        {
+            FetchEntry( pVarCache, hVarServer, pEntry );
+        }
+
+        pEntry->cycle = pVarCache->cycle;
+
+        if ( pEntry->valid == false )
+        {
+            result = ENOENT;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VARCACHE_Refresh                                                          */
+/*!
+    Bring a variable value snapshot up to date outside a render cycle
+
+    The VARCACHE_Refresh function fetches the variable's value if it has
+    been modified since it was last fetched, without using up the fetch
+    of the next render cycle.  A watched variable which is refreshed and
+    then rendered is only fetched once.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry
+
+    @retval EOK - the value snapshot is current
+    @retval EINVAL - invalid arguments
+    @retval ENOENT - the value could not be fetched
+
+==============================================================================*/
+int VARCACHE_Refresh( VarCache *pVarCache,
+                      VARSERVER_HANDLE hVarServer,
+                      VarEntry *pEntry )
+{
+    int result = EINVAL;
+
+    if ( ( pVarCache != NULL ) &&
+         ( hVarServer != NULL ) &&
+         ( pEntry != NULL ) )
+    {
+        if ( ( pEntry->valid == false ) ||
+             ( pEntry->fetchedVersion != pEntry->version ) )
+        {
+            FetchEntry( pVarCache, hVarServer, pEntry );
+        }
+
+        result = ( pEntry->valid == true ) ? EOK : ENOENT;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VARCACHE_Format                                                           */
+/*!
+    Format the numeric value snapshot of a variable natively
+
+    The VARCACHE_Format function formats the value with the numfmt
+    module: integers in decimal, and floats as the shortest text which
+    reads back as the same value.
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry
+
+    @param[out]
+        buf
+            output buffer of at least NUMFMT_MAX_LEN bytes
+
+    @retval length of the formatted text
+    @retval 0 if the snapshot does not hold a numeric value
+
+==============================================================================*/
+size_t VARCACHE_Format( const VarEntry *pEntry, char *buf )
+{
+    size_t n = 0;
+
+    if ( ( pEntry != NULL ) &&
+         ( buf != NULL ) )
+    {
+        switch( pEntry->value.type )
+        {
+            case VARTYPE_UINT16:
+                n = NUMFMT_Uint64( pEntry->value.val.ui, buf );
+                break;
+
+            case VARTYPE_INT16:
+                n = NUMFMT_Int64( pEntry->value.val.i, buf );
+                break;
+
+            case VARTYPE_UINT32:
+                n = NUMFMT_Uint64( pEntry->value.val.ul, buf );
+                break;
+
+            case VARTYPE_INT32:
+                n = NUMFMT_Int64( pEntry->value.val.l, buf );
+                break;
+
+            case VARTYPE_UINT64:
+                n = NUMFMT_Uint64( pEntry->value.val.ull, buf );
+                break;
+
+            case VARTYPE_INT64:
+                n = NUMFMT_Int64( pEntry->value.val.ll, buf );
+                break;
+
+            case VARTYPE_FLOAT:
+                n = NUMFMT_Float( pEntry->value.val.f, buf );
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return n;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  FetchEntry                                                                */
+/*!
+    Fetch a variable value snapshot from the variable server
+
+    Numeric values are fetched with VAR_Get, and all other values are
+    printed to the scratch buffer.  The snapshot is marked valid if the
+    fetch succeeded, and recorded to the capture file if there is one.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry
+
+==============================================================================*/
+static void FetchEntry( VarCache *pVarCache,
+                        VARSERVER_HANDLE hVarServer,
+                        VarEntry *pEntry )
+{
+    int result;
+
+    if ( pEntry->type == VARTYPE_INVALID )
+    {
+        VAR_GetType( hVarServer, pEntry->hVar, &pEntry->type );
+    }
+
+    switch( pEntry->type )
+    {
+        case VARTYPE_UINT16:
+        case VARTYPE_INT16:
+        case VARTYPE_UINT32:
+        case VARTYPE_INT32:
+        case VARTYPE_UINT64:
+        case VARTYPE_INT64:
+        case VARTYPE_FLOAT:
+            result = FetchNumeric( hVarServer, pEntry );
+            if ( ( result == EOK ) && ( pEntry->printed == true ) )
+            {
+                /* keep the variable server's formatting of the value */
+                result = FetchPrint( pVarCache, hVarServer, pEntry );
+            }
+            break;
+
+        default:
+            pEntry->value.type = VARTYPE_INVALID;
+            result = FetchPrint( pVarCache, hVarServer, pEntry );
+            break;
+    }
+
+    pEntry->valid = ( result == EOK );
+    pEntry->fetchedVersion = pEntry->version;
+
+    if ( ( pEntry->valid == true ) &&
+         ( pVarCache->pCapture != NULL ) )
+    {
+        CAPTURE_Value( pVarCache->pCapture, pEntry );
+    }
+}
+
+/*============================================================================*/
+/*  FetchNumeric                                                              */
+/*!
+    Fetch a numeric variable
+
+    The value is fetched with VAR_Get.  Unless the variable server's
+    formatting of the value is kept (see VARCACHE_SetPrinted), the value
+    is also formatted natively.
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry
+
+    @retval EOK - the value was fetched and formatted
+    @retval ENOTSUP - the value is not numeric
+    @retval other - error returned by VAR_Get
+
+==============================================================================*/
+static int FetchNumeric( VARSERVER_HANDLE hVarServer, VarEntry *pEntry )
+{
+    int result;
+    char buf[NUMFMT_MAX_LEN];
+    size_t n;
+
+    result = VAR_Get( hVarServer, pEntry->hVar, &pEntry->value );
+    if ( ( result == EOK ) &&
+         ( pEntry->printed == false ) )
+    {
+        n = VARCACHE_Format( pEntry, buf );
+        result = ( n > 0 ) ? SetText( pEntry, buf, n ) : ENOTSUP;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  FetchPrint                                                                */
+/*!
+    Fetch a variable by having the variable server print it
+
+    The FetchPrint function renders the variable into the scratch buffer
+    using VAR_Print, and copies the output into the entry's text buffer.
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @param[in]
+        hVarServer
+            handle to the variable server
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry
+
+    @retval EOK - the value was fetched
+    @retval EBADF - no scratch buffer is available
+    @retval E2BIG - the value did not fit in the scratch buffer
+    @retval other - error returned by VAR_Print
+
+==============================================================================*/
+static int FetchPrint( VarCache *pVarCache,
+                       VARSERVER_HANDLE hVarServer,
+                       VarEntry *pEntry )
+{
+    int result = EBADF;
+    off_t offset;
+
+    if ( ( pVarCache->scratchFd != -1 ) &&
+         ( pVarCache->pScratch != NULL ) &&
+         ( lseek( pVarCache->scratchFd, 0, SEEK_SET ) == 0 ) )
+    {
+        result = VAR_Print( hVarServer, pEntry->hVar, pVarCache->scratchFd );
+        if ( result == EOK )
+        {
+            offset = lseek( pVarCache->scratchFd, 0, SEEK_CUR );
+            if ( ( offset >= 0 ) &&
+                 ( (size_t)offset <= pVarCache->scratchSize ) )
+            {
+                result = SetText( pEntry, pVarCache->pScratch, offset );
+            }
+            else
+            {
+                result = E2BIG;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetText                                                                   */
+/*!
+    Store the formatted text of a variable snapshot
+
+    The text buffer is only re-allocated when the text grows beyond its
+    current size, so steady state fetches do not allocate memory.  The
+    buffer fits any formatted number, and grows in powers of two, so a
+    value whose length changes from one fetch to the next does not
+    re-allocate it each time.
+
+    @param[in]
+        pEntry
+            pointer to the variable cache entry
+
+    @param[in]
+        p
+            pointer to the formatted text
+
+    @param[in]
+        len
+            length of the formatted text
+
+    @retval EOK - the text was stored
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int SetText( VarEntry *pEntry, const char *p, size_t len )
+{
+    int result = EOK;
+    char *pText;
+    size_t size;
+
+    if ( len + 1 > pEntry->textSize )
+    {
+        size = NUMFMT_MAX_LEN;
+        while ( size < len + 1 )
+        {
+            size *= 2;
+        }
+
+        pText = realloc( pEntry->pText, size );
+        if ( pText != NULL )
+        {
+            pEntry->pText = pText;
+            pEntry->textSize = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        memcpy( pEntry->pText, p, len );
+        pEntry->pText[len] = '\0';
+        pEntry->textLen = len;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Hash                                                                      */
+/*!
+    Compute the hash bucket index for a variable handle
+
+    @param[in]
+        hVar
+            variable handle
+
+    @param[in]
+        numBuckets
+            number of hash buckets (power of 2)
+
+    @retval hash bucket index
+
+==============================================================================*/
+static size_t Hash( VAR_HANDLE hVar, size_t numBuckets )
+{
+    /* Fibonacci hashing spreads sequential handles across the buckets */
+    uint64_t h = (uint64_t)hVar * 0x9E3779B97F4A7C15ULL;
+
+    return (size_t)( h >> 32 ) & ( numBuckets - 1 );
+}
+
+/*============================================================================*/
+/*  HashName                                                                  */
+/*!
+    Map a variable name to a hash bucket
+
+    @param[in]
+        name
+            variable name
+
+    @param[in]
+        numBuckets
+            number of hash buckets (power of 2)
+
+    @retval hash bucket index
+
+==============================================================================*/
+static size_t HashName( const char *name, size_t numBuckets )
+{
+    /* FNV-1a */
+    uint64_t h = 0xCBF29CE484222325ULL;
+
+    while ( *name != '\0' )
+    {
+        h ^= (unsigned char)*name++;
+        h *= 0x100000001B3ULL;
+    }
+
+    return (size_t)( h ^ ( h >> 32 ) ) & ( numBuckets - 1 );
+}
+
+/*============================================================================*/
+/*  Grow                                                                      */
+/*!
+    Double the number of hash buckets
+
+    @param[in]
+        pVarCache
+            pointer to the variable cache
+
+    @retval EOK - the hash table was resized
+    @retval ENOMEM - memory allocation failure
+
+==============================================================================*/
+static int Grow( VarCache *pVarCache )
+{
+    int result = ENOMEM;
+    VarEntry **ppBuckets;
+    VarEntry **ppNames;
+    VarEntry *pEntry;
+    VarEntry *pNext;
+    size_t numBuckets = pVarCache->numBuckets * 2;
+    size_t idx;
+    size_t i;
+
+    ppBuckets = calloc( numBuckets, sizeof( VarEntry * ) );
+    ppNames = calloc( numBuckets, sizeof( VarEntry * ) );
+    if ( ( ppBuckets != NULL ) && ( ppNames != NULL ) )
+    {
+        for ( i = 0 ; i < pVarCache->numBuckets ; i++ )
+        {
+            pEntry = pVarCache->ppBuckets[i];
+            while ( pEntry != NULL )
+            {
+                pNext = pEntry->pNext;
+                idx = Hash( pEntry->hVar, numBuckets );
+                pEntry->pNext = ppBuckets[idx];
+                ppBuckets[idx] = pEntry;
+
+                if ( pEntry->name != NULL )
+                {
+                    idx = HashName( pEntry->name, numBuckets );
+                    pEntry->pNameNext = ppNames[idx];
+                    ppNames[idx] = pEntry;
+                }
+
+                pEntry = pNext;
+            }
+        }
+
+        free( pVarCache->ppBuckets );
+        free( pVarCache->ppNames );
+        pVarCache->ppBuckets = ppBuckets;
+        pVarCache->ppNames = ppNames;
+        pVarCache->numBuckets = numBuckets;
+        result = EOK;
+    }
+    else
+    {
+        free( ppBuckets );
+        free( ppNames );
+    }
+
+    return result;
+}
+
+/*! @}
+ * end of varcache group */
@@ -0,0 +1,558 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+
+/*!
+ * @defgroup varreg varreg
+ * @brief Parallel variable lookup and notification registration
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file varreg.c
+
+    Variable Registrar
+
+    The varreg module looks up a set of variables by name, and requests
+    their MODIFIED notifications, using several variable server
+    connections at once.  Each lookup and each request is a round trip
+    to the variable server, and the variable server has no call which
+    takes more than one variable, so with tens of thousands of variables
+    a serial registration takes seconds.  Spreading the round trips over
+    a pool of worker threads, each with its own connection, overlaps
+    them.
+
+    The variables are added in any order, and duplicates are merged when
+    the registrar is run.  The calling thread works on the caller's
+    connection, and the extra connections are opened on the first run.
+    A notification belongs to the connection which requested it, so the
+    extra connections stay open until the registrar is deleted, and each
+    variable records the connection its notification was requested on,
+    so it can be cancelled through the same connection.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "varreg.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! maximum number of variable server connections */
+#define VARREG_MAX_CONNECTIONS  ( 8 )
+
+/*! minimum number of variables worth each extra connection */
+#define VARREG_MIN_BATCH        ( 64 )
+
+/*! initial number of variables allocated */
+#define VARREG_INITIAL_SIZE     ( 64 )
+
+/*! variable registrar */
+struct varReg
+{
+    /*! variables to register */
+    VarRegItem *pItems;
+
+    /*! number of variables */
+    size_t count;
+
+    /*! number of variables allocated */
+    size_t size;
+
+    /*! index of the next variable to be registered */
+    atomic_size_t next;
+
+    /*! extra variable server connections */
+    VARSERVER_HANDLE hConns[VARREG_MAX_CONNECTIONS];
+
+    /*! number of extra connections open */
+    size_t numConns;
+};
+
+/*! registration worker */
+typedef struct varRegWorker
+{
+    /*! pointer to the registrar */
+    VarReg *pReg;
+
+    /*! connection the worker registers on */
+    VARSERVER_HANDLE hVarServer;
+} VarRegWorker;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void Merge( VarReg *pReg );
+static int CompareItems( const void *pA, const void *pB );
+static size_t Connections( VarReg *pReg, size_t connections );
+static void *RegisterThread( void *arg );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  VARREG_Create                                                             */
+/*!
+    Create an empty variable registrar
+
+    @retval pointer to the new variable registrar
+    @retval NULL if memory allocation failed
+
+==============================================================================*/
+VarReg *VARREG_Create( void )
+{
+    return calloc( 1, sizeof( VarReg ) );
+}
+
+/*============================================================================*/
+/*  VARREG_Delete                                                             */
+/*!
+    Delete a variable registrar
+
+    The extra connections are closed, so the notifications which were
+    requested on them are no longer delivered.
+
+    @param[in]
+        pReg
+            pointer to the variable registrar (may be NULL)
+
+==============================================================================*/
+void VARREG_Delete( VarReg *pReg )
+{
+    size_t i;
+
+    if ( pReg != NULL )
+    {
+        for ( i = 0 ; i < pReg->numConns ; i++ )
+        {
+            (void)VARSERVER_Close( pReg->hConns[i] );
+        }
+
+        free( pReg->pItems );
+        free( pReg );
+    }
+}
+
+/*============================================================================*/
+/*  VARREG_Clear                                                              */
+/*!
+    Remove all of the variables from a variable registrar
+
+    The extra connections are kept open.
+
+    @param[in]
+        pReg
+            pointer to the variable registrar
+
+==============================================================================*/
+void VARREG_Clear( VarReg *pReg )
+{
+    if ( pReg != NULL )
+    {
+        pReg->count = 0;
+    }
+}
+
+/*============================================================================*/
+/*  VARREG_Add                                                                */
+/*!
+    Add a variable to a variable registrar
+
+    The name is not copied, so it must outlive the registration.
+
+    @param[in]
+        pReg
+            pointer to the variable registrar
+
+    @param[in]
+        name
+            name of the variable
+
+    @param[in]
+        hVar
+            handle of the variable, or VAR_INVALID to look it up
+
+    @param[in]
+        watch
+            request a MODIFIED notification for the variable
+
+    @retval EOK - the variable was added
+    @retval ENOMEM - memory allocation failed
+    @retval EINVAL - invalid arguments
+
+==============================================================================*/
+int VARREG_Add( VarReg *pReg, char *name, VAR_HANDLE hVar, bool watch )
+{
+    int result = EINVAL;
+    VarRegItem *pItems;
+    VarRegItem *pItem;
+    size_t size;
+
+    if ( ( pReg != NULL ) &&
+         ( name != NULL ) )
+    {
+        result = EOK;
+
+        if ( pReg->count == pReg->size )
+        {
+            size = ( pReg->size > 0 ) ? pReg->size * 2 : VARREG_INITIAL_SIZE;
+            pItems = realloc( pReg->pItems, size * sizeof( VarRegItem ) );
+            if ( pItems != NULL )
+            {
+                pReg->pItems = pItems;
+                pReg->size = size;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pItem = &pReg->pItems[pReg->count++];
+            pItem->name = name;
+            pItem->hVar = hVar;
+            pItem->watch = watch;
+            pItem->hWatch = NULL;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VARREG_Run                                                                */
+/*!
+    Register the variables of a variable registrar
+
+    The VARREG_Run function merges the duplicate variables, and then
+    looks up the handle of each variable which does not have one, and
+    requests the notifications, using up to the specified number of
+    connections.  A small set of variables is registered on the
+    caller's connection alone, since a connection is only worth
+    opening for a batch of variables.
+
+    @param[in]
+        pReg
+            pointer to the variable registrar
+
+    @param[in]
+        hVarServer
+            handle to the variable server, used by the calling thread
+
+    @param[in]
+        connections
+            maximum number of connections (0 for one per online CPU)
+
+    @retval number of connections the variables were registered on
+
+==============================================================================*/
+size_t VARREG_Run( VarReg *pReg,
+                   VARSERVER_HANDLE hVarServer,
+                   size_t connections )
+{
+    VarRegWorker workers[VARREG_MAX_CONNECTIONS];
+    pthread_t threads[VARREG_MAX_CONNECTIONS];
+    sigset_t mask;
+    sigset_t saved;
+    size_t started = 0;
+    size_t i;
+
+    if ( ( pReg != NULL ) &&
+         ( hVarServer != NULL ) )
+    {
+        Merge( pReg );
+        atomic_store( &pReg->next, 0 );
+
+        connections = Connections( pReg, connections );
+        while ( pReg->numConns + 1 < connections )
+        {
+            pReg->hConns[pReg->numConns] = VARSERVER_Open();
+            if ( pReg->hConns[pReg->numConns] == NULL )
+            {
+                break;
+            }
+
+            pReg->numConns++;
+        }
+
+        /* the workers must not take the process signals, which are
+           received synchronously by the main thread */
+        sigfillset( &mask );
+        pthread_sigmask( SIG_SETMASK, &mask, &saved );
+
+        for ( i = 0 ; ( i + 1 < connections ) && ( i < pReg->numConns ) ; i++ )
+        {
+            workers[started].pReg = pReg;
+            workers[started].hVarServer = pReg->hConns[i];
+            if ( pthread_create( &threads[started],
+                                 NULL,
+                                 RegisterThread,
+                                 &workers[started] ) == 0 )
+            {
+                started++;
+            }
+        }
+
+        pthread_sigmask( SIG_SETMASK, &saved, NULL );
+
+        /* the calling thread is one of the workers */
+        workers[started].pReg = pReg;
+        workers[started].hVarServer = hVarServer;
+        (void)RegisterThread( &workers[started] );
+
+        for ( i = 0 ; i < started ; i++ )
+        {
+            pthread_join( threads[i], NULL );
+        }
+
+        started++;
+    }
+
+    return started;
+}
+
+/*============================================================================*/
+/*  VARREG_Count                                                              */
+/*!
+    Get the number of variables of a variable registrar
+
+    @param[in]
+        pReg
+            pointer to the variable registrar
+
+    @retval number of variables
+
+==============================================================================*/
+size_t VARREG_Count( VarReg *pReg )
+{
+    return ( pReg != NULL ) ? pReg->count : 0;
+}
+
+/*============================================================================*/
+/*  VARREG_Get                                                                */
+/*!
+    Get a variable of a variable registrar
+
+    Once the registrar has been run, the variables are in name order,
+    without duplicates.
+
+    @param[in]
+        pReg
+            pointer to the variable registrar
+
+    @param[in]
+        idx
+            index of the variable
+
+    @retval pointer to the variable
+    @retval NULL if the index is out of range
+
+==============================================================================*/
+VarRegItem *VARREG_Get( VarReg *pReg, size_t idx )
+{
+    return ( ( pReg != NULL ) && ( idx < pReg->count ) )
+           ? &pReg->pItems[idx]
+           : NULL;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Merge                                                                     */
+/*!
+    Merge the duplicate variables of a variable registrar
+
+    The variables are sorted by name, and the entries of a name are
+    merged into one, which is watched if any of them is.
+
+    @param[in]
+        pReg
+            pointer to the variable registrar
+
+==============================================================================*/
+static void Merge( VarReg *pReg )
+{
+    VarRegItem *pLast;
+    VarRegItem *pItem;
+    size_t count = 0;
+    size_t i;
+
+    if ( pReg->count > 1 )
+    {
+        qsort( pReg->pItems, pReg->count, sizeof( VarRegItem ), CompareItems );
+
+        for ( i = 0 ; i < pReg->count ; i++ )
+        {
+            pItem = &pReg->pItems[i];
+            pLast = ( count > 0 ) ? &pReg->pItems[count - 1] : NULL;
+            if ( ( pLast != NULL ) &&
+                 ( strcmp( pLast->name, pItem->name ) == 0 ) )
+            {
+                pLast->watch |= pItem->watch;
+                if ( pLast->hVar == VAR_INVALID )
+                {
+                    pLast->hVar = pItem->hVar;
+                }
+            }
+            else
+            {
+                pReg->pItems[count++] = *pItem;
+            }
+        }
+
+        pReg->count = count;
+    }
+}
+
+/*============================================================================*/
+/*  CompareItems                                                              */
+/*!
+    Compare two variables by name
+
+    @param[in]
+        pA
+            pointer to the first variable
+
+    @param[in]
+        pB
+            pointer to the second variable
+
+    @retval <0, 0 or >0 as the first name sorts before, with, or after
+            the second
+
+==============================================================================*/
+static int CompareItems( const void *pA, const void *pB )
+{
+    return strcmp( ( (const VarRegItem *)pA )->name,
+                   ( (const VarRegItem *)pB )->name );
+}
+
+/*============================================================================*/
+/*  Connections                                                               */
+/*!
+    Choose the number of connections to register the variables on
+
+    @param[in]
+        pReg
+            pointer to the variable registrar
+
+    @param[in]
+        connections
+            maximum number of connections (0 for one per online CPU)
+
+    @retval number of connections, including the caller's
+
+==============================================================================*/
+static size_t Connections( VarReg *pReg, size_t connections )
+{
+    long cpus;
+    size_t batches = ( pReg->count + VARREG_MIN_BATCH - 1 ) / VARREG_MIN_BATCH;
+
+    if ( connections == 0 )
+    {
+        cpus = sysconf( _SC_NPROCESSORS_ONLN );
+        connections = ( cpus > 0 ) ? (size_t)cpus : 1;
+    }
+
+    if ( connections > VARREG_MAX_CONNECTIONS )
+    {
+        connections = VARREG_MAX_CONNECTIONS;
+    }
+
+    if ( connections > batches )
+    {
+        connections = batches;
+    }
+
+    return ( connections > 0 ) ? connections : 1;
+}
+
+/*============================================================================*/
+/*  RegisterThread                                                            */
+/*!
+    Variable registration worker
+
+    The RegisterThread function looks up, and watches, variables until
+    all of the variables of the registrar have been taken.
+
+    @param[in]
+        arg
+            pointer to the registration worker
+
+    @retval NULL
+
+==============================================================================*/
+static void *RegisterThread( void *arg )
+{
+    VarRegWorker *pWorker = (VarRegWorker *)arg;
+    VarReg *pReg = pWorker->pReg;
+    VarRegItem *pItem;
+    size_t idx;
+
+    while ( ( idx = atomic_fetch_add( &pReg->next, 1 ) ) < pReg->count )
+    {
+        pItem = &pReg->pItems[idx];
+        if ( pItem->hVar == VAR_INVALID )
+        {
+            pItem->hVar = VAR_FindByName( pWorker->hVarServer, pItem->name );
+        }
+
+        if ( ( pItem->hVar != VAR_INVALID ) &&
+             ( pItem->watch == true ) &&
+             ( VAR_Notify( pWorker->hVarServer,
+                           pItem->hVar,
+                           NOTIFY_MODIFIED ) == EOK ) )
+        {
+            pItem->hWatch = pWorker->hVarServer;
+        }
+    }
+
+    return NULL;
+}
+
+/*! @}
+ * end of varreg group */
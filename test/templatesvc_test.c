@@ -0,0 +1,3200 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2024 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup templatesvc_test templatesvc_test
+ * @brief Template service unit tests
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file templatesvc_test.c
+
+    Template Service Unit Tests
+
+    The templatesvc_test application exercises the template service core
+    against the in-process mock variable server.  Each test writes a
+    template service configuration to a temporary directory, loads it,
+    injects variable server notifications, and checks the exact bytes
+    delivered to the file and message queue targets, along with the
+    number of renders performed.
+
+    The application exits with a non-zero status if any check fails.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <varserver/varserver.h>
+#include <tjson/json.h>
+#include "templatesvc.h"
+#include "capture.h"
+#include "logger.h"
+#include "eventloop.h"
+#include "mockvarserver.h"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! maximum length of a test file path */
+#define TEST_PATH_LEN       ( 256 )
+
+/*! size of the buffers used to build configurations and read output */
+#define TEST_BUF_SIZE       ( 4096 )
+
+/*! message size of the test message queue */
+#define TEST_MQ_MSGSIZE     ( 1024 )
+
+/*! length of the output which overruns a default size pipe */
+#define TEST_PIPE_FILL      ( 128 * 1024 )
+
+/*! number of render cycles which warm up the templates */
+#define TEST_WARM_CYCLES    ( 4 )
+
+/*! number of steady state render cycles checked for heap allocations */
+#define TEST_STEADY_CYCLES  ( 32 )
+
+/*! size of a render which does not fit in the default render buffer */
+#define TEST_STREAM_SIZE    ( 384 * 1024 )
+
+/*! number of trigger variables registered over several connections */
+#define TEST_REGISTER_VARS  ( 256 )
+
+/*! check a test condition and record a failure if it does not hold */
+#define CHECK( cond ) Check( (cond), #cond, __FILE__, __LINE__ )
+
+/*! a unit test */
+typedef struct unitTest
+{
+    /*! name of the test */
+    char *name;
+
+    /*! test function */
+    void (*fn)( void );
+
+} UnitTest;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! template service state under test */
+static TemplateSvcState state;
+
+/*! temporary directory holding the test files */
+static char testDir[TEST_PATH_LEN];
+
+/*! number of checks performed */
+static int checks;
+
+/*! number of failed checks */
+static int failures;
+
+/*! test variable handles */
+static VAR_HANDLE hA;
+static VAR_HANDLE hB;
+static VAR_HANDLE hC;
+
+/*! heap allocations are being counted */
+static bool countAllocs;
+
+/*! number of heap allocations counted */
+static uint64_t allocs;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void Check( bool cond, const char *expr, const char *file, int line );
+static char *TestPath( char *buf, const char *name );
+static int WriteFile( const char *path, const char *fmt, ... );
+static ssize_t ReadFile( const char *path, char *buf, size_t size );
+static bool FileEquals( const char *path, const char *expected );
+static int Setup( const char *fmt, ... );
+static void Teardown( void );
+static void SetStr( VAR_HANDLE hVar, char *str );
+static void SetUint( VAR_HANDLE hVar, uint32_t val );
+static int Dispatch( void );
+static int Fetch( Template *pTemplate );
+static Template *FindTemplate( const char *name );
+
+static void TestSetupTemplate( void );
+static void TestProcessTemplates( void );
+static void TestDispatchBatching( void );
+static void TestPrintTemplateFD( void );
+static void TestNumericFormat( void );
+static void TestPrintTemplateMQ( void );
+static void TestStructuredOutput( void );
+static void TestPrintMetrics( void );
+static void TestCompression( void );
+static void TestCapture( void );
+static void TestLogger( void );
+static void TestEventLoop( void );
+static void TestPeriodic( void );
+static void TestTriggerConditions( void );
+static void TestCommit( void );
+static void TestReload( void );
+static void TestConfCache( void );
+static void TestConfigDir( void );
+static void TestTenants( void );
+static void TestTriggerIndex( void );
+static void TestWildcardTriggers( void );
+static void TestAutoTriggers( void );
+static void TestPendingVars( void );
+static void TestStartupRegistration( void );
+static void TestSteadyState( void );
+static size_t Signatures( char *buf, size_t size );
+static size_t DecodeFrames( const char *algorithm,
+                            const char *pData,
+                            size_t len,
+                            const char **ppExpected,
+                            size_t count );
+static void Trigger( VAR_HANDLE hVar );
+static void TimerExpired( EventLoop *pLoop,
+                          EventTimer *pTimer,
+                          uint64_t expirations,
+                          void *arg );
+
+/* allocator functions wrapped at link time to count heap allocations */
+void *__real_malloc( size_t size );
+void *__real_calloc( size_t nmemb, size_t size );
+void *__real_realloc( void *ptr, size_t size );
+char *__real_strdup( const char *s );
+
+void *__wrap_malloc( size_t size );
+void *__wrap_calloc( size_t nmemb, size_t size );
+void *__wrap_realloc( void *ptr, size_t size );
+char *__wrap_strdup( const char *s );
+
+/*! list of unit tests */
+static const UnitTest tests[] =
+{
+    { "SetupTemplate", TestSetupTemplate },
+    { "ProcessTemplates", TestProcessTemplates },
+    { "DispatchBatching", TestDispatchBatching },
+    { "PrintTemplateFD", TestPrintTemplateFD },
+    { "NumericFormat", TestNumericFormat },
+    { "PrintTemplateMQ", TestPrintTemplateMQ },
+    { "StructuredOutput", TestStructuredOutput },
+    { "PrintMetrics", TestPrintMetrics },
+    { "Compression", TestCompression },
+    { "Capture", TestCapture },
+    { "Logger", TestLogger },
+    { "EventLoop", TestEventLoop },
+    { "Periodic", TestPeriodic },
+    { "TriggerConditions", TestTriggerConditions },
+    { "Commit", TestCommit },
+    { "Reload", TestReload },
+    { "ConfCache", TestConfCache },
+    { "ConfigDir", TestConfigDir },
+    { "Tenants", TestTenants },
+    { "TriggerIndex", TestTriggerIndex },
+    { "WildcardTriggers", TestWildcardTriggers },
+    { "AutoTriggers", TestAutoTriggers },
+    { "PendingVars", TestPendingVars },
+    { "StartupRegistration", TestStartupRegistration },
+    { "SteadyState", TestSteadyState }
+};
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the templatesvc_test application
+
+    @retval 0 - all checks passed
+    @retval 1 - one or more checks failed
+
+==============================================================================*/
+int main( void )
+{
+    size_t i;
+    int before;
+    char cmd[TEST_PATH_LEN + 16];
+
+    strcpy( testDir, "/tmp/templatesvc_test.XXXXXX" );
+    if ( mkdtemp( testDir ) == NULL )
+    {
+        fprintf( stderr, "templatesvc_test: cannot create %s\n", testDir );
+        return 1;
+    }
+
+    for ( i = 0 ; i < sizeof( tests ) / sizeof( tests[0] ) ; i++ )
+    {
+        before = failures;
+        tests[i].fn();
+        printf( "%-24s %s\n",
+                tests[i].name,
+                ( failures == before ) ? "PASS" : "FAIL" );
+    }
+
+    printf( "%d checks, %d failures\n", checks, failures );
+
+    snprintf( cmd, sizeof( cmd ), "rm -rf %s", testDir );
+    if ( system( cmd ) != 0 )
+    {
+        fprintf( stderr, "templatesvc_test: cannot remove %s\n", testDir );
+    }
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*============================================================================*/
+/*  __wrap_malloc                                                             */
+/*!
+    Count a heap allocation
+
+==============================================================================*/
+void *__wrap_malloc( size_t size )
+{
+    if ( countAllocs == true )
+    {
+        allocs++;
+    }
+
+    return __real_malloc( size );
+}
+
+/*============================================================================*/
+/*  __wrap_calloc                                                             */
+/*!
+    Count a zeroed heap allocation
+
+==============================================================================*/
+void *__wrap_calloc( size_t nmemb, size_t size )
+{
+    if ( countAllocs == true )
+    {
+        allocs++;
+    }
+
+    return __real_calloc( nmemb, size );
+}
+
+/*============================================================================*/
+/*  __wrap_realloc                                                            */
+/*!
+    Count a heap reallocation
+
+==============================================================================*/
+void *__wrap_realloc( void *ptr, size_t size )
+{
+    if ( countAllocs == true )
+    {
+        allocs++;
+    }
+
+    return __real_realloc( ptr, size );
+}
+
+/*============================================================================*/
+/*  __wrap_strdup                                                             */
+/*!
+    Count a string duplication
+
+==============================================================================*/
+char *__wrap_strdup( const char *s )
+{
+    if ( countAllocs == true )
+    {
+        allocs++;
+    }
+
+    return __real_strdup( s );
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  TestSetupTemplate                                                         */
+/*!
+    Check that template definitions are loaded
+
+    Checks that the template type, compiled template and trigger variables
+    are set up from the configuration, that only the trigger variables
+    are watched for MODIFIED notifications, and that a template with an
+    unsupported compression is rejected.
+
+==============================================================================*/
+static void TestSetupTemplate( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out[TEST_PATH_LEN];
+    Template *pTemplate;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out, "test.out" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"fd\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"mq\",\"trigger\":[\"/test/c\"],"
+                  "\"template\":\"%s\",\"type\":\"mq\","
+                  "\"target\":\"/templatesvc_test\"}]}",
+                  tmpl, out, tmpl ) == EOK );
+
+    pTemplate = FindTemplate( "fd" );
+    CHECK( pTemplate != NULL );
+    if ( pTemplate != NULL )
+    {
+        CHECK( pTemplate->type == TMPL_FD );
+        CHECK( pTemplate->format == FMT_TEXT );
+        CHECK( pTemplate->pCompiled != NULL );
+        CHECK( pTemplate->pTriggers != NULL );
+        if ( pTemplate->pTriggers != NULL )
+        {
+            CHECK( pTemplate->pTriggers->hVar == hA );
+            CHECK( pTemplate->numTriggers == 1 );
+        }
+
+        CHECK( pTemplate->renders == 0 );
+    }
+
+    pTemplate = FindTemplate( "mq" );
+    CHECK( pTemplate != NULL );
+    if ( pTemplate != NULL )
+    {
+        CHECK( pTemplate->type == TMPL_MQ );
+    }
+
+    CHECK( MOCK_IsWatched( hA ) == true );
+    CHECK( MOCK_IsWatched( hB ) == false );
+    CHECK( MOCK_IsWatched( hC ) == true );
+
+    Teardown();
+
+    /* a template whose compression is not available is rejected */
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"fd\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"packed\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\","
+                  "\"compress\":\"brotli\"}]}",
+                  tmpl, out, tmpl, out ) == ENOTSUP );
+    CHECK( FindTemplate( "fd" ) != NULL );
+    CHECK( FindTemplate( "packed" ) == NULL );
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestProcessTemplates                                                      */
+/*!
+    Check that only triggered templates are rendered
+
+==============================================================================*/
+static void TestProcessTemplates( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out[TEST_PATH_LEN];
+    Template *pTemplate;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out, "process.out" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"t\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out ) == EOK );
+
+    pTemplate = FindTemplate( "t" );
+    CHECK( pTemplate != NULL );
+    if ( pTemplate != NULL )
+    {
+        /* a referenced variable which is not a trigger */
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hB ) == EOK );
+        CHECK( pTemplate->dirty == false );
+
+        CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+        CHECK( pTemplate->renders == 0 );
+        CHECK( access( out, F_OK ) != 0 );
+
+        /* the trigger variable */
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+        CHECK( pTemplate->dirty == true );
+
+        CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+        CHECK( pTemplate->dirty == false );
+        CHECK( pTemplate->renders == 1 );
+        CHECK( FileEquals( out, "a=1 b=hello\n" ) );
+
+        /* the output is replaced on each render */
+        SetUint( hA, 7 );
+        SetStr( hB, "hi" );
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+        CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+        CHECK( pTemplate->renders == 2 );
+        CHECK( FileEquals( out, "a=7 b=hi\n" ) );
+    }
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestDispatchBatching                                                      */
+/*!
+    Check that pending notifications are batched into one render cycle
+
+    Several MODIFIED notifications are injected for two templates before
+    the first one is dispatched.  Each template must be rendered exactly
+    once, from the latest variable values, and no notifications may be
+    left pending.
+
+==============================================================================*/
+static void TestDispatchBatching( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    Template *pT1;
+    Template *pT2;
+    sigset_t pending;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out1, "batch1.out" );
+    TestPath( out2, "batch2.out" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"t1\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"t2\",\"trigger\":[\"/test/a\",\"/test/c\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out1, tmpl, out2 ) == EOK );
+
+    pT1 = FindTemplate( "t1" );
+    pT2 = FindTemplate( "t2" );
+    CHECK( ( pT1 != NULL ) && ( pT2 != NULL ) );
+    if ( ( pT1 != NULL ) && ( pT2 != NULL ) )
+    {
+        SetUint( hA, 2 );
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        SetUint( hA, 3 );
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        CHECK( MOCK_InjectModified( hC ) == EOK );
+
+        /* b is not watched, so there is nothing to inject */
+        CHECK( MOCK_InjectModified( hB ) == ENOENT );
+
+        CHECK( Dispatch() == EOK );
+        CHECK( pT1->renders == 1 );
+        CHECK( pT2->renders == 1 );
+        CHECK( FileEquals( out1, "a=3 b=hello\n" ) );
+        CHECK( FileEquals( out2, "a=3 b=hello\n" ) );
+
+        sigpending( &pending );
+        CHECK( sigismember( &pending, SIG_VAR_MODIFIED ) == 0 );
+
+        /* a notification for the second template only */
+        CHECK( MOCK_InjectModified( hC ) == EOK );
+        CHECK( Dispatch() == EOK );
+        CHECK( pT1->renders == 1 );
+        CHECK( pT2->renders == 2 );
+    }
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestPrintTemplateFD                                                       */
+/*!
+    Check the file descriptor sink
+
+    Checks the overwrite and append modes, and a target which cannot
+    be opened.
+
+==============================================================================*/
+static void TestPrintTemplateFD( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    char out3[TEST_PATH_LEN];
+    Template *pTemplate;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out1, "overwrite.out" );
+    TestPath( out2, "append.out" );
+    TestPath( out3, "missing/dir.out" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"overwrite\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"append\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\","
+                  "\"append\":true},"
+                  "{\"name\":\"missing\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out1, tmpl, out2, tmpl, out3 ) == EOK );
+
+    pTemplate = FindTemplate( "overwrite" );
+    CHECK( pTemplate != NULL );
+    if ( pTemplate != NULL )
+    {
+        CHECK( Fetch( pTemplate ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pTemplate ) == EOK );
+        CHECK( FileEquals( out1, "a=1 b=hello\n" ) );
+
+        /* shorter output must not leave stale bytes behind */
+        SetStr( hB, "x" );
+        CHECK( Fetch( pTemplate ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pTemplate ) == EOK );
+        CHECK( FileEquals( out1, "a=1 b=x\n" ) );
+        CHECK( pTemplate->fd == -1 );
+    }
+
+    pTemplate = FindTemplate( "append" );
+    CHECK( pTemplate != NULL );
+    if ( pTemplate != NULL )
+    {
+        SetStr( hB, "one" );
+        CHECK( Fetch( pTemplate ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pTemplate ) == EOK );
+        SetStr( hB, "two" );
+        CHECK( Fetch( pTemplate ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pTemplate ) == EOK );
+        CHECK( FileEquals( out2, "a=1 b=one\na=1 b=two\n" ) );
+    }
+
+    pTemplate = FindTemplate( "missing" );
+    CHECK( pTemplate != NULL );
+    if ( pTemplate != NULL )
+    {
+        CHECK( Fetch( pTemplate ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pTemplate ) == ENOENT );
+    }
+
+    CHECK( TEMPLATESVC_PrintTemplateFD( &state, NULL ) == EINVAL );
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestNumericFormat                                                         */
+/*!
+    Check the formatting of numeric variables
+
+    Numeric variables must be rendered as the variable server prints them
+    by default, and in the shortest round-trip form by a template with
+    the "native_format" attribute, also when both reference the same
+    variable.
+
+==============================================================================*/
+static void TestNumericFormat( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    Template *pPrinted;
+    Template *pNative;
+    VarObject obj;
+    VAR_HANDLE hF;
+
+    TestPath( tmpl, "numeric.tmpl" );
+    TestPath( out1, "printed.out" );
+    TestPath( out2, "native.out" );
+    WriteFile( tmpl, "f=${/test/f} c=${/test/c}\n" );
+
+    obj.type = VARTYPE_FLOAT;
+    obj.len = sizeof( float );
+    obj.val.f = 1.5f;
+    hF = MOCK_AddVar( "/test/f", &obj );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"printed\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"native\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\","
+                  "\"native_format\":true}]}",
+                  tmpl, out1, tmpl, out2 ) == EOK );
+
+    pPrinted = FindTemplate( "printed" );
+    pNative = FindTemplate( "native" );
+    CHECK( ( pPrinted != NULL ) && ( pNative != NULL ) );
+    if ( ( pPrinted != NULL ) && ( pNative != NULL ) )
+    {
+        CHECK( Fetch( pPrinted ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pPrinted ) == EOK );
+        CHECK( FileEquals( out1, "f=1.500000 c=-5\n" ) );
+
+        CHECK( Fetch( pNative ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pNative ) == EOK );
+        CHECK( FileEquals( out2, "f=1.5 c=-5\n" ) );
+
+        obj.val.f = 0.1f;
+        CHECK( MOCK_SetVar( hF, &obj ) == EOK );
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hF ) == EOK );
+        CHECK( Fetch( pNative ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pNative ) == EOK );
+        CHECK( FileEquals( out2, "f=0.1 c=-5\n" ) );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pPrinted ) == EOK );
+        CHECK( FileEquals( out1, "f=0.100000 c=-5\n" ) );
+    }
+
+    Teardown();
+
+    /* a variable referenced only natively is formatted natively */
+    hF = MOCK_AddVar( "/test/f", &obj );
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"native\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\","
+                  "\"native_format\":true}]}",
+                  tmpl, out2 ) == EOK );
+
+    pNative = FindTemplate( "native" );
+    CHECK( pNative != NULL );
+    if ( pNative != NULL )
+    {
+        CHECK( pNative->pCompiled->pSegments[1].pEntry->printed == false );
+        CHECK( Fetch( pNative ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateFD( &state, pNative ) == EOK );
+        CHECK( FileEquals( out2, "f=0.1 c=-5\n" ) );
+    }
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestPrintTemplateMQ                                                       */
+/*!
+    Check the message queue sink
+
+    Each render must be delivered as exactly one message holding the
+    rendered output.
+
+==============================================================================*/
+static void TestPrintTemplateMQ( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char mqName[TEST_PATH_LEN];
+    char buf[TEST_MQ_MSGSIZE];
+    struct mq_attr attr;
+    Template *pTemplate;
+    mqd_t mq;
+    ssize_t n;
+
+    TestPath( tmpl, "test.tmpl" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+
+    snprintf( mqName, sizeof( mqName ), "/templatesvc_test.%d", getpid() );
+
+    memset( &attr, 0, sizeof( attr ) );
+    attr.mq_maxmsg = 4;
+    attr.mq_msgsize = TEST_MQ_MSGSIZE;
+
+    mq = mq_open( mqName, O_RDONLY | O_CREAT | O_NONBLOCK, 0600, &attr );
+    CHECK( mq != (mqd_t)-1 );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"mq\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"mq\","
+                  "\"target\":\"%s\"}]}",
+                  tmpl, mqName ) == EOK );
+
+    pTemplate = FindTemplate( "mq" );
+    CHECK( pTemplate != NULL );
+    if ( ( pTemplate != NULL ) && ( mq != (mqd_t)-1 ) )
+    {
+        CHECK( Fetch( pTemplate ) == EOK );
+        CHECK( TEMPLATESVC_PrintTemplateMQ( &state, pTemplate ) == EOK );
+
+        n = mq_receive( mq, buf, sizeof( buf ), NULL );
+        CHECK( n == (ssize_t)strlen( "a=1 b=hello\n" ) );
+        CHECK( ( n > 0 ) && ( memcmp( buf, "a=1 b=hello\n", n ) == 0 ) );
+
+        /* a triggered render is delivered as one message */
+        SetUint( hA, 42 );
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        CHECK( Dispatch() == EOK );
+        CHECK( pTemplate->renders == 1 );
+
+        n = mq_receive( mq, buf, sizeof( buf ), NULL );
+        CHECK( n == (ssize_t)strlen( "a=42 b=hello\n" ) );
+        CHECK( ( n > 0 ) && ( memcmp( buf, "a=42 b=hello\n", n ) == 0 ) );
+
+        n = mq_receive( mq, buf, sizeof( buf ), NULL );
+        CHECK( ( n == -1 ) && ( errno == EAGAIN ) );
+    }
+
+    Teardown();
+
+    if ( mq != (mqd_t)-1 )
+    {
+        mq_close( mq );
+        mq_unlink( mqName );
+    }
+}
+
+/*============================================================================*/
+/*  TestStructuredOutput                                                      */
+/*!
+    Check the JSON Lines output format
+
+==============================================================================*/
+static void TestStructuredOutput( void )
+{
+    char out[TEST_PATH_LEN];
+    Template *pTemplate;
+
+    TestPath( out, "test.jsonl" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"jsonl\",\"trigger\":[\"/test/a\"],"
+                  "\"format\":\"jsonl\",\"vars\":[\"/test/a\",\"/test/b\","
+                  "\"/test/c\"],\"type\":\"fd\",\"target\":\"%s\","
+                  "\"append\":true}]}",
+                  out ) == EOK );
+
+    pTemplate = FindTemplate( "jsonl" );
+    CHECK( pTemplate != NULL );
+    if ( pTemplate != NULL )
+    {
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        CHECK( Dispatch() == EOK );
+
+        SetUint( hA, 5 );
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        CHECK( Dispatch() == EOK );
+
+        CHECK( pTemplate->renders == 2 );
+        CHECK( FileEquals( out,
+                           "{\"/test/a\":1,\"/test/b\":\"hello\","
+                           "\"/test/c\":-5}\n"
+                           "{\"/test/a\":5,\"/test/b\":\"hello\","
+                           "\"/test/c\":-5}\n" ) );
+    }
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestPrintMetrics                                                          */
+/*!
+    Check that render metrics are printed on a PRINT notification
+
+==============================================================================*/
+static void TestPrintMetrics( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out[TEST_PATH_LEN];
+    char buf[TEST_BUF_SIZE];
+    VAR_HANDLE hMetric;
+    int fds[2];
+    ssize_t n;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out, "metrics.out" );
+    WriteFile( tmpl, "a=${/test/a}\n" );
+
+    state.pMetricsPrefix = "/test/metrics";
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"m\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out ) == EOK );
+
+    hMetric = VAR_FindByName( state.hVarServer, "/test/metrics/m/render" );
+    CHECK( hMetric != VAR_INVALID );
+
+    CHECK( MOCK_InjectModified( hA ) == EOK );
+    CHECK( Dispatch() == EOK );
+
+    CHECK( pipe( fds ) == 0 );
+    CHECK( MOCK_InjectPrint( hMetric, fds[1] ) == EOK );
+    CHECK( Dispatch() == EOK );
+    close( fds[1] );
+
+    n = read( fds[0], buf, sizeof( buf ) - 1 );
+    close( fds[0] );
+    CHECK( n > 0 );
+    if ( n > 0 )
+    {
+        buf[n] = '\0';
+        CHECK( strncmp( buf, "{\"count\":1,", 11 ) == 0 );
+    }
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestCompression                                                           */
+/*!
+    Check the compressed output
+
+    Each render of a compressed template must be written as one frame
+    which decodes on its own to the rendered output, also when the render
+    is larger than the render buffer, and the compression must be
+    published with the template's metrics.  Only the compression
+    algorithms which are built in are checked.
+
+==============================================================================*/
+static void TestCompression( void )
+{
+    const char *algorithms[] =
+    {
+#ifdef HAVE_ZSTD
+        "zstd",
+#endif
+#ifdef HAVE_LZ4
+        "lz4",
+#endif
+        NULL
+    };
+    char tmpl[TEST_PATH_LEN];
+    char big[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    char buf[TEST_BUF_SIZE];
+    const char *small[] = { "a=1 b=one\n", "a=1 b=two\n" };
+    const char *large[2];
+    char *pFill;
+    char *pLarge;
+    char *pData;
+    VAR_HANDLE hMetric;
+    int fds[2];
+    ssize_t n;
+    size_t i;
+
+    pFill = malloc( TEST_STREAM_SIZE + 1 );
+    pLarge = malloc( 2 * ( TEST_STREAM_SIZE + 8 ) );
+    pData = malloc( 2 * TEST_STREAM_SIZE );
+    CHECK( ( pFill != NULL ) && ( pLarge != NULL ) && ( pData != NULL ) );
+
+    TestPath( tmpl, "compress.tmpl" );
+    TestPath( big, "compress.big" );
+    TestPath( out1, "compress.small" );
+    TestPath( out2, "compress.large" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+
+    if ( ( pFill != NULL ) && ( pLarge != NULL ) && ( pData != NULL ) )
+    {
+        memset( pFill, 'x', TEST_STREAM_SIZE );
+        pFill[TEST_STREAM_SIZE] = '\0';
+        WriteFile( big, "%s${/test/b}\n", pFill );
+        large[0] = pLarge;
+        large[1] = pLarge + sprintf( pLarge, "%sone\n", pFill ) + 1;
+        sprintf( pLarge + strlen( pLarge ) + 1, "%stwo\n", pFill );
+    }
+    else
+    {
+        algorithms[0] = NULL;
+    }
+
+    for ( i = 0 ; algorithms[i] != NULL ; i++ )
+    {
+        unlink( out1 );
+        unlink( out2 );
+        state.pMetricsPrefix = "/test/metrics";
+        CHECK( Setup( "{\"config\":["
+                      "{\"name\":\"small\",\"trigger\":[\"/test/a\"],"
+                      "\"template\":\"%s\",\"type\":\"fd\","
+                      "\"target\":\"%s\",\"append\":true,"
+                      "\"compress\":\"%s\"},"
+                      "{\"name\":\"large\",\"trigger\":[\"/test/a\"],"
+                      "\"template\":\"%s\",\"type\":\"fd\","
+                      "\"target\":\"%s\",\"append\":true,"
+                      "\"compress\":\"%s\"}]}",
+                      tmpl, out1, algorithms[i],
+                      big, out2, algorithms[i] ) == EOK );
+
+        SetStr( hB, "one" );
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        CHECK( Dispatch() == EOK );
+        SetStr( hB, "two" );
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        CHECK( Dispatch() == EOK );
+
+        /* each render decodes on its own */
+        n = ReadFile( out1, pData, 2 * TEST_STREAM_SIZE );
+        CHECK( DecodeFrames( algorithms[i],
+                             pData,
+                             ( n > 0 ) ? (size_t)n : 0,
+                             small,
+                             2 ) == 2 );
+
+        n = ReadFile( out2, pData, 2 * TEST_STREAM_SIZE );
+        CHECK( ( n > 0 ) && ( n < TEST_STREAM_SIZE ) );
+        CHECK( DecodeFrames( algorithms[i],
+                             pData,
+                             ( n > 0 ) ? (size_t)n : 0,
+                             large,
+                             2 ) == 2 );
+
+        /* the compression is published with the render metrics */
+        hMetric = VAR_FindByName( state.hVarServer,
+                                  "/test/metrics/large/ratio" );
+        CHECK( hMetric != VAR_INVALID );
+        CHECK( pipe( fds ) == 0 );
+        CHECK( MOCK_InjectPrint( hMetric, fds[1] ) == EOK );
+        CHECK( Dispatch() == EOK );
+        close( fds[1] );
+
+        n = read( fds[0], buf, sizeof( buf ) - 1 );
+        close( fds[0] );
+        CHECK( n > 0 );
+        if ( n > 0 )
+        {
+            buf[n] = '\0';
+            snprintf( pData,
+                      TEST_BUF_SIZE,
+                      "{\"in\":%zu,",
+                      strlen( large[0] ) + strlen( large[1] ) );
+            CHECK( strncmp( buf, pData, strlen( pData ) ) == 0 );
+        }
+
+        hMetric = VAR_FindByName( state.hVarServer,
+                                  "/test/metrics/small/compress" );
+        CHECK( hMetric != VAR_INVALID );
+        CHECK( VAR_FindByName( state.hVarServer,
+                               "/test/metrics/large/compress" )
+               != VAR_INVALID );
+
+        Teardown();
+    }
+
+    free( pFill );
+    free( pLarge );
+    free( pData );
+}
+
+/*============================================================================*/
+/*  TestCapture                                                               */
+/*!
+    Check that received triggers and fetched values are captured
+
+    The capture must hold the name table of the template variables, and
+    for the render cycle, one MODIFIED record per received notification
+    in order of receipt, followed by the values fetched to render them.
+
+==============================================================================*/
+static void TestCapture( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out[TEST_PATH_LEN];
+    char cap[TEST_PATH_LEN];
+    CaptureRecord record;
+    Capture *pCapture;
+    int cycles = 0;
+    int modified = 0;
+    int values = 0;
+    bool namedA = false;
+    bool namedB = false;
+    uint64_t last = 0;
+    int rc;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out, "capture.out" );
+    TestPath( cap, "test.cap" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+
+    state.pCaptureFile = cap;
+    state.captureFlags = CAPTURE_VALUES;
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"t\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out ) == EOK );
+    CHECK( state.pCapture != NULL );
+
+    SetUint( hA, 7 );
+    CHECK( MOCK_InjectModified( hA ) == EOK );
+    CHECK( MOCK_InjectModified( hA ) == EOK );
+    CHECK( Dispatch() == EOK );
+    CHECK( FileEquals( out, "a=7 b=hello\n" ) );
+
+    /* closing the service flushes the capture */
+    Teardown();
+
+    pCapture = CAPTURE_Open( cap );
+    CHECK( pCapture != NULL );
+    if ( pCapture != NULL )
+    {
+        CHECK( CAPTURE_GetFlags( pCapture ) == CAPTURE_VALUES );
+
+        while ( ( rc = CAPTURE_Read( pCapture, &record ) ) == EOK )
+        {
+            switch( record.type )
+            {
+                case CAPTURE_REC_VAR:
+                    if ( strcmp( record.name, "/test/a" ) == 0 )
+                    {
+                        namedA = ( record.hVar == hA ) &&
+                                 ( record.value.type == VARTYPE_UINT32 );
+                    }
+                    else if ( strcmp( record.name, "/test/b" ) == 0 )
+                    {
+                        namedB = ( record.hVar == hB );
+                    }
+                    break;
+
+                case CAPTURE_REC_CYCLE:
+                    cycles++;
+                    CHECK( modified == 0 );
+                    break;
+
+                case CAPTURE_REC_MODIFIED:
+                    modified++;
+                    CHECK( record.hVar == hA );
+                    CHECK( record.timestamp >= last );
+                    last = record.timestamp;
+                    break;
+
+                case CAPTURE_REC_VALUE:
+                    values++;
+                    if ( record.hVar == hA )
+                    {
+                        CHECK( record.value.type == VARTYPE_UINT32 );
+                        CHECK( record.value.val.ul == 7 );
+                    }
+                    else
+                    {
+                        CHECK( record.hVar == hB );
+                        CHECK( record.value.type == VARTYPE_STR );
+                        CHECK( strcmp( record.value.val.str, "hello" ) == 0 );
+                    }
+                    break;
+
+                default:
+                    CHECK( false );
+                    break;
+            }
+        }
+
+        CHECK( rc == ENOENT );
+        CHECK( namedA == true );
+        CHECK( namedB == true );
+        CHECK( cycles == 1 );
+        CHECK( modified == 2 );
+        CHECK( values == 2 );
+
+        CAPTURE_Close( pCapture );
+    }
+}
+
+/*============================================================================*/
+/*  TestLogger                                                                */
+/*!
+    Check that render logging is leveled and rate limited
+
+    Renders are only traced at the debug level, and repeated output
+    failures are rate limited, with every failure either logged or
+    counted as suppressed.
+
+==============================================================================*/
+static void TestLogger( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char buf[4096];
+    LoggerStats before;
+    LoggerStats after;
+    int fds[2];
+    ssize_t n;
+    char *p;
+    int lines = 0;
+    int i;
+
+    TestPath( tmpl, "test.tmpl" );
+    WriteFile( tmpl, "a=${/test/a}\n" );
+
+    CHECK( pipe( fds ) == 0 );
+    CHECK( LOGGER_Open( LOGGER_INFO, fds[1] ) == EOK );
+    LOGGER_GetStats( &before );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"t\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\","
+                  "\"target\":\"%s/missing/out\"}]}",
+                  tmpl, testDir ) == EOK );
+
+    for ( i = 0 ; i < 10 ; i++ )
+    {
+        SetUint( hA, i );
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        Dispatch();
+    }
+
+    CHECK( LOGGER_Enabled( LOGGER_INFO ) == true );
+    CHECK( LOGGER_Enabled( LOGGER_DEBUG ) == false );
+
+    /* closing the logger writes out the queued records */
+    LOGGER_Close();
+    LOGGER_SetLevel( LOGGER_WARNING );
+    LOGGER_GetStats( &after );
+    Teardown();
+
+    close( fds[1] );
+    n = read( fds[0], buf, sizeof( buf ) - 1 );
+    close( fds[0] );
+    buf[( n > 0 ) ? n : 0] = 0;
+
+    for ( p = strstr( buf, "Cannot output" ) ;
+          p != NULL ;
+          p = strstr( p + 1, "Cannot output" ) )
+    {
+        lines++;
+    }
+
+    CHECK( strstr( buf, "Printing template" ) == NULL );
+    CHECK( lines > 0 );
+    CHECK( after.suppressed > before.suppressed );
+    CHECK( lines + ( after.suppressed - before.suppressed ) == 10 );
+    CHECK( after.dropped == before.dropped );
+}
+
+/*============================================================================*/
+/*  TestEventLoop                                                             */
+/*!
+    Check the service running on the event loop
+
+    Timers expire, injected triggers render, a rewritten template is
+    picked up through its file watch, and output which a slow reader
+    cannot accept is queued and flushed as the reader drains it.
+
+==============================================================================*/
+static void TestEventLoop( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char big[TEST_PATH_LEN];
+    char out[TEST_PATH_LEN];
+    char fifo[TEST_PATH_LEN];
+    char buf[TEST_BUF_SIZE];
+    char *pFill;
+    EventLoop *pLoop;
+    EventTimer *pTimer;
+    Template *pTemplate;
+    uint64_t expired = 0;
+    size_t total = 0;
+    ssize_t n;
+    int reader;
+    int i;
+
+    TestPath( tmpl, "loop.tmpl" );
+    TestPath( big, "big.tmpl" );
+    TestPath( out, "loop.out" );
+    TestPath( fifo, "loop.fifo" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+
+    pFill = malloc( TEST_PIPE_FILL + 1 );
+    CHECK( pFill != NULL );
+    if ( pFill == NULL )
+    {
+        return;
+    }
+
+    memset( pFill, 'x', TEST_PIPE_FILL );
+    pFill[TEST_PIPE_FILL] = 0;
+    WriteFile( big, "%s${/test/b}\n", pFill );
+    free( pFill );
+
+    /* open the reader first so the target can be opened non-blocking */
+    CHECK( mkfifo( fifo, 0644 ) == 0 );
+    reader = open( fifo, O_RDONLY | O_NONBLOCK );
+    CHECK( reader != -1 );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"file\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"fifo\",\"trigger\":[\"/test/b\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out, big, fifo ) == EOK );
+
+    pLoop = EVENTLOOP_Create();
+    CHECK( pLoop != NULL );
+    CHECK( TEMPLATESVC_Attach( &state, pLoop ) == EOK );
+
+    /* a one-shot timer expires once */
+    pTimer = EVENTLOOP_CreateTimer( pLoop, TimerExpired, &expired );
+    CHECK( pTimer != NULL );
+    CHECK( EVENTLOOP_SetTimer( pTimer, 1000000, 0 ) == EOK );
+    CHECK( EVENTLOOP_RunOnce( pLoop, 1000 ) == EOK );
+    CHECK( expired == 1 );
+    CHECK( EVENTLOOP_RunOnce( pLoop, 10 ) == ETIMEDOUT );
+    EVENTLOOP_DeleteTimer( pLoop, pTimer );
+
+    /* a trigger renders from the loop */
+    CHECK( MOCK_InjectModified( hA ) == EOK );
+    CHECK( EVENTLOOP_RunOnce( pLoop, 1000 ) == EOK );
+    CHECK( FileEquals( out, "a=1 b=hello\n" ) );
+
+    /* the rewritten template is recompiled before the next render */
+    pTemplate = FindTemplate( "file" );
+    CHECK( ( pTemplate != NULL ) && ( pTemplate->watched == true ) );
+    WriteFile( tmpl, "A=${/test/a}\n" );
+    CHECK( EVENTLOOP_RunOnce( pLoop, 1000 ) == EOK );
+    CHECK( ( pTemplate != NULL ) && ( pTemplate->stale == true ) );
+    CHECK( MOCK_InjectModified( hA ) == EOK );
+    CHECK( EVENTLOOP_RunOnce( pLoop, 1000 ) == EOK );
+    CHECK( FileEquals( out, "A=1\n" ) );
+
+    /* output the reader cannot accept yet is queued, not blocked on */
+    pTemplate = FindTemplate( "fifo" );
+    CHECK( pTemplate != NULL );
+    CHECK( MOCK_InjectModified( hB ) == EOK );
+    CHECK( EVENTLOOP_RunOnce( pLoop, 1000 ) == EOK );
+    CHECK( ( pTemplate != NULL ) && ( pTemplate->pendingLen > 0 ) );
+
+    for ( i = 0 ; ( i < 100 ) && ( pTemplate != NULL ) ; i++ )
+    {
+        while ( ( n = read( reader, buf, sizeof( buf ) ) ) > 0 )
+        {
+            total += (size_t)n;
+        }
+
+        if ( ( pTemplate->pendingLen == 0 ) && ( pTemplate->fd == -1 ) )
+        {
+            break;
+        }
+
+        EVENTLOOP_RunOnce( pLoop, 100 );
+    }
+
+    CHECK( total == TEST_PIPE_FILL + strlen( "hello\n" ) );
+    CHECK( ( pTemplate != NULL ) && ( pTemplate->fd == -1 ) );
+
+    Teardown();
+    EVENTLOOP_Destroy( pLoop );
+    close( reader );
+}
+
+/*============================================================================*/
+/*  TestPeriodic                                                              */
+/*!
+    Check the periodic renders
+
+    Templates with the same interval render in the same batch, and a
+    periodic render is skipped when the template was triggered within
+    the interval.
+
+==============================================================================*/
+static void TestPeriodic( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out[TEST_PATH_LEN];
+    EventLoop *pLoop;
+    Template *pBeat;
+    Template *pBoth;
+    Template *pSlow;
+    int i;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out, "periodic.out" );
+    WriteFile( tmpl, "a=${/test/a}\n" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"beat\",\"interval_ms\":100,"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"both\",\"interval_ms\":100,"
+                  "\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"slow\",\"interval_ms\":150,"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out, tmpl, out, tmpl, out ) == EOK );
+
+    pBeat = FindTemplate( "beat" );
+    pBoth = FindTemplate( "both" );
+    pSlow = FindTemplate( "slow" );
+    CHECK( ( pBeat != NULL ) && ( pBoth != NULL ) && ( pSlow != NULL ) );
+
+    pLoop = EVENTLOOP_Create();
+    CHECK( pLoop != NULL );
+
+    if ( ( pBeat != NULL ) && ( pBoth != NULL ) && ( pSlow != NULL ) &&
+         ( TEMPLATESVC_Attach( &state, pLoop ) == EOK ) )
+    {
+        /* one timer ticks at the common divisor of the intervals */
+        CHECK( state.pTicker != NULL );
+        CHECK( state.tickNs == 50000000 );
+
+        /* templates with the same interval render together */
+        for ( i = 0 ; ( i < 10 ) && ( pBeat->renders == 0 ) ; i++ )
+        {
+            EVENTLOOP_RunOnce( pLoop, 1000 );
+        }
+
+        CHECK( pBeat->renders == 1 );
+        CHECK( pBoth->renders == 1 );
+        CHECK( pSlow->renders == 0 );
+
+        /* a triggered render defers the next periodic render */
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        CHECK( EVENTLOOP_RunOnce( pLoop, 1000 ) == EOK );
+        CHECK( pBoth->renders == 2 );
+
+        for ( i = 0 ; ( i < 10 ) && ( pBeat->renders == 1 ) ; i++ )
+        {
+            EVENTLOOP_RunOnce( pLoop, 1000 );
+        }
+
+        CHECK( pBeat->renders == 2 );
+        CHECK( pBoth->renders == 2 );
+        CHECK( pSlow->renders == 1 );
+
+        /* without a trigger, the periodic renders resume */
+        for ( i = 0 ; ( i < 10 ) && ( pBeat->renders == 2 ) ; i++ )
+        {
+            EVENTLOOP_RunOnce( pLoop, 1000 );
+        }
+
+        CHECK( pBoth->renders == 3 );
+    }
+
+    Teardown();
+    CHECK( state.pTicker == NULL );
+    EVENTLOOP_Destroy( pLoop );
+}
+
+/*============================================================================*/
+/*  TestTriggerConditions                                                     */
+/*!
+    Check that trigger conditions filter out insignificant changes
+
+    Each condition is evaluated against the last value, filtered
+    notifications are counted, and the value fetched to evaluate the
+    conditions is reused by the render.
+
+==============================================================================*/
+static void TestTriggerConditions( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out[TEST_PATH_LEN];
+    Template *pChange;
+    Template *pDeadband;
+    Template *pRising;
+    Template *pText;
+    MockStats stats;
+    VarObject obj;
+    VAR_HANDLE hWide;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out, "conditions.out" );
+    WriteFile( tmpl, "a=${/test/a}\n" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"change\","
+                  "\"trigger\":[{\"var\":\"/test/a\",\"on\":\"change\"}],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"deadband\","
+                  "\"trigger\":[{\"var\":\"/test/a\",\"deadband\":5}],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"rising\","
+                  "\"trigger\":[{\"var\":\"/test/a\",\"rising_above\":10}],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"text\","
+                  "\"trigger\":[{\"var\":\"/test/b\",\"on\":\"change\"}],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out, tmpl, out, tmpl, out, tmpl, out ) == EOK );
+
+    pChange = FindTemplate( "change" );
+    pDeadband = FindTemplate( "deadband" );
+    pRising = FindTemplate( "rising" );
+    pText = FindTemplate( "text" );
+
+    if ( ( pChange != NULL ) && ( pDeadband != NULL ) &&
+         ( pRising != NULL ) && ( pText != NULL ) )
+    {
+        /* rewriting the same value renders nothing */
+        MOCK_ResetStats();
+        Trigger( hA );
+        CHECK( pChange->renders == 0 );
+        CHECK( pChange->filtered == 1 );
+        CHECK( pDeadband->filtered == 1 );
+        CHECK( pRising->filtered == 1 );
+
+        /* the value is fetched once for all the conditions */
+        MOCK_GetStats( &stats );
+        CHECK( stats.gets == 1 );
+
+        SetUint( hA, 3 );
+        MOCK_ResetStats();
+        Trigger( hA );
+        CHECK( pChange->renders == 1 );
+        CHECK( pDeadband->renders == 0 );
+        CHECK( pRising->renders == 0 );
+
+        /* the render reuses the value fetched for the conditions */
+        MOCK_GetStats( &stats );
+        CHECK( stats.gets == 1 );
+
+        /* the deadband is measured from the last rendered value */
+        SetUint( hA, 7 );
+        Trigger( hA );
+        CHECK( pChange->renders == 2 );
+        CHECK( pDeadband->renders == 1 );
+
+        SetUint( hA, 11 );
+        Trigger( hA );
+        CHECK( pDeadband->renders == 1 );
+        CHECK( pRising->renders == 1 );
+
+        SetUint( hA, 12 );
+        Trigger( hA );
+        CHECK( pDeadband->renders == 2 );
+        CHECK( pRising->renders == 1 );
+
+        /* a threshold renders each time it is crossed */
+        SetUint( hA, 5 );
+        Trigger( hA );
+        SetUint( hA, 12 );
+        Trigger( hA );
+        CHECK( pRising->renders == 2 );
+        CHECK( pChange->renders == 6 );
+
+        /* non-numeric values are checked for changes */
+        Trigger( hB );
+        CHECK( pText->renders == 0 );
+        SetStr( hB, "x" );
+        Trigger( hB );
+        CHECK( pText->renders == 1 );
+        CHECK( pText->filtered == 1 );
+    }
+    else
+    {
+        CHECK( false );
+    }
+
+    Teardown();
+
+    /* 64-bit values above 2^53 are compared exactly */
+    obj.type = VARTYPE_UINT64;
+    obj.len = sizeof( uint64_t );
+    obj.val.ull = ( 1ULL << 53 );
+    hWide = MOCK_AddVar( "/test/wide", &obj );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"change\","
+                  "\"trigger\":[{\"var\":\"/test/wide\",\"on\":\"change\"}],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out ) == EOK );
+
+    pChange = FindTemplate( "change" );
+    CHECK( pChange != NULL );
+    if ( pChange != NULL )
+    {
+        Trigger( hWide );
+        CHECK( pChange->renders == 0 );
+
+        obj.val.ull = ( 1ULL << 53 ) + 1;
+        CHECK( MOCK_SetVar( hWide, &obj ) == EOK );
+        Trigger( hWide );
+        CHECK( pChange->renders == 1 );
+
+        Trigger( hWide );
+        CHECK( pChange->renders == 1 );
+    }
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestCommit                                                                */
+/*!
+    Check the transactional commit trigger
+
+    Triggers only mark a transactional template, which is rendered once
+    when the commit variable is notified, and only if it was marked.
+
+==============================================================================*/
+static void TestCommit( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out[TEST_PATH_LEN];
+    Template *pTemplate;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out, "commit.out" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"txn\",\"trigger\":[\"/test/a\",\"/test/b\"],"
+                  "\"commit\":\"/test/c\","
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out ) == EOK );
+
+    CHECK( MOCK_IsWatched( hC ) == true );
+
+    pTemplate = FindTemplate( "txn" );
+    CHECK( pTemplate != NULL );
+    if ( pTemplate != NULL )
+    {
+        /* the updates are held until the commit */
+        SetUint( hA, 2 );
+        Trigger( hA );
+        SetStr( hB, "two" );
+        Trigger( hB );
+        CHECK( pTemplate->renders == 0 );
+        CHECK( pTemplate->pending == true );
+
+        Trigger( hC );
+        CHECK( pTemplate->renders == 1 );
+        CHECK( pTemplate->pending == false );
+        CHECK( FileEquals( out, "a=2 b=two\n" ) );
+
+        /* a commit without updates renders nothing */
+        Trigger( hC );
+        CHECK( pTemplate->renders == 1 );
+
+        /* a queued transaction renders once */
+        SetUint( hA, 3 );
+        SetStr( hB, "three" );
+        CHECK( MOCK_InjectModified( hA ) == EOK );
+        CHECK( MOCK_InjectModified( hB ) == EOK );
+        CHECK( MOCK_InjectModified( hC ) == EOK );
+        CHECK( Dispatch() == EOK );
+        CHECK( pTemplate->renders == 2 );
+        CHECK( FileEquals( out, "a=3 b=three\n" ) );
+    }
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestReload                                                                */
+/*!
+    Check the incremental configuration reload
+
+    Unchanged templates are kept with their open targets, removed
+    templates are torn down, and notifications are only requested for
+    new trigger variables and cancelled for unreferenced ones.
+
+==============================================================================*/
+static void TestReload( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    char out3[TEST_PATH_LEN];
+    char config[TEST_PATH_LEN];
+    Template *pKeep;
+    MockStats stats;
+    int fd;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out1, "keep.out" );
+    TestPath( out2, "drop.out" );
+    TestPath( out3, "add.out" );
+    TestPath( config, "config.json" );
+    WriteFile( tmpl, "a=${/test/a}\n" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"keep\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\","
+                  "\"keep_open\":true},"
+                  "{\"name\":\"drop\",\"trigger\":[\"/test/b\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out1, tmpl, out2 ) == EOK );
+    state.pFileName = config;
+
+    Trigger( hA );
+    pKeep = FindTemplate( "keep" );
+    CHECK( ( pKeep != NULL ) && ( pKeep->fd != -1 ) );
+    fd = ( pKeep != NULL ) ? pKeep->fd : -1;
+
+    /* replace one template and keep the other */
+    WriteFile( config,
+               "{\"config\":["
+               "{\"name\":\"keep\",\"trigger\":[\"/test/a\"],"
+               "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\","
+               "\"keep_open\":true},"
+               "{\"name\":\"add\",\"trigger\":[\"/test/c\"],"
+               "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+               tmpl, out1, tmpl, out3 );
+
+    MOCK_ResetStats();
+    CHECK( TEMPLATESVC_Reload( &state ) == EOK );
+    MOCK_GetStats( &stats );
+
+    CHECK( FindTemplate( "keep" ) == pKeep );
+    CHECK( ( pKeep != NULL ) && ( pKeep->fd == fd ) );
+    CHECK( FindTemplate( "drop" ) == NULL );
+    CHECK( FindTemplate( "add" ) != NULL );
+
+    /* one new notification, and one cancelled */
+    CHECK( MOCK_IsWatched( hA ) == true );
+    CHECK( MOCK_IsWatched( hB ) == false );
+    CHECK( MOCK_IsWatched( hC ) == true );
+    CHECK( stats.notifies == 2 );
+
+    Trigger( hC );
+    CHECK( FileEquals( out3, "a=1\n" ) );
+
+    /* an unreadable configuration keeps the running templates */
+    unlink( config );
+    CHECK( TEMPLATESVC_Reload( &state ) == ENOENT );
+    CHECK( FindTemplate( "keep" ) == pKeep );
+
+    state.pFileName = NULL;
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestConfCache                                                             */
+/*!
+    Check the compiled configuration cache
+
+    The cache is written when the configuration is parsed, and the same
+    templates are set up from it on the next load.  A modified
+    configuration, or a damaged cache, is parsed again.
+
+==============================================================================*/
+static void TestConfCache( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    char config[TEST_PATH_LEN];
+    char cache[TEST_PATH_LEN];
+    char parsed[TEST_BUF_SIZE];
+    char cached[TEST_BUF_SIZE];
+    struct stat st;
+    Template *pTemplate;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out1, "text.out" );
+    TestPath( out2, "jsonl.out" );
+    TestPath( config, "config.json" );
+    TestPath( cache, "config.cache" );
+    WriteFile( tmpl, "a=${/test/a}\n" );
+    unlink( cache );
+
+    /* parse the configuration and build the cache */
+    state.pCacheFile = cache;
+    CHECK( Setup( "{\"tenant\":{\"name\":\"net\",\"priority\":3,"
+                  "\"max_renders_per_sec\":100},"
+                  "\"config\":["
+                  "{\"name\":\"text\",\"trigger\":[\"/test/a\","
+                  "{\"var\":\"/test/c\",\"deadband\":2.5}],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\","
+                  "\"interval_ms\":500},"
+                  "{\"name\":\"jsonl\",\"trigger\":[\"/test/a\"],"
+                  "\"format\":\"jsonl\",\"vars\":[\"/test/a\",\"/test/b\"],"
+                  "\"type\":\"fd\",\"target\":\"%s\",\"append\":true}]}",
+                  tmpl, out1, out2 ) == EOK );
+    CHECK( state.pConfCache == NULL );
+    CHECK( stat( cache, &st ) == 0 );
+    Signatures( parsed, sizeof( parsed ) );
+    Teardown();
+
+    /* load the same templates from the cache */
+    state.pCacheFile = cache;
+    CHECK( Setup( NULL ) == EOK );
+    CHECK( state.pConfCache != NULL );
+    CHECK( Signatures( cached, sizeof( cached ) ) > 0 );
+    CHECK( strcmp( parsed, cached ) == 0 );
+
+    pTemplate = FindTemplate( "text" );
+    CHECK( ( pTemplate != NULL ) &&
+           ( pTemplate->pTenant != NULL ) &&
+           ( strcmp( pTemplate->pTenant->name, "net" ) == 0 ) &&
+           ( pTemplate->pTenant->priority == 3 ) &&
+           ( pTemplate->pTenant->maxRendersPerSec == 100 ) );
+    CHECK( ( pTemplate != NULL ) &&
+           ( pTemplate->intervalMs == 500 ) &&
+           ( pTemplate->numTriggers == 2 ) &&
+           ( pTemplate->pTriggers[1].condition == TRIGGER_DEADBAND ) &&
+           ( pTemplate->pTriggers[1].level == 2.5 ) &&
+           ( pTemplate->pTriggers[1].hVar == hC ) );
+
+    Trigger( hA );
+    CHECK( FileEquals( out1, "a=1\n" ) );
+    CHECK( FileEquals( out2, "{\"/test/a\":1,\"/test/b\":\"hello\"}\n" ) );
+    Teardown();
+
+    /* a modified configuration is parsed, and the cache rebuilt */
+    WriteFile( config,
+               "{\"config\":["
+               "{\"name\":\"text\",\"trigger\":[\"/test/b\"],"
+               "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+               tmpl, out1 );
+    state.pCacheFile = cache;
+    CHECK( Setup( NULL ) == EOK );
+    CHECK( state.pConfCache == NULL );
+    CHECK( FindTemplate( "jsonl" ) == NULL );
+    Teardown();
+
+    state.pCacheFile = cache;
+    CHECK( Setup( NULL ) == EOK );
+    CHECK( state.pConfCache != NULL );
+    pTemplate = FindTemplate( "text" );
+    CHECK( ( pTemplate != NULL ) && ( pTemplate->pTriggers->hVar == hB ) );
+    Teardown();
+
+    /* a damaged cache is ignored */
+    CHECK( truncate( cache, sizeof( uint64_t ) * 4 ) == 0 );
+    state.pCacheFile = cache;
+    CHECK( Setup( NULL ) == EOK );
+    CHECK( state.pConfCache == NULL );
+    CHECK( FindTemplate( "text" ) != NULL );
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestConfigDir                                                             */
+/*!
+    Check loading a directory of configuration files
+
+    Every *.json file of the directory is loaded into the one template
+    list.  A file which cannot be parsed does not stop the others from
+    loading, but stops a reload so the running templates are kept.
+
+==============================================================================*/
+static void TestConfigDir( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    char dir[TEST_PATH_LEN];
+    char file1[TEST_PATH_LEN];
+    char file2[TEST_PATH_LEN];
+    char bad[TEST_PATH_LEN];
+    Template *pKeep;
+
+    TestPath( tmpl, "test.tmpl" );
+    TestPath( out1, "dir1.out" );
+    TestPath( out2, "dir2.out" );
+    TestPath( dir, "conf.d" );
+    TestPath( file1, "conf.d/10-one.json" );
+    TestPath( file2, "conf.d/20-two.json" );
+    TestPath( bad, "conf.d/30-bad.json" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b}\n" );
+    CHECK( mkdir( dir, 0700 ) == 0 );
+
+    WriteFile( file1,
+               "{\"config\":["
+               "{\"name\":\"one\",\"trigger\":[\"/test/a\"],"
+               "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"}]}",
+               tmpl, out1 );
+    WriteFile( file2,
+               "{\"config\":["
+               "{\"name\":\"two\",\"trigger\":[\"/test/c\"],"
+               "\"format\":\"jsonl\",\"vars\":[\"/test/a\"],"
+               "\"type\":\"fd\",\"target\":\"%s\"}]}",
+               out2 );
+    WriteFile( bad, "{\"config\":[{\"name\":" );
+    TestPath( file2, "conf.d/two.json.orig" );
+    WriteFile( file2, "{\"config\":[{\"name\":\"ignored\"}]}" );
+    TestPath( file2, "conf.d/.hidden.json" );
+    WriteFile( file2, "{\"config\":[{\"name\":\"hidden\"}]}" );
+    TestPath( file2, "conf.d/20-two.json" );
+
+    /* the bad file is skipped, and the others are loaded */
+    CHECK( Setup( "{\"config\":[]}" ) == EOK );
+    state.pConfigDir = dir;
+    CHECK( TEMPLATESVC_LoadConfig( &state ) != EOK );
+
+    pKeep = FindTemplate( "one" );
+    CHECK( ( pKeep != NULL ) && ( pKeep->pCompiled != NULL ) );
+    CHECK( FindTemplate( "two" ) != NULL );
+    CHECK( FindTemplate( "ignored" ) == NULL );
+    CHECK( FindTemplate( "hidden" ) == NULL );
+    CHECK( MOCK_IsWatched( hA ) == true );
+    CHECK( MOCK_IsWatched( hC ) == true );
+
+    Trigger( hA );
+    CHECK( FileEquals( out1, "a=1 b=hello\n" ) );
+    Trigger( hC );
+    CHECK( FileEquals( out2, "{\"/test/a\":1}\n" ) );
+
+    /* a reload with a bad file keeps the running templates */
+    unlink( file2 );
+    CHECK( TEMPLATESVC_Reload( &state ) == ENOENT );
+    CHECK( FindTemplate( "two" ) != NULL );
+
+    /* a reload applies the removal of a file */
+    unlink( bad );
+    CHECK( TEMPLATESVC_Reload( &state ) == EOK );
+    CHECK( FindTemplate( "one" ) == pKeep );
+    CHECK( FindTemplate( "two" ) == NULL );
+    CHECK( MOCK_IsWatched( hC ) == false );
+
+    state.pConfigDir = NULL;
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestTenants                                                               */
+/*!
+    Check the rule sets hosted as tenants
+
+    Each file of the configuration directory is the rule set of a tenant,
+    whose template limit is enforced, whose templates render in priority
+    order, and whose renders are deferred once its rate limit is reached.
+
+==============================================================================*/
+static void TestTenants( void )
+{
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    char dir[TEST_PATH_LEN];
+    char file[TEST_PATH_LEN];
+    Template *pLow;
+    Template *pHigh;
+    Tenant *pTenant;
+
+    TestPath( out1, "low.out" );
+    TestPath( out2, "high.out" );
+    TestPath( dir, "tenants.d" );
+    CHECK( mkdir( dir, 0700 ) == 0 );
+
+    TestPath( file, "tenants.d/10-low.json" );
+    WriteFile( file,
+               "{\"tenant\":{\"name\":\"low\",\"priority\":1,"
+               "\"max_templates\":1,\"max_renders_per_sec\":2},"
+               "\"config\":["
+               "{\"name\":\"low1\",\"trigger\":[\"/test/a\"],"
+               "\"format\":\"jsonl\",\"vars\":[\"/test/a\"],"
+               "\"type\":\"fd\",\"target\":\"%s\",\"append\":true},"
+               "{\"name\":\"low2\",\"trigger\":[\"/test/a\"],"
+               "\"format\":\"jsonl\",\"vars\":[\"/test/a\"],"
+               "\"type\":\"fd\",\"target\":\"%s\"}]}",
+               out1, out1 );
+
+    TestPath( file, "tenants.d/20-high.json" );
+    WriteFile( file,
+               "{\"tenant\":{\"priority\":5},"
+               "\"config\":["
+               "{\"name\":\"high\",\"trigger\":[\"/test/a\"],"
+               "\"format\":\"jsonl\",\"vars\":[\"/test/a\"],"
+               "\"type\":\"fd\",\"target\":\"%s\",\"append\":true}]}",
+               out2 );
+
+    /* the second template of the low tenant exceeds its limit */
+    CHECK( Setup( "{\"config\":[]}" ) == EOK );
+    state.pConfigDir = dir;
+    CHECK( TEMPLATESVC_LoadConfig( &state ) == ENOSPC );
+
+    pLow = FindTemplate( "low1" );
+    pHigh = FindTemplate( "high" );
+    CHECK( FindTemplate( "low2" ) == NULL );
+    CHECK( ( pLow != NULL ) && ( pLow->pTenant != NULL ) &&
+           ( strcmp( pLow->pTenant->name, "low" ) == 0 ) &&
+           ( pLow->pTenant->templates == 1 ) );
+    CHECK( ( pHigh != NULL ) && ( pHigh->pTenant != NULL ) &&
+           ( strcmp( pHigh->pTenant->name, "20-high" ) == 0 ) );
+
+    /* the higher priority tenant renders first */
+    CHECK( state.pTemplates == pHigh );
+
+    if ( ( pLow != NULL ) && ( pHigh != NULL ) )
+    {
+        pTenant = pLow->pTenant;
+
+        /* the third render within a second is deferred */
+        Trigger( hA );
+        Trigger( hA );
+        Trigger( hA );
+        CHECK( pLow->renders == 2 );
+        CHECK( pLow->deferred == true );
+        CHECK( pLow->throttled == 1 );
+        CHECK( pTenant->throttled == 1 );
+        CHECK( pHigh->renders == 3 );
+        CHECK( pHigh->pTenant->throttled == 0 );
+
+        /* a deferred render is not counted again */
+        Trigger( hA );
+        CHECK( pLow->throttled == 1 );
+        CHECK( pHigh->renders == 4 );
+
+        /* the deferred render completes once the rate allows it */
+        pTenant->tokens = 1.0;
+        CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+        CHECK( pLow->renders == 3 );
+        CHECK( pLow->deferred == false );
+        CHECK( pTenant->renders == 3 );
+        CHECK( FileEquals( out1, "{\"/test/a\":1}\n"
+                                 "{\"/test/a\":1}\n"
+                                 "{\"/test/a\":1}\n" ) );
+    }
+
+    /* a reload keeps the tenants and their templates */
+    CHECK( TEMPLATESVC_Reload( &state ) == ENOSPC );
+    CHECK( FindTemplate( "low1" ) == pLow );
+    CHECK( FindTemplate( "high" ) == pHigh );
+    CHECK( ( pLow != NULL ) && ( pLow->pTenant->templates == 1 ) );
+    CHECK( state.pTemplates == pHigh );
+
+    state.pConfigDir = NULL;
+    Teardown();
+}
+
+/*============================================================================*/
+/*  Signatures                                                                */
+/*!
+    Concatenate the signatures of the loaded templates
+
+    @param[out]
+        buf
+            buffer to store the signatures
+
+    @param[in]
+        size
+            size of the buffer
+
+    @retval length of the signatures
+
+==============================================================================*/
+static size_t Signatures( char *buf, size_t size )
+{
+    Template *pTemplate;
+    size_t len = 0;
+
+    buf[0] = '\0';
+    for ( pTemplate = state.pTemplates ;
+          pTemplate != NULL ;
+          pTemplate = pTemplate->pNext )
+    {
+        if ( ( pTemplate->pSignature != NULL ) && ( len < size ) )
+        {
+            len += snprintf( &buf[len],
+                             size - len,
+                             "%s|",
+                             pTemplate->pSignature );
+        }
+    }
+
+    return len;
+}
+
+/*============================================================================*/
+/*  DecodeFrames                                                              */
+/*!
+    Decode the compressed frames of an output file one at a time
+
+    Each frame is decoded with a new decompression context, so a frame
+    which depends on the one before it does not decode.
+
+    @param[in]
+        algorithm
+            name of the compression algorithm
+
+    @param[in]
+        pData
+            pointer to the compressed output
+
+    @param[in]
+        len
+            length of the compressed output
+
+    @param[in]
+        ppExpected
+            expected output of each frame
+
+    @param[in]
+        count
+            number of frames expected
+
+    @retval number of frames decoded to their expected output, or 0 if
+            the output holds more frames than expected
+
+==============================================================================*/
+static size_t DecodeFrames( const char *algorithm,
+                            const char *pData,
+                            size_t len,
+                            const char **ppExpected,
+                            size_t count )
+{
+    size_t matched = 0;
+    size_t frames = 0;
+    size_t outSize = 2 * TEST_STREAM_SIZE;
+    char *pOut = malloc( outSize );
+    size_t used = len;
+    size_t n = 0;
+#ifdef HAVE_LZ4
+    LZ4F_dctx *dctx;
+    size_t dstSize;
+    size_t srcSize;
+    size_t rc;
+#endif
+
+    while ( ( pOut != NULL ) && ( len > 0 ) && ( used > 0 ) )
+    {
+        used = 0;
+
+#ifdef HAVE_ZSTD
+        if ( strcmp( algorithm, "zstd" ) == 0 )
+        {
+            used = ZSTD_findFrameCompressedSize( pData, len );
+            n = ZSTD_isError( used ) ? 0 : ZSTD_decompress( pOut,
+                                                            outSize,
+                                                            pData,
+                                                            used );
+            if ( ZSTD_isError( used ) || ZSTD_isError( n ) )
+            {
+                used = 0;
+            }
+        }
+#endif
+
+#ifdef HAVE_LZ4
+        if ( ( strcmp( algorithm, "lz4" ) == 0 ) &&
+             ( !LZ4F_isError( LZ4F_createDecompressionContext(
+                                    &dctx, LZ4F_VERSION ) ) ) )
+        {
+            n = 0;
+            rc = 1;
+            while ( ( rc != 0 ) && ( !LZ4F_isError( rc ) ) && ( used < len ) )
+            {
+                dstSize = outSize - n;
+                srcSize = len - used;
+                rc = LZ4F_decompress( dctx,
+                                      pOut + n,
+                                      &dstSize,
+                                      pData + used,
+                                      &srcSize,
+                                      NULL );
+                n += dstSize;
+                used += srcSize;
+            }
+
+            if ( rc != 0 )
+            {
+                used = 0;
+            }
+
+            LZ4F_freeDecompressionContext( dctx );
+        }
+#endif
+
+        if ( used > 0 )
+        {
+            if ( ( frames < count ) &&
+                 ( n == strlen( ppExpected[frames] ) ) &&
+                 ( memcmp( pOut, ppExpected[frames], n ) == 0 ) )
+            {
+                matched++;
+            }
+
+            frames++;
+            pData += used;
+            len -= used;
+        }
+    }
+
+    free( pOut );
+
+    return ( frames == count ) ? matched : 0;
+}
+
+/*============================================================================*/
+/*  TimerExpired                                                              */
+/*!
+    Count the expirations of a test timer
+
+    @param[in]
+        pLoop
+            pointer to the event loop
+
+    @param[in]
+        pTimer
+            pointer to the expired timer
+
+    @param[in]
+        expirations
+            number of expirations since the last call
+
+    @param[in]
+        arg
+            pointer to the expiration counter
+
+==============================================================================*/
+static void TimerExpired( EventLoop *pLoop,
+                          EventTimer *pTimer,
+                          uint64_t expirations,
+                          void *arg )
+{
+    (void)pLoop;
+    (void)pTimer;
+
+    *(uint64_t *)arg += expirations;
+}
+
+/*============================================================================*/
+/*  Check                                                                     */
+/*!
+    Record the result of a test check
+
+    @param[in]
+        cond
+            result of the check
+
+    @param[in]
+        expr
+            text of the checked expression
+
+    @param[in]
+        file
+            source file of the check
+
+    @param[in]
+        line
+            source line of the check
+
+==============================================================================*/
+static void Check( bool cond, const char *expr, const char *file, int line )
+{
+    checks++;
+
+    if ( cond == false )
+    {
+        failures++;
+        fprintf( stderr, "%s:%d: check failed: %s\n", file, line, expr );
+    }
+}
+
+/*============================================================================*/
+/*  TestPath                                                                  */
+/*!
+    Build the path of a file in the test directory
+
+    @param[out]
+        buf
+            buffer of TEST_PATH_LEN bytes to store the path
+
+    @param[in]
+        name
+            name of the file
+
+    @retval pointer to the path
+
+==============================================================================*/
+static char *TestPath( char *buf, const char *name )
+{
+    int n = snprintf( buf, TEST_PATH_LEN, "%s/%s", testDir, name );
+
+    CHECK( ( n >= 0 ) && ( n < TEST_PATH_LEN ) );
+    return buf;
+}
+
+/*============================================================================*/
+/*  WriteFile                                                                 */
+/*!
+    Write formatted content to a file
+
+    @param[in]
+        path
+            path of the file to write
+
+    @param[in]
+        fmt
+            format specifier of the file content
+
+    @retval EOK - the file was written
+    @retval other - the file could not be written
+
+==============================================================================*/
+static int WriteFile( const char *path, const char *fmt, ... )
+{
+    int result = EOK;
+    va_list args;
+    FILE *fp;
+
+    fp = fopen( path, "w" );
+    if ( fp != NULL )
+    {
+        va_start( args, fmt );
+        vfprintf( fp, fmt, args );
+        va_end( args );
+        fclose( fp );
+    }
+    else
+    {
+        result = errno;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ReadFile                                                                  */
+/*!
+    Read the content of a file into a NUL terminated buffer
+
+    @param[in]
+        path
+            path of the file to read
+
+    @param[out]
+        buf
+            buffer to store the file content
+
+    @param[in]
+        size
+            size of the buffer
+
+    @retval number of bytes read
+    @retval -1 if the file could not be read
+
+==============================================================================*/
+static ssize_t ReadFile( const char *path, char *buf, size_t size )
+{
+    ssize_t n = -1;
+    int fd;
+
+    fd = open( path, O_RDONLY );
+    if ( fd != -1 )
+    {
+        n = read( fd, buf, size - 1 );
+        if ( n >= 0 )
+        {
+            buf[n] = '\0';
+        }
+
+        close( fd );
+    }
+
+    return n;
+}
+
+/*============================================================================*/
+/*  FileEquals                                                                */
+/*!
+    Check that the content of a file matches the expected bytes
+
+    @param[in]
+        path
+            path of the file to check
+
+    @param[in]
+        expected
+            expected file content
+
+    @retval true - the file content matches
+    @retval false - the file content does not match
+
+==============================================================================*/
+static bool FileEquals( const char *path, const char *expected )
+{
+    char buf[TEST_BUF_SIZE];
+    ssize_t n;
+    bool result = false;
+
+    n = ReadFile( path, buf, sizeof( buf ) );
+    if ( n >= 0 )
+    {
+        result = ( ( (size_t)n == strlen( expected ) ) &&
+                   ( memcmp( buf, expected, n ) == 0 ) );
+        if ( result == false )
+        {
+            fprintf( stderr, "%s: expected \"%s\" got \"%s\"\n",
+                     path, expected, buf );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Setup                                                                     */
+/*!
+    Set up the template service for a test
+
+    The Setup function creates the test variables in the mock variable
+    server, writes the formatted template service configuration to the
+    test directory, and opens and loads the template service from it.
+    If a configuration cache file is specified, the configuration is
+    loaded through the cache.  If fmt is NULL, the configuration written
+    by the previous Setup is loaded again.  The test variables are:
+
+        /test/a : uint32 1
+        /test/b : string "hello"
+        /test/c : int16 -5
+
+    @param[in]
+        fmt
+            format specifier of the template service configuration
+
+    @retval EOK - the template service was loaded
+    @retval other - the template service could not be set up
+
+==============================================================================*/
+static int Setup( const char *fmt, ... )
+{
+    int result;
+    char config[TEST_BUF_SIZE];
+    char path[TEST_PATH_LEN];
+    char *pMetricsPrefix = state.pMetricsPrefix;
+    char *pCaptureFile = state.pCaptureFile;
+    char *pCacheFile = state.pCacheFile;
+    uint32_t captureFlags = state.captureFlags;
+    size_t connections = state.connections;
+    bool renderOnLoad = state.renderOnLoad;
+    VarObject obj;
+    va_list args;
+    JNode *pConfig;
+
+    obj.type = VARTYPE_UINT32;
+    obj.len = sizeof( uint32_t );
+    obj.val.ul = 1;
+    hA = MOCK_AddVar( "/test/a", &obj );
+
+    obj.type = VARTYPE_STR;
+    obj.val.str = "hello";
+    obj.len = strlen( obj.val.str ) + 1;
+    hB = MOCK_AddVar( "/test/b", &obj );
+
+    obj.type = VARTYPE_INT16;
+    obj.len = sizeof( int16_t );
+    obj.val.i = -5;
+    hC = MOCK_AddVar( "/test/c", &obj );
+
+    TestPath( path, "config.json" );
+    result = EOK;
+    if ( fmt != NULL )
+    {
+        va_start( args, fmt );
+        vsnprintf( config, sizeof( config ), fmt, args );
+        va_end( args );
+
+        result = WriteFile( path, "%s", config );
+    }
+
+    if ( result == EOK )
+    {
+        TEMPLATESVC_Init( &state );
+        state.pMetricsPrefix = pMetricsPrefix;
+        state.pCaptureFile = pCaptureFile;
+        state.pCacheFile = pCacheFile;
+        state.captureFlags = captureFlags;
+        state.connections = connections;
+        state.renderOnLoad = renderOnLoad;
+
+        result = TEMPLATESVC_Open( &state );
+        if ( ( result == EOK ) && ( pCacheFile != NULL ) )
+        {
+            state.pFileName = path;
+            result = TEMPLATESVC_LoadConfig( &state );
+            state.pFileName = NULL;
+        }
+        else if ( result == EOK )
+        {
+            pConfig = JSON_Process( path );
+            result = ( pConfig != NULL )
+                     ? TEMPLATESVC_Load( &state, pConfig )
+                     : EINVAL;
+
+            if ( pConfig != NULL )
+            {
+                /* the templates do not refer to the parsed configuration */
+                JSON_Free( pConfig );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Teardown                                                                  */
+/*!
+    Close the template service and reset the mock variable server
+
+    Any notifications left pending by the test are discarded.
+
+==============================================================================*/
+static void Teardown( void )
+{
+    struct timespec timeout = { 0, 0 };
+    siginfo_t info;
+    sigset_t mask;
+
+    TEMPLATESVC_Close( &state );
+    state.pMetricsPrefix = NULL;
+    state.pCaptureFile = NULL;
+    state.pCacheFile = NULL;
+    state.captureFlags = 0;
+    state.connections = 0;
+    state.renderOnLoad = false;
+    MOCK_Clear();
+
+    sigemptyset( &mask );
+    sigaddset( &mask, SIG_VAR_MODIFIED );
+    sigaddset( &mask, SIG_VAR_PRINT );
+    while ( sigtimedwait( &mask, &info, &timeout ) > 0 )
+    {
+        /* discard the notification */
+    }
+}
+
+/*============================================================================*/
+/*  SetStr                                                                    */
+/*!
+    Set a string test variable
+
+    @param[in]
+        hVar
+            handle of the variable to set
+
+    @param[in]
+        str
+            new value of the variable
+
+==============================================================================*/
+static void SetStr( VAR_HANDLE hVar, char *str )
+{
+    VarObject obj;
+
+    obj.type = VARTYPE_STR;
+    obj.len = strlen( str ) + 1;
+    obj.val.str = str;
+    MOCK_SetVar( hVar, &obj );
+}
+
+/*============================================================================*/
+/*  SetUint                                                                   */
+/*!
+    Set a uint32 test variable
+
+    @param[in]
+        hVar
+            handle of the variable to set
+
+    @param[in]
+        val
+            new value of the variable
+
+==============================================================================*/
+static void SetUint( VAR_HANDLE hVar, uint32_t val )
+{
+    VarObject obj;
+
+    obj.type = VARTYPE_UINT32;
+    obj.len = sizeof( uint32_t );
+    obj.val.ul = val;
+    MOCK_SetVar( hVar, &obj );
+}
+
+/*============================================================================*/
+/*  TestTriggerIndex                                                          */
+/*!
+    Check the dispatch of notifications through the trigger index
+
+    A variable which triggers several templates must mark each of them
+    dirty, a template which lists a trigger twice is processed once per
+    notification, and the index must follow templates which are added
+    by a reload.  The template names are interned, so they remain valid
+    after the configuration is released.
+
+==============================================================================*/
+static void TestTriggerIndex( void )
+{
+    char out[TEST_PATH_LEN];
+    char config[TEST_PATH_LEN];
+    Template *pFirst;
+    Template *pSecond;
+    Template *pThird;
+
+    TestPath( out, "index.jsonl" );
+    TestPath( config, "index.json" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"first\","
+                  "\"trigger\":[\"/test/a\",\"/test/a\"],"
+                  "\"format\":\"jsonl\",\"vars\":[\"/test/a\"],"
+                  "\"type\":\"fd\",\"target\":\"%s\",\"append\":true},"
+                  "{\"name\":\"second\","
+                  "\"trigger\":[\"/test/a\",\"/test/b\"],"
+                  "\"format\":\"jsonl\",\"vars\":[\"/test/b\"],"
+                  "\"type\":\"fd\",\"target\":\"%s\",\"append\":true}]}",
+                  out, out ) == EOK );
+    state.pFileName = config;
+
+    pFirst = FindTemplate( "first" );
+    pSecond = FindTemplate( "second" );
+    CHECK( ( pFirst != NULL ) && ( pSecond != NULL ) );
+    if ( ( pFirst != NULL ) && ( pSecond != NULL ) )
+    {
+        /* the shared target name is interned once */
+        CHECK( pFirst->target == pSecond->target );
+
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+        CHECK( pFirst->dirty == true );
+        CHECK( pSecond->dirty == true );
+        CHECK( TRIGINDEX_Count( state.pTrigIndex ) == 3 );
+
+        /* the duplicate is dropped again when the index is rebuilt */
+        state.reindex = true;
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+        CHECK( TRIGINDEX_Count( state.pTrigIndex ) == 3 );
+
+        CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+        CHECK( pFirst->renders == 1 );
+        CHECK( pSecond->renders == 1 );
+
+        /* only the triggered template is visited by the render cycle */
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hB ) == EOK );
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hB ) == EOK );
+        CHECK( pFirst->dirty == false );
+        CHECK( pSecond->dirty == true );
+        CHECK( ( state.numDirty == 1 ) && ( state.ppDirty[0] == pSecond ) );
+        CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+        CHECK( state.numDirty == 0 );
+
+        /* a template added by a reload is indexed */
+        WriteFile( config,
+                   "{\"config\":["
+                   "{\"name\":\"third\",\"trigger\":[\"/test/b\"],"
+                   "\"format\":\"jsonl\",\"vars\":[\"/test/b\"],"
+                   "\"type\":\"fd\",\"target\":\"%s\"}]}",
+                   out );
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+        CHECK( TEMPLATESVC_Reload( &state ) == EOK );
+
+        /* a torn down template leaves the dirty set */
+        CHECK( state.numDirty == 0 );
+
+        pThird = FindTemplate( "third" );
+        CHECK( pThird != NULL );
+        CHECK( FindTemplate( "first" ) == NULL );
+        if ( pThird != NULL )
+        {
+            CHECK( strcmp( pThird->name, "third" ) == 0 );
+            CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+            CHECK( TEMPLATESVC_ProcessTemplates( &state, hB ) == EOK );
+            CHECK( pThird->dirty == true );
+            CHECK( TRIGINDEX_Count( state.pTrigIndex ) == 1 );
+            CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+            CHECK( pThird->renders == 1 );
+        }
+    }
+
+    state.pFileName = NULL;
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestWildcardTriggers                                                      */
+/*!
+    Check the expansion of wildcard triggers
+
+    A wildcard trigger must trigger the template for each variable under
+    its prefix, with the wildcard's condition, and not for the variables
+    outside it.  A matching variable created after the template was set
+    up must be picked up by a rescan, and only once.
+
+==============================================================================*/
+static void TestWildcardTriggers( void )
+{
+    char out[TEST_PATH_LEN];
+    VarObject obj;
+    VAR_HANDLE hRx;
+    VAR_HANDLE hTx;
+    VAR_HANDLE hOther;
+    VAR_HANDLE hErrors;
+    Template *pNet;
+    Template *pChange;
+    size_t i;
+
+    TestPath( out, "wildcard.jsonl" );
+
+    obj.type = VARTYPE_UINT32;
+    obj.len = sizeof( uint32_t );
+    obj.val.ul = 0;
+    hRx = MOCK_AddVar( "/net/eth0/rx", &obj );
+    hTx = MOCK_AddVar( "/net/eth0/tx", &obj );
+    hOther = MOCK_AddVar( "/net/eth1/rx", &obj );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"net\","
+                  "\"trigger\":[\"/net/eth0/*\",\"/test/a\"],"
+                  "\"format\":\"jsonl\",\"vars\":[\"/test/a\"],"
+                  "\"type\":\"fd\",\"target\":\"%s\",\"append\":true},"
+                  "{\"name\":\"change\","
+                  "\"trigger\":[{\"var\":\"/net/eth0/*\",\"on\":\"change\"}],"
+                  "\"format\":\"jsonl\",\"vars\":[\"/test/a\"],"
+                  "\"type\":\"fd\",\"target\":\"%s\",\"append\":true}]}",
+                  out, out ) == EOK );
+
+    pNet = FindTemplate( "net" );
+    pChange = FindTemplate( "change" );
+    CHECK( ( pNet != NULL ) && ( pChange != NULL ) );
+    if ( ( pNet != NULL ) && ( pChange != NULL ) )
+    {
+        CHECK( pNet->numWildcards == 1 );
+        CHECK( pNet->numTriggers == 3 );
+        CHECK( MOCK_IsWatched( hRx ) == true );
+        CHECK( MOCK_IsWatched( hTx ) == true );
+        CHECK( MOCK_IsWatched( hOther ) == false );
+
+        /* the expanded triggers take the wildcard's condition */
+        CHECK( pChange->numTriggers == 2 );
+        for ( i = 0 ; i < pChange->numTriggers ; i++ )
+        {
+            CHECK( pChange->pTriggers[i].condition == TRIGGER_CHANGE );
+        }
+
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hOther ) == EOK );
+        CHECK( pNet->dirty == false );
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hTx ) == EOK );
+        CHECK( pNet->dirty == true );
+        CHECK( pChange->dirty == false );
+        SetUint( hTx, 7 );
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hTx ) == EOK );
+        CHECK( pChange->dirty == true );
+        CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+
+        /* a variable created later is picked up by the rescan */
+        hErrors = MOCK_AddVar( "/net/eth0/errors", &obj );
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hErrors ) == EOK );
+        CHECK( pNet->dirty == false );
+        CHECK( TEMPLATESVC_RescanWildcards( &state ) == 2 );
+        CHECK( MOCK_IsWatched( hErrors ) == true );
+        CHECK( TEMPLATESVC_RescanWildcards( &state ) == 0 );
+        CHECK( pNet->numTriggers == 4 );
+
+        CHECK( TEMPLATESVC_ProcessTemplates( &state, hErrors ) == EOK );
+        CHECK( pNet->dirty == true );
+        CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+        CHECK( pNet->renders == 2 );
+    }
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestAutoTriggers                                                          */
+/*!
+    Check the triggers derived from the template references
+
+    A template with "trigger" : "auto" must be triggered by each variable
+    it references, once, except the excluded variables.  The derived
+    triggers must follow the template file when it changes, also from the
+    event loop when none of the old triggers change, and must be the same
+    when the definition is loaded from the configuration cache.
+
+==============================================================================*/
+static void TestAutoTriggers( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    char cache[TEST_PATH_LEN];
+    char parsed[TEST_BUF_SIZE];
+    char cached[TEST_BUF_SIZE];
+    Template *pText;
+    Template *pJsonl;
+    EventLoop *pLoop;
+    int pass;
+    int i;
+
+    TestPath( tmpl, "auto.tmpl" );
+    TestPath( out1, "auto.out" );
+    TestPath( out2, "auto.jsonl" );
+    TestPath( cache, "auto.cache" );
+    unlink( cache );
+
+    for ( pass = 0 ; pass < 2 ; pass++ )
+    {
+        /* the second pass loads the definitions from the cache */
+        WriteFile( tmpl, "a=${/test/a} b=${/test/b} c=${/test/c} "
+                         "a=${/test/a}\n" );
+        state.pCacheFile = cache;
+        if ( pass == 0 )
+        {
+            CHECK( Setup( "{\"config\":["
+                          "{\"name\":\"text\",\"trigger\":\"auto\","
+                          "\"exclude\":[\"/test/b\"],"
+                          "\"template\":\"%s\",\"type\":\"fd\","
+                          "\"target\":\"%s\"},"
+                          "{\"name\":\"jsonl\",\"trigger\":\"auto\","
+                          "\"format\":\"jsonl\","
+                          "\"vars\":[\"/test/a\",\"/test/b\"],"
+                          "\"type\":\"fd\",\"target\":\"%s\","
+                          "\"append\":true}]}",
+                          tmpl, out1, out2 ) == EOK );
+        }
+        else
+        {
+            CHECK( Setup( NULL ) == EOK );
+        }
+
+        CHECK( ( state.pConfCache != NULL ) == ( pass == 1 ) );
+        Signatures( ( pass == 0 ) ? parsed : cached, sizeof( parsed ) );
+
+        pText = FindTemplate( "text" );
+        pJsonl = FindTemplate( "jsonl" );
+        CHECK( ( pText != NULL ) && ( pJsonl != NULL ) );
+        if ( ( pText != NULL ) && ( pJsonl != NULL ) )
+        {
+            CHECK( pText->autoTrigger == true );
+            CHECK( pText->numTriggers == 2 );
+            CHECK( pJsonl->numTriggers == 2 );
+            CHECK( MOCK_IsWatched( hA ) == true );
+            CHECK( MOCK_IsWatched( hB ) == true );
+            CHECK( MOCK_IsWatched( hC ) == true );
+
+            CHECK( TEMPLATESVC_ProcessTemplates( &state, hB ) == EOK );
+            CHECK( pText->dirty == false );
+            CHECK( pJsonl->dirty == true );
+            CHECK( TEMPLATESVC_ProcessTemplates( &state, hC ) == EOK );
+            CHECK( pText->dirty == true );
+            CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+            CHECK( FileEquals( out1, "a=1 b=hello c=-5 a=1\n" ) );
+
+            /* the triggers follow the references of a changed template */
+            WriteFile( tmpl, "b=${/test/b} c=${/test/c}\n" );
+            CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+            CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+            CHECK( FileEquals( out1, "b=hello c=-5\n" ) );
+            CHECK( pText->numTriggers == 1 );
+
+            CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+            CHECK( pText->dirty == false );
+            CHECK( pJsonl->dirty == true );
+            CHECK( TEMPLATESVC_ProcessTemplates( &state, hC ) == EOK );
+            CHECK( pText->dirty == true );
+            CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+        }
+
+        Teardown();
+    }
+
+    CHECK( strcmp( parsed, cached ) == 0 );
+
+    /* an edited template follows its new references from the event loop,
+       without waiting for one of its old triggers */
+    WriteFile( tmpl, "a=${/test/a}\n" );
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"text\",\"trigger\":\"auto\","
+                  "\"template\":\"%s\",\"type\":\"fd\","
+                  "\"target\":\"%s\"}]}",
+                  tmpl, out1 ) == EOK );
+
+    pLoop = EVENTLOOP_Create();
+    CHECK( pLoop != NULL );
+    CHECK( TEMPLATESVC_Attach( &state, pLoop ) == EOK );
+
+    pText = FindTemplate( "text" );
+    CHECK( ( pText != NULL ) && ( pText->watched == true ) );
+    if ( ( pText != NULL ) && ( pText->numTriggers == 1 ) )
+    {
+        CHECK( pText->pTriggers[0].hVar == hA );
+
+        WriteFile( tmpl, "c=${/test/c}\n" );
+        for ( i = 0 ; ( i < 10 ) && ( pText->renders == 0 ) ; i++ )
+        {
+            EVENTLOOP_RunOnce( pLoop, 100 );
+        }
+
+        CHECK( FileEquals( out1, "c=-5\n" ) );
+        CHECK( pText->numTriggers == 1 );
+        CHECK( pText->pTriggers[0].hVar == hC );
+        CHECK( pText->queued == false );
+
+        /* the new reference now triggers the template on its own */
+        CHECK( MOCK_InjectModified( hC ) == EOK );
+        CHECK( EVENTLOOP_RunOnce( pLoop, 1000 ) == EOK );
+        CHECK( pText->renders == 2 );
+    }
+
+    Teardown();
+    EVENTLOOP_Destroy( pLoop );
+}
+
+/*============================================================================*/
+/*  TestPendingVars                                                           */
+/*!
+    Check the retries of variables created after the service started
+
+    Triggers, output variables and template references which do not
+    exist when the templates are set up must be kept pending, and must
+    be activated once they are created, either by an explicit retry or
+    by the retry timer of the event loop.
+
+==============================================================================*/
+static void TestPendingVars( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    EventLoop *pLoop;
+    VarObject obj;
+    VAR_HANDLE hT;
+    VAR_HANDLE hD;
+    Template *pLate;
+
+    TestPath( tmpl, "late.tmpl" );
+    TestPath( out1, "late.out" );
+    TestPath( out2, "late.jsonl" );
+    WriteFile( tmpl, "t=${/late/r}\n" );
+
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"late\",\"trigger\":[\"/test/a\",\"/late/t\","
+                  "{\"var\":\"/late/d\",\"on\":\"change\"}],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"jsonl\",\"trigger\":[\"/test/a\"],"
+                  "\"format\":\"jsonl\",\"vars\":[\"/late/v\"],"
+                  "\"type\":\"fd\",\"target\":\"%s\"}]}",
+                  tmpl, out1, out2 ) == EOK );
+
+    pLate = FindTemplate( "late" );
+    CHECK( ( pLate != NULL ) && ( pLate->numTriggers == 3 ) );
+    CHECK( TEMPLATESVC_ResolvePending( &state ) == 4 );
+
+    /* a reference is rendered as written until it is found */
+    CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+    CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+    CHECK( FileEquals( out1, "t=${/late/r}\n" ) );
+
+    obj.type = VARTYPE_UINT32;
+    obj.len = sizeof( uint32_t );
+    obj.val.ul = 9;
+    hT = MOCK_AddVar( "/late/t", &obj );
+    (void)MOCK_AddVar( "/late/r", &obj );
+    CHECK( TEMPLATESVC_ProcessTemplates( &state, hT ) == EOK );
+    CHECK( ( pLate != NULL ) && ( pLate->dirty == false ) );
+
+    CHECK( TEMPLATESVC_ResolvePending( &state ) == 2 );
+    CHECK( MOCK_IsWatched( hT ) == true );
+    CHECK( TEMPLATESVC_ProcessTemplates( &state, hT ) == EOK );
+    CHECK( ( pLate != NULL ) && ( pLate->dirty == true ) );
+    CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+    CHECK( FileEquals( out1, "t=9\n" ) );
+
+    /* the event loop retries the rest in the background */
+    pLoop = EVENTLOOP_Create();
+    CHECK( pLoop != NULL );
+    CHECK( TEMPLATESVC_Attach( &state, pLoop ) == EOK );
+    CHECK( state.pResolveTimer != NULL );
+    CHECK( state.resolveDelayMs > 0 );
+
+    hD = MOCK_AddVar( "/late/d", &obj );
+    (void)MOCK_AddVar( "/late/v", &obj );
+    CHECK( EVENTLOOP_RunOnce( pLoop, 1000 ) == EOK );
+    CHECK( state.resolveDelayMs == 0 );
+    CHECK( state.unresolved == 0 );
+    CHECK( MOCK_IsWatched( hD ) == true );
+
+    /* the change trigger was primed when it was found */
+    CHECK( TEMPLATESVC_ProcessTemplates( &state, hD ) == EOK );
+    CHECK( ( pLate != NULL ) && ( pLate->dirty == false ) );
+    CHECK( TEMPLATESVC_ProcessTemplates( &state, hA ) == EOK );
+    CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+    CHECK( FileEquals( out2, "{\"/late/v\":9}\n" ) );
+
+    Teardown();
+    EVENTLOOP_Destroy( pLoop );
+}
+
+/*============================================================================*/
+/*  TestStartupRegistration                                                   */
+/*!
+    Check the parallel registration of the variables at startup
+
+    The trigger variables of a large configuration must each be looked
+    up and watched exactly once, spread over several variable server
+    connections, and every template must be rendered once they are all
+    watched.
+
+==============================================================================*/
+static void TestStartupRegistration( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out[TEST_PATH_LEN];
+    char triggers[TEST_BUF_SIZE];
+    char name[TEST_PATH_LEN];
+    VAR_HANDLE hVars[TEST_REGISTER_VARS];
+    VarObject obj;
+    MockStats stats;
+    Template *pTemplate;
+    size_t len = 0;
+    bool watched = true;
+    int i;
+
+    TestPath( tmpl, "register.tmpl" );
+    TestPath( out, "register.out" );
+    WriteFile( tmpl, "a=${/test/a} n=${/reg/0}\n" );
+
+    obj.type = VARTYPE_UINT32;
+    obj.len = sizeof( uint32_t );
+    for ( i = 0 ; i < TEST_REGISTER_VARS ; i++ )
+    {
+        snprintf( name, sizeof( name ), "/reg/%d", i );
+        obj.val.ul = (uint32_t)i;
+        hVars[i] = MOCK_AddVar( name, &obj );
+        len += snprintf( &triggers[len],
+                         sizeof( triggers ) - len,
+                         "\"%s\",",
+                         name );
+    }
+
+    /* the triggers are shared by two templates, and one is missing */
+    MOCK_ResetStats();
+    state.connections = 4;
+    state.renderOnLoad = true;
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"all\",\"trigger\":[%s\"/reg/missing\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"one\",\"trigger\":[\"/reg/0\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\","
+                  "\"target\":\"/dev/null\"}]}",
+                  triggers, tmpl, out, tmpl ) == EOK );
+
+    MOCK_GetStats( &stats );
+    CHECK( stats.opens == 4 );
+    CHECK( stats.notifies == TEST_REGISTER_VARS );
+    CHECK( state.unresolved == 1 );
+
+    for ( i = 0 ; i < TEST_REGISTER_VARS ; i++ )
+    {
+        watched &= MOCK_IsWatched( hVars[i] );
+    }
+
+    CHECK( watched == true );
+
+    /* every template was rendered once its triggers were watched */
+    pTemplate = FindTemplate( "all" );
+    CHECK( ( pTemplate != NULL ) && ( pTemplate->renders == 1 ) );
+    CHECK( FileEquals( out, "a=1 n=0\n" ) );
+
+    pTemplate = FindTemplate( "one" );
+    CHECK( ( pTemplate != NULL ) && ( pTemplate->renders == 1 ) );
+
+    /* the triggers are dispatched from the registered handles */
+    CHECK( TEMPLATESVC_ProcessTemplates( &state,
+                                         hVars[TEST_REGISTER_VARS - 1] )
+           == EOK );
+    pTemplate = FindTemplate( "all" );
+    CHECK( ( pTemplate != NULL ) && ( pTemplate->dirty == true ) );
+    CHECK( TEMPLATESVC_RenderTemplates( &state ) == EOK );
+    CHECK( ( pTemplate != NULL ) && ( pTemplate->renders == 2 ) );
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  TestSteadyState                                                           */
+/*!
+    Check that warm templates render without heap allocations
+
+    Text, incremental, trigger condition and structured output templates,
+    with render metrics, are rendered until they are warm.  The
+    allocator is then counted while further notifications are
+    dispatched and rendered, and no allocation may be made.
+
+==============================================================================*/
+static void TestSteadyState( void )
+{
+    char tmpl[TEST_PATH_LEN];
+    char out1[TEST_PATH_LEN];
+    char out2[TEST_PATH_LEN];
+    char out3[TEST_PATH_LEN];
+    char out4[TEST_PATH_LEN];
+    /* the compressed template definition holds two paths */
+    char compressed[TEST_PATH_LEN * 3];
+    Compressor *pCompressor;
+    Template *pText;
+    Template *pCbor;
+    int i;
+
+    TestPath( tmpl, "steady.tmpl" );
+    TestPath( out1, "steady.out" );
+    TestPath( out2, "steady.incr" );
+    TestPath( out3, "steady.jsonl" );
+    TestPath( out4, "steady.cbor" );
+    WriteFile( tmpl, "a=${/test/a} b=${/test/b} c=${/test/c}\n" );
+
+    /* include a compressed template when compression is built in */
+    compressed[0] = '\0';
+    pCompressor = COMPRESS_Create( COMPRESS_ZSTD );
+    if ( pCompressor != NULL )
+    {
+        COMPRESS_Delete( pCompressor );
+        snprintf( compressed,
+                  sizeof( compressed ),
+                  ",{\"name\":\"zstd\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\","
+                  "\"target\":\"%s.zst\",\"compress\":\"zstd\"}",
+                  tmpl,
+                  out1 );
+    }
+
+    state.pMetricsPrefix = "/test/metrics";
+    CHECK( Setup( "{\"config\":["
+                  "{\"name\":\"text\",\"trigger\":[\"/test/a\"],"
+                  "\"template\":\"%s\",\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"incr\","
+                  "\"trigger\":[{\"var\":\"/test/b\",\"on\":\"change\"}],"
+                  "\"template\":\"%s\",\"incremental\":true,"
+                  "\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"jsonl\",\"trigger\":[\"/test/a\","
+                  "{\"var\":\"/test/c\",\"deadband\":1}],"
+                  "\"format\":\"jsonl\",\"vars\":[\"/test/a\",\"/test/b\","
+                  "\"/test/c\"],\"type\":\"fd\",\"target\":\"%s\"},"
+                  "{\"name\":\"cbor\",\"trigger\":[\"/test/a\"],"
+                  "\"format\":\"cbor\",\"vars\":[\"/test/b\"],"
+                  "\"type\":\"fd\",\"target\":\"%s\"}%s]}",
+                  tmpl, out1, tmpl, out2, out3, out4, compressed ) == EOK );
+
+    pText = FindTemplate( "text" );
+    pCbor = FindTemplate( "cbor" );
+    CHECK( ( pText != NULL ) && ( pCbor != NULL ) );
+    if ( ( pText != NULL ) && ( pCbor != NULL ) )
+    {
+        allocs = 0;
+
+        for ( i = 0 ; i < TEST_WARM_CYCLES + TEST_STEADY_CYCLES ; i++ )
+        {
+            /* the variable server side of the writes may allocate */
+            SetUint( hA, (uint32_t)i );
+            SetStr( hB, ( i & 1 ) ? "odd" : "even" );
+            CHECK( MOCK_InjectModified( hA ) == EOK );
+            CHECK( MOCK_InjectModified( hB ) == EOK );
+
+            countAllocs = ( i >= TEST_WARM_CYCLES );
+            CHECK( Dispatch() == EOK );
+            countAllocs = false;
+        }
+
+        CHECK( allocs == 0 );
+        CHECK( pText->renders ==
+               (uint64_t)( TEST_WARM_CYCLES + TEST_STEADY_CYCLES ) );
+        CHECK( pCbor->renders ==
+               (uint64_t)( TEST_WARM_CYCLES + TEST_STEADY_CYCLES ) );
+        CHECK( FileEquals( out1, "a=35 b=odd c=-5\n" ) );
+    }
+
+    Teardown();
+}
+
+/*============================================================================*/
+/*  Dispatch                                                                  */
+/*!
+    Dispatch the next pending notification to the template service
+
+    This is one iteration of the service's main loop.
+
+    @retval result of TEMPLATESVC_HandleSignal
+
+==============================================================================*/
+static int Dispatch( void )
+{
+    int sigval = 0;
+    int sig;
+
+    sig = VARSERVER_WaitSignal( &sigval );
+
+    return TEMPLATESVC_HandleSignal( &state, sig, sigval );
+}
+
+/*============================================================================*/
+/*  Trigger                                                                   */
+/*!
+    Notify the template service that a variable was modified
+
+    @param[in]
+        hVar
+            handle of the modified variable
+
+==============================================================================*/
+static void Trigger( VAR_HANDLE hVar )
+{
+    CHECK( MOCK_InjectModified( hVar ) == EOK );
+    CHECK( Dispatch() == EOK );
+}
+
+/*============================================================================*/
+/*  Fetch                                                                     */
+/*!
+    Fetch the variables of a template into a new render cycle snapshot
+
+    The TEMPLATESVC_PrintTemplate* functions render from the snapshot of
+    the current render cycle, so this must be called before printing a
+    template directly.
+
+    @param[in]
+        pTemplate
+            pointer to the template to fetch
+
+    @retval result of RENDER_Fetch
+
+==============================================================================*/
+static int Fetch( Template *pTemplate )
+{
+    VARCACHE_BeginCycle( state.pVarCache );
+
+    return RENDER_Fetch( state.hVarServer, pTemplate->pCompiled );
+}
+
+/*============================================================================*/
+/*  FindTemplate                                                              */
+/*!
+    Find a loaded template by name
+
+    @param[in]
+        name
+            name of the template to find
+
+    @retval pointer to the template
+    @retval NULL if the template was not found
+
+==============================================================================*/
+static Template *FindTemplate( const char *name )
+{
+    Template *pTemplate = state.pTemplates;
+
+    while ( ( pTemplate != NULL ) &&
+            ( ( pTemplate->name == NULL ) ||
+              ( strcmp( pTemplate->name, name ) != 0 ) ) )
+    {
+        pTemplate = pTemplate->pNext;
+    }
+
+    return pTemplate;
+}
+
+/*! @}
+ * end of templatesvc_test group */